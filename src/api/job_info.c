@@ -841,6 +841,7 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **resp,
 	req.show_flags = show_flags;
 	req_msg.msg_type = REQUEST_JOB_INFO;
 	req_msg.data     = &req;
+	req_msg.flags    = SLURM_PACK_COMPACT_OK | SLURM_COMPRESS_OK;
 
 	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
 		return SLURM_ERROR;
@@ -220,6 +220,7 @@ slurm_get_job_steps (time_t update_time, uint32_t job_id, uint32_t step_id,
 	req.show_flags	= show_flags;
 	req_msg.msg_type = REQUEST_JOB_STEP_INFO;
 	req_msg.data	= &req;
+	req_msg.flags	= SLURM_PACK_COMPACT_OK | SLURM_COMPRESS_OK;
 
 	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
 		return SLURM_ERROR;
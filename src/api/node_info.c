@@ -314,6 +314,7 @@ extern int slurm_load_node (time_t update_time,
 	req.show_flags   = show_flags;
 	req_msg.msg_type = REQUEST_NODE_INFO;
 	req_msg.data     = &req;
+	req_msg.flags    = SLURM_PACK_COMPACT_OK | SLURM_COMPRESS_OK;
 
 	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
 		return SLURM_ERROR;
@@ -58,6 +58,7 @@ int pmi_fd = -1;
 int pmi_time = 0;
 uint16_t srun_port = 0;
 slurm_addr_t srun_addr;
+bool pmi_stepd_local = false;	/* RPCs go to the local slurmstepd */
 
 static void _delay_rpc(int pmi_rank, int pmi_size);
 static int  _forward_comm_set(struct kvs_comm_set *kvs_set_ptr);
@@ -77,6 +78,10 @@ static void _delay_rpc(int pmi_rank, int pmi_size)
 	uint32_t delta_time, error_time;
 	int retries = 0;
 
+	/* The local slurmstepd serializes its own tasks' RPCs */
+	if (pmi_stepd_local)
+		return;
+
 	_set_pmi_time();
 
 again:	if (gettimeofday(&tv1, NULL)) {
@@ -129,6 +134,16 @@ static int _get_addr(void)
 	if (srun_port)
 		return SLURM_SUCCESS;
 
+	/* If slurmstepd is aggregating the node's key-pairs (PMI_AGGREGATE
+	 * set in the step environment), then talk to it instead of srun */
+	env_port = getenv("SLURM_PMI_STEPD_PORT");
+	if (env_port) {
+		srun_port = (uint16_t) atol(env_port);
+		slurm_set_addr(&srun_addr, srun_port, "localhost");
+		pmi_stepd_local = true;
+		return SLURM_SUCCESS;
+	}
+
 	env_host = getenv("SLURM_SRUN_COMM_HOST");
 	env_port = getenv("SLURM_SRUN_COMM_PORT");
 	if (!env_host || !env_port)
@@ -139,6 +154,16 @@ static int _get_addr(void)
 	return SLURM_SUCCESS;
 }
 
+/* Set the srun communication address explicitly rather than from this
+ * process' environment. Used by slurmstepd when it forwards the aggregated
+ * key-pairs of its local tasks. */
+extern void slurm_pmi_set_srun_addr(char *host, uint16_t port)
+{
+	srun_port = port;
+	slurm_set_addr(&srun_addr, srun_port, host);
+	pmi_stepd_local = false;
+}
+
 static void _set_pmi_time(void)
 {
 	char *tmp, *endptr;
@@ -87,6 +87,10 @@ int slurm_send_kvs_comm_set(struct kvs_comm_set *kvs_set_ptr,
 int  slurm_get_kvs_comm_set(struct kvs_comm_set **kvs_set_ptr,
 		int pmi_rank, int pmi_size);
 
+/* Direct this process' key-pair RPCs to the given srun address rather than
+ * the one named by SLURM_SRUN_COMM_HOST and SLURM_SRUN_COMM_PORT */
+void slurm_pmi_set_srun_addr(char *host, uint16_t port);
+
 /* Free kvs_comm_set returned by slurm_get_kvs_comm_set() */
 void slurm_free_kvs_comm_set(struct kvs_comm_set *kvs_set_ptr);
 
@@ -65,6 +65,7 @@
 
 #define MAX_RETRIES 3
 #define STDIO_MAX_FREE_BUF 1024
+#define STDIO_AGGREGATE_BUF 65536	/* bytes gathered per write */
 
 struct io_buf {
 	int ref_count;
@@ -123,6 +124,7 @@ struct server_io_info {
 	bool in_eof;
 	int remote_stdout_objs; /* active eio_obj_t's on the remote node */
 	int remote_stderr_objs; /* active eio_obj_t's on the remote node */
+	bitstr_t *relayed;	/* nodes whose IO the remote node relays */
 
 	/* outgoing variables */
 	List msg_queue;
@@ -244,6 +246,88 @@ _create_server_eio_obj(int fd, client_io_t *cio, int nodeid,
 	return eio;
 }
 
+/* Tell the step launch about an IO error on the node and on every node
+ * whose IO it relays */
+static void
+_server_io_failure(struct server_io_info *s)
+{
+	int i;
+
+	if (s->cio->sls == NULL)
+		return;
+	step_launch_notify_io_failure(s->cio->sls, s->node_id);
+	if (s->relayed == NULL)
+		return;
+	for (i = 0; i < s->cio->num_nodes; i++) {
+		if (bit_test(s->relayed, i))
+			step_launch_notify_io_failure(s->cio->sls, i);
+	}
+}
+
+static void
+_server_connection_okay(struct server_io_info *s)
+{
+	int i;
+
+	if (s->cio->sls == NULL)
+		return;
+	step_launch_clear_questionable_state(s->cio->sls, s->node_id);
+	if (s->relayed == NULL)
+		return;
+	for (i = 0; i < s->cio->num_nodes; i++) {
+		if (bit_test(s->relayed, i))
+			step_launch_clear_questionable_state(s->cio->sls, i);
+	}
+}
+
+/*
+ * The remote slurmstepd relays the IO of another node from now on, the
+ * message body is the relayed node's io init msg.
+ */
+static void
+_server_node_init(eio_obj_t *obj, struct io_buf *msg)
+{
+	struct server_io_info *s = (struct server_io_info *) obj->arg;
+	client_io_t *cio = s->cio;
+	struct slurm_io_init_msg init;
+	Buf packbuf;
+	int rc;
+
+	packbuf = create_buf(msg->data, msg->length);
+	rc = io_node_init_unpack(&init, packbuf);
+	/* free the Buf packbuf, but not the memory to which it points */
+	packbuf->head = NULL;
+	free_buf(packbuf);
+	if ((rc != SLURM_SUCCESS) || (init.nodeid >= cio->num_nodes)) {
+		error("Invalid relayed IO stream from node %d", s->node_id);
+		return;
+	}
+	debug2("IO of node rank %u relayed by node rank %d",
+	       init.nodeid, s->node_id);
+	debug3("msg.stdout_objs = %d", init.stdout_objs);
+	debug3("msg.stderr_objs = %d", init.stderr_objs);
+
+	s->remote_stdout_objs += init.stdout_objs;
+	s->remote_stderr_objs += init.stderr_objs;
+	if (s->relayed == NULL)
+		s->relayed = bit_alloc(cio->num_nodes);
+	bit_set(s->relayed, init.nodeid);
+
+	pthread_mutex_lock(&cio->ioservers_lock);
+	if (cio->ioserver[init.nodeid] != NULL)
+		error("IO: Node %d already established stream!", init.nodeid);
+	else if (bit_test(cio->ioservers_ready_bits, init.nodeid))
+		error("IO: Hey, you told me node %d was down!", init.nodeid);
+	else
+		cio->ioserver[init.nodeid] = obj;
+	bit_set(cio->ioservers_ready_bits, init.nodeid);
+	cio->ioservers_ready = bit_set_count(cio->ioservers_ready_bits);
+	pthread_mutex_unlock(&cio->ioservers_lock);
+
+	if (cio->sls)
+		step_launch_clear_questionable_state(cio->sls, init.nodeid);
+}
+
 static bool
 _server_readable(eio_obj_t *obj)
 {
@@ -301,9 +385,7 @@ _server_read(eio_obj_t *obj, List objs)
 
 		n = io_hdr_read_fd(obj->fd, &s->header);
 		if (n <= 0) { /* got eof or error on socket read */
-			if (s->cio->sls)
-				step_launch_notify_io_failure(s->cio->sls,
-							      s->node_id);
+			_server_io_failure(s);
 			debug3("got error or unexpected eof "
 			       "on _server_read header");
 			close(obj->fd);
@@ -315,9 +397,7 @@ _server_read(eio_obj_t *obj, List objs)
 			return SLURM_SUCCESS;
 		}
 		if (s->header.type == SLURM_IO_CONNECTION_TEST) {
-			if (s->cio->sls)
-				step_launch_clear_questionable_state(
-					s->cio->sls, s->node_id);
+			_server_connection_okay(s);
 			list_enqueue(s->cio->free_outgoing, s->in_msg);
 			s->in_msg = NULL;
 			s->testing_connection = false;
@@ -369,9 +449,7 @@ _server_read(eio_obj_t *obj, List objs)
 			}
 		}
 		if (n <= 0) { /* got eof or unhandled error */
-			if (s->cio->sls)
-				step_launch_notify_io_failure(
-					s->cio->sls, s->node_id);
+			_server_io_failure(s);
 			debug3("got error or unexpected eof "
 			       "on _server_read body");
 			close(obj->fd);
@@ -391,6 +469,13 @@ _server_read(eio_obj_t *obj, List objs)
 		debug3("***** passing on eof message");
 	}
 
+	if (s->in_msg->header.type == SLURM_IO_NODE_INIT) {
+		_server_node_init(obj, s->in_msg);
+		list_enqueue(s->cio->free_outgoing, s->in_msg);
+		s->in_msg = NULL;
+		return SLURM_SUCCESS;
+	}
+
 	/*
 	 * Route the message to the proper output
 	 */
@@ -481,9 +566,7 @@ again:
 			return SLURM_SUCCESS;
 		} else {
 			error("_server_write write failed: %m");
-			if (s->cio->sls)
-				step_launch_notify_io_failure(s->cio->sls,
-							      s->node_id);
+			_server_io_failure(s);
 			s->out_eof = true;
 			/* FIXME - perhaps we should free the message here? */
 			return SLURM_ERROR;
@@ -550,6 +633,94 @@ static bool _file_writable(eio_obj_t *obj)
 	return false;
 }
 
+/*
+ * Copy a message to dst with each line labelled as write_labelled_message()
+ * would write it, return the bytes copied.  dst must have room for
+ * _aggregate_size() bytes.
+ */
+static int _aggregate_copy(char *dst, char *src, int len, int taskid,
+			   bool label, int label_width)
+{
+	char *end;
+	int line_len, n = 0;
+
+	if (!label) {
+		memcpy(dst, src, len);
+		return len;
+	}
+	while (len > 0) {
+		n += sprintf(dst + n, "%0*d: ", label_width, taskid);
+		end = memchr(src, '\n', len);
+		line_len = end ? (int)(end - src) + 1 : len;
+		memcpy(dst + n, src, line_len);
+		n += line_len;
+		src += line_len;
+		len -= line_len;
+		if (end == NULL)
+			dst[n++] = '\n';
+	}
+	return n;
+}
+
+static int _aggregate_size(client_io_t *cio, int len)
+{
+	if (!cio->label)
+		return len;
+	/* every byte could be a newline needing a label */
+	return (len + 1) * (cio->label_width + 3);
+}
+
+/*
+ * With --io-aggregate, write the queued messages from all tasks with a
+ * single write() where per message writes would cost one or more system
+ * calls each.
+ */
+static int _file_write_aggregate(eio_obj_t *obj)
+{
+	struct file_write_info *info = (struct file_write_info *) obj->arg;
+	client_io_t *cio = info->cio;
+	struct io_buf *msg;
+	char *ptr = cio->aggregate_buf;
+	int len = 0, n;
+
+	while ((msg = list_peek(info->msg_queue))) {
+		if (info->eof) {
+			/* output is closed, discard message */
+		} else if (info->taskid != (uint32_t)-1
+			   && msg->header.gtaskid != info->taskid) {
+			/* we are ignoring messages not from info->taskid */
+		} else if ((len + _aggregate_size(cio, msg->length)) >
+			   STDIO_AGGREGATE_BUF) {
+			break;
+		} else {
+			len += _aggregate_copy(ptr + len, msg->data,
+					       msg->length,
+					       msg->header.gtaskid,
+					       cio->label, cio->label_width);
+		}
+		list_dequeue(info->msg_queue);
+		msg->ref_count--;
+		if (msg->ref_count == 0)
+			list_enqueue(cio->free_outgoing, msg);
+	}
+
+	while (len > 0) {
+		if ((n = write(obj->fd, ptr, len)) < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN) ||
+			    (errno == EWOULDBLOCK))
+				continue;
+			error("_file_write_aggregate: %m");
+			info->eof = true;
+			return SLURM_ERROR;
+		}
+		debug3("  wrote %d bytes", n);
+		ptr += n;
+		len -= n;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 static int _file_write(eio_obj_t *obj, List objs)
 {
 	struct file_write_info *info = (struct file_write_info *) obj->arg;
@@ -557,6 +728,8 @@ static int _file_write(eio_obj_t *obj, List objs)
 	int n;
 
 	debug2("Entering _file_write");
+	if (info->cio->aggregate_buf)
+		return _file_write_aggregate(obj);
 	/*
 	 * If we aren't already in the middle of sending a message, get the
 	 * next message from the queue.
@@ -735,16 +908,25 @@ again:
 		int i;
 		struct server_io_info *server;
 		for (i = 0; i < info->cio->num_nodes; i++) {
-			msg->ref_count++;
-			if (info->cio->ioserver[i] == NULL)
+			if (info->cio->ioserver[i] == NULL) {
 				/* client_io_handler_abort() or 
 				 * client_io_handler_downnodes() called */
 				verbose("ioserver stream of node %d not yet "
 					"initialized", i);
-			else {
-				server = info->cio->ioserver[i]->arg;
-				list_enqueue(server->msg_queue, msg);
+				continue;
 			}
+			server = info->cio->ioserver[i]->arg;
+			/* a relaying node passes stdin on to the nodes
+			 * it relays, send it once */
+			if (server->node_id != i)
+				continue;
+			msg->ref_count++;
+			list_enqueue(server->msg_queue, msg);
+		}
+		if (msg->ref_count == 0) {
+			pthread_mutex_lock(&info->cio->ioservers_lock);
+			list_enqueue(info->cio->free_incoming, msg);
+			pthread_mutex_unlock(&info->cio->ioservers_lock);
 		}
 	} else if (header.type == SLURM_IO_STDIN) {
 		uint32_t nodeid;
@@ -832,7 +1014,11 @@ _read_io_init_msg(int fd, client_io_t *cio, char *host)
 	debug3("msg.stdout_objs = %d", msg.stdout_objs);
 	debug3("msg.stderr_objs = %d", msg.stderr_objs);
 	/* sanity checks, just print warning */
-	if (cio->ioserver[msg.nodeid] != NULL) {
+	if ((cio->ioserver[msg.nodeid] != NULL) &&
+	    (((struct server_io_info *) cio->ioserver[msg.nodeid]->arg)->
+	     node_id != msg.nodeid)) {
+		debug("IO: Node %d no longer relayed", msg.nodeid);
+	} else if (cio->ioserver[msg.nodeid] != NULL) {
 		error("IO: Node %d already established stream!", msg.nodeid);
 	} else if (bit_test(cio->ioservers_ready_bits, msg.nodeid)) {
 		error("IO: Hey, you told me node %d was down!", msg.nodeid);
@@ -1068,7 +1254,8 @@ client_io_handler_create(slurm_step_io_fds_t fds,
 			 int num_tasks,
 			 int num_nodes,
 			 slurm_cred_t *cred,
-			 bool label)
+			 bool label,
+			 bool aggregate)
 {
 	client_io_t *cio;
 	int len;
@@ -1082,6 +1269,8 @@ client_io_handler_create(slurm_step_io_fds_t fds,
 
 	cio->num_tasks = num_tasks;
 	cio->num_nodes = num_nodes;
+	if (aggregate)
+		cio->aggregate_buf = xmalloc(STDIO_AGGREGATE_BUF);
 
 	cio->label = label;
 	if (cio->label)
@@ -1197,6 +1386,7 @@ client_io_handler_destroy(client_io_t *cio)
 	xfree(cio->listensock);
 	eio_handle_destroy(cio->eio);
 	xfree(cio->io_key);
+	xfree(cio->aggregate_buf);
 	xfree(cio);
 }
 
@@ -1220,6 +1410,10 @@ client_io_handler_downnodes(client_io_t *cio,
 		    && cio->ioserver[node_id] != NULL) {
 			tmp = cio->ioserver[node_id]->arg;
 			info = (struct server_io_info *)tmp;
+			/* the relaying node closes the streams of a node
+			 * it loses */
+			if (info->node_id != node_id)
+				continue;
 			info->remote_stdout_objs = 0;
 			info->remote_stderr_objs = 0;
 			info->testing_connection = false;
@@ -1272,7 +1466,6 @@ int client_io_handler_send_test_message(client_io_t *cio, int node_id,
 	int rc = SLURM_SUCCESS;
 	pthread_mutex_lock(&cio->ioservers_lock);
 
-	server = (struct server_io_info *)cio->ioserver[node_id]->arg;
 	if (sent_message)
 		*sent_message = false;
 
@@ -1284,6 +1477,7 @@ int client_io_handler_send_test_message(client_io_t *cio, int node_id,
 	if (cio->ioserver[node_id] == NULL) {
 		goto done;
 	}
+	server = (struct server_io_info *)cio->ioserver[node_id]->arg;
 
 	/* In this case, the I/O connection has closed so can't send a test
 	   message.  This error case is handled elsewhere. */
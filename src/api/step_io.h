@@ -47,6 +47,8 @@ struct client_io {
 	bool label;
 	int label_width;
 	char *io_key;
+	char *aggregate_buf;	/* output gathered for a single write, if
+				 * --io-aggregate */
 
 	/* internal variables */
 	pthread_t ioid;		/* stdio thread id 		  */
@@ -100,12 +102,14 @@ typedef struct client_io client_io_t;
  *	string from the credential.  The slurmstepd sends the signature back
  *	back to the client when it establishes the IO connection as a sort
  *	of validity check.
+ * IN aggregate - gather the output of many messages into each write
  */
 client_io_t *client_io_handler_create(slurm_step_io_fds_t fds,
 				      int num_tasks,
 				      int num_nodes,
 				      slurm_cred_t *cred,
-				      bool label);
+				      bool label,
+				      bool aggregate);
 
 int client_io_handler_start(client_io_t *cio);
 
@@ -255,6 +255,10 @@ int slurm_step_launch (slurm_step_ctx_t *ctx,
 	launch.task_flags = 0;
 	if (params->parallel_debug)
 		launch.task_flags |= TASK_PARALLEL_DEBUG;
+	if (params->launch_relay)
+		launch.task_flags |= TASK_LAUNCH_RELAY;
+	if (params->io_aggregate)
+		launch.task_flags |= TASK_IO_AGGREGATE;
 
 	launch.tasks_to_launch = ctx->step_resp->step_layout->tasks;
 	launch.cpus_allocated  = ctx->step_resp->step_layout->tasks;
@@ -274,7 +278,8 @@ int slurm_step_launch (slurm_step_ctx_t *ctx,
 						 ctx->step_req->num_tasks,
 						 launch.nnodes,
 						 ctx->step_resp->cred,
-						 params->labelio);
+						 params->labelio,
+						 params->io_aggregate);
 		if (ctx->launch_state->io.normal == NULL) {
 			rc = SLURM_ERROR;
 			goto fail1;
@@ -847,9 +852,9 @@ static int _msg_thr_create(struct step_launch_state *sls, int num_nodes)
 }
 
 static void
-_launch_handler(struct step_launch_state *sls, slurm_msg_t *resp)
+_launch_handler(struct step_launch_state *sls,
+		launch_tasks_response_msg_t *msg)
 {
-	launch_tasks_response_msg_t *msg = resp->data;
 	int i;
 
 	pthread_mutex_lock(&sls->lock);
@@ -881,6 +886,29 @@ _launch_handler(struct step_launch_state *sls, slurm_msg_t *resp)
 
 }
 
+/*
+ * Launch responses of many nodes relayed by the rank 0 slurmstepd
+ */
+static void
+_launch_relay_handler(struct step_launch_state *sls, slurm_msg_t *relay_msg)
+{
+	launch_tasks_relay_msg_t *msg = relay_msg->data;
+	launch_tasks_response_msg_t *resp;
+	ListIterator itr;
+
+	if ((msg->job_id != sls->mpi_info->jobid) ||
+	    (msg->job_step_id != sls->mpi_info->stepid)) {
+		debug("Received relayed launch responses from wrong job: "
+		      "%u.%u", msg->job_id, msg->job_step_id);
+		return;
+	}
+
+	itr = list_iterator_create(msg->resp_list);
+	while ((resp = list_next(itr)))
+		_launch_handler(sls, resp);
+	list_iterator_destroy(itr);
+}
+
 static void
 _exit_handler(struct step_launch_state *sls, slurm_msg_t *exit_msg)
 {
@@ -1220,9 +1248,14 @@ _handle_msg(void *arg, slurm_msg_t *msg)
 	switch (msg->msg_type) {
 	case RESPONSE_LAUNCH_TASKS:
 		debug2("received task launch");
-		_launch_handler(sls, msg);
+		_launch_handler(sls, msg->data);
 		slurm_free_launch_tasks_response_msg(msg->data);
 		break;
+	case RESPONSE_LAUNCH_TASKS_RELAY:
+		debug2("received relayed task launches");
+		_launch_relay_handler(sls, msg);
+		slurm_free_launch_tasks_relay_msg(msg->data);
+		break;
 	case MESSAGE_TASK_EXIT:
 		debug2("received task exit");
 		_exit_handler(sls, msg);
@@ -110,6 +110,9 @@ struct assoc_mgr_association_usage {
 	uint32_t level_shares;  /* number of shares on this level of
 				 * the tree (DON'T PACK) */
 
+	uint32_t release_gen;   /* bumped each time a running job's
+				 * usage is released (DON'T PACK) */
+
 	slurmdb_association_rec_t *parent_assoc_ptr; /* ptr to parent acct
 						      * set in slurmctld
 						      * (DON'T PACK) */
@@ -146,6 +149,8 @@ struct assoc_mgr_qos_usage {
 	double grp_used_wall;   /* group count of time (minutes) used in
 				 * running jobs (DON'T PACK) */
 	double norm_priority;/* normalized priority (DON'T PACK) */
+	uint32_t release_gen;   /* bumped each time a running job's
+				 * usage is released (DON'T PACK) */
 	long double usage_raw;	/* measure of resource usage (DON'T PACK) */
 
 	List user_limit_list; /* slurmdb_used_limits_t's (DON'T PACK) */
@@ -42,6 +42,11 @@
 #include <sys/poll.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdlib.h>
+
+#ifdef HAVE_SYS_EPOLL_H
+#  include <sys/epoll.h>
+#endif
 
 #include "src/common/xmalloc.h"
 #include "src/common/xassert.h"
@@ -64,6 +69,9 @@ struct eio_handle_components {
 	int  fds[2];
 	List obj_list;
 	List new_objs;
+	int  ep_fd;		/* epoll instance of a running mainloop */
+	eio_obj_t **ep_owner;	/* object holding each fd's registration */
+	int  ep_owner_size;
 };
 
 
@@ -76,6 +84,10 @@ static void         _poll_dispatch(struct pollfd *, unsigned int, eio_obj_t **,
 		                   List objList);
 static void         _poll_handle_event(short revents, eio_obj_t *obj,
 		                       List objList);
+static int          _poll_mainloop(eio_handle_t *eio);
+#ifdef HAVE_SYS_EPOLL_H
+static int          _epoll_mainloop(eio_handle_t *eio);
+#endif
 
 eio_handle_t *eio_handle_create(void)
 {
@@ -90,6 +102,7 @@ eio_handle_t *eio_handle_create(void)
 	fd_set_nonblocking(eio->fds[0]);
 	fd_set_close_on_exec(eio->fds[0]);
 	fd_set_close_on_exec(eio->fds[1]);
+	eio->ep_fd = -1;
 
 	xassert(eio->magic = EIO_MAGIC);
 
@@ -110,6 +123,7 @@ void eio_handle_destroy(eio_handle_t *eio)
 
 	if (eio->new_objs)
 		list_destroy(eio->new_objs);
+	xfree(eio->ep_owner);
 
 	xassert(eio->magic = ~EIO_MAGIC);
 	xfree(eio);
@@ -241,6 +255,18 @@ static int _eio_wakeup_handler(eio_handle_t *eio)
 }
 
 int eio_handle_mainloop(eio_handle_t *eio)
+{
+	xassert (eio != NULL);
+	xassert (eio->magic == EIO_MAGIC);
+
+#ifdef HAVE_SYS_EPOLL_H
+	if (!getenv("SLURM_EIO_POLL"))
+		return _epoll_mainloop(eio);
+#endif
+	return _poll_mainloop(eio);
+}
+
+static int _poll_mainloop(eio_handle_t *eio)
 {
 	int            retval  = 0;
 	struct pollfd *pollfds = NULL;
@@ -248,9 +274,6 @@ int eio_handle_mainloop(eio_handle_t *eio)
 	unsigned int   maxnfds = 0, nfds = 0;
 	unsigned int   n       = 0;
 
-	xassert (eio != NULL);
-	xassert (eio->magic == EIO_MAGIC);
-
 	for (;;) {
 
 		/* Alloc memory for pfds and map if needed */
@@ -435,6 +458,289 @@ _poll_handle_event(short revents, eio_obj_t *obj, List objList)
 	}
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * epoll backend.  An object's fd stays registered with the kernel between
+ * iterations, so only objects whose interest changed or which were just
+ * handled cost a system call, and epoll_wait() returns only the ready fds.
+ * The readable/writable callbacks are still called for every object each
+ * iteration since they may change their minds on the state of other
+ * objects.
+ *
+ * Registrations are one-shot: once an event is reported the fd is disarmed
+ * until the next iteration re-arms it.  A callback may close its fd, which
+ * the kernel keeps registered if the file is still open elsewhere (e.g.
+ * inherited by a task), and a one-shot registration reports at most one
+ * event for it, which is then discarded.
+ */
+
+/* Forget obj's registration, its fd was closed or replaced */
+static void
+_epoll_forget(eio_handle_t *eio, eio_obj_t *obj)
+{
+	if ((obj->ep_fd >= 0) && (obj->ep_fd < eio->ep_owner_size) &&
+	    (eio->ep_owner[obj->ep_fd] == obj))
+		eio->ep_owner[obj->ep_fd] = NULL;
+	obj->ep_fd = -1;
+	obj->ep_events = 0;
+	obj->ep_poll = false;
+}
+
+/*
+ * Arm obj's fd for "events".  Returns -1 if the fd must be polled instead,
+ * either because epoll does not support it (regular files) or because
+ * another object holds the registration of the same fd.
+ */
+static int
+_epoll_arm(eio_handle_t *eio, eio_obj_t *obj, uint32_t events)
+{
+	struct epoll_event ev;
+	eio_obj_t *owner;
+	int op, rc;
+
+	if (obj->ep_poll)
+		return -1;
+
+	if (obj->fd >= eio->ep_owner_size) {
+		eio->ep_owner_size = obj->fd + 256;
+		xrealloc(eio->ep_owner,
+			 eio->ep_owner_size * sizeof(eio_obj_t *));
+	}
+	owner = eio->ep_owner[obj->fd];
+	if (owner && (owner != obj) && (owner->fd == obj->fd) &&
+	    (owner->ep_fd == obj->fd))
+		return -1;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events | EPOLLONESHOT;
+	ev.data.ptr = obj;
+	op = (obj->ep_fd == obj->fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	if (owner && (owner != obj) && (owner->ep_fd == obj->fd))
+		_epoll_forget(eio, owner);
+
+	/* The fd number may have been reused for a new file, or the old
+	 * registration may have outlived an earlier owner */
+	rc = epoll_ctl(eio->ep_fd, op, obj->fd, &ev);
+	if ((rc < 0) && (op == EPOLL_CTL_MOD) && (errno == ENOENT))
+		rc = epoll_ctl(eio->ep_fd, EPOLL_CTL_ADD, obj->fd, &ev);
+	else if ((rc < 0) && (op == EPOLL_CTL_ADD) && (errno == EEXIST))
+		rc = epoll_ctl(eio->ep_fd, EPOLL_CTL_MOD, obj->fd, &ev);
+	if (rc < 0) {
+		if (errno != EPERM)
+			debug("eio: epoll_ctl(%d): %m", obj->fd);
+		obj->ep_fd = obj->fd;
+		obj->ep_poll = true;
+		return -1;
+	}
+
+	eio->ep_owner[obj->fd] = obj;
+	obj->ep_fd = obj->fd;
+	obj->ep_events = events;
+	return 0;
+}
+
+static void
+_epoll_disarm(eio_handle_t *eio, eio_obj_t *obj)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLONESHOT;
+	ev.data.ptr = obj;
+	(void) epoll_ctl(eio->ep_fd, EPOLL_CTL_MOD, obj->fd, &ev);
+	obj->ep_events = 0;
+}
+
+/*
+ * Bring the registrations up to date with the objects' readable and
+ * writable callbacks.  Objects which can not use epoll are put in "pfds".
+ * Returns the number of objects waiting for events, including those in
+ * "pfds".
+ */
+static unsigned int
+_epoll_setup(eio_handle_t *eio, struct pollfd *pfds, eio_obj_t *map[],
+	     unsigned int *npoll)
+{
+	ListIterator  i    = list_iterator_create(eio->obj_list);
+	eio_obj_t    *obj  = NULL;
+	unsigned int  nobj = 0;
+	uint32_t      events;
+
+	*npoll = 0;
+	while ((obj = list_next(i))) {
+		events = 0;
+		if (_is_writable(obj))
+			events |= EPOLLOUT;
+		if (_is_readable(obj))
+			events |= EPOLLIN;
+
+		if ((obj->ep_fd != -1) && (obj->ep_fd != obj->fd))
+			_epoll_forget(eio, obj);
+		if (events == 0) {
+			if (obj->ep_events)
+				_epoll_disarm(eio, obj);
+			continue;
+		}
+		nobj++;
+		if ((events == obj->ep_events) ||
+		    (_epoll_arm(eio, obj, events) == 0))
+			continue;
+
+		if (obj->ep_events)
+			_epoll_disarm(eio, obj);
+		pfds[*npoll].fd      = obj->fd;
+		pfds[*npoll].events  = ((events & EPOLLIN)  ? POLLIN  : 0) |
+				       ((events & EPOLLOUT) ? POLLOUT : 0);
+		pfds[*npoll].revents = 0;
+		map[*npoll]          = obj;
+		(*npoll)++;
+	}
+	list_iterator_destroy(i);
+	return nobj;
+}
+
+static int
+_epoll_internal(int ep_fd, struct epoll_event *events, int maxevents,
+		int timeout)
+{
+	int n;
+	while ((n = epoll_wait(ep_fd, events, maxevents, timeout)) < 0) {
+		switch (errno) {
+		case EINTR : return 0;
+		case EAGAIN: continue;
+		default:
+			error("epoll_wait: %m");
+			return -1;
+		}
+	}
+	return n;
+}
+
+static void
+_epoll_dispatch(struct epoll_event *events, int nevents, List objList)
+{
+	eio_obj_t *obj;
+	short revents;
+	int i;
+
+	for (i = 0; i < nevents; i++) {
+		obj = events[i].data.ptr;
+		/* the eio handle signalling fd or a stale registration */
+		if (!obj || !obj->ep_events || (obj->ep_fd != obj->fd))
+			continue;
+		obj->ep_events = 0;	/* one-shot, re-armed by setup */
+
+		revents = 0;
+		if (events[i].events & EPOLLIN)
+			revents |= POLLIN;
+		if (events[i].events & EPOLLOUT)
+			revents |= POLLOUT;
+		if (events[i].events & EPOLLERR)
+			revents |= POLLERR;
+		if (events[i].events & EPOLLHUP)
+			revents |= POLLHUP;
+		_poll_handle_event(revents, obj, objList);
+	}
+}
+
+static int
+_epoll_mainloop(eio_handle_t *eio)
+{
+	int                 retval  = 0;
+	struct epoll_event  ev, *events = NULL;
+	struct pollfd      *pollfds = NULL;
+	eio_obj_t         **map     = NULL;
+	ListIterator        itr;
+	eio_obj_t          *obj;
+	unsigned int        maxnfds = 0, nobj = 0, npoll = 0;
+	unsigned int        n       = 0;
+	int                 i, nevents, timeout;
+
+	if ((eio->ep_fd = epoll_create(1024)) < 0) {
+		error("eio: epoll_create: %m, using poll");
+		return _poll_mainloop(eio);
+	}
+	fd_set_close_on_exec(eio->ep_fd);
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(eio->ep_fd, EPOLL_CTL_ADD, eio->fds[0], &ev) < 0) {
+		error("eio: epoll_ctl: %m");
+		goto error;
+	}
+
+	/* Registrations do not outlive the epoll instance */
+	itr = list_iterator_create(eio->obj_list);
+	while ((obj = list_next(itr)))
+		_epoll_forget(eio, obj);
+	list_iterator_destroy(itr);
+
+	for (;;) {
+
+		/* Alloc memory for events, pfds and map if needed */
+		n = list_count(eio->obj_list);
+		if (maxnfds < n) {
+			maxnfds = n;
+			xrealloc(events,  (maxnfds+1) * sizeof(struct epoll_event));
+			xrealloc(pollfds, (maxnfds+1) * sizeof(struct pollfd));
+			xrealloc(map,     maxnfds     * sizeof(eio_obj_t *  ));
+		}
+
+		debug4("eio: handling events for %d objects", n);
+		nobj = _epoll_setup(eio, pollfds, map, &npoll);
+		if (nobj == 0)
+			goto done;
+
+		/*
+		 *  Objects which can not use epoll are polled together
+		 *  with the epoll fd
+		 */
+		timeout = -1;
+		if (npoll) {
+			pollfds[npoll].fd      = eio->ep_fd;
+			pollfds[npoll].events  = POLLIN;
+			pollfds[npoll].revents = 0;
+			if (_poll_internal(pollfds, npoll + 1) < 0)
+				goto error;
+			timeout = 0;
+		}
+
+		nevents = 0;
+		if ((npoll == 0) || (pollfds[npoll].revents & POLLIN)) {
+			nevents = _epoll_internal(eio->ep_fd, events,
+						  maxnfds + 1, timeout);
+			if (nevents < 0)
+				goto error;
+		}
+
+		for (i = 0; i < nevents; i++) {
+			if (events[i].data.ptr == NULL) {
+				_eio_wakeup_handler(eio);
+				break;
+			}
+		}
+
+		_epoll_dispatch(events, nevents, eio->obj_list);
+		if (npoll)
+			_poll_dispatch(pollfds, npoll, map, eio->obj_list);
+	}
+  error:
+	retval = -1;
+  done:
+	itr = list_iterator_create(eio->obj_list);
+	while ((obj = list_next(itr)))
+		_epoll_forget(eio, obj);
+	list_iterator_destroy(itr);
+	close(eio->ep_fd);
+	eio->ep_fd = -1;
+	xfree(events);
+	xfree(pollfds);
+	xfree(map);
+	return retval;
+}
+#endif	/* HAVE_SYS_EPOLL_H */
+
 static struct io_operations *
 _ops_copy(struct io_operations *ops)
 {
@@ -453,6 +759,7 @@ eio_obj_create(int fd, struct io_operations *ops, void *arg)
 	obj->arg = arg;
 	obj->ops = _ops_copy(ops);
 	obj->shutdown = false;
+	obj->ep_fd = -1;
 	return obj;
 }
 
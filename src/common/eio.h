@@ -67,6 +67,11 @@ struct eio_obj {
 	void *arg;                        /* application-specific data       */
 	struct io_operations *ops;        /* pointer to ops struct for obj   */
 	bool shutdown;
+
+	/* private to eio.c, state of the fd's epoll registration */
+	int ep_fd;                        /* fd registered, -1 if none       */
+	uint32_t ep_events;               /* events armed, 0 if disarmed     */
+	bool ep_poll;                     /* ep_fd can not use epoll         */
 };
 
 eio_handle_t *eio_handle_create(void);
@@ -94,6 +99,11 @@ void eio_new_obj(eio_handle_t *eio, eio_obj_t *obj);
  * routine returns 0 when either list is empty or no objects in list are
  * readable() or writable().
  *
+ * Where epoll is available the fd's stay registered with the kernel
+ * between iterations and only objects whose interest changed, or which
+ * were just handled, are updated. Set SLURM_EIO_POLL in the environment
+ * to use poll() instead.
+ *
  * returns -1 on error.
  */
 int eio_handle_mainloop(eio_handle_t *eio);
@@ -83,7 +83,8 @@ void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 void *_forward_thread(void *arg)
 {
 	forward_msg_t *fwd_msg = (forward_msg_t *)arg;
-	Buf buffer = init_buf(fwd_msg->buf_len);
+	Buf buffer = init_pool_buf();
+	struct iovec iov[2];
 	int i=0;
 	List ret_list = NULL;
 	slurm_fd_t fd = -1;
@@ -140,24 +141,16 @@ void *_forward_thread(void *arg)
 
 		pack_header(&fwd_msg->header, buffer);
 
-		/* add forward data to buffer */
-		if (remaining_buf(buffer) < fwd_msg->buf_len) {
-			buffer->size += (fwd_msg->buf_len + BUF_SIZE);
-			xrealloc(buffer->head, buffer->size);
-		}
-		if (fwd_msg->buf_len) {
-			memcpy(&buffer->head[buffer->processed],
-			       fwd_msg->buf, fwd_msg->buf_len);
-			buffer->processed += fwd_msg->buf_len;
-		}
-
 		/*
-		 * forward message
+		 * forward message, the forward data is sent after the
+		 * header from where it is rather than copied to buffer
 		 */
-		if(_slurm_msg_sendto(fd,
-				     get_buf_data(buffer),
-				     get_buf_offset(buffer),
-				     SLURM_PROTOCOL_NO_SEND_RECV_FLAGS ) < 0) {
+		iov[0].iov_base = get_buf_data(buffer);
+		iov[0].iov_len  = get_buf_offset(buffer);
+		iov[1].iov_base = fwd_msg->buf;
+		iov[1].iov_len  = fwd_msg->buf_len;
+		if(_slurm_msg_sendv(fd, iov, 2,
+				    SLURM_PROTOCOL_NO_SEND_RECV_FLAGS) < 0) {
 			error("forward_thread: slurm_msg_sendto: %m");
 
 			slurm_mutex_lock(fwd_msg->forward_mutex);
@@ -165,8 +158,7 @@ void *_forward_thread(void *arg)
 					       errno);
 			free(name);
 			if(hostlist_count(hl) > 0) {
-				free_buf(buffer);
-				buffer = init_buf(fwd_msg->buf_len);
+				set_buf_offset(buffer, 0);
 				slurm_mutex_unlock(fwd_msg->forward_mutex);
 				slurm_close_accepted_conn(fd);
 				fd = -1;
@@ -220,8 +212,7 @@ void *_forward_thread(void *arg)
 			if(ret_list)
 				list_destroy(ret_list);
 			if (hostlist_count(hl) > 0) {
-				free_buf(buffer);
-				buffer = init_buf(fwd_msg->buf_len);
+				set_buf_offset(buffer, 0);
 				slurm_mutex_unlock(fwd_msg->forward_mutex);
 				slurm_close_accepted_conn(fd);
 				fd = -1;
@@ -295,7 +286,7 @@ cleanup:
 		error ("close(%d): %m", fd);
 	hostlist_destroy(hl);
 	destroy_forward(&fwd_msg->header.forward);
-	free_buf(buffer);
+	free_pool_buf(buffer);
 	pthread_cond_signal(fwd_msg->notify);
 	slurm_mutex_unlock(fwd_msg->forward_mutex);
 
@@ -313,6 +304,9 @@ void *_fwd_tree_thread(void *arg)
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
 	send_msg.data = fwd_tree->orig_msg->data;
+	send_msg.restrict_uid = fwd_tree->orig_msg->restrict_uid;
+	send_msg.restrict_gid = fwd_tree->orig_msg->restrict_gid;
+	send_msg.restrict_uid_set = fwd_tree->orig_msg->restrict_uid_set;
 
 	/* repeat until we are sure the message was sent */
 	while((name = hostlist_shift(fwd_tree->tree_hl))) {
@@ -471,7 +465,10 @@ extern int forward_msg(forward_struct_t *forward_struct,
 		       sizeof(slurm_addr_t));
 
 		forward_msg->header.version = header->version;
-		forward_msg->header.flags = header->flags;
+		/* the connections to our children are not persistent */
+		forward_msg->header.flags = header->flags &
+					    (~SLURM_PERSIST_CONN);
+		forward_msg->header.msg_id = 0;
 		forward_msg->header.msg_type = header->msg_type;
 		forward_msg->header.body_length = header->body_length;
 		forward_msg->header.ret_list = NULL;
@@ -0,0 +1,259 @@
+/*****************************************************************************\
+ *  src/common/hmac.c - SHA-256 and HMAC-SHA256 message authentication
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "src/common/hmac.h"
+#include "src/common/macros.h"
+
+/*
+** Define slurm-specific aliases for use by plugins, see slurm_xlator.h
+** for details.
+*/
+strong_alias(sha256_init,	slurm_sha256_init);
+strong_alias(sha256_update,	slurm_sha256_update);
+strong_alias(sha256_final,	slurm_sha256_final);
+strong_alias(hmac_sha256_key,	slurm_hmac_sha256_key);
+strong_alias(hmac_sha256,	slurm_hmac_sha256);
+strong_alias(hmac_sha256_iov,	slurm_hmac_sha256_iov);
+strong_alias(hmac_compare,	slurm_hmac_compare);
+
+static const uint32_t k256[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)	(((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)	(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define S0(x)		(ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S1(x)		(ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define G0(x)		(ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define G1(x)		(ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+static void _compress(uint32_t state[8], const unsigned char *p)
+{
+	uint32_t w[64], a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+
+	for (i = 0; i < 16; i++, p += 4) {
+		w[i] = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+		       ((uint32_t) p[2] << 8)  |  (uint32_t) p[3];
+	}
+	for ( ; i < 64; i++)
+		w[i] = G1(w[i - 2]) + w[i - 7] + G0(w[i - 15]) + w[i - 16];
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+	for (i = 0; i < 64; i++) {
+		t1 = h + S1(e) + CH(e, f, g) + k256[i] + w[i];
+		t2 = S0(a) + MAJ(a, b, c);
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+extern void sha256_init(sha256_ctx_t *ctx)
+{
+	ctx->state[0] = 0x6a09e667;
+	ctx->state[1] = 0xbb67ae85;
+	ctx->state[2] = 0x3c6ef372;
+	ctx->state[3] = 0xa54ff53a;
+	ctx->state[4] = 0x510e527f;
+	ctx->state[5] = 0x9b05688c;
+	ctx->state[6] = 0x1f83d9ab;
+	ctx->state[7] = 0x5be0cd19;
+	ctx->length = 0;
+}
+
+extern void sha256_update(sha256_ctx_t *ctx, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t used = ctx->length % SHA256_BLOCK_LEN, n;
+
+	ctx->length += len;
+	if (used) {
+		n = MIN(len, SHA256_BLOCK_LEN - used);
+		memcpy(ctx->block + used, p, n);
+		p += n;
+		len -= n;
+		if ((used + n) < SHA256_BLOCK_LEN)
+			return;
+		_compress(ctx->state, ctx->block);
+	}
+	for ( ; len >= SHA256_BLOCK_LEN; len -= SHA256_BLOCK_LEN) {
+		_compress(ctx->state, p);
+		p += SHA256_BLOCK_LEN;
+	}
+	if (len)
+		memcpy(ctx->block, p, len);
+}
+
+extern void sha256_final(sha256_ctx_t *ctx,
+			 unsigned char digest[SHA256_DIGEST_LEN])
+{
+	size_t used = ctx->length % SHA256_BLOCK_LEN;
+	uint64_t bits = ctx->length * 8;
+	int i;
+
+	ctx->block[used++] = 0x80;
+	if (used > (SHA256_BLOCK_LEN - 8)) {
+		memset(ctx->block + used, 0, SHA256_BLOCK_LEN - used);
+		_compress(ctx->state, ctx->block);
+		used = 0;
+	}
+	memset(ctx->block + used, 0, SHA256_BLOCK_LEN - 8 - used);
+	for (i = 0; i < 8; i++)
+		ctx->block[SHA256_BLOCK_LEN - 1 - i] = bits >> (i * 8);
+	_compress(ctx->state, ctx->block);
+
+	for (i = 0; i < 8; i++) {
+		digest[i * 4]     = ctx->state[i] >> 24;
+		digest[i * 4 + 1] = ctx->state[i] >> 16;
+		digest[i * 4 + 2] = ctx->state[i] >> 8;
+		digest[i * 4 + 3] = ctx->state[i];
+	}
+}
+
+extern void hmac_sha256_key(hmac_sha256_key_t *key, const void *secret,
+			    size_t len)
+{
+	unsigned char pad[SHA256_BLOCK_LEN];
+	sha256_ctx_t ctx;
+	int i;
+
+	memset(pad, 0, sizeof(pad));
+	if (len > SHA256_BLOCK_LEN) {
+		sha256_init(&ctx);
+		sha256_update(&ctx, secret, len);
+		sha256_final(&ctx, pad);
+	} else
+		memcpy(pad, secret, len);
+
+	for (i = 0; i < SHA256_BLOCK_LEN; i++)
+		pad[i] ^= 0x36;
+	sha256_init(&key->inner);
+	sha256_update(&key->inner, pad, SHA256_BLOCK_LEN);
+
+	for (i = 0; i < SHA256_BLOCK_LEN; i++)
+		pad[i] ^= (0x36 ^ 0x5c);
+	sha256_init(&key->outer);
+	sha256_update(&key->outer, pad, SHA256_BLOCK_LEN);
+
+	memset(pad, 0, sizeof(pad));
+}
+
+extern void hmac_sha256(const hmac_sha256_key_t *key, const void *data,
+			size_t len, unsigned char mac[SHA256_DIGEST_LEN])
+{
+	sha256_ctx_t ctx;
+	unsigned char digest[SHA256_DIGEST_LEN];
+
+	ctx = key->inner;
+	sha256_update(&ctx, data, len);
+	sha256_final(&ctx, digest);
+
+	ctx = key->outer;
+	sha256_update(&ctx, digest, SHA256_DIGEST_LEN);
+	sha256_final(&ctx, mac);
+}
+
+extern void hmac_sha256_iov(const hmac_sha256_key_t *key,
+			    const struct iovec *iov, int iovcnt,
+			    unsigned char mac[SHA256_DIGEST_LEN])
+{
+	sha256_ctx_t ctx;
+	unsigned char digest[SHA256_DIGEST_LEN];
+	int i;
+
+	ctx = key->inner;
+	for (i = 0; i < iovcnt; i++)
+		sha256_update(&ctx, iov[i].iov_base, iov[i].iov_len);
+	sha256_final(&ctx, digest);
+
+	ctx = key->outer;
+	sha256_update(&ctx, digest, SHA256_DIGEST_LEN);
+	sha256_final(&ctx, mac);
+}
+
+extern int hmac_compare(const unsigned char *a, const unsigned char *b,
+			size_t len)
+{
+	unsigned char diff = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		diff |= a[i] ^ b[i];
+	return diff;
+}
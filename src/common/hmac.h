@@ -0,0 +1,97 @@
+/*****************************************************************************\
+ *  src/common/hmac.h - SHA-256 and HMAC-SHA256 message authentication
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HMAC_H
+#define _HMAC_H
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#if HAVE_INTTYPES_H
+#  include <inttypes.h>
+#else
+#  if HAVE_STDINT_H
+#    include <stdint.h>
+#  endif
+#endif
+
+#define SHA256_DIGEST_LEN	32
+#define SHA256_BLOCK_LEN	64
+
+typedef struct {
+	uint32_t state[8];
+	uint64_t length;			/* bytes hashed so far */
+	unsigned char block[SHA256_BLOCK_LEN];
+} sha256_ctx_t;
+
+/*
+ * An HMAC key with the inner and outer pads already hashed, so each MAC
+ * costs only the compression of the data plus two final blocks
+ */
+typedef struct {
+	sha256_ctx_t inner;
+	sha256_ctx_t outer;
+} hmac_sha256_key_t;
+
+extern void sha256_init(sha256_ctx_t *ctx);
+extern void sha256_update(sha256_ctx_t *ctx, const void *data, size_t len);
+extern void sha256_final(sha256_ctx_t *ctx,
+			 unsigned char digest[SHA256_DIGEST_LEN]);
+
+/* Prepare key for hmac_sha256() from secret of any length */
+extern void hmac_sha256_key(hmac_sha256_key_t *key, const void *secret,
+			    size_t len);
+
+/* Compute the HMAC-SHA256 (RFC 2104) of data under key */
+extern void hmac_sha256(const hmac_sha256_key_t *key, const void *data,
+			size_t len, unsigned char mac[SHA256_DIGEST_LEN]);
+
+/* Compute the HMAC-SHA256 of the iovcnt buffers of iov, in order */
+extern void hmac_sha256_iov(const hmac_sha256_key_t *key,
+			    const struct iovec *iov, int iovcnt,
+			    unsigned char mac[SHA256_DIGEST_LEN]);
+
+/*
+ * Compare len bytes of two MACs in time independent of where they differ
+ * RET 0 if equal
+ */
+extern int hmac_compare(const unsigned char *a, const unsigned char *b,
+			size_t len);
+
+#endif /* !_HMAC_H */
@@ -189,6 +189,11 @@ extern void * lsd_nomem_error(char *file, int line, char *mesg);
 /* max number of ranges that will be processed between brackets */
 #define MAX_RANGES   (12*1024)    /* 12K Ranges */
 
+/* a hostlist with at least this many ranges is indexed once it has been
+ * searched HOSTLIST_INDEX_LOOKUPS times without changing */
+#define HOSTLIST_INDEX_MIN     16
+#define HOSTLIST_INDEX_LOOKUPS 2
+
 /* size of internal hostname buffer (+ some slop), hostnames will probably
  * be truncated if longer than MAXHOSTNAMELEN */
 #ifndef MAXHOSTNAMELEN
@@ -252,6 +257,27 @@ struct hostlist {
 	/* list of iterators */
 	struct hostlist_iterator *ilist;
 
+	/* lookup index of hr[], NULL until built, dropped on any change */
+	struct hostlist_index *index;
+
+	/* searches since the last change */
+	int lookups;
+};
+
+/* An entry of the hostlist lookup index, one per range */
+struct hostlist_index_ent {
+	hostrange_t hr;
+	int range;		/* position of hr in hl->hr[] */
+	int group;		/* first entry with the same prefix */
+	unsigned long max_hi;	/* highest hi of this and earlier entries
+				 * in the group */
+};
+
+/* The hostlist lookup index: ranges ordered by prefix, then lo, so a host
+ * is found by binary search rather than a scan of every range */
+struct hostlist_index {
+	struct hostlist_index_ent *ent;
+	int *pos;		/* position of each range's first host */
 };
 
 
@@ -386,6 +412,10 @@ static void        hostlist_coalesce(hostlist_t hl);
 static void        hostlist_collapse(hostlist_t hl);
 static hostlist_t _hostlist_create(const char *, char *, char *, int);
 static void        hostlist_shift_iterators(hostlist_t, int, int, int);
+static void        hostlist_index_drop(hostlist_t);
+static int         hostlist_locate(hostlist_t, hostname_t, int *);
+static void        hostlist_delete_host_in_range(hostlist_t, int,
+						 unsigned long);
 static int        _attempt_range_join(hostlist_t, int);
 static int        _is_bracket_needed(hostlist_t, int);
 
@@ -1292,6 +1322,8 @@ static hostlist_t hostlist_new(void)
 	new->nranges = 0;
 	new->nhosts = 0;
 	new->ilist = NULL;
+	new->index = NULL;
+	new->lookups = 0;
 	return new;
 
 fail2:
@@ -1348,6 +1380,7 @@ static int hostlist_push_range(hostlist_t hl, hostrange_t hr)
 
 	assert(hr != NULL);
 	LOCK_HOSTLIST(hl);
+	hostlist_index_drop(hl);
 
 	tail = (hl->nranges > 0) ? hl->hr[hl->nranges-1] : hl->hr[0];
 
@@ -1411,6 +1444,8 @@ static int hostlist_insert_range(hostlist_t hl, hostrange_t hr, int n)
 	if (hl->size == hl->nranges && !hostlist_expand(hl))
 		return 0;
 
+	hostlist_index_drop(hl);
+
 	/* copy new hostrange into slot "n" in array */
 	tmp = hl->hr[n];
 	hl->hr[n] = hostrange_copy(hr);
@@ -1444,6 +1479,7 @@ static void hostlist_delete_range(hostlist_t hl, int n)
 	assert(hl->magic == HOSTLIST_MAGIC);
 	assert(n < hl->nranges && n >= 0);
 
+	hostlist_index_drop(hl);
 	old = hl->hr[n];
 	for (i = n; i < hl->nranges - 1; i++)
 		hl->hr[i] = hl->hr[i + 1];
@@ -1457,6 +1493,153 @@ static void hostlist_delete_range(hostlist_t hl, int n)
 	hostrange_destroy(old);
 }
 
+/* Order index entries by prefix, singlehost, lo and then list position */
+static int _index_ent_cmp(const void *x, const void *y)
+{
+	const struct hostlist_index_ent *e1 = x, *e2 = y;
+	int retval;
+
+	if ((retval = strcmp(e1->hr->prefix, e2->hr->prefix)))
+		return retval;
+	if (e1->hr->singlehost != e2->hr->singlehost)
+		return e1->hr->singlehost - e2->hr->singlehost;
+	if (e1->hr->lo != e2->hr->lo)
+		return (e1->hr->lo < e2->hr->lo) ? -1 : 1;
+	return e1->range - e2->range;
+}
+
+/* Build the lookup index of hl, leaving hl->index NULL if out of memory.
+ * Assumes the hostlist lock is already held.
+ */
+static void hostlist_index_build(hostlist_t hl)
+{
+	struct hostlist_index *index;
+	struct hostlist_index_ent *ent;
+	int i, count = 0;
+
+	if (!(index = malloc(sizeof(*index))))
+		return;
+	index->ent = malloc(hl->nranges * sizeof(*index->ent));
+	index->pos = malloc(hl->nranges * sizeof(int));
+	if (!index->ent || !index->pos) {
+		free(index->ent);
+		free(index->pos);
+		free(index);
+		return;
+	}
+
+	for (i = 0; i < hl->nranges; i++) {
+		index->ent[i].hr = hl->hr[i];
+		index->ent[i].range = i;
+		index->pos[i] = count;
+		count += hostrange_count(hl->hr[i]);
+	}
+	qsort(index->ent, hl->nranges, sizeof(*index->ent), &_index_ent_cmp);
+
+	for (i = 0, ent = index->ent; i < hl->nranges; i++, ent++) {
+		if (i && !strcmp(ent->hr->prefix, ent[-1].hr->prefix) &&
+		    (ent->hr->singlehost == ent[-1].hr->singlehost)) {
+			ent->group = ent[-1].group;
+			ent->max_hi = MAX(ent->hr->hi, ent[-1].max_hi);
+		} else {
+			ent->group = i;
+			ent->max_hi = ent->hr->hi;
+		}
+	}
+	hl->index = index;
+}
+
+/* Free the lookup index of hl, to be called on any change to its ranges.
+ * Assumes the hostlist lock is already held.
+ */
+static void hostlist_index_drop(hostlist_t hl)
+{
+	hl->lookups = 0;
+	if (!hl->index)
+		return;
+	free(hl->index->ent);
+	free(hl->index->pos);
+	free(hl->index);
+	hl->index = NULL;
+}
+
+/* Return the last index entry at or before prefix/singlehost/lo,
+ * or -1 if there is none in that group.
+ */
+static int _index_search(hostlist_t hl, const char *prefix, int singlehost,
+			 unsigned long lo)
+{
+	struct hostlist_index_ent *ent = hl->index->ent;
+	int first = 0, last = hl->nranges, mid, retval;
+
+	while (first < last) {
+		mid = (first + last) / 2;
+		if (!(retval = strcmp(ent[mid].hr->prefix, prefix)))
+			retval = ent[mid].hr->singlehost - singlehost;
+		if (!retval && (ent[mid].hr->lo > lo))
+			retval = 1;
+		if (retval > 0)
+			last = mid;
+		else
+			first = mid + 1;
+	}
+	if ((first == 0) || strcmp(ent[first - 1].hr->prefix, prefix) ||
+	    (ent[first - 1].hr->singlehost != singlehost))
+		return -1;
+	return first - 1;
+}
+
+/* Find the first range of hl holding host hn, indexing hl if it is
+ * searched repeatedly. Returns the range number, or -1 if hn is not in hl,
+ * and sets *pos (if not NULL) to the host's position in hl.
+ * Assumes the hostlist lock is already held.
+ */
+static int hostlist_locate(hostlist_t hl, hostname_t hn, int *pos)
+{
+	struct hostlist_index_ent *ent;
+	int i, group, count = 0, range = -1;
+
+	if (!hl->index && (hl->nranges >= HOSTLIST_INDEX_MIN) &&
+	    (++hl->lookups >= HOSTLIST_INDEX_LOOKUPS))
+		hostlist_index_build(hl);
+
+	if (!hl->index) {
+		for (i = 0, count = 0; i < hl->nranges; i++) {
+			if (hostrange_hn_within(hl->hr[i], hn)) {
+				range = i;
+				break;
+			}
+			count += hostrange_count(hl->hr[i]);
+		}
+	} else {
+		/* singlehost ranges are grouped by their full name */
+		if ((i = _index_search(hl, hn->hostname, 1, 0)) >= 0)
+			range = hl->index->ent[hl->index->ent[i].group].range;
+
+		/* a range holding hn starts at or before it, earlier ranges
+		 * are skipped once none in the group reach up to hn */
+		if (hostname_suffix_is_valid(hn) &&
+		    ((i = _index_search(hl, hn->prefix, 0, hn->num)) >= 0)) {
+			ent = hl->index->ent;
+			group = ent[i].group;
+			for ( ; (i >= group) && (ent[i].max_hi >= hn->num); i--) {
+				if (((range < 0) || (ent[i].range < range)) &&
+				    hostrange_hn_within(ent[i].hr, hn))
+					range = ent[i].range;
+			}
+		}
+		if (range >= 0)
+			count = hl->index->pos[range];
+	}
+
+	if ((range >= 0) && pos) {
+		*pos = count;
+		if (!hl->hr[range]->singlehost)
+			*pos += hn->num - hl->hr[range]->lo;
+	}
+	return range;
+}
+
 #if WANT_RECKLESS_HOSTRANGE_EXPANSION
 
 /* The reckless hostrange expansion function.
@@ -1941,6 +2124,7 @@ void hostlist_destroy(hostlist_t hl)
 	for (i = 0; i < hl->nranges; i++)
 		hostrange_destroy(hl->hr[i]);
 	free(hl->hr);
+	hostlist_index_drop(hl);
 	assert(hl->magic = 0x1);
 	UNLOCK_HOSTLIST(hl);
 	mutex_destroy(&hl->mutex);
@@ -2027,6 +2211,7 @@ char *hostlist_pop(hostlist_t hl)
 	LOCK_HOSTLIST(hl);
 	if (hl->nhosts > 0) {
 		hostrange_t hr = hl->hr[hl->nranges - 1];
+		hostlist_index_drop(hl);
 		host = hostrange_pop(hr);
 		hl->nhosts--;
 		if (hostrange_empty(hr)) {
@@ -2076,6 +2261,7 @@ char *hostlist_shift(hostlist_t hl)
 	if (hl->nhosts > 0) {
 		hostrange_t hr = hl->hr[0];
 
+		hostlist_index_drop(hl);
 		host = hostrange_shift(hr);
 		hl->nhosts--;
 
@@ -2107,6 +2293,7 @@ char *hostlist_pop_range(hostlist_t hl)
 		return NULL;
 	}
 
+	hostlist_index_drop(hl);
 	i = hl->nranges - 2;
 	tail = hl->hr[hl->nranges - 1];
 	while (i >= 0 && hostrange_within_range(tail, hl->hr[i]))
@@ -2143,6 +2330,7 @@ char *hostlist_shift_range(hostlist_t hl)
 		return NULL;
 	}
 
+	hostlist_index_drop(hl);
 	i = 0;
 	do {
 		hostlist_push_range(hltmp, hl->hr[i]);
@@ -2190,17 +2378,24 @@ int hostlist_delete(hostlist_t hl, const char *hosts)
 }
 
 
-/* XXX watch out! poor implementation follows! (fix it at some point) */
 int hostlist_delete_host(hostlist_t hl, const char *hostname)
 {
+	hostname_t hn;
 	int n;
 
 	if(!hl)
 		return -1;
-	n = hostlist_find(hl, hostname);
+	if (!hostname)
+		return 0;
+
+	hn = hostname_create(hostname);
+
+	LOCK_HOSTLIST(hl);
+	if ((n = hostlist_locate(hl, hn, NULL)) >= 0)
+		hostlist_delete_host_in_range(hl, n, hn->num);
+	UNLOCK_HOSTLIST(hl);
 
-	if (n >= 0)
-		hostlist_delete_nth(hl, n);
+	hostname_destroy(hn);
 	return n >= 0 ? 1 : 0;
 }
 
@@ -2275,32 +2470,40 @@ int hostlist_delete_nth(hostlist_t hl, int n)
 
 	for (i = 0; i < hl->nranges; i++) {
 		int num_in_range = hostrange_count(hl->hr[i]);
-		hostrange_t hr = hl->hr[i];
 
 		if (n <= (num_in_range - 1 + count)) {
-			unsigned long num = hr->lo + n - count;
-			hostrange_t new;
-
-			if (hr->singlehost) { /* this wasn't a range */
-				hostlist_delete_range(hl, i);
-			} else if ((new = hostrange_delete_host(hr, num))) {
-				hostlist_insert_range(hl, new, i + 1);
-				hostrange_destroy(new);
-			} else if (hostrange_empty(hr))
-				hostlist_delete_range(hl, i);
-
-			goto done;
+			hostlist_delete_host_in_range(hl, i,
+						      hl->hr[i]->lo + n - count);
+			break;
 		} else
 			count += num_in_range;
 
 	}
 
-done:
 	UNLOCK_HOSTLIST(hl);
-	hl->nhosts--;
 	return 1;
 }
 
+/* Delete host number num from range n of hl, which must hold it.
+ * Assumes the hostlist lock is already held.
+ */
+static void hostlist_delete_host_in_range(hostlist_t hl, int n,
+					  unsigned long num)
+{
+	hostrange_t hr = hl->hr[n];
+	hostrange_t new;
+
+	hostlist_index_drop(hl);
+	if (hr->singlehost) { /* this wasn't a range */
+		hostlist_delete_range(hl, n);
+	} else if ((new = hostrange_delete_host(hr, num))) {
+		hostlist_insert_range(hl, new, n + 1);
+		hostrange_destroy(new);
+	} else if (hostrange_empty(hr))
+		hostlist_delete_range(hl, n);
+	hl->nhosts--;
+}
+
 int hostlist_count(hostlist_t hl)
 {
 	int retval;
@@ -2315,7 +2518,7 @@ int hostlist_count(hostlist_t hl)
 
 int hostlist_find(hostlist_t hl, const char *hostname)
 {
-	int i, count, ret = -1;
+	int ret = -1;
 	hostname_t hn;
 
 	if (!hostname || !hl)
@@ -2324,19 +2527,7 @@ int hostlist_find(hostlist_t hl, const char *hostname)
 	hn = hostname_create(hostname);
 
 	LOCK_HOSTLIST(hl);
-
-	for (i = 0, count = 0; i < hl->nranges; i++) {
-		if (hostrange_hn_within(hl->hr[i], hn)) {
-			if (hostname_suffix_is_valid(hn))
-				ret = count + hn->num - hl->hr[i]->lo;
-			else
-				ret = count;
-			goto done;
-		} else
-			count += hostrange_count(hl->hr[i]);
-	}
-
-done:
+	hostlist_locate(hl, hn, &ret);
 	UNLOCK_HOSTLIST(hl);
 	hostname_destroy(hn);
 	return ret;
@@ -2363,6 +2554,7 @@ void hostlist_sort(hostlist_t hl)
 		return;
 	}
 
+	hostlist_index_drop(hl);
 	qsort(hl->hr, hl->nranges, sizeof(hostrange_t), &_cmp);
 
 	/* reset all iterators */
@@ -2391,6 +2583,7 @@ static void hostlist_collapse(hostlist_t hl)
 		if (hostrange_prefix_cmp(hprev, hnext) == 0 &&
 		    hprev->hi == hnext->lo - 1 &&
 		    hostrange_width_combine(hprev, hnext)) {
+			hostlist_index_drop(hl);
 			hprev->hi = hnext->hi;
 			hostlist_delete_range(hl, i);
 		}
@@ -2417,6 +2610,7 @@ static void hostlist_coalesce(hostlist_t hl)
 			hostrange_t hnext = hl->hr[i];
 			j = i;
 
+			hostlist_index_drop(hl);
 			if (new->hi < hprev->hi)
 				hnext->hi = hprev->hi;
 
@@ -2479,6 +2673,7 @@ void hostlist_uniq(hostlist_t hl)
 		UNLOCK_HOSTLIST(hl);
 		return;
 	}
+	hostlist_index_drop(hl);
 	qsort(hl->hr, hl->nranges, sizeof(hostrange_t), &_cmp);
 
 	while (i < hl->nranges) {
@@ -3346,6 +3541,7 @@ int hostlist_remove(hostlist_iterator_t i)
 	assert(i != NULL);
 	assert(i->magic == HOSTLIST_MAGIC);
 	LOCK_HOSTLIST(i->hl);
+	hostlist_index_drop(i->hl);
 	new = hostrange_delete_host(i->hr, i->hr->lo + i->depth);
 	if (new) {
 		hostlist_insert_range(i->hl, new, i->idx + 1);
@@ -3410,6 +3606,63 @@ void hostset_destroy(hostset_t set)
 	free(set);
 }
 
+/* return the position of the first range of a hostset not ordered before
+ * hr, or hl->nranges if there is none
+ * Assumes that the set->hl lock is already held
+ */
+static int hostset_find_range(hostset_t set, hostrange_t hr)
+{
+	hostlist_t hl = set->hl;
+	int first = 0, last = hl->nranges, mid;
+
+	/* the ranges of a hostset are sorted */
+	while (first < last) {
+		mid = (first + last) / 2;
+		if (hostrange_cmp(hr, hl->hr[mid]) <= 0)
+			last = mid;
+		else
+			first = mid + 1;
+	}
+	if ((first == 0) || (hostrange_cmp(hr, hl->hr[first - 1]) > 0))
+		return first;
+
+	/* ranges whose widths do not combine need not sort consistently */
+	for (first = 0; first < hl->nranges; first++) {
+		if (hostrange_cmp(hr, hl->hr[first]) <= 0)
+			break;
+	}
+	return first;
+}
+
+/* return the range of a hostset holding host hn, or -1 if there is none
+ * Assumes that the set->hl lock is already held
+ */
+static int hostset_locate(hostset_t set, hostname_t hn)
+{
+	hostlist_t hl = set->hl;
+	hostrange_t hr;
+	int i;
+
+	if (hostname_suffix_is_valid(hn))
+		hr = hostrange_create(hn->prefix, hn->num, hn->num,
+				      hostname_suffix_width(hn));
+	else
+		hr = hostrange_create_single(hn->hostname);
+	i = hostset_find_range(set, hr);
+	hostrange_destroy(hr);
+
+	/* the ranges of a hostset do not overlap, so the range found by
+	 * binary search is the only one that may hold hn */
+	if ((i < hl->nranges) && hostrange_hn_within(hl->hr[i], hn))
+		return i;
+	if ((i > 0) && hostrange_hn_within(hl->hr[i - 1], hn))
+		return i - 1;
+
+	/* hosts whose suffix widths differ from the set's can sort apart
+	 * from the range holding them */
+	return hostlist_locate(hl, hn, NULL);
+}
+
 /* inserts a single range object into a hostset
  * Assumes that the set->hl lock is already held
  * Updates hl->nhosts
@@ -3427,28 +3680,25 @@ static int hostset_insert_range(hostset_t set, hostrange_t hr)
 	if (hl->size == hl->nranges && !hostlist_expand(hl))
 		return 0;
 
+	hostlist_index_drop(hl);
 	nhosts = hostrange_count(hr);
 
-	for (i = 0; i < hl->nranges; i++) {
-		if (hostrange_cmp(hr, hl->hr[i]) <= 0) {
-
-			if ((ndups = hostrange_join(hr, hl->hr[i])) >= 0)
-				hostlist_delete_range(hl, i);
-			else if (ndups < 0)
-				ndups = 0;
+	if ((i = hostset_find_range(set, hr)) < hl->nranges) {
+		if ((ndups = hostrange_join(hr, hl->hr[i])) >= 0)
+			hostlist_delete_range(hl, i);
+		else if (ndups < 0)
+			ndups = 0;
 
-			hostlist_insert_range(hl, hr, i);
+		hostlist_insert_range(hl, hr, i);
 
-			/* now attempt to join hr[i] and hr[i-1] */
-			if (i > 0) {
-				int m;
-				if ((m = _attempt_range_join(hl, i)) > 0)
-					ndups += m;
-			}
-			hl->nhosts += nhosts - ndups;
-			inserted = 1;
-			break;
+		/* now attempt to join hr[i] and hr[i-1] */
+		if (i > 0) {
+			int m;
+			if ((m = _attempt_range_join(hl, i)) > 0)
+				ndups += m;
 		}
+		hl->nhosts += nhosts - ndups;
+		inserted = 1;
 	}
 
 	if (inserted == 0) {
@@ -3483,22 +3733,16 @@ int hostset_insert(hostset_t set, const char *hosts)
 }
 
 
-/* linear search through N ranges for hostname "host"
+/* search through N ranges for hostname "host"
  * */
 static int hostset_find_host(hostset_t set, const char *host)
 {
-	int i;
 	int retval = 0;
 	hostname_t hn;
 	LOCK_HOSTLIST(set->hl);
 	hn = hostname_create(host);
-	for (i = 0; i < set->hl->nranges; i++) {
-		if (hostrange_hn_within(set->hl->hr[i], hn)) {
-			retval = 1;
-			goto done;
-		}
-	}
-done:
+	if (hostset_locate(set, hn) >= 0)
+		retval = 1;
 	UNLOCK_HOSTLIST(set->hl);
 	hostname_destroy(hn);
 	return retval;
@@ -3551,14 +3795,41 @@ int hostset_within(hostset_t set, const char *hosts)
 	return (nhosts == nfound);
 }
 
-int hostset_delete(hostset_t set, const char *hosts)
+int hostset_delete_host(hostset_t set, const char *hostname)
 {
-	return hostlist_delete(set->hl, hosts);
+	hostname_t hn;
+	int n;
+
+	if (!hostname)
+		return 0;
+
+	hn = hostname_create(hostname);
+
+	LOCK_HOSTLIST(set->hl);
+	if ((n = hostset_locate(set, hn)) >= 0)
+		hostlist_delete_host_in_range(set->hl, n, hn->num);
+	UNLOCK_HOSTLIST(set->hl);
+
+	hostname_destroy(hn);
+	return n >= 0 ? 1 : 0;
 }
 
-int hostset_delete_host(hostset_t set, const char *hostname)
+int hostset_delete(hostset_t set, const char *hosts)
 {
-	return hostlist_delete_host(set->hl, hostname);
+	int n = 0;
+	char *hostname = NULL;
+	hostlist_t hltmp;
+
+	if (!(hltmp = hostlist_create(hosts)))
+		seterrno_ret(EINVAL, 0);
+
+	while ((hostname = hostlist_pop(hltmp)) != NULL) {
+		n += hostset_delete_host(set, hostname);
+		free(hostname);
+	}
+	hostlist_destroy(hltmp);
+
+	return n;
 }
 
 char *hostset_shift(hostset_t set)
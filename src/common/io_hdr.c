@@ -90,6 +90,33 @@ io_hdr_packed_size()
 	return sizeof(uint32_t) + 3*sizeof(uint16_t);
 }
 
+int
+io_node_init_packed_size(void)
+{
+	return 3*sizeof(uint32_t);
+}
+
+void
+io_node_init_pack(struct slurm_io_init_msg *msg, Buf buffer)
+{
+	pack32(msg->nodeid, buffer);
+	pack32(msg->stdout_objs, buffer);
+	pack32(msg->stderr_objs, buffer);
+}
+
+int
+io_node_init_unpack(struct slurm_io_init_msg *msg, Buf buffer)
+{
+	safe_unpack32(&msg->nodeid, buffer);
+	safe_unpack32(&msg->stdout_objs, buffer);
+	safe_unpack32(&msg->stderr_objs, buffer);
+	return SLURM_SUCCESS;
+
+    unpack_error:
+	error("io_node_init_unpack error: %m");
+	return SLURM_ERROR;
+}
+
 /*
  * Only return when the all of the bytes have been read, or an unignorable
  * error has occurred.
@@ -173,7 +200,7 @@ io_init_msg_validate(struct slurm_io_init_msg *msg, const char *sig)
 }
 
 
-static int
+int
 io_init_msg_packed_size(void)
 {
 	int len;
@@ -198,7 +225,7 @@ io_init_msg_pack(struct slurm_io_init_msg *hdr, Buf buffer)
 }
 
 
-static int
+int
 io_init_msg_unpack(struct slurm_io_init_msg *hdr, Buf buffer)
 {
 	uint32_t val;
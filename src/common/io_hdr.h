@@ -65,6 +65,9 @@
 #define SLURM_IO_STDERR 2
 #define SLURM_IO_ALLSTDIN 3
 #define SLURM_IO_CONNECTION_TEST 4
+#define SLURM_IO_NODE_INIT 5	/* a node's streams now arrive relayed on
+				 * this connection, body is packed by
+				 * io_node_init_pack() */
 
 struct slurm_io_init_msg {
 	uint16_t      version;
@@ -97,4 +100,19 @@ int io_init_msg_validate(struct slurm_io_init_msg *msg, const char *sig);
 int io_init_msg_write_to_fd(int fd, struct slurm_io_init_msg *msg);
 int io_init_msg_read_from_fd(int fd, struct slurm_io_init_msg *msg);
 
+/*
+ * For a reader collecting the io init msg itself without blocking:
+ * its packed size in bytes, and unpack it from a Buf
+ */
+int io_init_msg_packed_size(void);
+int io_init_msg_unpack(struct slurm_io_init_msg *msg, Buf buffer);
+
+/*
+ * Body of a SLURM_IO_NODE_INIT message: the nodeid, stdout_objs and
+ * stderr_objs of a relayed node's io init msg
+ */
+int io_node_init_packed_size(void);
+void io_node_init_pack(struct slurm_io_init_msg *msg, Buf buffer);
+int io_node_init_unpack(struct slurm_io_init_msg *msg, Buf buffer);
+
 #endif /* !_HAVE_IO_HDR_H */
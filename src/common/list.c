@@ -59,6 +59,7 @@
 ** for details.
  */
 strong_alias(list_create,	slurm_list_create);
+strong_alias(list_create_unlocked,	slurm_list_create_unlocked);
 strong_alias(list_destroy,	slurm_list_destroy);
 strong_alias(list_is_empty,	slurm_list_is_empty);
 strong_alias(list_count,	slurm_list_count);
@@ -147,6 +148,13 @@ strong_alias(list_install_fork_handlers, slurm_list_install_fork_handlers);
 #endif
 #define LIST_MAGIC 0xDEADBEEF
 
+/*  Each thread allocates from and frees to its own cache of free objects
+ *  without locking.  list_free_lock is only taken to move LIST_CACHE_BATCH
+ *  objects between a thread's cache and the global freelists, when the
+ *  cache runs empty or grows to twice that size, and when a thread exits.
+ */
+#define LIST_CACHE_BATCH 64
+
 
 /****************
  *  Data Types  *
@@ -175,6 +183,7 @@ struct list {
     int                   count;        /* number of nodes in list           */
 #ifdef WITH_PTHREADS
     pthread_mutex_t       mutex;        /* mutex to protect access to list   */
+    int                   unlocked;     /* true if confined to one thread    */
 #endif /* WITH_PTHREADS */
 #ifndef NDEBUG
     unsigned int          magic;        /* sentinel for asserting validity   */
@@ -183,6 +192,18 @@ struct list {
 
 typedef struct listNode * ListNode;
 
+typedef enum {
+    LIST_OBJ_LIST,
+    LIST_OBJ_NODE,
+    LIST_OBJ_ITERATOR,
+    LIST_OBJ_TYPES
+} list_obj_t;
+
+typedef struct listCache {
+    void                 *free[LIST_OBJ_TYPES];  /* free objects by type     */
+    int                   count[LIST_OBJ_TYPES]; /* objects in each list     */
+} * ListCache;
+
 
 /****************
  *  Prototypes  *
@@ -196,20 +217,27 @@ static ListNode list_node_alloc (void);
 static void list_node_free (ListNode p);
 static ListIterator list_iterator_alloc (void);
 static void list_iterator_free (ListIterator i);
-static void * list_alloc_aux (int size, void *pfreelist);
-static void list_free_aux (void *x, void *pfreelist);
+static void * list_alloc_aux (list_obj_t type);
+static void list_free_aux (void *x, list_obj_t type);
+static ListCache list_cache_get (void);
 
 
 /***************
  *  Variables  *
  ***************/
 
-static List list_free_lists = NULL;
-static ListNode list_free_nodes = NULL;
-static ListIterator list_free_iterators = NULL;
+static const int list_obj_size[LIST_OBJ_TYPES] = {
+    sizeof(struct list),
+    sizeof(struct listNode),
+    sizeof(struct listIterator)
+};
+static void *list_free_objs[LIST_OBJ_TYPES];
 
 #ifdef WITH_PTHREADS
 static pthread_mutex_t list_free_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t list_cache_key;
+static pthread_once_t list_cache_once = PTHREAD_ONCE_INIT;
+static int list_cache_ok = 0;
 #endif /* WITH_PTHREADS */
 
 
@@ -259,6 +287,21 @@ static pthread_mutex_t list_free_lock = PTHREAD_MUTEX_INITIALIZER;
 	 }                                                                    \
      } while (0)
 
+#  define list_lock(l)                                                        \
+     do {                                                                     \
+	 if (!(l)->unlocked)                                                  \
+	     list_mutex_lock(&(l)->mutex);                                    \
+     } while (0)
+
+#  define list_unlock(l)                                                      \
+     do {                                                                     \
+	 if (!(l)->unlocked)                                                  \
+	     list_mutex_unlock(&(l)->mutex);                                  \
+     } while (0)
+
+#  define list_is_locked(l)                                                   \
+     ((l)->unlocked || list_mutex_is_locked(&(l)->mutex))
+
 #  ifndef NDEBUG
      static int list_mutex_is_locked (pthread_mutex_t *mutex);
 #  endif /* !NDEBUG */
@@ -270,6 +313,9 @@ static pthread_mutex_t list_free_lock = PTHREAD_MUTEX_INITIALIZER;
 #  define list_mutex_unlock(mutex)
 #  define list_mutex_destroy(mutex)
 #  define list_mutex_is_locked(mutex) (1)
+#  define list_lock(l)
+#  define list_unlock(l)
+#  define list_is_locked(l) (1)
 
 #endif /* !WITH_PTHREADS */
 
@@ -291,11 +337,28 @@ list_create (ListDelF f)
     l->fDel = f;
     l->count = 0;
     list_mutex_init(&l->mutex);
+#ifdef WITH_PTHREADS
+    l->unlocked = 0;
+#endif /* WITH_PTHREADS */
     assert(l->magic = LIST_MAGIC);      /* set magic via assert abuse */
     return(l);
 }
 
 
+List
+list_create_unlocked (ListDelF f)
+{
+    List l;
+
+    if (!(l = list_create(f)))
+	return(NULL);
+#ifdef WITH_PTHREADS
+    l->unlocked = 1;
+#endif /* WITH_PTHREADS */
+    return(l);
+}
+
+
 void
 list_destroy (List l)
 {
@@ -303,7 +366,7 @@ list_destroy (List l)
     ListNode p, pTmp;
 
     assert(l != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     i = l->iNext;
     while (i) {
@@ -322,7 +385,7 @@ list_destroy (List l)
 	p = pTmp;
     }
     assert(l->magic = ~LIST_MAGIC);     /* clear magic via assert abuse */
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     list_mutex_destroy(&l->mutex);
     list_free(l);
     return;
@@ -335,10 +398,10 @@ list_is_empty (List l)
     int n;
 
     assert(l != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     n = l->count;
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(n == 0);
 }
 
@@ -349,10 +412,10 @@ list_count (List l)
     int n;
 
     assert(l != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     n = l->count;
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(n);
 }
 
@@ -364,10 +427,10 @@ list_append (List l, void *x)
 
     assert(l != NULL);
     assert(x != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     v = list_node_create(l, l->tail, x);
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -423,10 +486,10 @@ list_prepend (List l, void *x)
 
     assert(l != NULL);
     assert(x != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     v = list_node_create(l, &l->head, x);
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -440,7 +503,7 @@ list_find_first (List l, ListFindF f, void *key)
     assert(l != NULL);
     assert(f != NULL);
     assert(key != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     for (p=l->head; p; p=p->next) {
 	if (f(p->data, key)) {
@@ -448,7 +511,7 @@ list_find_first (List l, ListFindF f, void *key)
 	    break;
 	}
     }
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -462,7 +525,7 @@ list_delete_all (List l, ListFindF f, void *key)
 
     assert(l != NULL);
     assert(f != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     pp = &l->head;
     while (*pp) {
@@ -477,7 +540,7 @@ list_delete_all (List l, ListFindF f, void *key)
 	    pp = &(*pp)->next;
 	}
     }
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(n);
 }
 
@@ -490,7 +553,7 @@ list_for_each (List l, ListForF f, void *arg)
 
     assert(l != NULL);
     assert(f != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     for (p=l->head; p; p=p->next) {
 	n++;
@@ -499,7 +562,7 @@ list_for_each (List l, ListForF f, void *arg)
 	    break;
 	}
     }
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(n);
 }
 
@@ -512,7 +575,7 @@ list_flush (List l)
     int n = 0;
 
     assert(l != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     pp = &l->head;
     while (*pp) {
@@ -522,7 +585,7 @@ list_flush (List l)
 	    n++;
 	}
     }
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(n);
 }
 
@@ -537,7 +600,7 @@ list_sort (List l, ListCmpF f)
 
     assert(l != NULL);
     assert(f != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     if (l->count > 1) {
 	ppPrev = &l->head;
@@ -567,7 +630,7 @@ list_sort (List l, ListCmpF f)
 	    i->prev = &i->list->head;
 	}
     }
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return;
 }
 
@@ -578,10 +641,10 @@ list_push (List l, void *x)
 
     assert(l != NULL);
     assert(x != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     v = list_node_create(l, &l->head, x);
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -592,10 +655,10 @@ list_pop (List l)
     void *v;
 
     assert(l != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     v = list_node_destroy(l, &l->head);
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -607,7 +670,7 @@ list_pop_top (List l, ListCmpF f)
     ListNode *pp, *pTop;
     assert(l != NULL);
     assert(f != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     pTop = &l->head;
     if (*pTop) {
@@ -619,7 +682,7 @@ list_pop_top (List l, ListCmpF f)
         }
         v = list_node_destroy(l, pTop);
     }
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return (v);
 }
 
@@ -631,7 +694,7 @@ list_pop_bottom (List l, ListCmpF f)
     ListNode *pp, *pBottom;
     assert(l != NULL);
     assert(f != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     pBottom = &l->head;
     if (*pBottom) {
@@ -643,7 +706,7 @@ list_pop_bottom (List l, ListCmpF f)
         }
         v = list_node_destroy(l, pBottom);
     }
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return (v);
 }
 
@@ -653,10 +716,10 @@ list_peek (List l)
     void *v;
 
     assert(l != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     v = (l->head) ? l->head->data : NULL;
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -668,10 +731,10 @@ list_enqueue (List l, void *x)
 
     assert(l != NULL);
     assert(x != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     v = list_node_create(l, l->tail, x);
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -682,10 +745,10 @@ list_dequeue (List l)
     void *v;
 
     assert(l != NULL);
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     v = list_node_destroy(l, &l->head);
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(v);
 }
 
@@ -699,14 +762,14 @@ list_iterator_create (List l)
     if (!(i = list_iterator_alloc()))
 	return(lsd_nomem_error(__FILE__, __LINE__, "list iterator create"));
     i->list = l;
-    list_mutex_lock(&l->mutex);
+    list_lock(l);
     assert(l->magic == LIST_MAGIC);
     i->pos = l->head;
     i->prev = &l->head;
     i->iNext = l->iNext;
     l->iNext = i;
     assert(i->magic = LIST_MAGIC);      /* set magic via assert abuse */
-    list_mutex_unlock(&l->mutex);
+    list_unlock(l);
     return(i);
 }
 
@@ -716,11 +779,11 @@ list_iterator_reset (ListIterator i)
 {
     assert(i != NULL);
     assert(i->magic == LIST_MAGIC);
-    list_mutex_lock(&i->list->mutex);
+    list_lock(i->list);
     assert(i->list->magic == LIST_MAGIC);
     i->pos = i->list->head;
     i->prev = &i->list->head;
-    list_mutex_unlock(&i->list->mutex);
+    list_unlock(i->list);
     return;
 }
 
@@ -732,7 +795,7 @@ list_iterator_destroy (ListIterator i)
 
     assert(i != NULL);
     assert(i->magic == LIST_MAGIC);
-    list_mutex_lock(&i->list->mutex);
+    list_lock(i->list);
     assert(i->list->magic == LIST_MAGIC);
     for (pi=&i->list->iNext; *pi; pi=&(*pi)->iNext) {
 	assert((*pi)->magic == LIST_MAGIC);
@@ -741,7 +804,7 @@ list_iterator_destroy (ListIterator i)
 	    break;
 	}
     }
-    list_mutex_unlock(&i->list->mutex);
+    list_unlock(i->list);
     assert(i->magic = ~LIST_MAGIC);     /* clear magic via assert abuse */
     list_iterator_free(i);
     return;
@@ -755,13 +818,13 @@ list_next (ListIterator i)
 
     assert(i != NULL);
     assert(i->magic == LIST_MAGIC);
-    list_mutex_lock(&i->list->mutex);
+    list_lock(i->list);
     assert(i->list->magic == LIST_MAGIC);
     if ((p = i->pos))
 	i->pos = p->next;
     if (*i->prev != p)
 	i->prev = &(*i->prev)->next;
-    list_mutex_unlock(&i->list->mutex);
+    list_unlock(i->list);
     return(p ? p->data : NULL);
 }
 
@@ -774,10 +837,10 @@ list_insert (ListIterator i, void *x)
     assert(i != NULL);
     assert(x != NULL);
     assert(i->magic == LIST_MAGIC);
-    list_mutex_lock(&i->list->mutex);
+    list_lock(i->list);
     assert(i->list->magic == LIST_MAGIC);
     v = list_node_create(i->list, i->prev, x);
-    list_mutex_unlock(&i->list->mutex);
+    list_unlock(i->list);
     return(v);
 }
 
@@ -803,11 +866,11 @@ list_remove (ListIterator i)
 
     assert(i != NULL);
     assert(i->magic == LIST_MAGIC);
-    list_mutex_lock(&i->list->mutex);
+    list_lock(i->list);
     assert(i->list->magic == LIST_MAGIC);
     if (*i->prev != i->pos)
 	v = list_node_destroy(i->list, i->prev);
-    list_mutex_unlock(&i->list->mutex);
+    list_unlock(i->list);
     return(v);
 }
 
@@ -841,7 +904,7 @@ list_node_create (List l, ListNode *pp, void *x)
 
     assert(l != NULL);
     assert(l->magic == LIST_MAGIC);
-    assert(list_mutex_is_locked(&l->mutex));
+    assert(list_is_locked(l));
     assert(pp != NULL);
     assert(x != NULL);
     if (!(p = list_node_alloc()))
@@ -878,7 +941,7 @@ list_node_destroy (List l, ListNode *pp)
 
     assert(l != NULL);
     assert(l->magic == LIST_MAGIC);
-    assert(list_mutex_is_locked(&l->mutex));
+    assert(list_is_locked(l));
     assert(pp != NULL);
     if (!(p = *pp))
 	return(NULL);
@@ -902,14 +965,14 @@ list_node_destroy (List l, ListNode *pp)
 static List
 list_alloc (void)
 {
-    return(list_alloc_aux(sizeof(struct list), &list_free_lists));
+    return(list_alloc_aux(LIST_OBJ_LIST));
 }
 
 
 static void
 list_free (List l)
 {
-    list_free_aux(l, &list_free_lists);
+    list_free_aux(l, LIST_OBJ_LIST);
     return;
 }
 
@@ -917,14 +980,14 @@ list_free (List l)
 static ListNode
 list_node_alloc (void)
 {
-    return(list_alloc_aux(sizeof(struct listNode), &list_free_nodes));
+    return(list_alloc_aux(LIST_OBJ_NODE));
 }
 
 
 static void
 list_node_free (ListNode p)
 {
-    list_free_aux(p, &list_free_nodes);
+    list_free_aux(p, LIST_OBJ_NODE);
     return;
 }
 
@@ -932,45 +995,175 @@ list_node_free (ListNode p)
 static ListIterator
 list_iterator_alloc (void)
 {
-    return(list_alloc_aux(sizeof(struct listIterator), &list_free_iterators));
+    return(list_alloc_aux(LIST_OBJ_ITERATOR));
 }
 
 
 static void
 list_iterator_free (ListIterator i)
 {
-    list_free_aux(i, &list_free_iterators);
+    list_free_aux(i, LIST_OBJ_ITERATOR);
     return;
 }
 
 
 static void *
-list_alloc_aux (int size, void *pfreelist)
+list_chunk_alloc (int size)
 {
-/*  Allocates an object of [size] bytes from the freelist [*pfreelist].
- *  Memory is added to the freelist in chunks of size LIST_ALLOC.
- *  Returns a ptr to the object, or NULL if the memory request fails.
+/*  Allocates a chunk of LIST_ALLOC objects of [size] bytes, chained into
+ *    a freelist.
+ *  Returns a ptr to the first object, or NULL if the memory request fails.
  */
     void **px;
-    void **pfree = pfreelist;
     void **plast;
+    void *chunk;
 
-    assert(sizeof(char) == 1);
-    assert(size >= sizeof(void *));
-    assert(pfreelist != NULL);
-    assert(LIST_ALLOC > 0);
+    if (!(chunk = xmalloc(LIST_ALLOC * size)))
+	return(NULL);
+    px = chunk;
+    plast = (void **) ((char *) chunk + ((LIST_ALLOC - 1) * size));
+    while (px < plast)
+	*px = (char *) px + size, px = *px;
+    *plast = NULL;
+    return(chunk);
+}
+
+
+static void
+list_cache_fill (ListCache c, list_obj_t type)
+{
+/*  Moves up to LIST_CACHE_BATCH objects of [type] from the global freelist
+ *    to the empty cache [c], or a new chunk if the freelist is empty.
+ */
+    void **px;
+    int n = 0;
+
+    assert(c->free[type] == NULL);
     list_mutex_lock(&list_free_lock);
-    if (!*pfree) {
-	if ((*pfree = xmalloc(LIST_ALLOC * size))) {
-	    px = *pfree;
-	    plast = (void **) ((char *) *pfree + ((LIST_ALLOC - 1) * size));
-	    while (px < plast)
-		*px = (char *) px + size, px = *px;
-	    *plast = NULL;
+    if ((px = list_free_objs[type])) {
+	c->free[type] = px;
+	for (n = 1; (n < LIST_CACHE_BATCH) && *px; n++)
+	    px = *px;
+	list_free_objs[type] = *px;
+	*px = NULL;
+    }
+    list_mutex_unlock(&list_free_lock);
+    if (n == 0) {
+	if ((c->free[type] = list_chunk_alloc(list_obj_size[type])))
+	    n = LIST_ALLOC;
+    }
+    c->count[type] = n;
+    return;
+}
+
+
+static void
+list_cache_drain (ListCache c, list_obj_t type, int n)
+{
+/*  Returns [n] objects of [type] from cache [c] to the global freelist.
+ */
+    void **pfirst, **plast;
+    int i;
+
+    assert((n > 0) && (n <= c->count[type]));
+    pfirst = plast = c->free[type];
+    for (i = 1; i < n; i++)
+	plast = *plast;
+    c->free[type] = *plast;
+    c->count[type] -= n;
+    list_mutex_lock(&list_free_lock);
+    *plast = list_free_objs[type];
+    list_free_objs[type] = pfirst;
+    list_mutex_unlock(&list_free_lock);
+    return;
+}
+
+
+#ifdef WITH_PTHREADS
+static void
+list_cache_destroy (void *arg)
+{
+/*  Returns the objects cached by an exiting thread to the global freelists.
+ */
+    ListCache c = arg;
+    int type;
+
+    for (type = 0; type < LIST_OBJ_TYPES; type++) {
+	if (c->count[type])
+	    list_cache_drain(c, type, c->count[type]);
+    }
+    xfree(c);
+    return;
+}
+
+
+static void
+list_cache_init (void)
+{
+    if (pthread_key_create(&list_cache_key, list_cache_destroy) == 0)
+	list_cache_ok = 1;
+    return;
+}
+#endif /* WITH_PTHREADS */
+
+
+static ListCache
+list_cache_get (void)
+{
+/*  Returns the calling thread's cache, or NULL if objects must be taken
+ *    from the global freelists directly.
+ */
+#ifdef WITH_PTHREADS
+    ListCache c;
+
+    pthread_once(&list_cache_once, list_cache_init);
+    if (!list_cache_ok)
+	return(NULL);
+    if (!(c = pthread_getspecific(list_cache_key))) {
+	if (!(c = xmalloc(sizeof(*c))))
+	    return(NULL);
+	if (pthread_setspecific(list_cache_key, c) != 0) {
+	    xfree(c);
+	    return(NULL);
 	}
     }
-    if ((px = *pfree))
-	*pfree = *px;
+    return(c);
+#else
+    return(NULL);
+#endif
+}
+
+
+static void *
+list_alloc_aux (list_obj_t type)
+{
+/*  Allocates an object of [type] from the calling thread's cache, or the
+ *    global freelist if the thread has no cache.
+ *  Memory is added to the freelists in chunks of size LIST_ALLOC.
+ *  Returns a ptr to the object, or NULL if the memory request fails.
+ */
+    void **px;
+    ListCache c;
+
+    assert(sizeof(char) == 1);
+    assert(list_obj_size[type] >= sizeof(void *));
+    assert(LIST_ALLOC > 0);
+    if ((c = list_cache_get())) {
+	if (!c->free[type])
+	    list_cache_fill(c, type);
+	if ((px = c->free[type])) {
+	    c->free[type] = *px;
+	    c->count[type]--;
+	} else
+	    errno = ENOMEM;
+	return(px);
+    }
+
+    list_mutex_lock(&list_free_lock);
+    if (!list_free_objs[type])
+	list_free_objs[type] = list_chunk_alloc(list_obj_size[type]);
+    if ((px = list_free_objs[type]))
+	list_free_objs[type] = *px;
     else
 	errno = ENOMEM;
     list_mutex_unlock(&list_free_lock);
@@ -979,21 +1172,29 @@ list_alloc_aux (int size, void *pfreelist)
 
 
 static void
-list_free_aux (void *x, void *pfreelist)
+list_free_aux (void *x, list_obj_t type)
 {
-/*  Frees the object [x], returning it to the freelist [*pfreelist].
+/*  Frees the object [x], returning it to the calling thread's cache or
+ *    the global freelist.
  */
 #ifdef MEMORY_LEAK_DEBUG
     xfree(x);
 #else
     void **px = x;
-    void **pfree = pfreelist;
+    ListCache c;
 
     assert(x != NULL);
-    assert(pfreelist != NULL);
+    if ((c = list_cache_get())) {
+	*px = c->free[type];
+	c->free[type] = px;
+	if (++c->count[type] >= (LIST_CACHE_BATCH * 2))
+	    list_cache_drain(c, type, LIST_CACHE_BATCH);
+	return;
+    }
+
     list_mutex_lock(&list_free_lock);
-    *px = *pfree;
-    *pfree = px;
+    *px = list_free_objs[type];
+    list_free_objs[type] = px;
     list_mutex_unlock(&list_free_lock);
 #endif
     return;
@@ -126,6 +126,13 @@ List list_create (ListDelF f);
  *    in a memory leak.
  */
 
+List list_create_unlocked (ListDelF f);
+/*
+ *  Creates and returns a new empty list, or lsd_nomem_error() on failure,
+ *    as list_create() does.  The list's mutex is never taken, so the list
+ *    and its iterators must only be used by one thread at a time.
+ */
+
 void list_destroy (List l);
 /*
  *  Destroys list [l], freeing memory used for list iterators and the
@@ -0,0 +1,225 @@
+/*****************************************************************************\
+ *  src/common/lz_compress.c - fast LZ77 block compression
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "src/common/lz_compress.h"
+
+#define LZ_HASH_BITS	12
+#define LZ_MIN_MATCH	4
+#define LZ_MAX_OFFSET	0xffff
+#define LZ_RUN_MASK	0xf
+
+static inline uint32_t _read32(const unsigned char *p)
+{
+	uint32_t val;
+
+	memcpy(&val, p, sizeof(uint32_t));
+	return val;
+}
+
+static inline uint32_t _hash(uint32_t val)
+{
+	return (val * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/* Append the extension bytes for a run length of 15 or more */
+static inline unsigned char *_put_len(unsigned char *op, uint32_t len)
+{
+	for (len -= LZ_RUN_MASK; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = (unsigned char) len;
+	return op;
+}
+
+/*
+ * Emit one sequence: lit_len literal bytes from lit, then (if match_len is
+ * non-zero) a back-reference of match_len bytes at the given offset.
+ * RET the new output position or NULL if the sequence does not fit
+ */
+static unsigned char *_put_seq(unsigned char *op, unsigned char *oend,
+			       const unsigned char *lit, uint32_t lit_len,
+			       uint32_t offset, uint32_t match_len)
+{
+	unsigned char *token;
+	uint32_t need;
+
+	need = 1 + lit_len + (lit_len / 255) + 1;
+	if (match_len)
+		need += 2 + (match_len / 255) + 1;
+	if ((oend - op) < need)
+		return NULL;
+
+	token = op++;
+	if (lit_len >= LZ_RUN_MASK) {
+		*token = LZ_RUN_MASK << 4;
+		op = _put_len(op, lit_len);
+	} else
+		*token = lit_len << 4;
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+
+	if (match_len == 0)
+		return op;
+
+	*op++ = offset & 0xff;
+	*op++ = offset >> 8;
+	match_len -= LZ_MIN_MATCH;
+	if (match_len >= LZ_RUN_MASK) {
+		*token |= LZ_RUN_MASK;
+		op = _put_len(op, match_len);
+	} else
+		*token |= match_len;
+	return op;
+}
+
+extern uint32_t lz_compress(const char *src, uint32_t src_len,
+			    char *dst, uint32_t dst_size)
+{
+	uint32_t table[1 << LZ_HASH_BITS];
+	const unsigned char *base = (const unsigned char *) src;
+	const unsigned char *ip = base, *anchor = base;
+	const unsigned char *iend = base + src_len;
+	const unsigned char *ilimit, *ref;
+	unsigned char *op = (unsigned char *) dst;
+	unsigned char *oend = op + dst_size;
+	uint32_t seq, h, match_len;
+
+	memset(table, 0, sizeof(table));
+	ilimit = (src_len > LZ_MIN_MATCH) ? (iend - LZ_MIN_MATCH) : base;
+
+	while (ip < ilimit) {
+		seq = _read32(ip);
+		h = _hash(seq);
+		ref = base + table[h];
+		table[h] = ip - base;
+		if ((ref >= ip) || ((ip - ref) > LZ_MAX_OFFSET) ||
+		    (_read32(ref) != seq)) {
+			ip++;
+			continue;
+		}
+
+		match_len = LZ_MIN_MATCH;
+		while (((ip + match_len) < iend) &&
+		       (ref[match_len] == ip[match_len]))
+			match_len++;
+
+		op = _put_seq(op, oend, anchor, ip - anchor,
+			      ip - ref, match_len);
+		if (op == NULL)
+			return 0;
+		ip += match_len;
+		anchor = ip;
+	}
+
+	/* The final sequence carries the trailing literals and no match */
+	op = _put_seq(op, oend, anchor, iend - anchor, 0, 0);
+	if (op == NULL)
+		return 0;
+	return op - (unsigned char *) dst;
+}
+
+/* Read a run length continued in extension bytes, RET -1 on overrun */
+static inline int _get_len(const unsigned char **ipp,
+			   const unsigned char *iend, uint32_t *len)
+{
+	const unsigned char *ip = *ipp;
+	unsigned char c;
+
+	do {
+		if (ip >= iend)
+			return -1;
+		c = *ip++;
+		*len += c;
+	} while (c == 255);
+	*ipp = ip;
+	return 0;
+}
+
+extern int lz_decompress(const char *src, uint32_t src_len,
+			 char *dst, uint32_t dst_size)
+{
+	const unsigned char *ip = (const unsigned char *) src;
+	const unsigned char *iend = ip + src_len;
+	unsigned char *op = (unsigned char *) dst;
+	unsigned char *oend = op + dst_size;
+	const unsigned char *ref;
+	uint32_t token, len, offset;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		len = token >> 4;
+		if ((len == LZ_RUN_MASK) && _get_len(&ip, iend, &len))
+			return -1;
+		if (((iend - ip) < len) || ((oend - op) < len))
+			return -1;
+		memcpy(op, ip, len);
+		ip += len;
+		op += len;
+		if (ip == iend)
+			break;	/* final sequence has no match */
+
+		if ((iend - ip) < 2)
+			return -1;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if ((offset == 0) || (offset > (op - (unsigned char *) dst)))
+			return -1;
+		len = token & LZ_RUN_MASK;
+		if ((len == LZ_RUN_MASK) && _get_len(&ip, iend, &len))
+			return -1;
+		len += LZ_MIN_MATCH;
+		if ((oend - op) < len)
+			return -1;
+
+		ref = op - offset;
+		if (offset >= len) {
+			memcpy(op, ref, len);
+			op += len;
+		} else {
+			/* overlapping copy repeats the pattern */
+			while (len--)
+				*op++ = *ref++;
+		}
+	}
+
+	return op - (unsigned char *) dst;
+}
@@ -0,0 +1,79 @@
+/*****************************************************************************\
+ *  src/common/lz_compress.h - fast LZ77 block compression
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _LZ_COMPRESS_H
+#define _LZ_COMPRESS_H
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if HAVE_INTTYPES_H
+#  include <inttypes.h>
+#else
+#  if HAVE_STDINT_H
+#    include <stdint.h>
+#  endif
+#endif
+
+/* Compression types carried in messages */
+#define COMPRESS_OFF	0
+#define COMPRESS_LZ	1
+
+/*
+ * A byte-oriented LZ77 encoding in the style of LZ4: sequences of literal
+ * runs followed by back-references into the previous 64KB of data. It
+ * favors speed over ratio, so it is suitable for compressing data on the
+ * fly before it is sent over the network.
+ */
+
+/*
+ * Compress src_len bytes from src into dst, which has room for dst_size bytes.
+ * RET length of the compressed data, or 0 if it will not fit in dst_size
+ */
+extern uint32_t lz_compress(const char *src, uint32_t src_len,
+			    char *dst, uint32_t dst_size);
+
+/*
+ * Expand src_len bytes of lz_compress() output from src into dst, which has
+ * room for dst_size bytes.
+ * RET length of the expanded data, or -1 if src is malformed or the expanded
+ * data will not fit in dst_size
+ */
+extern int lz_decompress(const char *src, uint32_t src_len,
+			 char *dst, uint32_t dst_size);
+
+#endif /* !_LZ_COMPRESS_H */
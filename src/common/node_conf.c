@@ -445,7 +445,7 @@ char * bitmap2node_name (bitstr_t *bitmap)
 	for (i = first; i <= last; i++) {
 		if (bit_test(bitmap, i) == 0)
 			continue;
-		hostlist_push(hl, node_record_table_ptr[i].name);
+		hostlist_push_host(hl, node_record_table_ptr[i].name);
 	}
 	hostlist_uniq(hl);
 	buf = hostlist_ranged_string_xmalloc(hl);
@@ -841,6 +841,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
+	hostlist_iterator_t host_itr;
 
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	if (my_bitmap == NULL)
@@ -860,7 +861,9 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
+	/* walk the ranges rather than shift them off the front of the list */
+	host_itr = hostlist_iterator_create (host_list);
+	while ( (this_node_name = hostlist_next (host_itr)) ) {
 		struct node_record *node_ptr;
 		node_ptr = find_node_record (this_node_name);
 		if (node_ptr) {
@@ -874,6 +877,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		}
 		free (this_node_name);
 	}
+	hostlist_iterator_destroy (host_itr);
 	hostlist_destroy (host_list);
 
 	return rc;
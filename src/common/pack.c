@@ -1,6 +1,7 @@
 /****************************************************************************\
  *  pack.c - lowest level un/pack functions
- *  NOTE: The memory buffer will expand as needed using xrealloc()
+ *  NOTE: The memory buffer will expand as needed using xrealloc(), at
+ *  least doubling in size so that a large buffer is only moved a few times
  *****************************************************************************
  *  Copyright (C) 2002-2007 The Regents of the University of California.
  *  Copyright (C) 2008 Lawrence Livermore National Security.
@@ -46,6 +47,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <string.h>
 #include <time.h>
 #include <inttypes.h>
@@ -63,6 +65,33 @@
 #define MAX_PACK_MEM_LEN	(16 * 1024 * 1024)
 #define MAX_PACK_STR_LEN	(16 * 1024 * 1024)
 
+/* Buffers kept by free_pool_buf() for reuse by init_pool_buf(). Larger
+ * buffers are freed rather than held by an idle daemon. */
+#define BUF_POOL_CNT		16
+#define BUF_POOL_MAX_SIZE	(BUF_SIZE * 4)
+
+/* A string packed compactly is added to a table of the buffer, a later
+ * copy being packed as its index in the table. Both sides add every
+ * literal of STRTAB_MIN_LEN to STRTAB_MAX_LEN bytes until the table holds
+ * STRTAB_MAX_CNT strings. */
+#define STRTAB_MIN_LEN		3
+#define STRTAB_MAX_LEN		1024
+#define STRTAB_MAX_CNT		(256 * 1024)
+
+struct pack_compact {
+	uint32_t *str_off;	/* offset of each string in the buffer */
+	uint32_t *str_len;	/* and its length */
+	uint32_t str_cnt;
+	uint32_t str_size;	/* entries allocated in str_off and str_len */
+	uint32_t *hash;		/* packing only, table index + 1 or 0 */
+	uint32_t hash_size;	/* a power of two */
+	uint64_t last_time;	/* last non-zero time packed or unpacked */
+};
+
+static Buf buf_pool[BUF_POOL_CNT];
+static int buf_pool_cnt = 0;
+static pthread_mutex_t buf_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
  * for details.
@@ -71,6 +100,9 @@ strong_alias(create_buf,	slurm_create_buf);
 strong_alias(free_buf,		slurm_free_buf);
 strong_alias(grow_buf,		slurm_grow_buf);
 strong_alias(init_buf,		slurm_init_buf);
+strong_alias(init_pool_buf,	slurm_init_pool_buf);
+strong_alias(free_pool_buf,	slurm_free_pool_buf);
+strong_alias(set_buf_compact,	slurm_set_buf_compact);
 strong_alias(xfer_buf_data,	slurm_xfer_buf_data);
 strong_alias(pack_time,		slurm_pack_time);
 strong_alias(unpack_time,	slurm_unpack_time);
@@ -124,6 +156,7 @@ Buf create_buf(char *data, int size)
 void free_buf(Buf my_buf)
 {
 	assert(my_buf->magic == BUF_MAGIC);
+	set_buf_compact(my_buf, false);
 	xfree(my_buf->head);
 	xfree(my_buf);
 }
@@ -140,6 +173,33 @@ void grow_buf (Buf buffer, int size)
 	xrealloc(buffer->head, buffer->size);
 }
 
+/* Grow a buffer so that need more bytes fit after its offset. The size at
+ * least doubles, so packing N bytes costs O(log N) reallocs rather than
+ * one per BUF_SIZE. RET SLURM_ERROR if the buffer would get too large. */
+static int _expand_buf(Buf buffer, uint32_t need, const char *caller)
+{
+	uint64_t size;
+
+	if (need > (MAX_BUF_SIZE - buffer->processed)) {
+		error("%s: buffer size too large", caller);
+		return SLURM_ERROR;
+	}
+
+	size = MAX((uint64_t) buffer->size * 2, BUF_SIZE);
+	size = MAX(size, (uint64_t) buffer->processed + need);
+	buffer->size = MIN(size, MAX_BUF_SIZE);
+	xrealloc(buffer->head, buffer->size);
+	return SLURM_SUCCESS;
+}
+
+/* Make room for need more bytes in the buffer, RET SLURM_ERROR on failure */
+static inline int _reserve_buf(Buf buffer, uint32_t need, const char *caller)
+{
+	if (remaining_buf(buffer) >= need)
+		return SLURM_SUCCESS;
+	return _expand_buf(buffer, need, caller);
+}
+
 /* init_buf - create an empty buffer of the given size */
 Buf init_buf(int size)
 {
@@ -166,11 +226,306 @@ void *xfer_buf_data(Buf my_buf)
 	void *data_ptr;
 
 	assert(my_buf->magic == BUF_MAGIC);
+	set_buf_compact(my_buf, false);
 	data_ptr = (void *) my_buf->head;
 	xfree(my_buf);
 	return data_ptr;
 }
 
+/* init_pool_buf - return an empty buffer of at least BUF_SIZE bytes,
+ * reusing one released by free_pool_buf() if possible. Unlike init_buf()
+ * the contents are not zeroed, only what has been packed may be read. */
+Buf init_pool_buf(void)
+{
+	Buf my_buf = NULL;
+
+	slurm_mutex_lock(&buf_pool_lock);
+	if (buf_pool_cnt > 0)
+		my_buf = buf_pool[--buf_pool_cnt];
+	slurm_mutex_unlock(&buf_pool_lock);
+
+	if (my_buf == NULL)
+		return init_buf(BUF_SIZE);
+	my_buf->processed = 0;
+	return my_buf;
+}
+
+/* free_pool_buf - release a buffer, keeping it for reuse by
+ * init_pool_buf() unless the pool is full or the buffer is large */
+void free_pool_buf(Buf my_buf)
+{
+	assert(my_buf->magic == BUF_MAGIC);
+	set_buf_compact(my_buf, false);
+	if ((my_buf->size >= BUF_SIZE) && (my_buf->size <= BUF_POOL_MAX_SIZE)) {
+		slurm_mutex_lock(&buf_pool_lock);
+		if (buf_pool_cnt < BUF_POOL_CNT) {
+			buf_pool[buf_pool_cnt++] = my_buf;
+			my_buf = NULL;
+		}
+		slurm_mutex_unlock(&buf_pool_lock);
+	}
+	if (my_buf)
+		free_buf(my_buf);
+}
+
+/* set_buf_compact - pack (or unpack) what follows the buffer's offset
+ * compactly, or from now on at full width. Compact integers are varints
+ * and compact strings already in the buffer are references to their first
+ * copy. Anything to be repacked in place must come before. */
+void set_buf_compact(Buf my_buf, bool compact)
+{
+	struct pack_compact *c = my_buf->compact;
+
+	if (compact && !c) {
+		my_buf->compact = xmalloc(sizeof(struct pack_compact));
+	} else if (!compact && c) {
+		xfree(c->str_off);
+		xfree(c->str_len);
+		xfree(c->hash);
+		xfree(c);
+		my_buf->compact = NULL;
+	}
+}
+
+/* Pack val seven bits per byte, low bits first, the high bit of each byte
+ * but the last set */
+static inline void _pack_varint(uint64_t val, Buf buffer,
+				const char *caller)
+{
+	char *p;
+
+	if (_reserve_buf(buffer, 10, caller))
+		return;
+
+	p = &buffer->head[buffer->processed];
+	if (val < 0x80) {	/* most values */
+		*p = val;
+		buffer->processed++;
+		return;
+	}
+	while (val >= 0x80) {
+		*p++ = (val & 0x7f) | 0x80;
+		val >>= 7;
+	}
+	*p++ = val;
+	buffer->processed = p - buffer->head;
+}
+
+static inline int _unpack_varint(uint64_t *valp, Buf buffer)
+{
+	uint64_t val = 0;
+	unsigned char c;
+	int shift = 0;
+
+	if ((remaining_buf(buffer) >= 1) &&
+	    !(buffer->head[buffer->processed] & 0x80)) {
+		*valp = (unsigned char) buffer->head[buffer->processed++];
+		return SLURM_SUCCESS;
+	}
+	do {
+		if ((remaining_buf(buffer) < 1) || (shift > 63))
+			return SLURM_ERROR;
+		c = buffer->head[buffer->processed++];
+		val |= (uint64_t) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	*valp = val;
+	return SLURM_SUCCESS;
+}
+
+/* Times are packed compactly as the difference from the last one, zigzag
+ * encoded so that small negative differences are small too. A time of
+ * zero, common for times not yet reached, is packed as 0. */
+static void _pack_time_compact(time_t val, Buf buffer)
+{
+	struct pack_compact *c = buffer->compact;
+	uint64_t delta;
+
+	if (val == 0) {
+		_pack_varint(0, buffer, "pack_time");
+		return;
+	}
+	delta = (uint64_t) val - c->last_time;
+	c->last_time = (uint64_t) val;
+	_pack_varint(((delta << 1) ^ (uint64_t) ((int64_t) delta >> 63)) + 1,
+		     buffer, "pack_time");
+}
+
+static int _unpack_time_compact(time_t *valp, Buf buffer)
+{
+	struct pack_compact *c = buffer->compact;
+	uint64_t val;
+
+	if (_unpack_varint(&val, buffer))
+		return SLURM_ERROR;
+	if (val == 0) {
+		*valp = 0;
+		return SLURM_SUCCESS;
+	}
+	val--;
+	c->last_time += (val >> 1) ^ (~(val & 1) + 1);
+	*valp = (time_t) c->last_time;
+	return SLURM_SUCCESS;
+}
+
+/* Hash eight bytes at a time, strings are mostly short names */
+static inline uint32_t _strtab_hash(char *valp, uint32_t size_val)
+{
+	uint64_t word, hash = size_val;
+
+	while (size_val >= 8) {
+		memcpy(&word, valp, 8);
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+		hash ^= hash >> 29;
+		valp += 8;
+		size_val -= 8;
+	}
+	if (size_val) {
+		word = 0;
+		memcpy(&word, valp, size_val);
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+	}
+	hash ^= hash >> 32;
+	return (uint32_t) hash;
+}
+
+/* Put string inx of the table in the hash of a buffer being packed */
+static void _strtab_hash_add(Buf buffer, uint32_t inx)
+{
+	struct pack_compact *c = buffer->compact;
+	uint32_t h;
+
+	h = _strtab_hash(&buffer->head[c->str_off[inx]], c->str_len[inx]);
+	h &= (c->hash_size - 1);
+	while (c->hash[h])
+		h = (h + 1) & (c->hash_size - 1);
+	c->hash[h] = inx + 1;
+}
+
+/* Add the string of size_val bytes at offset off of the buffer to its
+ * table, if the table takes it */
+static void _strtab_add(Buf buffer, uint32_t off, uint32_t size_val)
+{
+	struct pack_compact *c = buffer->compact;
+	uint32_t i;
+
+	if ((size_val < STRTAB_MIN_LEN) || (size_val > STRTAB_MAX_LEN) ||
+	    (c->str_cnt >= STRTAB_MAX_CNT))
+		return;
+
+	if (c->str_cnt == c->str_size) {
+		c->str_size = MAX(c->str_size * 2, 256);
+		xrealloc(c->str_off, sizeof(uint32_t) * c->str_size);
+		xrealloc(c->str_len, sizeof(uint32_t) * c->str_size);
+	}
+	c->str_off[c->str_cnt] = off;
+	c->str_len[c->str_cnt] = size_val;
+	c->str_cnt++;
+
+	if (c->hash == NULL)
+		return;
+	if ((c->str_cnt * 2) > c->hash_size) {
+		xfree(c->hash);
+		c->hash_size *= 2;
+		c->hash = xmalloc(sizeof(uint32_t) * c->hash_size);
+		for (i = 0; i < c->str_cnt; i++)
+			_strtab_hash_add(buffer, i);
+	} else
+		_strtab_hash_add(buffer, c->str_cnt - 1);
+}
+
+/* RET index of a copy of the string in the table of a buffer being
+ * packed, or -1 */
+static int _strtab_find(Buf buffer, char *valp, uint32_t size_val)
+{
+	struct pack_compact *c = buffer->compact;
+	uint32_t h, inx;
+
+	if ((size_val < STRTAB_MIN_LEN) || (size_val > STRTAB_MAX_LEN))
+		return -1;
+	if (c->hash == NULL) {
+		c->hash_size = 1024;
+		c->hash = xmalloc(sizeof(uint32_t) * c->hash_size);
+	}
+
+	h = _strtab_hash(valp, size_val) & (c->hash_size - 1);
+	while (c->hash[h]) {
+		inx = c->hash[h] - 1;
+		if ((c->str_len[inx] == size_val) &&
+		    !memcmp(&buffer->head[c->str_off[inx]], valp, size_val))
+			return inx;
+		h = (h + 1) & (c->hash_size - 1);
+	}
+	return -1;
+}
+
+/* Memory is packed compactly as a varint holding either its length times
+ * two, followed by its contents, or the index of a copy in the table times
+ * two plus one. */
+static void _packmem_compact(char *valp, uint32_t size_val, Buf buffer)
+{
+	uint32_t off;
+	int inx;
+
+	if ((inx = _strtab_find(buffer, valp, size_val)) >= 0) {
+		_pack_varint(((uint64_t) inx << 1) | 1, buffer, "packmem");
+		return;
+	}
+
+	_pack_varint((uint64_t) size_val << 1, buffer, "packmem");
+	if (_reserve_buf(buffer, size_val, "packmem"))
+		return;
+	off = buffer->processed;
+	if (size_val) {
+		memcpy(&buffer->head[off], valp, size_val);
+		buffer->processed += size_val;
+	}
+	_strtab_add(buffer, off, size_val);
+}
+
+/* Locate memory packed by packmem() in the buffer, of at most max_len
+ * bytes. *valp is set to the contents, in the buffer. */
+static int _unpackmem_loc(char **valp, uint32_t *size_valp,
+			  uint32_t max_len, Buf buffer)
+{
+	struct pack_compact *c = buffer->compact;
+	uint32_t ns;
+	uint64_t tag;
+
+	if (c) {
+		if (_unpack_varint(&tag, buffer))
+			return SLURM_ERROR;
+		if (tag & 1) {
+			tag >>= 1;
+			if (tag >= c->str_cnt)
+				return SLURM_ERROR;
+			*size_valp = c->str_len[tag];
+			*valp = &buffer->head[c->str_off[tag]];
+			return SLURM_SUCCESS;
+		}
+		if ((tag >> 1) > max_len)
+			return SLURM_ERROR;
+		*size_valp = tag >> 1;
+	} else {
+		if (remaining_buf(buffer) < sizeof(ns))
+			return SLURM_ERROR;
+		memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
+		*size_valp = ntohl(ns);
+		buffer->processed += sizeof(ns);
+		if (*size_valp > max_len)
+			return SLURM_ERROR;
+	}
+
+	if (remaining_buf(buffer) < *size_valp)
+		return SLURM_ERROR;
+	*valp = &buffer->head[buffer->processed];
+	if (c)
+		_strtab_add(buffer, buffer->processed, *size_valp);
+	buffer->processed += *size_valp;
+	return SLURM_SUCCESS;
+}
+
 /*
  * Given a time_t in host byte order, promote it to int64_t, convert to
  * network byte order, store in buffer and adjust buffer acc'd'ngly
@@ -179,14 +534,12 @@ void pack_time(time_t val, Buf buffer)
 {
 	int64_t n64 = HTON_int64((int64_t) val);
 
-	if (remaining_buf(buffer) < sizeof(n64)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack_time: buffer size too large");
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
+	if (buffer->compact) {
+		_pack_time_compact(val, buffer);
+		return;
 	}
+	if (_reserve_buf(buffer, sizeof(n64), "pack_time"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &n64, sizeof(n64));
 	buffer->processed += sizeof(n64);
@@ -196,6 +549,8 @@ int unpack_time(time_t * valp, Buf buffer)
 {
 	int64_t n64;
 
+	if (buffer->compact)
+		return _unpack_time_compact(valp, buffer);
 	if (remaining_buf(buffer) < sizeof(n64))
 		return SLURM_ERROR;
 
@@ -223,14 +578,8 @@ void 	packdouble(double val, Buf buffer)
 	  * more than 15 decimals will mess things up, but this corrects it. */
 	uval.d =  (val * FLOAT_MULT);
 	nl =  HTON_uint64(uval.u);
-	if (remaining_buf(buffer) < sizeof(nl)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("packdouble: buffer size too large");
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
-	}
+	if (_reserve_buf(buffer, sizeof(nl), "packdouble"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
 	buffer->processed += sizeof(nl);
@@ -269,14 +618,12 @@ void pack64(uint64_t val, Buf buffer)
 {
 	uint64_t nl =  HTON_uint64(val);
 
-	if (remaining_buf(buffer) < sizeof(nl)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack64: buffer size too large");
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
+	if (buffer->compact) {
+		_pack_varint(val + 2, buffer, "pack64");
+		return;
 	}
+	if (_reserve_buf(buffer, sizeof(nl), "pack64"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
 	buffer->processed += sizeof(nl);
@@ -289,6 +636,13 @@ void pack64(uint64_t val, Buf buffer)
 int unpack64(uint64_t * valp, Buf buffer)
 {
 	uint64_t nl;
+
+	if (buffer->compact) {
+		if (_unpack_varint(&nl, buffer))
+			return SLURM_ERROR;
+		*valp = nl - 2;
+		return SLURM_SUCCESS;
+	}
 	if (remaining_buf(buffer) < sizeof(nl))
 		return SLURM_ERROR;
 
@@ -306,14 +660,13 @@ void pack32(uint32_t val, Buf buffer)
 {
 	uint32_t nl = htonl(val);
 
-	if (remaining_buf(buffer) < sizeof(nl)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack32: buffer size too large");
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
+	if (buffer->compact) {
+		/* NO_VAL and INFINITE fit in one byte */
+		_pack_varint((uint32_t) (val + 2), buffer, "pack32");
+		return;
 	}
+	if (_reserve_buf(buffer, sizeof(nl), "pack32"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
 	buffer->processed += sizeof(nl);
@@ -326,6 +679,14 @@ void pack32(uint32_t val, Buf buffer)
 int unpack32(uint32_t * valp, Buf buffer)
 {
 	uint32_t nl;
+	uint64_t val;
+
+	if (buffer->compact) {
+		if (_unpack_varint(&val, buffer) || (val > 0xffffffff))
+			return SLURM_ERROR;
+		*valp = (uint32_t) val - 2;
+		return SLURM_SUCCESS;
+	}
 	if (remaining_buf(buffer) < sizeof(nl))
 		return SLURM_ERROR;
 
@@ -401,14 +762,12 @@ void pack16(uint16_t val, Buf buffer)
 {
 	uint16_t ns = htons(val);
 
-	if (remaining_buf(buffer) < sizeof(ns)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack16: buffer size too large");
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
+	if (buffer->compact) {
+		_pack_varint((uint16_t) (val + 2), buffer, "pack16");
+		return;
 	}
+	if (_reserve_buf(buffer, sizeof(ns), "pack16"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
 	buffer->processed += sizeof(ns);
@@ -421,7 +780,14 @@ void pack16(uint16_t val, Buf buffer)
 int unpack16(uint16_t * valp, Buf buffer)
 {
 	uint16_t ns;
+	uint64_t val;
 
+	if (buffer->compact) {
+		if (_unpack_varint(&val, buffer) || (val > 0xffff))
+			return SLURM_ERROR;
+		*valp = (uint16_t) val - 2;
+		return SLURM_SUCCESS;
+	}
 	if (remaining_buf(buffer) < sizeof(ns))
 		return SLURM_ERROR;
 
@@ -437,14 +803,8 @@ int unpack16(uint16_t * valp, Buf buffer)
  */
 void pack8(uint8_t val, Buf buffer)
 {
-	if (remaining_buf(buffer) < sizeof(uint8_t)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack8: buffer size too large");
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
-	}
+	if (_reserve_buf(buffer, sizeof(uint8_t), "pack8"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &val, sizeof(uint8_t));
 	buffer->processed += sizeof(uint8_t);
@@ -473,14 +833,12 @@ void packmem(char *valp, uint32_t size_val, Buf buffer)
 {
 	uint32_t ns = htonl(size_val);
 
-	if (remaining_buf(buffer) < (sizeof(ns) + size_val)) {
-		if (buffer->size > (MAX_BUF_SIZE -  size_val - BUF_SIZE)) {
-			error("packmem: buffer size too large");
-			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc(buffer->head, buffer->size);
+	if (buffer->compact) {
+		_packmem_compact(valp, size_val, buffer);
+		return;
 	}
+	if (_reserve_buf(buffer, sizeof(ns) + size_val, "packmem"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
 	buffer->processed += sizeof(ns);
@@ -502,24 +860,11 @@ void packmem(char *valp, uint32_t size_val, Buf buffer)
  */
 int unpackmem_ptr(char **valp, uint32_t * size_valp, Buf buffer)
 {
-	uint32_t ns;
+	char *ptr;
 
-	if (remaining_buf(buffer) < sizeof(ns))
+	if (_unpackmem_loc(&ptr, size_valp, MAX_PACK_MEM_LEN, buffer))
 		return SLURM_ERROR;
-
-	memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
-	*size_valp = ntohl(ns);
-	buffer->processed += sizeof(ns);
-
-	if (*size_valp > MAX_PACK_MEM_LEN)
-		return SLURM_ERROR;
-	else if (*size_valp > 0) {
-		if (remaining_buf(buffer) < *size_valp)
-			return SLURM_ERROR;
-		*valp = &buffer->head[buffer->processed];
-		buffer->processed += *size_valp;
-	} else
-		*valp = NULL;
+	*valp = *size_valp ? ptr : NULL;
 	return SLURM_SUCCESS;
 }
 
@@ -534,23 +879,13 @@ int unpackmem_ptr(char **valp, uint32_t * size_valp, Buf buffer)
  */
 int unpackmem(char *valp, uint32_t * size_valp, Buf buffer)
 {
-	uint32_t ns;
-
-	if (remaining_buf(buffer) < sizeof(ns))
-		return SLURM_ERROR;
-
-	memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
-	*size_valp = ntohl(ns);
-	buffer->processed += sizeof(ns);
+	char *ptr;
 
-	if (*size_valp > MAX_PACK_MEM_LEN)
+	if (_unpackmem_loc(&ptr, size_valp, MAX_PACK_MEM_LEN, buffer))
 		return SLURM_ERROR;
-	else if (*size_valp > 0) {
-		if (remaining_buf(buffer) < *size_valp)
-			return SLURM_ERROR;
-		memcpy(valp, &buffer->head[buffer->processed], *size_valp);
-		buffer->processed += *size_valp;
-	} else
+	if (*size_valp > 0)
+		memcpy(valp, ptr, *size_valp);
+	else
 		*valp = 0;
 	return SLURM_SUCCESS;
 }
@@ -566,24 +901,13 @@ int unpackmem(char *valp, uint32_t * size_valp, Buf buffer)
  */
 int unpackmem_xmalloc(char **valp, uint32_t * size_valp, Buf buffer)
 {
-	uint32_t ns;
+	char *ptr;
 
-	if (remaining_buf(buffer) < sizeof(ns))
-		return SLURM_ERROR;
-
-	memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
-	*size_valp = ntohl(ns);
-	buffer->processed += sizeof(ns);
-
-	if (*size_valp > MAX_PACK_STR_LEN)
+	if (_unpackmem_loc(&ptr, size_valp, MAX_PACK_STR_LEN, buffer))
 		return SLURM_ERROR;
-	else if (*size_valp > 0) {
-		if (remaining_buf(buffer) < *size_valp)
-			return SLURM_ERROR;
+	if (*size_valp > 0) {
 		*valp = xmalloc(*size_valp);
-		memcpy(*valp, &buffer->head[buffer->processed],
-		       *size_valp);
-		buffer->processed += *size_valp;
+		memcpy(*valp, ptr, *size_valp);
 	} else
 		*valp = NULL;
 	return SLURM_SUCCESS;
@@ -600,23 +924,13 @@ int unpackmem_xmalloc(char **valp, uint32_t * size_valp, Buf buffer)
  */
 int unpackmem_malloc(char **valp, uint32_t * size_valp, Buf buffer)
 {
-	uint32_t ns;
-
-	if (remaining_buf(buffer) < sizeof(ns))
-		return SLURM_ERROR;
+	char *ptr;
 
-	memcpy(&ns, &buffer->head[buffer->processed], sizeof(ns));
-	*size_valp = ntohl(ns);
-	buffer->processed += sizeof(ns);
-	if (*size_valp > MAX_PACK_STR_LEN)
+	if (_unpackmem_loc(&ptr, size_valp, MAX_PACK_STR_LEN, buffer))
 		return SLURM_ERROR;
-	else if (*size_valp > 0) {
-		if (remaining_buf(buffer) < *size_valp)
-			return SLURM_ERROR;
+	if (*size_valp > 0) {
 		*valp = malloc(*size_valp);
-		memcpy(*valp, &buffer->head[buffer->processed],
-		       *size_valp);
-		buffer->processed += *size_valp;
+		memcpy(*valp, ptr, *size_valp);
 	} else
 		*valp = NULL;
 	return SLURM_SUCCESS;
@@ -632,14 +946,8 @@ void packstr_array(char **valp, uint32_t size_val, Buf buffer)
 	int i;
 	uint32_t ns = htonl(size_val);
 
-	if (remaining_buf(buffer) < sizeof(ns)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("packstr_array: buffer size too large");
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
-	}
+	if (_reserve_buf(buffer, sizeof(ns), "packstr_array"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
 	buffer->processed += sizeof(ns);
@@ -692,14 +1000,8 @@ int unpackstr_array(char ***valp, uint32_t * size_valp, Buf buffer)
  */
 void packmem_array(char *valp, uint32_t size_val, Buf buffer)
 {
-	if (remaining_buf(buffer) < size_val) {
-		if (buffer->size > (MAX_BUF_SIZE - size_val - BUF_SIZE)) {
-			error("packmem_array: buffer size too large");
-			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc(buffer->head, buffer->size);
-	}
+	if (_reserve_buf(buffer, size_val, "packmem_array"))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], valp, size_val);
 	buffer->processed += size_val;
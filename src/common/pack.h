@@ -58,6 +58,8 @@
 #include <time.h>
 #include <string.h>
 
+#include "src/common/macros.h"
+
 #define BUF_MAGIC 0x42554545
 #define BUF_SIZE (16 * 1024)
 #define MAX_BUF_SIZE ((uint32_t) 0xffff0000)	/* avoid going over 32-bits */
@@ -68,6 +70,7 @@ struct slurm_buf {
 	char *head;
 	uint32_t size;
 	uint32_t processed;
+	struct pack_compact *compact;	/* NULL unless set_buf_compact() */
 };
 
 typedef struct slurm_buf * Buf;
@@ -81,6 +84,9 @@ typedef struct slurm_buf * Buf;
 Buf	create_buf (char *data, int size);
 void	free_buf(Buf my_buf);
 Buf	init_buf(int size);
+Buf	init_pool_buf(void);
+void	free_pool_buf(Buf my_buf);
+void	set_buf_compact(Buf my_buf, bool compact);
 void    grow_buf (Buf my_buf, int size);
 void	*xfer_buf_data(Buf my_buf);
 
@@ -153,6 +153,7 @@ s_p_options_t slurm_conf_options[] = {
 	{"AccountingStorageType", S_P_STRING},
 	{"AccountingStorageUser", S_P_STRING},
 	{"AccountingStoreJobComment", S_P_BOOLEAN},
+	{"AuthSessionTimeout", S_P_UINT16},
 	{"AuthType", S_P_STRING},
 	{"BackupAddr", S_P_STRING},
 	{"BackupController", S_P_STRING},
@@ -211,6 +212,7 @@ s_p_options_t slurm_conf_options[] = {
 	{"MaxMemPerNode", S_P_UINT32},
 	{"MaxStepCount", S_P_UINT32},
 	{"MaxTasksPerNode", S_P_UINT16},
+	{"MessagePersistTimeout", S_P_UINT16},
 	{"MessageTimeout", S_P_UINT16},
 	{"MinJobAge", S_P_UINT16},
 	{"MpiDefault", S_P_STRING},
@@ -1831,6 +1833,7 @@ init_slurm_conf (slurm_ctl_conf_t *ctl_conf_ptr)
 	ctl_conf_ptr->accounting_storage_port             = 0;
 	xfree (ctl_conf_ptr->accounting_storage_type);
 	xfree (ctl_conf_ptr->accounting_storage_user);
+	ctl_conf_ptr->auth_session_timeout	= 0;
 	xfree (ctl_conf_ptr->authtype);
 	xfree (ctl_conf_ptr->backup_addr);
 	xfree (ctl_conf_ptr->backup_controller);
@@ -1879,6 +1882,7 @@ init_slurm_conf (slurm_ctl_conf_t *ctl_conf_ptr)
 	ctl_conf_ptr->min_job_age		= (uint16_t) NO_VAL;
 	xfree (ctl_conf_ptr->mpi_default);
 	xfree (ctl_conf_ptr->mpi_params);
+	ctl_conf_ptr->msg_persist_timeout	= 0;
 	ctl_conf_ptr->msg_timeout		= (uint16_t) NO_VAL;
 	ctl_conf_ptr->next_job_id		= (uint32_t) NO_VAL;
 	xfree (ctl_conf_ptr->node_prefix);
@@ -2243,6 +2247,10 @@ _validate_and_set_defaults(slurm_ctl_conf_t *conf, s_p_hashtbl_t *hashtbl)
 		      conf->max_step_cnt);
 	}
 
+	if (!s_p_get_uint16(&conf->auth_session_timeout, "AuthSessionTimeout",
+			    hashtbl))
+		conf->auth_session_timeout = DEFAULT_AUTH_SESSION_TIMEOUT;
+
 	if (!s_p_get_string(&conf->authtype, "AuthType", hashtbl))
 		conf->authtype = xstrdup(DEFAULT_AUTH_TYPE);
 
@@ -2451,6 +2459,10 @@ _validate_and_set_defaults(slurm_ctl_conf_t *conf, s_p_hashtbl_t *hashtbl)
 		conf->max_tasks_per_node = DEFAULT_MAX_TASKS_PER_NODE;
 	}
 
+	if (!s_p_get_uint16(&conf->msg_persist_timeout, "MessagePersistTimeout",
+			    hashtbl))
+		conf->msg_persist_timeout = DEFAULT_MSG_PERSIST_TIMEOUT;
+
 	if (!s_p_get_uint16(&conf->msg_timeout, "MessageTimeout", hashtbl))
 		conf->msg_timeout = DEFAULT_MSG_TIMEOUT;
 	else if (conf->msg_timeout > 100) {
@@ -3216,6 +3228,11 @@ extern char * debug_flags2str(uint32_t debug_flags)
 			xstrcat(rc, ",");
 		xstrcat(rc, "Wiki");
 	}
+	if (debug_flags & DEBUG_FLAG_XMALLOC) {
+		if (rc)
+			xstrcat(rc, ",");
+		xstrcat(rc, "XMalloc");
+	}
 
 	return rc;
 }
@@ -3272,6 +3289,8 @@ extern uint32_t debug_str2flags(char *debug_flags)
 			rc |= DEBUG_FLAG_TRIGGERS;
 		else if (strcasecmp(tok, "Wiki") == 0)
 			rc |= DEBUG_FLAG_WIKI;
+		else if (strcasecmp(tok, "XMalloc") == 0)
+			rc |= DEBUG_FLAG_XMALLOC;
 		else {
 			error("Invalid DebugFlag: %s", tok);
 			rc = NO_VAL;
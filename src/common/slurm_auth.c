@@ -71,6 +71,11 @@ typedef struct slurm_auth_ops {
         int          (*print)     ( void *cred, FILE *fp );
         int          (*sa_errno)  ( void *cred );
         const char * (*sa_errstr) ( int slurm_errno );
+        void *       (*create_signed) ( void *argv[], char *auth_info,
+                                        uid_t r_uid, gid_t r_gid,
+                                        struct iovec *data, int iovcnt );
+        int          (*verify_signed) ( void *cred, char *auth_info,
+                                        struct iovec *data, int iovcnt );
 } slurm_auth_ops_t;
 
 /*
@@ -136,7 +141,9 @@ slurm_auth_get_ops( slurm_auth_context_t c )
                 "slurm_auth_unpack",
                 "slurm_auth_print",
                 "slurm_auth_errno",
-                "slurm_auth_errstr"
+                "slurm_auth_errstr",
+                "slurm_auth_create_signed",
+                "slurm_auth_verify_signed"
         };
         int n_syms = sizeof( syms ) / sizeof( char * );
 
@@ -465,6 +472,53 @@ g_slurm_auth_unpack( Buf buf )
         return (*(g_context->ops.unpack))( buf );
 }
 
+void *
+g_slurm_auth_create_signed( void *hosts, int timeout, char *auth_info,
+			    uid_t r_uid, gid_t r_gid, struct iovec *data,
+			    int iovcnt )
+{
+        void **argv;
+        void *ret;
+
+	if ( slurm_auth_init(NULL) < 0 )
+		return NULL;
+
+	if ( auth_dummy )
+		return xmalloc(0);
+
+        if ( ( argv = slurm_auth_marshal_args( hosts, timeout ) ) == NULL ) {
+                return NULL;
+        }
+
+        ret = (*(g_context->ops.create_signed))( argv, auth_info, r_uid,
+						 r_gid, data, iovcnt );
+        xfree( argv );
+        return ret;
+}
+
+int
+g_slurm_auth_verify_signed( void *cred, void *hosts, int timeout,
+			    char *auth_info, struct iovec *data, int iovcnt )
+{
+        int ret;
+        void **argv = (void **) NULL;
+
+        if ( slurm_auth_init(NULL) < 0 )
+                return SLURM_ERROR;
+
+	if ( auth_dummy )
+		return SLURM_SUCCESS;
+
+        if ( ( argv = slurm_auth_marshal_args( hosts, timeout ) ) == NULL ) {
+                return SLURM_ERROR;
+        }
+
+        ret = (*(g_context->ops.verify_signed))( cred, auth_info, data,
+						 iovcnt );
+        xfree( argv );
+        return ret;
+}
+
 int
 g_slurm_auth_print( void *cred, FILE *fp )
 {
@@ -40,6 +40,7 @@
 #define __SLURM_AUTHENTICATION_H__
 
 #include <stdio.h>
+#include <sys/uio.h>
 
 #if HAVE_CONFIG_H
 #  include "config.h"
@@ -136,6 +137,12 @@ int slurm_auth_context_destroy( slurm_auth_context_t ctxt );
  */
 #define SLURM_AUTH_NOBODY		99
 
+/*
+ * Passed as the gid to g_slurm_auth_create_signed() to let a user read
+ * the credential whatever its group.
+ */
+#define SLURM_AUTH_ANY_GID		((gid_t) -1)
+
 /*
  * Prepare the global context.
  * auth_type IN: authentication mechanism (e.g. "auth/munge") or
@@ -159,6 +166,21 @@ extern uid_t	g_slurm_auth_get_uid( void *cred, char *auth_info );
 extern gid_t	g_slurm_auth_get_gid( void *cred, char *auth_info );
 extern int	g_slurm_auth_pack( void *cred, Buf buf );
 
+/*
+ * Create a credential for a message to a process of user r_uid (and
+ * group r_gid, unless SLURM_AUTH_ANY_GID) and bind it to the "iovcnt"
+ * parts of the message in "data", which the receiver must pass to
+ * g_slurm_auth_verify_signed(). Plugins which do not sign messages
+ * return the same credential as g_slurm_auth_create().
+ */
+extern void *	g_slurm_auth_create_signed( void *hosts, int timeout,
+					    char *auth_info, uid_t r_uid,
+					    gid_t r_gid, struct iovec *data,
+					    int iovcnt );
+extern int	g_slurm_auth_verify_signed( void *cred, void *hosts,
+					    int timeout, char *auth_info,
+					    struct iovec *data, int iovcnt );
+
 /*
  * WARNING!  The returned auth pointer WILL have pointers
  *           into "buf" so do NOT free "buf" until you are done
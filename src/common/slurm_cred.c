@@ -44,6 +44,7 @@
 #include <fcntl.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 
 #if WITH_PTHREADS
@@ -81,15 +82,25 @@ typedef struct sbcast_cred sbcast_cred_t;		/* opaque data type */
 #define MAX_TIME 0x7fffffff
 #define SBCAST_CACHE_SIZE 64
 
+/*
+ * Hash table sizes for the verifier's job, credential and signature state.
+ * Expired entries are purged at most once per second.
+ */
+#define JOB_STATE_HASH_SIZE	1024
+#define CRED_STATE_HASH_SIZE	1024
+#define SIG_CACHE_HASH_SIZE	256
+#define SIG_CACHE_MAX		4096	/* Most signatures cached at once */
+
 /*
  * slurm job credential state
  *
  */
-typedef struct {
+typedef struct cred_state {
 	time_t   ctime;		/* Time that the cred was created	*/
 	time_t   expiration;    /* Time at which cred is no longer good	*/
 	uint32_t jobid;		/* SLURM job id for this credential	*/
 	uint32_t stepid;	/* SLURM step id for this credential	*/
+	struct cred_state *next;/* Next state in hash bucket		*/
 } cred_state_t;
 
 /*
@@ -97,13 +108,30 @@ typedef struct {
  * tracks jobids for which all future credentials have been revoked
  *
  */
-typedef struct {
+typedef struct job_state {
 	time_t   ctime;         /* Time that this entry was created         */
 	time_t   expiration;    /* Time at which credentials can be purged  */
 	uint32_t jobid;         /* SLURM job id for this credential	*/
 	time_t   revoked;       /* Time at which credentials were revoked   */
+	struct job_state *next; /* Next state in hash bucket                */
 } job_state_t;
 
+/*
+ * A credential whose signature has been verified. Repeated verification
+ * of the same credential (e.g. a launch retried after slurm_cred_rewind())
+ * matches the packed credential and signature here rather than calling
+ * the crypto plugin again.
+ */
+typedef struct sig_cache {
+	uint32_t hash;		/* Hash of data and signature		*/
+	char    *data;		/* Packed credential			*/
+	uint32_t data_len;
+	char    *signature;	/* Credential signature			*/
+	unsigned int siglen;
+	time_t   expiration;	/* Time at which cred is no longer good	*/
+	struct sig_cache *next;	/* Next entry in hash bucket		*/
+} sig_cache_t;
+
 
 /*
  * Completion of slurm credential context
@@ -139,8 +167,15 @@ struct slurm_cred_context {
 #endif
 	enum ctx_type  type;       /* type of context (creator or verifier) */
 	void          *key;        /* private or public key                 */
-	List           job_list;   /* List of used jobids (for verifier)    */
-	List           state_list; /* List of cred states (for verifier)    */
+	job_state_t  **job_hash;   /* Hash of used jobids (for verifier)    */
+	uint32_t       job_cnt;
+	time_t         job_purge;  /* Time of last expired job state purge  */
+	cred_state_t **state_hash; /* Hash of cred states (for verifier)    */
+	uint32_t       state_cnt;
+	time_t         state_purge;/* Time of last expired cred state purge */
+	sig_cache_t  **sig_hash;   /* Hash of verified signatures           */
+	uint32_t       sig_cnt;
+	time_t         sig_purge;  /* Time of last expired signature purge  */
 
 	int          expiry_window;/* expiration window for cached creds    */
 
@@ -243,7 +278,13 @@ static void           _job_state_destroy(job_state_t   *js);
 
 static job_state_t  * _find_job_state(slurm_cred_ctx_t ctx, uint32_t jobid);
 static job_state_t  * _insert_job_state(slurm_cred_ctx_t ctx,  uint32_t jobid);
-static int            _find_cred_state(cred_state_t *c, slurm_cred_t *cred);
+static void           _append_job_state(slurm_cred_ctx_t ctx, job_state_t *j);
+static void           _remove_job_state(slurm_cred_ctx_t ctx, uint32_t jobid);
+static void           _append_cred_state(slurm_cred_ctx_t ctx,
+					 cred_state_t *s);
+static int            _delete_cred_state(slurm_cred_ctx_t ctx,
+					 slurm_cred_t *cred);
+static void           _clear_sig_cache(slurm_cred_ctx_t ctx);
 
 static void _insert_cred_state(slurm_cred_ctx_t ctx, slurm_cred_t *cred);
 static void _clear_expired_job_states(slurm_cred_ctx_t ctx);
@@ -529,10 +570,28 @@ slurm_cred_ctx_destroy(slurm_cred_ctx_t ctx)
 		(*(g_crypto_context->ops.crypto_destroy_key))(ctx->exkey);
 	if (ctx->key)
 		(*(g_crypto_context->ops.crypto_destroy_key))(ctx->key);
-	if (ctx->job_list)
-		list_destroy(ctx->job_list);
-	if (ctx->state_list)
-		list_destroy(ctx->state_list);
+	if (ctx->job_hash) {
+		job_state_t *j;
+		cred_state_t *cs;
+		int i;
+
+		for (i = 0; i < JOB_STATE_HASH_SIZE; i++) {
+			while ((j = ctx->job_hash[i])) {
+				ctx->job_hash[i] = j->next;
+				_job_state_destroy(j);
+			}
+		}
+		for (i = 0; i < CRED_STATE_HASH_SIZE; i++) {
+			while ((cs = ctx->state_hash[i])) {
+				ctx->state_hash[i] = cs->next;
+				_cred_state_destroy(cs);
+			}
+		}
+		_clear_sig_cache(ctx);
+		xfree(ctx->job_hash);
+		xfree(ctx->state_hash);
+		xfree(ctx->sig_hash);
+	}
 
 	xassert(ctx->magic = ~CRED_CTX_MAGIC);
 
@@ -1046,8 +1105,7 @@ slurm_cred_rewind(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 	xassert(ctx->magic == CRED_CTX_MAGIC);
 	xassert(ctx->type  == SLURM_CRED_VERIFIER);
 
-	rc = list_delete_all(ctx->state_list,
-			     (ListFindF) _find_cred_state, cred);
+	rc = _delete_cred_state(ctx, cred);
 
 	slurm_mutex_unlock(&ctx->mutex);
 
@@ -1456,7 +1514,7 @@ slurm_cred_ctx_unpack(slurm_cred_ctx_t ctx, Buf buffer)
 
 	/*
 	 * Unpack job state list and cred state list from buffer
-	 * appening them onto ctx->state_list and ctx->job_list.
+	 * adding them to ctx->job_hash and ctx->state_hash.
 	 */
 	_job_state_unpack(ctx, buffer);
 	_cred_state_unpack(ctx, buffer);
@@ -1514,8 +1572,12 @@ _verifier_ctx_init(slurm_cred_ctx_t ctx)
 	xassert(ctx->magic == CRED_CTX_MAGIC);
 	xassert(ctx->type == SLURM_CRED_VERIFIER);
 
-	ctx->job_list   = list_create((ListDelF) _job_state_destroy);
-	ctx->state_list = list_create((ListDelF) _cred_state_destroy);
+	ctx->job_hash   = xmalloc(sizeof(job_state_t *) *
+				  JOB_STATE_HASH_SIZE);
+	ctx->state_hash = xmalloc(sizeof(cred_state_t *) *
+				  CRED_STATE_HASH_SIZE);
+	ctx->sig_hash   = xmalloc(sizeof(sig_cache_t *) *
+				  SIG_CACHE_HASH_SIZE);
 
 	return;
 }
@@ -1667,16 +1729,133 @@ _slurm_cred_sign(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 	return SLURM_SUCCESS;
 }
 
+/* FNV-1a hash of a packed credential and its signature */
+static uint32_t
+_sig_hash(char *data, uint32_t data_len, char *sig, unsigned int siglen)
+{
+	uint32_t hash = 2166136261U;
+	uint32_t i;
+
+	for (i = 0; i < data_len; i++)
+		hash = (hash ^ (unsigned char) data[i]) * 16777619U;
+	for (i = 0; i < siglen; i++)
+		hash = (hash ^ (unsigned char) sig[i]) * 16777619U;
+	return hash;
+}
+
+static void
+_sig_cache_destroy(sig_cache_t *sc)
+{
+	xfree(sc->data);
+	xfree(sc->signature);
+	xfree(sc);
+}
+
+static void
+_clear_sig_cache(slurm_cred_ctx_t ctx)
+{
+	sig_cache_t *sc;
+	int i;
+
+	for (i = 0; i < SIG_CACHE_HASH_SIZE; i++) {
+		while ((sc = ctx->sig_hash[i])) {
+			ctx->sig_hash[i] = sc->next;
+			_sig_cache_destroy(sc);
+		}
+	}
+	ctx->sig_cnt = 0;
+}
+
+static void
+_clear_expired_sig_cache(slurm_cred_ctx_t ctx)
+{
+	time_t        now = time(NULL);
+	sig_cache_t **scp, *sc;
+	int i;
+
+	if (ctx->sig_purge == now)
+		return;
+	ctx->sig_purge = now;
+
+	for (i = 0; i < SIG_CACHE_HASH_SIZE; i++) {
+		scp = &ctx->sig_hash[i];
+		while ((sc = *scp)) {
+			if (now > sc->expiration) {
+				*scp = sc->next;
+				_sig_cache_destroy(sc);
+				ctx->sig_cnt--;
+			} else
+				scp = &sc->next;
+		}
+	}
+}
+
+/* Return true if this exact credential and signature were verified */
+static bool
+_sig_cached(slurm_cred_ctx_t ctx, uint32_t hash, char *data,
+	    uint32_t data_len, slurm_cred_t *cred)
+{
+	time_t       now = time(NULL);
+	sig_cache_t *sc;
+
+	for (sc = ctx->sig_hash[hash % SIG_CACHE_HASH_SIZE]; sc;
+	     sc = sc->next) {
+		if ((sc->hash == hash) && (now <= sc->expiration) &&
+		    (sc->data_len == data_len) &&
+		    (sc->siglen == cred->siglen) &&
+		    !memcmp(sc->data, data, data_len) &&
+		    !memcmp(sc->signature, cred->signature, cred->siglen))
+			return true;
+	}
+	return false;
+}
+
+static void
+_sig_cache_insert(slurm_cred_ctx_t ctx, uint32_t hash, char *data,
+		  uint32_t data_len, slurm_cred_t *cred)
+{
+	sig_cache_t *sc;
+	int inx = hash % SIG_CACHE_HASH_SIZE;
+
+	_clear_expired_sig_cache(ctx);
+	if (ctx->sig_cnt >= SIG_CACHE_MAX)
+		return;
+
+	sc = xmalloc(sizeof(sig_cache_t));
+	sc->hash       = hash;
+	sc->data       = xmalloc(data_len);
+	memcpy(sc->data, data, data_len);
+	sc->data_len   = data_len;
+	sc->signature  = xmalloc(cred->siglen);
+	memcpy(sc->signature, cred->signature, cred->siglen);
+	sc->siglen     = cred->siglen;
+	sc->expiration = cred->ctime + ctx->expiry_window;
+	sc->next       = ctx->sig_hash[inx];
+	ctx->sig_hash[inx] = sc;
+	ctx->sig_cnt++;
+}
+
 static int
 _slurm_cred_verify_signature(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 {
 	Buf            buffer;
 	int            rc;
+	uint32_t       hash;
 
 	debug("Checking credential with %u bytes of sig data", cred->siglen);
 	buffer = init_buf(4096);
 	_pack_cred(cred, buffer);
 
+	hash = _sig_hash(get_buf_data(buffer), get_buf_offset(buffer),
+			 cred->signature, cred->siglen);
+	if (_sig_cached(ctx, hash, get_buf_data(buffer),
+			get_buf_offset(buffer), cred)) {
+		debug2("Credential signature for job %u.%u verified earlier",
+		       cred->jobid, cred->stepid);
+		free_buf(buffer);
+		return SLURM_SUCCESS;
+	}
+
 	rc = (*(g_crypto_context->ops.crypto_verify_sign))(ctx->key,
 							get_buf_data(buffer),
 							get_buf_offset(buffer),
@@ -1689,6 +1868,10 @@ _slurm_cred_verify_signature(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 							cred->signature,
 							cred->siglen);
 	}
+	if (rc == 0) {
+		_sig_cache_insert(ctx, hash, get_buf_data(buffer),
+				  get_buf_offset(buffer), cred);
+	}
 	free_buf(buffer);
 
 	if (rc) {
@@ -1745,25 +1928,29 @@ _pack_cred(slurm_cred_t *cred, Buf buffer)
 }
 
 
+static inline int
+_cred_state_hash(uint32_t jobid, uint32_t stepid)
+{
+	return ((jobid * 31) + stepid) % CRED_STATE_HASH_SIZE;
+}
+
 static bool
 _credential_replayed(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 {
-	ListIterator  i = NULL;
+	time_t        now = time(NULL);
 	cred_state_t *s = NULL;
 
 	_clear_expired_credential_states(ctx);
 
-	i = list_iterator_create(ctx->state_list);
-
-	while ((s = list_next(i))) {
+	s = ctx->state_hash[_cred_state_hash(cred->jobid, cred->stepid)];
+	for ( ; s; s = s->next) {
 		if ((s->jobid  == cred->jobid)  &&
 		    (s->stepid == cred->stepid) &&
-		    (s->ctime  == cred->ctime))
+		    (s->ctime  == cred->ctime)  &&
+		    (now <= s->expiration))
 			break;
 	}
 
-	list_iterator_destroy(i);
-
 	/*
 	 * If we found a match, this credential is being replayed.
 	 */
@@ -1809,11 +1996,7 @@ slurm_cred_handle_reissue(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 		 * credential to any ensuing commands. */
 		info("reissued job credential for job %u", j->jobid);
 
-		/* Setting j->expiration to zero will make
-		 * _clear_expired_job_states() remove this
-		 * job credential from the cred context. */
-		j->expiration = 0;
-		_clear_expired_job_states(ctx);
+		_remove_job_state(ctx, j->jobid);
 	}
 }
 
@@ -1857,33 +2040,54 @@ _credential_revoked(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 static job_state_t *
 _find_job_state(slurm_cred_ctx_t ctx, uint32_t jobid)
 {
-	ListIterator  i = NULL;
+	time_t        now = time(NULL);
 	job_state_t  *j = NULL;
 
-	i = list_iterator_create(ctx->job_list);
-	while ((j = list_next(i))) {
-		if (j->jobid == jobid)
+	/* Skip states that have expired but are not yet purged */
+	for (j = ctx->job_hash[jobid % JOB_STATE_HASH_SIZE]; j; j = j->next) {
+		if ((j->jobid == jobid) &&
+		    !(j->revoked && (now > j->expiration)))
 			break;
 	}
-	list_iterator_destroy(i);
 	return j;
 }
 
-static int
-_find_cred_state(cred_state_t *c, slurm_cred_t *cred)
+static void
+_append_job_state(slurm_cred_ctx_t ctx, job_state_t *j)
 {
-	return ((c->jobid == cred->jobid) && (c->stepid == cred->stepid) &&
-		(c->ctime == cred->ctime));
+	job_state_t **jp = &ctx->job_hash[j->jobid % JOB_STATE_HASH_SIZE];
+
+	while (*jp)
+		jp = &(*jp)->next;
+	j->next = NULL;
+	*jp = j;
+	ctx->job_cnt++;
 }
 
 static job_state_t *
 _insert_job_state(slurm_cred_ctx_t ctx, uint32_t jobid)
 {
 	job_state_t *j = _job_state_create(jobid);
-	list_append(ctx->job_list, j);
+	_append_job_state(ctx, j);
 	return j;
 }
 
+static void
+_remove_job_state(slurm_cred_ctx_t ctx, uint32_t jobid)
+{
+	job_state_t **jp = &ctx->job_hash[jobid % JOB_STATE_HASH_SIZE];
+	job_state_t  *j;
+
+	while ((j = *jp)) {
+		if (j->jobid == jobid) {
+			*jp = j->next;
+			_job_state_destroy(j);
+			ctx->job_cnt--;
+		} else
+			jp = &j->next;
+	}
+}
+
 
 static job_state_t *
 _job_state_create(uint32_t jobid)
@@ -1909,53 +2113,64 @@ _job_state_destroy(job_state_t *j)
 static void
 _clear_expired_job_states(slurm_cred_ctx_t ctx)
 {
-	char          t1[64], t2[64], t3[64];
 	time_t        now = time(NULL);
-	ListIterator  i   = NULL;
-	job_state_t  *j   = NULL;
-
-	i = list_iterator_create(ctx->job_list);
-
-	while ((j = list_next(i))) {
-		if (j->revoked) {
-			strcpy(t2, " revoked:");
-			timestr(&j->revoked, (t2+9), (64-9));
-		} else {
-			t2[0] = '\0';
-		}
-		if (j->expiration) {
-			strcpy(t3, " expires:");
-			timestr(&j->revoked, (t3+9), (64-9));
-		} else {
-			t3[0] = '\0';
-		}
-		debug3("state for jobid %u: ctime:%s%s%s",
-		       j->jobid, timestr(&j->ctime, t1, 64), t2, t3);
+	job_state_t **jp, *j;
+	int i;
 
-		if (j->revoked && (now > j->expiration)) {
-			list_delete_item(i);
+	if (ctx->job_purge == now)
+		return;
+	ctx->job_purge = now;
+
+	for (i = 0; i < JOB_STATE_HASH_SIZE; i++) {
+		jp = &ctx->job_hash[i];
+		while ((j = *jp)) {
+			if (j->revoked && (now > j->expiration)) {
+				*jp = j->next;
+				_job_state_destroy(j);
+				ctx->job_cnt--;
+			} else
+				jp = &j->next;
 		}
 	}
-
-	list_iterator_destroy(i);
 }
 
 
 static void
 _clear_expired_credential_states(slurm_cred_ctx_t ctx)
 {
-	time_t        now = time(NULL);
-	ListIterator  i   = NULL;
-	cred_state_t *s   = NULL;
-
-	i = list_iterator_create(ctx->state_list);
+	time_t         now = time(NULL);
+	cred_state_t **sp, *s;
+	int i;
 
-	while ((s = list_next(i))) {
-		if (now > s->expiration)
-			list_delete_item(i);
+	if (ctx->state_purge == now)
+		return;
+	ctx->state_purge = now;
+
+	for (i = 0; i < CRED_STATE_HASH_SIZE; i++) {
+		sp = &ctx->state_hash[i];
+		while ((s = *sp)) {
+			if (now > s->expiration) {
+				*sp = s->next;
+				_cred_state_destroy(s);
+				ctx->state_cnt--;
+			} else
+				sp = &s->next;
+		}
 	}
+}
+
 
-	list_iterator_destroy(i);
+static void
+_append_cred_state(slurm_cred_ctx_t ctx, cred_state_t *s)
+{
+	cred_state_t **sp;
+
+	sp = &ctx->state_hash[_cred_state_hash(s->jobid, s->stepid)];
+	while (*sp)
+		sp = &(*sp)->next;
+	s->next = NULL;
+	*sp = s;
+	ctx->state_cnt++;
 }
 
 
@@ -1963,7 +2178,29 @@ static void
 _insert_cred_state(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 {
 	cred_state_t *s = _cred_state_create(ctx, cred);
-	list_append(ctx->state_list, s);
+	_append_cred_state(ctx, s);
+}
+
+
+/* Remove the state of a credential, RET count of states removed */
+static int
+_delete_cred_state(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
+{
+	cred_state_t **sp, *s;
+	int cnt = 0;
+
+	sp = &ctx->state_hash[_cred_state_hash(cred->jobid, cred->stepid)];
+	while ((s = *sp)) {
+		if ((s->jobid == cred->jobid) && (s->stepid == cred->stepid) &&
+		    (s->ctime == cred->ctime)) {
+			*sp = s->next;
+			_cred_state_destroy(s);
+			ctx->state_cnt--;
+			cnt++;
+		} else
+			sp = &s->next;
+	}
+	return cnt;
 }
 
 
@@ -2067,15 +2304,15 @@ unpack_error:
 static void
 _cred_state_pack(slurm_cred_ctx_t ctx, Buf buffer)
 {
-	ListIterator  i = NULL;
 	cred_state_t *s = NULL;
+	int i;
 
-	pack32(list_count(ctx->state_list), buffer);
+	pack32(ctx->state_cnt, buffer);
 
-	i = list_iterator_create(ctx->state_list);
-	while ((s = list_next(i)))
-		_cred_state_pack_one(s, buffer);
-	list_iterator_destroy(i);
+	for (i = 0; i < CRED_STATE_HASH_SIZE; i++) {
+		for (s = ctx->state_hash[i]; s; s = s->next)
+			_cred_state_pack_one(s, buffer);
+	}
 }
 
 
@@ -2094,7 +2331,9 @@ _cred_state_unpack(slurm_cred_ctx_t ctx, Buf buffer)
 			goto unpack_error;
 
 		if (now < s->expiration)
-			list_append(ctx->state_list, s);
+			_append_cred_state(ctx, s);
+		else
+			_cred_state_destroy(s);
 	}
 
 	return;
@@ -2108,16 +2347,15 @@ unpack_error:
 static void
 _job_state_pack(slurm_cred_ctx_t ctx, Buf buffer)
 {
-	ListIterator  i = NULL;
 	job_state_t  *j = NULL;
+	int i;
 
-	pack32((uint32_t) list_count(ctx->job_list), buffer);
-
+	pack32(ctx->job_cnt, buffer);
 
-	i = list_iterator_create(ctx->job_list);
-	while ((j = list_next(i)))
-		_job_state_pack_one(j, buffer);
-	list_iterator_destroy(i);
+	for (i = 0; i < JOB_STATE_HASH_SIZE; i++) {
+		for (j = ctx->job_hash[i]; j; j = j->next)
+			_job_state_pack_one(j, buffer);
+	}
 }
 
 
@@ -2136,10 +2374,11 @@ _job_state_unpack(slurm_cred_ctx_t ctx, Buf buffer)
 			goto unpack_error;
 
 		if (!j->revoked || (j->revoked && (now < j->expiration)))
-			list_append(ctx->job_list, j);
+			_append_job_state(ctx, j);
 		else {
 			debug3 ("not appending expired job %u state",
 				j->jobid);
+			_job_state_destroy(j);
 		}
 	}
 
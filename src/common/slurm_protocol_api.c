@@ -48,16 +48,20 @@
 #endif /* WITH_PTHREADS */
 
 #include <errno.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 #include <ctype.h>
 
 /* PROJECT INCLUDES */
+#include "src/common/fd.h"
 #include "src/common/macros.h"
 #include "src/common/pack.h"
 #include "src/common/parse_spec.h"
@@ -71,6 +75,7 @@
 #include "src/common/xstring.h"
 #include "src/common/log.h"
 #include "src/common/forward.h"
+#include "src/common/lz_compress.h"
 #include "src/slurmdbd/read_config.h"
 #include "src/common/slurm_accounting_storage.h"
 
@@ -81,6 +86,38 @@
 #define MAX_SHUTDOWN_RETRY 5
 #define MAX_RETRIES 3
 
+#define PERSIST_CONN_CACHE	256	/* connections cached by a process */
+#define PERSIST_CONN_PER_DEST	2	/* opened to one daemon when busy */
+#define PERSIST_CONN_DEPTH	8	/* requests in flight on one */
+
+#define MAX_EXPANDED_SIZE	(128 * 1024 * 1024)	/* as MAX_MSG_SIZE */
+
+typedef struct persist_req {
+	uint32_t msg_id;
+	bool     abandoned;	/* sender gave up, discard the response */
+	char    *buf;		/* response once read */
+	size_t   buflen;
+} persist_req_t;
+
+typedef struct persist_conn {
+	slurm_addr_t addr;
+	bool       controller;	/* connection to the primary slurmctld */
+	slurm_fd_t fd;		/* -1 if the daemon declined to keep it */
+	int        reserved;	/* requesters using it plus requests
+				 * abandoned in req[] */
+	persist_req_t req[PERSIST_CONN_DEPTH];	/* in the order sent */
+	int        req_cnt;
+	bool       reading;	/* a requester is reading responses */
+	bool       reused;	/* a response has been read on it */
+	bool       closing;	/* send no more requests on it */
+	bool       declined;	/* closed by the daemon after the first */
+	bool       last_read;	/* the daemon read no request after the
+				 * one it closes the connection with */
+	int        error;	/* errno of a failed send or read */
+	time_t     last_used;
+	pthread_mutex_t send_lock;
+} persist_conn_t;
+
 /* STATIC VARIABLES */
 /* static pthread_mutex_t config_lock = PTHREAD_MUTEX_INITIALIZER; */
 static slurm_protocol_config_t proto_conf_default;
@@ -88,8 +125,35 @@ static slurm_protocol_config_t *proto_conf = &proto_conf_default;
 /* static slurm_ctl_conf_t slurmctld_conf; */
 static int message_timeout = -1;
 
+static pthread_mutex_t persist_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  persist_cond = PTHREAD_COND_INITIALIZER;
+static List     persist_conns = NULL;
+static pid_t    persist_pid = 0;
+static uint32_t persist_msg_id = 0;
+
+/* identifiers of requests being responded to, by accepted connection */
+static pthread_mutex_t persist_reply_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t *persist_reply_id = NULL;
+static int       persist_reply_size = 0;
+
+/* The parts of a header a signed credential covers, see _signed_header() */
+#define SIGNED_HEADER_SIZE	10
+
 /* STATIC FUNCTIONS */
+static void *_auth_create(slurm_msg_t *msg, header_t *hdr,
+			  struct iovec *body, int bodycnt);
+static int   _auth_verify(void *auth_cred, header_t *hdr, Buf buffer);
+static int   _forward_timeout(slurm_msg_t *req, int *timeout);
 static char *_global_auth_key(void);
+static bool  _persist_conn_lost(int err);
+static int   _persist_recv(persist_conn_t *conn, uint32_t msg_id,
+			   char **buf, size_t *buflen, int timeout);
+static uint32_t _persist_reply_get(slurm_fd_t fd);
+static void  _persist_reply_set(slurm_fd_t fd, uint32_t msg_id);
+static int   _receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout,
+			  persist_conn_t *conn, uint32_t msg_id);
+static List  _receive_msgs(slurm_fd_t fd, int steps, int timeout,
+			   persist_conn_t *conn, uint32_t msg_id);
 static void  _remap_slurmctld_errno(void);
 static int   _unpack_msg_uid(Buf buffer);
 
@@ -432,6 +496,24 @@ char *slurm_get_mpi_params(void)
 	return mpi_params;
 }
 
+/* slurm_get_msg_persist_timeout
+ * get idle time of persistent connections from slurmctld_conf object
+ * RET uint16_t - seconds, 0 if connections are not kept
+ */
+uint16_t slurm_get_msg_persist_timeout(void)
+{
+	uint16_t msg_persist_timeout = 0;
+	slurm_ctl_conf_t *conf;
+
+	if (slurmdbd_conf) {
+	} else {
+		conf = slurm_conf_lock();
+		msg_persist_timeout = conf->msg_persist_timeout;
+		slurm_conf_unlock();
+	}
+	return msg_persist_timeout;
+}
+
 /* slurm_get_msg_timeout
  * get default message timeout value from slurmctld_conf object
  */
@@ -741,6 +823,24 @@ char *slurm_get_auth_type(void)
 	return auth_type;
 }
 
+/* slurm_get_auth_session_timeout
+ * get lifetime of message signing keys from slurmctld_conf object
+ * RET uint16_t - seconds, 0 if every message carries its own credential
+ */
+uint16_t slurm_get_auth_session_timeout(void)
+{
+	uint16_t auth_session_timeout = 0;
+	slurm_ctl_conf_t *conf;
+
+	if (slurmdbd_conf) {
+	} else {
+		conf = slurm_conf_lock();
+		auth_session_timeout = conf->auth_session_timeout;
+		slurm_conf_unlock();
+	}
+	return auth_session_timeout;
+}
+
 /* slurm_get_checkpoint_type
  * returns the checkpoint_type from slurmctld_conf object
  * RET char *    - checkpoint type, MUST be xfreed by caller
@@ -1913,6 +2013,7 @@ int slurm_shutdown_msg_engine(slurm_fd_t fd)
  */
 int slurm_shutdown_msg_conn(slurm_fd_t fd)
 {
+	_persist_reply_set(fd, 0);
 	return _slurm_close(fd);
 }
 
@@ -1930,7 +2031,10 @@ int slurm_shutdown_msg_conn(slurm_fd_t fd)
  */
 slurm_fd_t slurm_open_msg_conn(slurm_addr_t * slurm_address)
 {
-	return _slurm_open_msg_conn(slurm_address);
+	slurm_fd_t fd = _slurm_open_msg_conn(slurm_address);
+
+	_persist_reply_set(fd, 0);
+	return fd;
 }
 
 /* Calls connect to make a connection-less datagram connection to the
@@ -2072,13 +2176,712 @@ slurm_fd_t slurm_accept_msg_conn(slurm_fd_t open_fd,
  */
 int slurm_close_accepted_conn(slurm_fd_t open_fd)
 {
+	_persist_reply_set(open_fd, 0);
 	return _slurm_close_accepted_conn(open_fd);
 }
 
+/**********************************************************************\
+ * persistent connection functions
+ *
+ * With MessagePersistTimeout set, requests to a single slurmctld or
+ * slurmd are sent over cached connections. Each request carries an
+ * identifier in its header and several may be in flight on one
+ * connection; whichever requester is waiting reads the responses and
+ * hands each to its owner. A daemon tags its response with the
+ * request's identifier only if it will keep the connection open, so an
+ * untagged response belongs to the oldest request and is the last one
+ * read on that connection.
+\**********************************************************************/
+
+static void _persist_reply_set(slurm_fd_t fd, uint32_t msg_id)
+{
+	int new_size;
+
+	if (fd < 0)
+		return;
+
+	slurm_mutex_lock(&persist_reply_lock);
+	if (fd >= persist_reply_size) {
+		if (msg_id == 0) {
+			slurm_mutex_unlock(&persist_reply_lock);
+			return;
+		}
+		new_size = MAX(fd + 1, persist_reply_size * 2);
+		new_size = MAX(new_size, 64);
+		xrealloc(persist_reply_id, sizeof(uint32_t) * new_size);
+		persist_reply_size = new_size;
+	}
+	persist_reply_id[fd] = msg_id;
+	slurm_mutex_unlock(&persist_reply_lock);
+}
+
+static uint32_t _persist_reply_get(slurm_fd_t fd)
+{
+	uint32_t msg_id = 0;
+
+	slurm_mutex_lock(&persist_reply_lock);
+	if ((fd >= 0) && (fd < persist_reply_size))
+		msg_id = persist_reply_id[fd];
+	slurm_mutex_unlock(&persist_reply_lock);
+
+	return msg_id;
+}
+
+/*
+ * Decide whether a connection accepted by a daemon is kept open for
+ * further requests once msg has been responded to.
+ * IN/OUT msg - request just received
+ * IN allow   - false if the daemon is short of threads
+ * RET true if the caller should wait for another request
+ */
+extern bool slurm_persist_conn_keep(slurm_msg_t *msg, bool allow)
+{
+	if (!(msg->flags & SLURM_PERSIST_CONN) || !msg->msg_id ||
+	    (msg->conn_fd < 0) || !allow) {
+		msg->flags &= (~SLURM_PERSIST_CONN);
+		msg->msg_id = 0;
+		return false;
+	}
+
+	_persist_reply_set(msg->conn_fd, msg->msg_id);
+	return true;
+}
+
+/*
+ * Wait for another request on a persistent connection.
+ * IN fd      - connection
+ * IN timeout - how long to wait in milliseconds
+ * RET 1 if a request is ready, 0 on timeout, -1 if the peer closed it
+ */
+extern int slurm_persist_conn_wait(slurm_fd_t fd, int timeout)
+{
+	struct pollfd ufds;
+	char c;
+	int rc;
+
+	ufds.fd     = fd;
+	ufds.events = POLLIN;
+	while ((rc = poll(&ufds, 1, timeout)) < 0) {
+		if ((errno != EINTR) && (errno != EAGAIN))
+			return -1;
+	}
+	if (rc == 0)
+		return 0;
+	if ((ufds.revents & (POLLERR | POLLNVAL)) ||
+	    (recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) <= 0))
+		return -1;
+	return 1;
+}
+
+/* Errors after which a request sent on a reused connection may not have
+ * been read by the daemon, which closed the connection */
+static bool _persist_conn_lost(int err)
+{
+	return ((err == SLURM_PROTOCOL_SOCKET_ZERO_BYTES_SENT) ||
+		(err == SLURM_COMMUNICATIONS_RECEIVE_ERROR) ||
+		(err == SLURM_COMMUNICATIONS_SEND_ERROR) ||
+		(err == ENOTCONN) || (err == EPIPE) || (err == ECONNRESET));
+}
+
+/* True if the daemon closed a connection with no responses due on it,
+ * so that a request is not sent into a connection already gone */
+static bool _persist_conn_closed(slurm_fd_t fd)
+{
+	char c;
+	int rc;
+
+	while ((rc = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT)) < 0) {
+		if (errno != EINTR)
+			break;
+	}
+	if (rc == 0)
+		return true;
+	return ((rc < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK));
+}
+
+/* Requests which change nothing and may be sent again if the daemon
+ * might have read them before the connection was lost */
+static bool _persist_msg_idempotent(slurm_msg_type_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_PING:
+	case REQUEST_BUILD_INFO:
+	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_JOB_STEP_INFO:
+	case REQUEST_NODE_INFO:
+	case REQUEST_PARTITION_INFO:
+	case REQUEST_ACCTING_INFO:
+	case REQUEST_JOB_ID:
+	case REQUEST_BLOCK_INFO:
+	case REQUEST_TRIGGER_GET:
+	case REQUEST_SHARE_INFO:
+	case REQUEST_RESERVATION_INFO:
+	case REQUEST_PRIORITY_FACTORS:
+	case REQUEST_TOPO_INFO:
+	case REQUEST_FRONT_END_INFO:
+	case REQUEST_JOB_ALLOCATION_INFO:
+	case REQUEST_JOB_ALLOCATION_INFO_LITE:
+	case REQUEST_JOB_READY:
+	case REQUEST_JOB_END_TIME:
+	case REQUEST_STEP_LAYOUT:
+	case REQUEST_DAEMON_STATUS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Return the identifier of the message in buf, see pack_header() */
+static uint32_t _persist_msg_id(char *buf, size_t buflen)
+{
+	Buf buffer = create_buf(buf, buflen);
+	uint16_t version, flags;
+	uint32_t msg_id = 0;
+
+	safe_unpack16(&version, buffer);
+	safe_unpack16(&flags, buffer);
+	if ((flags & SLURM_PERSIST_CONN) &&
+	    (version >= SLURM_2_3_PROTOCOL_VERSION))
+		safe_unpack32(&msg_id, buffer);
+
+unpack_error:
+	buffer->head = NULL;	/* buf belongs to the caller */
+	free_buf(buffer);
+	return msg_id;
+}
+
+static int _msec_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((now.tv_sec - start->tv_sec) * 1000) +
+	       ((now.tv_usec - start->tv_usec) / 1000);
+}
+
+static int _persist_conn_find(void *x, void *key)
+{
+	return (x == key);
+}
+
+static void _persist_conn_free(persist_conn_t *conn)
+{
+	int i;
+
+	for (i = 0; i < conn->req_cnt; i++)
+		xfree(conn->req[i].buf);
+	if (conn->fd >= 0)
+		(void) slurm_shutdown_msg_conn(conn->fd);
+	slurm_mutex_destroy(&conn->send_lock);
+	xfree(conn);
+}
+
+static int _persist_req_index(persist_conn_t *conn, uint32_t msg_id)
+{
+	int i;
+
+	for (i = 0; i < conn->req_cnt; i++) {
+		if (conn->req[i].msg_id == msg_id)
+			return i;
+	}
+	return -1;
+}
+
+static void _persist_req_remove(persist_conn_t *conn, int inx)
+{
+	xfree(conn->req[inx].buf);
+	conn->req_cnt--;
+	memmove(&conn->req[inx], &conn->req[inx + 1],
+		sizeof(persist_req_t) * (conn->req_cnt - inx));
+}
+
+/* Drop requests whose senders gave up, their responses will never be
+ * read. persist_lock must be held */
+static void _persist_drop_abandoned(persist_conn_t *conn)
+{
+	int i;
+
+	for (i = conn->req_cnt - 1; i >= 0; i--) {
+		if (!conn->req[i].abandoned)
+			continue;
+		_persist_req_remove(conn, i);
+		conn->reserved--;
+	}
+}
+
+/* Close a connection that can no longer be used once nobody is waiting
+ * on it.
+ * A daemon which did not keep the first request's connection is
+ * remembered until it expires so that further requests to it go on
+ * connections of their own. persist_lock must be held */
+static void _persist_conn_release(persist_conn_t *conn)
+{
+	int i, abandoned = 0;
+
+	if (!conn->closing && !conn->error)
+		return;
+	for (i = 0; i < conn->req_cnt; i++) {
+		if (conn->req[i].abandoned)
+			abandoned++;
+	}
+	if (conn->reserved > abandoned)
+		return;
+	_persist_drop_abandoned(conn);
+
+	if (conn->declined) {
+		if (conn->fd >= 0) {
+			(void) slurm_shutdown_msg_conn(conn->fd);
+			conn->fd = -1;
+		}
+		return;
+	}
+	list_delete_all(persist_conns, _persist_conn_find, conn);
+	_persist_conn_free(conn);
+}
+
+/* Hand the message read in buf to the request it responds to.
+ * persist_lock must be held */
+static void _persist_route(persist_conn_t *conn, char *buf, size_t buflen)
+{
+	uint32_t msg_id = _persist_msg_id(buf, buflen);
+	int inx;
+
+	if (msg_id == 0) {
+		/* the daemon closes the connection after this response,
+		 * requests sent behind it were never read */
+		conn->closing = true;
+		conn->last_read = true;
+		if (!conn->reused)
+			conn->declined = true;
+		inx = conn->req_cnt ? 0 : -1;
+	} else
+		inx = _persist_req_index(conn, msg_id);
+	conn->reused = true;
+
+	if (inx < 0) {
+		debug2("discarding response %u on persistent connection",
+		       msg_id);
+		xfree(buf);
+	} else if (conn->req[inx].abandoned) {
+		xfree(buf);
+		_persist_req_remove(conn, inx);
+		conn->reserved--;
+	} else {
+		conn->req[inx].buf = buf;
+		conn->req[inx].buflen = buflen;
+	}
+}
+
+static bool _persist_addr_eq(slurm_addr_t *a, slurm_addr_t *b)
+{
+	return ((a->sin_addr.s_addr == b->sin_addr.s_addr) &&
+		(a->sin_port == b->sin_port));
+}
+
+/*
+ * Assign a request to addr, or to the primary slurmctld if addr is NULL,
+ * a cached connection, opening one if those to the daemon are all busy.
+ * OUT reused - set if a response has already been read on the connection
+ * OUT rc     - set to -1 if the slurmd could not be reached
+ * RET the connection or NULL if the request should be sent on a
+ *	connection of its own
+ */
+static persist_conn_t *_persist_conn_get(slurm_addr_t *addr, bool *reused,
+					 int *rc)
+{
+	persist_conn_t *conn, *best = NULL, *idle = NULL;
+	ListIterator itr;
+	uint16_t persist_timeout = slurm_get_msg_persist_timeout();
+	time_t now = time(NULL);
+	slurm_addr_t ctl_addr;
+	slurm_fd_t fd;
+	int dest_cnt = 0;
+
+	*rc = 0;
+	if (!persist_timeout || working_cluster_rec)
+		return NULL;
+
+	slurm_mutex_lock(&persist_lock);
+	if (persist_pid != getpid()) {
+		/* The connections of our parent process are not ours to
+		 * use, the copies of their descriptors are closed on exec */
+		persist_conns = NULL;
+		persist_pid = getpid();
+	}
+	if (!persist_conns)
+		persist_conns = list_create(NULL);
+
+	itr = list_iterator_create(persist_conns);
+	while ((conn = list_next(itr))) {
+		if (!conn->reserved &&
+		    (difftime(now, conn->last_used) >= persist_timeout)) {
+			list_remove(itr);
+			_persist_conn_free(conn);
+			continue;
+		}
+		if (addr ? (conn->controller ||
+			    !_persist_addr_eq(&conn->addr, addr)) :
+			   !conn->controller) {
+			if (!conn->reserved &&
+			    (!idle || (conn->last_used < idle->last_used)))
+				idle = conn;
+			continue;
+		}
+		if (conn->fd < 0)	/* daemon declined to keep it */
+			break;
+		if (conn->closing || conn->error)
+			continue;
+		dest_cnt++;
+		if ((conn->reserved < PERSIST_CONN_DEPTH) &&
+		    (!best || (conn->reserved < best->reserved)))
+			best = conn;
+	}
+	list_iterator_destroy(itr);
+	if (conn) {
+		slurm_mutex_unlock(&persist_lock);
+		return NULL;
+	}
+
+	if (best && (!best->reserved || (dest_cnt >= PERSIST_CONN_PER_DEST) ||
+		     ((list_count(persist_conns) >= PERSIST_CONN_CACHE) &&
+		      !idle))) {
+		best->reserved++;
+		*reused = best->reused;
+		slurm_mutex_unlock(&persist_lock);
+		return best;
+	}
+	if (list_count(persist_conns) >= PERSIST_CONN_CACHE) {
+		if (!idle) {
+			slurm_mutex_unlock(&persist_lock);
+			return NULL;
+		}
+		list_delete_all(persist_conns, _persist_conn_find, idle);
+		_persist_conn_free(idle);
+	}
+	slurm_mutex_unlock(&persist_lock);
+
+	if (addr) {
+		if ((fd = slurm_open_msg_conn(addr)) < 0) {
+			*rc = -1;
+			return NULL;
+		}
+	} else {
+		/* Only the primary is tried, slurm_open_controller_conn()
+		 * handles the backup and retries */
+		if (slurm_api_set_default_config() < 0)
+			return NULL;
+		ctl_addr = proto_conf->primary_controller;
+		ctl_addr.sin_port = htons(slurmctld_conf.slurmctld_port +
+					  (((time(NULL) + getpid()) %
+					    slurmctld_conf.
+					    slurmctld_port_count)));
+		if ((fd = slurm_open_msg_conn(&ctl_addr)) < 0)
+			return NULL;
+	}
+	fd_set_close_on_exec(fd);
+
+	conn = xmalloc(sizeof(persist_conn_t));
+	conn->addr = addr ? *addr : ctl_addr;
+	conn->controller = (addr == NULL);
+	conn->fd = fd;
+	conn->reserved = 1;
+	conn->last_used = now;
+	slurm_mutex_init(&conn->send_lock);
+	*reused = false;
+
+	slurm_mutex_lock(&persist_lock);
+	list_append(persist_conns, conn);
+	slurm_mutex_unlock(&persist_lock);
+	return conn;
+}
+
+/*
+ * Send req on conn with a new request identifier.
+ * RET the identifier or 0 if it could not be sent, errno set
+ */
+static uint32_t _persist_send(persist_conn_t *conn, slurm_msg_t *req)
+{
+	uint32_t msg_id;
+	int rc, err;
+
+	slurm_mutex_lock(&conn->send_lock);
+	slurm_mutex_lock(&persist_lock);
+	if (!conn->error && !conn->closing && !conn->req_cnt &&
+	    !conn->reading && _persist_conn_closed(conn->fd))
+		conn->error = SLURM_COMMUNICATIONS_SEND_ERROR;
+	if (conn->error || conn->closing) {
+		slurm_mutex_unlock(&persist_lock);
+		slurm_mutex_unlock(&conn->send_lock);
+		slurm_seterrno(SLURM_COMMUNICATIONS_SEND_ERROR);
+		return 0;
+	}
+	if (++persist_msg_id == 0)
+		persist_msg_id = 1;
+	msg_id = persist_msg_id;
+	/* the requests are recorded in the order they are sent */
+	memset(&conn->req[conn->req_cnt], 0, sizeof(persist_req_t));
+	conn->req[conn->req_cnt++].msg_id = msg_id;
+	slurm_mutex_unlock(&persist_lock);
+
+	req->flags |= SLURM_PERSIST_CONN;
+	req->msg_id = msg_id;
+	rc = slurm_send_node_msg(conn->fd, req);
+	req->flags &= (~SLURM_PERSIST_CONN);
+	req->msg_id = 0;
+	slurm_mutex_unlock(&conn->send_lock);
+	if (rc >= 0)
+		return msg_id;
+
+	err = slurm_get_errno();
+	slurm_mutex_lock(&persist_lock);
+	conn->error = SLURM_COMMUNICATIONS_SEND_ERROR;
+	_persist_req_remove(conn, _persist_req_index(conn, msg_id));
+	_persist_drop_abandoned(conn);
+	pthread_cond_broadcast(&persist_cond);
+	slurm_mutex_unlock(&persist_lock);
+	slurm_seterrno(err);
+	return 0;
+}
+
+/*
+ * Wait for the response to request msg_id on conn, reading the
+ * connection if no other requester is.
+ * OUT buf, buflen - the response, must be xfreed
+ * IN timeout      - how long to wait in milliseconds
+ * RET 0 or -1 on failure, errno set
+ */
+static int _persist_recv(persist_conn_t *conn, uint32_t msg_id,
+			 char **buf, size_t *buflen, int timeout)
+{
+	struct timeval tstart;
+	struct timespec deadline;
+	char *rbuf;
+	size_t rlen;
+	int inx, rc = -1, err = 0, time_left;
+
+	gettimeofday(&tstart, NULL);
+	deadline.tv_sec  = tstart.tv_sec + (timeout / 1000);
+	deadline.tv_nsec = (tstart.tv_usec + (timeout % 1000) * 1000) * 1000;
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	slurm_mutex_lock(&persist_lock);
+	while (1) {
+		if ((inx = _persist_req_index(conn, msg_id)) < 0) {
+			err = conn->error ? conn->error :
+			      SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+			break;
+		}
+		if (conn->req[inx].buf) {
+			*buf = conn->req[inx].buf;
+			*buflen = conn->req[inx].buflen;
+			conn->req[inx].buf = NULL;
+			_persist_req_remove(conn, inx);
+			rc = 0;
+			break;
+		}
+		if (conn->error) {
+			err = conn->error;
+			break;
+		}
+		time_left = timeout - _msec_since(&tstart);
+		if (!conn->reading && (time_left > 0)) {
+			conn->reading = true;
+			slurm_mutex_unlock(&persist_lock);
+			rbuf = NULL;
+			rlen = 0;
+			rc = _slurm_msg_recvfrom_timeout(conn->fd, &rbuf,
+							 &rlen, 0, time_left);
+			err = slurm_get_errno();
+			slurm_mutex_lock(&persist_lock);
+			conn->reading = false;
+			if (rc < 0) {
+				conn->error = err ? err :
+					SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+				_persist_drop_abandoned(conn);
+			} else
+				_persist_route(conn, rbuf, rlen);
+			rc = -1;
+			pthread_cond_broadcast(&persist_cond);
+			continue;
+		}
+		if ((time_left <= 0) ||
+		    (pthread_cond_timedwait(&persist_cond, &persist_lock,
+					    &deadline) == ETIMEDOUT)) {
+			if (conn->req[inx].buf)
+				continue;
+			/* The response is discarded if read. The daemon is
+			 * slow, send no more requests this way */
+			conn->req[inx].abandoned = true;
+			conn->closing = true;
+			err = SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT;
+			break;
+		}
+	}
+	slurm_mutex_unlock(&persist_lock);
+
+	if (rc < 0)
+		slurm_seterrno(err);
+	return rc;
+}
+
+/*
+ * Finish with a connection assigned by _persist_conn_get().
+ * IN msg_id   - identifier of the request sent, 0 if it was not
+ * IN msg_type - type of the request
+ * IN rc       - result of the request, errno is preserved
+ * IN reused   - as returned by _persist_conn_get()
+ * RET true if the request should be sent on a connection of its own:
+ *	it was not sent, the daemon stopped reading before it, or it is
+ *	idempotent and the connection was lost
+ */
+static bool _persist_conn_done(persist_conn_t *conn, uint32_t msg_id,
+			       slurm_msg_type_t msg_type, int rc,
+			       bool reused)
+{
+	int err = slurm_get_errno();
+	bool resend = false;
+	int inx = -1;
+
+	slurm_mutex_lock(&persist_lock);
+	if (rc && (!msg_id ||
+		   (_persist_conn_lost(err) &&
+		    (conn->last_read ||
+		     ((reused || conn->closing) &&
+		      _persist_msg_idempotent(msg_type))))))
+		resend = true;
+	if (msg_id)
+		inx = _persist_req_index(conn, msg_id);
+	if ((inx < 0) || !conn->req[inx].abandoned) {
+		if (inx >= 0)
+			_persist_req_remove(conn, inx);
+		conn->reserved--;
+	}
+	conn->last_used = time(NULL);
+	_persist_conn_release(conn);
+	pthread_cond_broadcast(&persist_cond);
+	slurm_mutex_unlock(&persist_lock);
+
+	slurm_seterrno(err);
+	return resend;
+}
+
+/*
+ * Send a request with no forwarding to addr, or to the primary slurmctld
+ * if addr is NULL, and read its response over a cached connection.
+ * RET 0 or -1 as _send_and_recv_msg(), or 1 if persistent connections
+ *	are not in use and the caller should open a connection of its own
+ */
+static int _persist_send_recv_msg(slurm_addr_t *addr, slurm_msg_t *req,
+				  slurm_msg_t *resp, int timeout)
+{
+	persist_conn_t *conn;
+	uint32_t msg_id;
+	bool reused = false;
+	int rc;
+
+	if (((req->forward.init == FORWARD_INIT) && req->forward.cnt) ||
+	    ((req->protocol_version != (uint16_t) NO_VAL) &&
+	     (req->protocol_version < SLURM_2_3_PROTOCOL_VERSION)))
+		return 1;
+	if (!(conn = _persist_conn_get(addr, &reused, &rc)))
+		return rc ? rc : 1;
+
+	if ((msg_id = _persist_send(conn, req)))
+		rc = _receive_msg(conn->fd, resp, timeout, conn, msg_id);
+	else {
+		slurm_msg_t_init(resp);
+		rc = -1;
+	}
+	resp->conn_fd = -1;
+
+	if (_persist_conn_done(conn, msg_id, req->msg_type, rc, reused)) {
+		debug2("persistent connection closed, resending msg_type=%u",
+		       req->msg_type);
+		return 1;
+	}
+	return rc;
+}
+
+/*
+ * As _persist_send_recv_msg() for a request which may be forwarded.
+ * OUT ret_list - as returned by _send_and_recv_msgs()
+ * RET 0 if ret_list is set, 1 if the caller should open a connection of
+ *	its own
+ */
+static int _persist_send_recv_msgs(slurm_addr_t *addr, slurm_msg_t *req,
+				   int timeout, List *ret_list)
+{
+	persist_conn_t *conn;
+	uint32_t msg_id;
+	bool reused = false;
+	int rc, steps;
+
+	*ret_list = NULL;
+	if ((req->protocol_version != (uint16_t) NO_VAL) &&
+	    (req->protocol_version < SLURM_2_3_PROTOCOL_VERSION))
+		return 1;
+	if (!(conn = _persist_conn_get(addr, &reused, &rc)))
+		return rc ? 0 : 1;
+
+	steps = _forward_timeout(req, &timeout);
+	if ((msg_id = _persist_send(conn, req)))
+		*ret_list = _receive_msgs(conn->fd, steps, timeout, conn,
+					  msg_id);
+	rc = (*ret_list && (slurm_get_errno() == SLURM_SUCCESS)) ? 0 : -1;
+
+	if (_persist_conn_done(conn, msg_id, req->msg_type, rc, reused)) {
+		debug2("persistent connection closed, resending msg_type=%u",
+		       req->msg_type);
+		if (*ret_list)
+			list_destroy(*ret_list);
+		*ret_list = NULL;
+		return 1;
+	}
+	return 0;
+}
+
 /**********************************************************************\
  * receive message functions
 \**********************************************************************/
 
+/*
+ * Expand a message body compressed by slurm_send_node_msg(), its length
+ * before compression followed by the lz_compress() output. The buffer is
+ * replaced by one holding the expanded body.
+ * RET SLURM_SUCCESS or SLURM_ERROR, leaving the buffer unchanged
+ */
+static int _expand_body(header_t *header, Buf *buffer)
+{
+	Buf old = *buffer;
+	uint32_t size, offset = get_buf_offset(old);
+	char *data;
+
+	if ((header->body_length > remaining_buf(old)) ||
+	    (header->body_length < sizeof(uint32_t)) ||
+	    unpack32(&size, old) || (size > MAX_EXPANDED_SIZE)) {
+		set_buf_offset(old, offset);
+		return SLURM_ERROR;
+	}
+
+	data = xmalloc(size);
+	if (lz_decompress(&old->head[old->processed],
+			  header->body_length - sizeof(uint32_t),
+			  data, size) != (int) size) {
+		error("slurm_receive_msg: bad compressed body");
+		xfree(data);
+		set_buf_offset(old, offset);
+		return SLURM_ERROR;
+	}
+	*buffer = create_buf(data, size);
+	free_buf(old);
+	header->body_length = size;
+	return SLURM_SUCCESS;
+}
+
 /*
  * NOTE: memory is allocated for the returned msg must be freed at
  *       some point using the slurm_free_functions.
@@ -2088,6 +2891,15 @@ int slurm_close_accepted_conn(slurm_fd_t open_fd)
  * RET int	- returns 0 on success, -1 on failure and sets errno
  */
 int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
+{
+	return _receive_msg(fd, msg, timeout, NULL, 0);
+}
+
+/* As slurm_receive_msg(). If conn is set, read the response to request
+ * msg_id on that persistent connection, reading responses to other
+ * requests on it as needed */
+static int _receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout,
+			persist_conn_t *conn, uint32_t msg_id)
 {
 	char *buf = NULL;
 	size_t buflen = 0;
@@ -2100,6 +2912,8 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 
 	slurm_msg_t_init(msg);
 	msg->conn_fd = fd;
+	if (!conn)
+		_persist_reply_set(fd, 0);
 
 	if (timeout <= 0)
 		/* convert secs to msec */
@@ -2119,7 +2933,12 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 	 *  length and allocate space on the heap for a buffer containing
 	 *  the message.
 	 */
-	if (_slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
+	if (conn)
+		rc = _persist_recv(conn, msg_id, &buf, &buflen, timeout);
+	else
+		rc = _slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0,
+						 timeout);
+	if (rc < 0) {
 		forward_init(&header.forward, NULL);
 		rc = errno;
 		goto total_return;
@@ -2171,11 +2990,7 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _global_auth_key() );
-	} else
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2, NULL );
+	rc = _auth_verify(auth_cred, &header, buffer);
 
 	if (rc != SLURM_SUCCESS) {
 		error( "authentication: %s ",
@@ -2186,12 +3001,21 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_COMPRESSED) &&
+	    (_expand_body(&header, &buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
 	msg->protocol_version = header.version;
 	msg->msg_type = header.msg_type;
 	msg->flags = header.flags;
+	msg->msg_id = header.msg_id;
 
 	if ((header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(msg, buffer) != SLURM_SUCCESS)) {
@@ -2212,7 +3036,10 @@ total_return:
 	slurm_seterrno(rc);
 	if (rc != SLURM_SUCCESS) {
 		msg->auth_cred = (void *) NULL;
-		error("slurm_receive_msg: %s", slurm_strerror(rc));
+		if (conn && _persist_conn_lost(rc))
+			debug2("slurm_receive_msg: %s", slurm_strerror(rc));
+		else
+			error("slurm_receive_msg: %s", slurm_strerror(rc));
 		rc = -1;
 	} else {
 		rc = 0;
@@ -2232,6 +3059,13 @@ total_return:
  *		  (ret_data_info_t).
  */
 List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
+{
+	return _receive_msgs(fd, steps, timeout, NULL, 0);
+}
+
+/* As slurm_receive_msgs(), reading on persistent connection conn if set */
+static List _receive_msgs(slurm_fd_t fd, int steps, int timeout,
+			  persist_conn_t *conn, uint32_t msg_id)
 {
 	char *buf = NULL;
 	size_t buflen = 0;
@@ -2286,7 +3120,12 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 	 *  length and allocate space on the heap for a buffer containing
 	 *  the message.
 	 */
-	if (_slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
+	if (conn)
+		rc = _persist_recv(conn, msg_id, &buf, &buflen, timeout);
+	else
+		rc = _slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0,
+						 timeout);
+	if (rc < 0) {
 		forward_init(&header.forward, NULL);
 		rc = errno;
 		goto total_return;
@@ -2338,11 +3177,7 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _global_auth_key() );
-	} else
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2, NULL );
+	rc = _auth_verify(auth_cred, &header, buffer);
 
 	if (rc != SLURM_SUCCESS) {
 		error("authentication: %s ",
@@ -2353,6 +3188,14 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_COMPRESSED) &&
+	    (_expand_body(&header, &buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -2382,7 +3225,10 @@ total_return:
 			ret_data_info->data = NULL;
 			list_push(ret_list, ret_data_info);
 		}
-		error("slurm_receive_msgs: %s", slurm_strerror(rc));
+		if (conn && _persist_conn_lost(rc))
+			debug2("slurm_receive_msgs: %s", slurm_strerror(rc));
+		else
+			error("slurm_receive_msgs: %s", slurm_strerror(rc));
 	} else {
 		if (!ret_list)
 			ret_list = list_create(destroy_data_info);
@@ -2451,6 +3297,7 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 	memcpy(&msg->orig_addr, orig_addr, sizeof(slurm_addr_t));
 
 	msg->ret_list = list_create(destroy_data_info);
+	_persist_reply_set(fd, 0);
 
 	if (timeout <= 0)
 		/* convert secs to msec */
@@ -2568,11 +3415,7 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _global_auth_key() );
-	} else
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2, NULL );
+	rc = _auth_verify(auth_cred, &header, buffer);
 
 	if (rc != SLURM_SUCCESS) {
 		error( "authentication: %s ",
@@ -2583,11 +3426,20 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_COMPRESSED) &&
+	    (_expand_body(&header, &buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
 	msg->msg_type = header.msg_type;
 	msg->flags = header.flags;
+	msg->msg_id = header.msg_id;
 
 	if ( (header.body_length > remaining_buf(buffer)) ||
 	     (unpack_msg(msg, buffer) != SLURM_SUCCESS) ) {
@@ -2624,26 +3476,110 @@ total_return:
 \**********************************************************************/
 
 /*
- *  Do the wonderful stuff that needs be done to pack msg
- *  and hdr into buffer
+ * Compress a dump for a peer which can expand it
+ * OUT comp_len - length of the compressed dump
+ * RET xmalloc'd compressed dump, or NULL if it would not save an eighth
+ */
+static char *_compress_body(char *data, uint32_t size, uint32_t *comp_len)
+{
+	uint32_t max_len = size - (size / 8);
+	char *comp = xmalloc(max_len);
+
+	*comp_len = lz_compress(data, size, comp, max_len);
+	if (*comp_len == 0)
+		xfree(comp);
+	return comp;
+}
+
+/*
+ *  Fill "data" with the parts of header "hdr" which a signed credential
+ *  covers along with the message body, those a slurmd forwarding the
+ *  message passes on unchanged
  */
 static void
-_pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
+_signed_header(header_t *hdr, unsigned char data[SIGNED_HEADER_SIZE])
 {
-	unsigned int tmplen, msglen;
+	uint16_t flags = hdr->flags & (~SLURM_PERSIST_CONN);
+	uint16_t val16;
+	uint32_t val32;
 
-	tmplen = get_buf_offset(buffer);
-	pack_msg(msg, buffer);
-	msglen = get_buf_offset(buffer) - tmplen;
+	val16 = htons(hdr->version);
+	memcpy(data, &val16, sizeof(val16));
+	val16 = htons(flags);
+	memcpy(data + 2, &val16, sizeof(val16));
+	val16 = htons(hdr->msg_type);
+	memcpy(data + 4, &val16, sizeof(val16));
+	val32 = htonl(hdr->body_length);
+	memcpy(data + 6, &val32, sizeof(val32));
+}
 
-	/* update header with correct cred and msg lengths */
-	update_header(hdr, msglen);
+/*
+ *  Create the credential for message "msg" with header "hdr" and the
+ *  "bodycnt" parts of its body in "body". The credential of a message
+ *  to a known user is bound to the message, see slurm_msg_set_r_uid()
+ */
+static void *
+_auth_create(slurm_msg_t *msg, header_t *hdr, struct iovec *body,
+	     int bodycnt)
+{
+	unsigned char signed_hdr[SIGNED_HEADER_SIZE];
+	struct iovec data[3];
+	char *auth_info = NULL;
+	int i;
+
+	if (msg->flags & SLURM_GLOBAL_AUTH_KEY)
+		auth_info = _global_auth_key();
+	if (!msg->restrict_uid_set)
+		return g_slurm_auth_create(NULL, 2, auth_info);
 
-	/* repack updated header */
-	tmplen = get_buf_offset(buffer);
-	set_buf_offset(buffer, 0);
-	pack_header(hdr, buffer);
-	set_buf_offset(buffer, tmplen);
+	xassert(bodycnt < 3);
+	_signed_header(hdr, signed_hdr);
+	data[0].iov_base = signed_hdr;
+	data[0].iov_len  = SIGNED_HEADER_SIZE;
+	for (i = 0; i < bodycnt; i++)
+		data[i + 1] = body[i];
+	return g_slurm_auth_create_signed(NULL, 2, auth_info,
+					  msg->restrict_uid, msg->restrict_gid,
+					  data, bodycnt + 1);
+}
+
+/*
+ *  Verify the credential of a message with header "hdr", "buffer" being
+ *  positioned at the start of the message body
+ */
+static int
+_auth_verify(void *auth_cred, header_t *hdr, Buf buffer)
+{
+	unsigned char signed_hdr[SIGNED_HEADER_SIZE];
+	struct iovec data[2];
+	char *auth_info = NULL;
+
+	if (hdr->flags & SLURM_GLOBAL_AUTH_KEY)
+		auth_info = _global_auth_key();
+
+	/* a truncated body fails to verify if signed and is refused as
+	 * incomplete otherwise */
+	_signed_header(hdr, signed_hdr);
+	data[0].iov_base = signed_hdr;
+	data[0].iov_len  = SIGNED_HEADER_SIZE;
+	data[1].iov_base = get_buf_data(buffer) + get_buf_offset(buffer);
+	data[1].iov_len  = MIN(hdr->body_length, remaining_buf(buffer));
+	return g_slurm_auth_verify_signed(auth_cred, NULL, 2, auth_info,
+					  data, 2);
+}
+
+/*
+ * slurm_msg_set_r_uid
+ * only let processes of user "uid" read the credential of message "msg",
+ *	which then may be signed with a session key, see AuthSessionTimeout
+ * IN msg		- a slurm msg struct to be sent
+ * IN uid		- user id of the receiving process
+ */
+extern void slurm_msg_set_r_uid(slurm_msg_t *msg, uid_t uid)
+{
+	msg->restrict_uid = uid;
+	msg->restrict_gid = SLURM_AUTH_ANY_GID;
+	msg->restrict_uid_set = true;
 }
 
 /*
@@ -2653,24 +3589,13 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 {
 	header_t header;
-	Buf      buffer;
-	int      rc;
+	Buf      buffer, body_buf = NULL;
+	int      rc, bodycnt;
+	struct iovec iov[3];
+	char    *comp = NULL;
+	uint32_t comp_len = 0, data_size;
 	void *   auth_cred;
-	uint16_t auth_flags = SLURM_PROTOCOL_NO_FLAGS;
-
-	/*
-	 * Initialize header with Auth credential and message type.
-	 */
-	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
-		auth_flags = SLURM_GLOBAL_AUTH_KEY;
-		auth_cred = g_slurm_auth_create(NULL, 2, _global_auth_key());
-	} else
-		auth_cred = g_slurm_auth_create(NULL, 2, NULL);
-	if (auth_cred == NULL) {
-		error("authentication: %s",
-		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)) );
-		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
-	}
+	uint32_t msg_id = msg->msg_id;
 
 	if (msg->forward.init != FORWARD_INIT) {
 		forward_init(&msg->forward, NULL);
@@ -2678,30 +3603,79 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	}
 	forward_wait(msg);
 
-	init_header(&header, msg, msg->flags);
+	/* a response on a persistent connection carries the request's
+	 * identifier, see slurm_persist_conn_keep() */
+	if (!msg_id)
+		msg_id = _persist_reply_get(fd);
+	init_header(&header, msg,
+		    msg->flags & (~(SLURM_PERSIST_CONN | SLURM_COMPRESSED)));
+	if (msg_id) {
+		header.flags |= SLURM_PERSIST_CONN;
+		header.msg_id = msg_id;
+	}
 
 	/*
-	 * Pack header into buffer for transmission
+	 * Pack message body first, since a signed credential covers it.
+	 * A job, node, etc. dump already packed by slurmctld is sent from
+	 * where it is rather than copied into a buffer. A large one is
+	 * compressed if the request said the peer can expand it.
 	 */
-	buffer = init_buf(BUF_SIZE);
-	pack_header(&header, buffer);
+	if (pack_msg_prepacked(msg) && (msg->flags & SLURM_COMPRESS_OK) &&
+	    (msg->data_size >= SLURM_COMPRESS_MIN_SIZE))
+		comp = _compress_body(msg->data, msg->data_size, &comp_len);
+	if (comp) {
+		header.flags |= SLURM_COMPRESSED;
+		data_size = htonl(msg->data_size);
+		iov[1].iov_base = &data_size;
+		iov[1].iov_len  = sizeof(data_size);
+		iov[2].iov_base = comp;
+		iov[2].iov_len  = comp_len;
+		bodycnt = 2;
+	} else if (pack_msg_prepacked(msg)) {
+		iov[1].iov_base = msg->data;
+		iov[1].iov_len  = msg->data_size;
+		bodycnt = 1;
+	} else {
+		body_buf = init_pool_buf();
+		pack_msg(msg, body_buf);
+		iov[1].iov_base = get_buf_data(body_buf);
+		iov[1].iov_len  = get_buf_offset(body_buf);
+		bodycnt = 1;
+	}
+	update_header(&header, (bodycnt == 2) ?
+		      (sizeof(data_size) + comp_len) : iov[1].iov_len);
 
 	/*
-	 * Pack auth credential
+	 * Initialize header with Auth credential and message type.
 	 */
+	if ((auth_cred = _auth_create(msg, &header, iov + 1, bodycnt)) ==
+	    NULL) {
+		error("authentication: %s",
+		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)) );
+		if (body_buf)
+			free_pool_buf(body_buf);
+		xfree(comp);
+		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+	}
+
+	/*
+	 * Pack header and auth credential into buffer for transmission
+	 */
+	buffer = init_pool_buf();
+	pack_header(&header, buffer);
 	rc = g_slurm_auth_pack(auth_cred, buffer);
 	(void) g_slurm_auth_destroy(auth_cred);
 	if (rc) {
 		error("authentication: %s",
 		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		free_buf(buffer);
+		free_pool_buf(buffer);
+		if (body_buf)
+			free_pool_buf(body_buf);
+		xfree(comp);
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
-
-	/*
-	 * Pack message into buffer
-	 */
-	_pack_msg(msg, &header, buffer);
+	iov[0].iov_base = get_buf_data(buffer);
+	iov[0].iov_len  = get_buf_offset(buffer);
 
 #if	_DEBUG
 	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
@@ -2709,9 +3683,8 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	/*
 	 * Send message
 	 */
-	rc = _slurm_msg_sendto( fd, get_buf_data(buffer),
-				get_buf_offset(buffer),
-				SLURM_PROTOCOL_NO_SEND_RECV_FLAGS );
+	rc = _slurm_msg_sendv(fd, iov, bodycnt + 1,
+			      SLURM_PROTOCOL_NO_SEND_RECV_FLAGS);
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		debug3("slurm_msg_sendto: peer has disappeared for msg_type=%u",
@@ -2726,7 +3699,10 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 		      addr_str, msg->msg_type);
 	}
 
-	free_buf(buffer);
+	free_pool_buf(buffer);
+	if (body_buf)
+		free_pool_buf(body_buf);
+	xfree(comp);
 	return rc;
 }
 
@@ -3113,6 +4089,38 @@ _send_and_recv_msg(slurm_fd_t fd, slurm_msg_t *req,
 	return rc;
 }
 
+/*
+ * Set the forwarding timeout of req if not already set.
+ * IN/OUT timeout - how long to wait in milliseconds, extended to wait
+ *		    for the responses of the nodes req is forwarded to
+ * RET the number of steps down the tree to wait for
+ */
+static int _forward_timeout(slurm_msg_t *req, int *timeout)
+{
+	int steps = 0;
+
+	if (!req->forward.timeout) {
+		if (!*timeout)
+			*timeout = slurm_get_msg_timeout() * 1000;
+		req->forward.timeout = *timeout;
+	}
+	if (req->forward.cnt > 0) {
+		/* figure out where we are in the tree and set
+		 * the timeout for to wait for our childern
+		 * correctly
+		 * (timeout+message_timeout sec per step)
+		 * to let the child timeout */
+		if (message_timeout < 0)
+			message_timeout = slurm_get_msg_timeout() * 1000;
+		steps = (req->forward.cnt+1)/slurm_get_tree_width();
+		*timeout = (message_timeout*steps);
+		steps++;
+
+		*timeout += (req->forward.timeout*steps);
+	}
+	return steps;
+}
+
 /*
  * Send and recv a slurm request and response on the open slurm descriptor
  * with a list containing the responses of the children (if any) we
@@ -3129,30 +4137,10 @@ _send_and_recv_msgs(slurm_fd_t fd, slurm_msg_t *req, int timeout)
 {
 	int retry = 0;
 	List ret_list = NULL;
-	int steps = 0;
+	int steps = _forward_timeout(req, &timeout);
 
-	if (!req->forward.timeout) {
-		if (!timeout)
-			timeout = slurm_get_msg_timeout() * 1000;
-		req->forward.timeout = timeout;
-	}
-	if (slurm_send_node_msg(fd, req) >= 0) {
-		if (req->forward.cnt > 0) {
-			/* figure out where we are in the tree and set
-			 * the timeout for to wait for our childern
-			 * correctly
-			 * (timeout+message_timeout sec per step)
-			 * to let the child timeout */
-			if (message_timeout < 0)
-				message_timeout = slurm_get_msg_timeout() * 1000;
-			steps = (req->forward.cnt+1)/slurm_get_tree_width();
-			timeout = (message_timeout*steps);
-			steps++;
-
-			timeout += (req->forward.timeout*steps);
-		}
+	if (slurm_send_node_msg(fd, req) >= 0)
 		ret_list = slurm_receive_msgs(fd, steps, timeout);
-	}
 
 
 	/*
@@ -3194,10 +4182,22 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 	forward_init(&req->forward, NULL);
 	req->ret_list = NULL;
 	req->forward_struct = NULL;
+	slurm_msg_set_r_uid(req, slurm_get_slurm_user_id());
 
 	if (working_cluster_rec)
 		req->flags |= SLURM_GLOBAL_AUTH_KEY;
 
+	if ((rc = _persist_send_recv_msg(NULL, req, resp, 0)) < 0)
+		goto cleanup;
+	if (rc == 0) {
+		g_slurm_auth_destroy(resp->auth_cred);
+		if ((resp->msg_type != RESPONSE_SLURM_RC) ||
+		    ((((return_code_msg_t *) resp->data)->return_code)
+		     != ESLURM_IN_STANDBY_MODE))
+			goto cleanup;
+		slurm_free_return_code_msg(resp->data);
+	}
+
 	if ((fd = slurm_open_controller_conn(&ctrl_addr)) < 0) {
 		rc = -1;
 		goto cleanup;
@@ -3260,8 +4260,12 @@ cleanup:
 int slurm_send_recv_node_msg(slurm_msg_t *req, slurm_msg_t *resp, int timeout)
 {
 	slurm_fd_t fd = -1;
+	int rc;
 
 	resp->auth_cred = NULL;
+	if ((rc = _persist_send_recv_msg(&req->address, req, resp, timeout))
+	    <= 0)
+		return rc;
 	if ((fd = slurm_open_msg_conn(&req->address)) < 0)
 		return -1;
 
@@ -3291,6 +4295,7 @@ int slurm_send_only_controller_msg(slurm_msg_t *req)
 		goto cleanup;
 	}
 
+	slurm_msg_set_r_uid(req, slurm_get_slurm_user_id());
 	if ((rc = slurm_send_node_msg(fd, req) < 0)) {
 		rc = SLURM_ERROR;
 	} else {
@@ -3397,16 +4402,20 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 	ret_data_info_t *ret_data_info = NULL;
 	ListIterator itr;
 
-	if ((fd = slurm_open_msg_conn(&msg->address)) < 0) {
-		mark_as_failed_forward(&ret_list, name,
-				       SLURM_COMMUNICATIONS_CONNECTION_ERROR);
-		errno = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
-		return ret_list;
-	}
-
 	msg->ret_list = NULL;
 	msg->forward_struct = NULL;
-	if (!(ret_list = _send_and_recv_msgs(fd, msg, timeout))) {
+	if (_persist_send_recv_msgs(&msg->address, msg, timeout,
+				    &ret_list)) {
+		if ((fd = slurm_open_msg_conn(&msg->address)) < 0) {
+			mark_as_failed_forward(
+				&ret_list, name,
+				SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+			errno = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
+			return ret_list;
+		}
+		ret_list = _send_and_recv_msgs(fd, msg, timeout);
+	}
+	if (!ret_list) {
 		mark_as_failed_forward(&ret_list, name, errno);
 		errno = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
 		return ret_list;
@@ -3448,11 +4457,13 @@ int slurm_send_recv_rc_msg_only_one(slurm_msg_t *req, int *rc, int timeout)
 	req->ret_list = NULL;
 	req->forward_struct = NULL;
 
-	if ((fd = slurm_open_msg_conn(&req->address)) < 0) {
-		return -1;
+	if ((ret_c = _persist_send_recv_msg(&req->address, req, &resp,
+					    timeout)) > 0) {
+		if ((fd = slurm_open_msg_conn(&req->address)) < 0)
+			return -1;
+		ret_c = _send_and_recv_msg(fd, req, &resp, timeout);
 	}
-
-	if (!_send_and_recv_msg(fd, req, &resp, timeout)) {
+	if (!ret_c) {
 		if (resp.auth_cred)
 			g_slurm_auth_destroy(resp.auth_cred);
 		*rc = slurm_get_return_code(resp.msg_type, resp.data);
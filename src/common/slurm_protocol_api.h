@@ -169,6 +169,12 @@ char *slurm_get_mpi_default(void);
  */
 char *slurm_get_mpi_params(void);
 
+/* slurm_get_msg_persist_timeout
+ * get idle time of persistent connections from slurmctld_conf object
+ * RET uint16_t - seconds, 0 if connections are not kept
+ */
+extern uint16_t slurm_get_msg_persist_timeout(void);
+
 /* slurm_get_msg_timeout
  * get default message timeout value from slurmctld_conf object
  */
@@ -309,6 +315,12 @@ char *slurm_get_state_save_location(void);
  */
 extern char *slurm_get_auth_type(void);
 
+/* slurm_get_auth_session_timeout
+ * get lifetime of message signing keys from slurmctld_conf object
+ * RET uint16_t - seconds, 0 if every message carries its own credential
+ */
+extern uint16_t slurm_get_auth_session_timeout(void);
+
 /* slurm_set_auth_type
  * set the authentication type in slurmctld_conf object
  * used for security testing purposes
@@ -710,10 +722,39 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout);
 int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 				  slurm_msg_t *resp, int timeout);
 
+/*
+ * Decide whether a connection accepted by a daemon is kept open for
+ * further requests once msg has been responded to. The response is
+ * then tagged with the request's identifier, telling the sender it may
+ * reuse the connection.
+ * IN/OUT msg - request just received by slurm_receive_msg() or
+ *	slurm_receive_msg_and_forward()
+ * IN allow   - false if the daemon is short of threads
+ * RET true if the caller should wait for another request on
+ *	msg->conn_fd with slurm_persist_conn_wait()
+ */
+extern bool slurm_persist_conn_keep(slurm_msg_t *msg, bool allow);
+
+/*
+ * Wait for another request on a persistent connection.
+ * IN fd      - connection
+ * IN timeout - how long to wait in milliseconds
+ * RET 1 if a request is ready, 0 on timeout, -1 if the peer closed it
+ */
+extern int slurm_persist_conn_wait(slurm_fd_t fd, int timeout);
+
 /**********************************************************************\
  * send message functions
 \**********************************************************************/
 
+/* slurm_msg_set_r_uid
+ * only let processes of user "uid" read the credential of message "msg",
+ *	which then may be signed with a session key, see AuthSessionTimeout
+ * IN msg		- a slurm msg struct to be sent
+ * IN uid		- user id of the receiving process
+ */
+extern void slurm_msg_set_r_uid(slurm_msg_t *msg, uid_t uid);
+
 /* sends a message to an arbitrary node
  *
  * IN open_fd		- file descriptor to send msg on
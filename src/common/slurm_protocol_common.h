@@ -79,6 +79,15 @@
 /* used to set flags to empty */
 #define SLURM_PROTOCOL_NO_FLAGS 0
 #define SLURM_GLOBAL_AUTH_KEY   0x0001
+#define SLURM_PERSIST_CONN      0x0002	/* msg_id in header, connection is
+					 * kept open for further messages */
+#define SLURM_PACK_COMPACT_OK   0x0004	/* sender unpacks compact dumps */
+#define SLURM_PACK_COMPACT      0x0008	/* dump packed with set_buf_compact */
+#define SLURM_COMPRESS_OK       0x0010	/* sender expands compressed dumps */
+#define SLURM_COMPRESSED        0x0020	/* body compressed with lz_compress */
+
+/* smallest dump compressed for a peer setting SLURM_COMPRESS_OK */
+#define SLURM_COMPRESS_MIN_SIZE (64 * 1024)
 
 #if MONGO_IMPLEMENTATION
 #  include "src/common/slurm_protocol_mongo_common.h"
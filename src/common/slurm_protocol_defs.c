@@ -603,6 +603,20 @@ extern void slurm_free_launch_tasks_response_msg(
 	}
 }
 
+extern void slurm_free_launch_tasks_relay_msg(launch_tasks_relay_msg_t *msg)
+{
+	if (msg) {
+		if (msg->resp_list)
+			list_destroy(msg->resp_list);
+		xfree(msg);
+	}
+}
+
+extern void slurm_free_io_relay_port_msg(io_relay_port_msg_t *msg)
+{
+	xfree(msg);
+}
+
 extern void slurm_free_kill_job_msg(kill_job_msg_t * msg)
 {
 	if (msg) {
@@ -2368,6 +2382,15 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case TASK_USER_MANAGED_IO_STREAM:
 		slurm_free_task_user_managed_io_stream_msg(data);
 		break;
+	case RESPONSE_LAUNCH_TASKS_RELAY:
+		slurm_free_launch_tasks_relay_msg(data);
+		break;
+	case REQUEST_IO_RELAY_PORT:
+		slurm_free_job_step_id_msg(data);
+		break;
+	case RESPONSE_IO_RELAY_PORT:
+		slurm_free_io_relay_port_msg(data);
+		break;
 	case REQUEST_SIGNAL_TASKS:
 	case REQUEST_TERMINATE_TASKS:
 		slurm_free_kill_tasks_msg(data);
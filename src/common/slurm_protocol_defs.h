@@ -149,8 +149,10 @@
  */
 enum task_flag_vals {
 	TASK_PARALLEL_DEBUG = 0x1,
-	TASK_UNUSED1 = 0x2,
-	TASK_UNUSED2 = 0x4
+	TASK_LAUNCH_RELAY = 0x2,	/* relay launch responses to srun
+					 * through the reverse tree */
+	TASK_IO_AGGREGATE = 0x4		/* relay task I/O through the reverse
+					 * tree, coalesce output in srun */
 };
 
 enum suspend_opts {
@@ -299,6 +301,9 @@ typedef enum {
 	REQUEST_FILE_BCAST,
 	TASK_USER_MANAGED_IO_STREAM,
 	REQUEST_KILL_PREEMPTED,
+	RESPONSE_LAUNCH_TASKS_RELAY,
+	REQUEST_IO_RELAY_PORT,
+	RESPONSE_IO_RELAY_PORT,
 
 	SRUN_PING = 7001,
 	SRUN_TIMEOUT,
@@ -341,6 +346,8 @@ typedef struct forward {
 typedef struct slurm_protocol_header {
 	uint16_t version;
 	uint16_t flags;
+	uint32_t msg_id;   /* matches a response to its request on a
+			    * persistent connection, 0 if none */
 	uint16_t msg_type; /* really slurm_msg_type_t but needs to be
 			      uint16_t for packing purposes. */
 	uint32_t body_length;
@@ -383,12 +390,19 @@ typedef struct slurm_msg {
 	void *data;
 	uint32_t data_size;
 	uint16_t flags;
+	uint32_t msg_id;   /* request identifier on a persistent connection,
+			    * 0 if none */
 	uint16_t msg_type; /* really a slurm_msg_type_t but needs to be
 			    * this way for packing purposes.  message type */
 	uint16_t protocol_version; /* DON'T PACK!  Only used if
 				    * message comming from non-default
 				    * slurm protocol.  Initted to
 				    * NO_VAL meaning use the default. */
+	uid_t restrict_uid;	/* DON'T PACK! If restrict_uid_set, only
+				 * this user (and restrict_gid) may read
+				 * the credential, see slurm_msg_set_r_uid() */
+	gid_t restrict_gid;
+	bool restrict_uid_set;
 	/* The following were all added for the forward.c code */
 	forward_t forward;
 	forward_struct_t *forward_struct;
@@ -690,6 +704,20 @@ typedef struct task_user_managed_io_msg {
 	uint32_t task_id;
 } task_user_managed_io_msg_t;
 
+/* Launch responses of several nodes, gathered by slurmstepd on their
+ * way to srun up the reverse tree */
+typedef struct launch_tasks_relay_msg {
+	uint32_t job_id;
+	uint32_t job_step_id;
+	List resp_list;		/* list of launch_tasks_response_msg_t */
+} launch_tasks_relay_msg_t;
+
+/* Port on which a step's slurmstepd accepts the I/O connections of the
+ * nodes below it in the reverse tree, zero if not (yet) listening */
+typedef struct io_relay_port_msg {
+	uint16_t port;
+} io_relay_port_msg_t;
+
 typedef struct partition_info partition_desc_msg_t;
 
 typedef struct return_code_msg {
@@ -864,8 +892,14 @@ typedef struct file_bcast_msg {
 	sbcast_cred_t *cred;	/* credential for the RPC */
 	uint32_t block_len;	/* length of this data block */
 	char *block;		/* data for this block */
+	uint16_t compress;	/* block compression type, COMPRESS_* */
+	uint32_t uncomp_len;	/* length of block once decompressed */
+	uint64_t block_offset;	/* offset of block in destination file,
+				 * BCAST_APPEND_OFFSET if sent in order */
 } file_bcast_msg_t;
 
+#define BCAST_APPEND_OFFSET	((uint64_t) 0xffffffffffffffffULL)
+
 typedef struct multi_core_data {
 	uint16_t sockets_per_node;	/* sockets per node required by job */
 	uint16_t cores_per_socket;	/* cores per cpu required by job */
@@ -1029,6 +1063,9 @@ extern void slurm_free_launch_tasks_request_msg(
 		launch_tasks_request_msg_t * msg);
 extern void slurm_free_launch_tasks_response_msg(
 		launch_tasks_response_msg_t * msg);
+extern void slurm_free_launch_tasks_relay_msg(
+		launch_tasks_relay_msg_t *msg);
+extern void slurm_free_io_relay_port_msg(io_relay_port_msg_t *msg);
 extern void slurm_free_task_user_managed_io_stream_msg(
 		task_user_managed_io_msg_t *msg);
 extern void slurm_free_task_exit_msg(task_exit_msg_t * msg);
@@ -69,6 +69,7 @@
 
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <stdarg.h>
@@ -166,6 +167,26 @@ ssize_t _slurm_msg_sendto ( slurm_fd_t open_fd, char *buffer ,
 ssize_t _slurm_msg_sendto_timeout ( slurm_fd_t open_fd, char *buffer,
 				    size_t size, uint32_t flags, int timeout );
 
+/* Most pieces of one message given to _slurm_msg_sendv */
+#define SLURM_MSG_IOV_MAX 8
+
+/* _slurm_msg_sendv
+ * Send one message made of several pieces over the given connection,
+ * handing them to the socket together rather than copying them into one
+ * buffer first, default timeout value
+ * IN open_fd - an open file descriptor
+ * IN iov - pieces of the message, in order
+ * IN iovcnt - number of pieces, at most SLURM_MSG_IOV_MAX
+ * IN flags - communication specific flags
+ * RET number of bytes written
+ */
+ssize_t _slurm_msg_sendv ( slurm_fd_t open_fd, struct iovec *iov,
+			   int iovcnt, uint32_t flags );
+/* _slurm_msg_sendv_timeout is identical to _slurm_msg_sendv except
+ * IN timeout - maximum time to wait for a message in milliseconds */
+ssize_t _slurm_msg_sendv_timeout ( slurm_fd_t open_fd, struct iovec *iov,
+				   int iovcnt, uint32_t flags, int timeout );
+
 /* _slurm_accept_msg_conn
  * In the bsd implmentation maps directly to a accept call
  * IN open_fd		- file descriptor to accept connection on
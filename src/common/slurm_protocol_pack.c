@@ -50,6 +50,7 @@
 #include "src/api/slurm_pmi.h"
 #include "src/common/bitstring.h"
 #include "src/common/log.h"
+#include "src/common/lz_compress.h"
 #include "src/common/node_select.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_jobacct_gather.h"
@@ -158,7 +159,7 @@ static int _unpack_node_info_request_msg(
 	uint16_t protocol_version);
 
 static int _unpack_node_info_msg(node_info_msg_t ** msg, Buf buffer,
-				 uint16_t protocol_version);
+				 uint16_t protocol_version, bool compact);
 static int _unpack_node_info_members(node_info_t * node, Buf buffer,
 				     uint16_t protocol_version);
 
@@ -271,6 +272,16 @@ static int _unpack_checkpoint_tasks_msg(checkpoint_tasks_msg_t ** msg_ptr,
 static void _pack_launch_tasks_response_msg(launch_tasks_response_msg_t *msg,
 					    Buf buffer,
 					    uint16_t protocol_version);
+static void _pack_launch_tasks_relay_msg(launch_tasks_relay_msg_t *msg,
+					 Buf buffer,
+					 uint16_t protocol_version);
+static int _unpack_launch_tasks_relay_msg(launch_tasks_relay_msg_t **msg_ptr,
+					  Buf buffer,
+					  uint16_t protocol_version);
+static void _pack_io_relay_port_msg(io_relay_port_msg_t *msg, Buf buffer,
+				    uint16_t protocol_version);
+static int _unpack_io_relay_port_msg(io_relay_port_msg_t **msg_ptr,
+				     Buf buffer, uint16_t protocol_version);
 static int _unpack_launch_tasks_response_msg(
 	launch_tasks_response_msg_t **msg_ptr, Buf buffer,
 	uint16_t protocol_version);
@@ -342,7 +353,8 @@ static int _unpack_job_step_info_req_msg(job_step_info_request_msg_t **
 					 uint16_t protocol_version);
 static int _unpack_job_step_info_response_msg(job_step_info_response_msg_t
 					      ** msg, Buf buffer,
-					      uint16_t protocol_version);
+					      uint16_t protocol_version,
+					      bool compact);
 static int _unpack_job_step_info_members(job_step_info_t * step, Buf buffer,
 					 uint16_t protocol_version);
 
@@ -396,7 +408,7 @@ static int _unpack_job_desc_msg(job_desc_msg_t ** job_desc_buffer_ptr,
 				Buf buffer,
 				uint16_t protocol_version);
 static int _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
-				uint16_t protocol_version);
+				uint16_t protocol_version, bool compact);
 
 static void _pack_last_update_msg(last_update_msg_t * msg, Buf buffer,
 				  uint16_t protocol_version);
@@ -610,6 +622,9 @@ pack_header(header_t * header, Buf buffer)
 {
 	pack16((uint16_t)header->version, buffer);
 	pack16((uint16_t)header->flags, buffer);
+	if ((header->flags & SLURM_PERSIST_CONN) &&
+	    (header->version >= SLURM_2_3_PROTOCOL_VERSION))
+		pack32(header->msg_id, buffer);
 	pack16((uint16_t)header->msg_type, buffer);
 	pack32((uint32_t)header->body_length, buffer);
 	pack16((uint16_t)header->forward.cnt, buffer);
@@ -642,6 +657,11 @@ unpack_header(header_t * header, Buf buffer)
 	header->ret_list = NULL;
 	safe_unpack16(&header->version, buffer);
 	safe_unpack16(&header->flags, buffer);
+	if ((header->flags & SLURM_PERSIST_CONN) &&
+	    (header->version >= SLURM_2_3_PROTOCOL_VERSION))
+		safe_unpack32(&header->msg_id, buffer);
+	else
+		header->flags &= (~SLURM_PERSIST_CONN);
 	safe_unpack16(&header->msg_type, buffer);
 	safe_unpack32(&header->body_length, buffer);
 	safe_unpack16(&header->forward.cnt, buffer);
@@ -844,6 +864,15 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 						 *) msg->data, buffer,
 						msg->protocol_version);
 		break;
+	case RESPONSE_LAUNCH_TASKS_RELAY:
+		_pack_launch_tasks_relay_msg((launch_tasks_relay_msg_t *)
+					     msg->data, buffer,
+					     msg->protocol_version);
+		break;
+	case RESPONSE_IO_RELAY_PORT:
+		_pack_io_relay_port_msg((io_relay_port_msg_t *) msg->data,
+					buffer, msg->protocol_version);
+		break;
 	case TASK_USER_MANAGED_IO_STREAM:
 		_pack_task_user_managed_io_stream_msg(
 			(task_user_managed_io_msg_t *) msg->data, buffer,
@@ -898,6 +927,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 	case REQUEST_STEP_LAYOUT:
 	case REQUEST_JOB_STEP_STAT:
 	case REQUEST_JOB_STEP_PIDS:
+	case REQUEST_IO_RELAY_PORT:
 		_pack_job_step_id_msg((job_step_id_msg_t *)msg->data, buffer,
 				      msg->protocol_version);
 		break;
@@ -1167,6 +1197,28 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 	return SLURM_SUCCESS;
 }
 
+/* pack_msg_prepacked
+ * IN msg - the message to be sent
+ * RET true if the body of msg is msg->data, a buffer of msg->data_size
+ *	bytes already packed by the sender, which pack_msg would only copy
+ */
+bool
+pack_msg_prepacked(slurm_msg_t const *msg)
+{
+	switch (msg->msg_type) {
+	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_STEP_INFO:
+	case RESPONSE_BLOCK_INFO:
+	case RESPONSE_FRONT_END_INFO:
+	case RESPONSE_NODE_INFO:
+	case RESPONSE_PARTITION_INFO:
+	case RESPONSE_RESERVATION_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /* unpack_msg
  * unpacks a generic slurm protocol message body
  * OUT msg - the body structure to unpack (note: includes message type)
@@ -1210,8 +1262,8 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 		break;
 	case RESPONSE_JOB_INFO:
 		rc = _unpack_job_info_msg((job_info_msg_t **) & (msg->data),
-					  buffer,
-					  msg->protocol_version);
+					  buffer, msg->protocol_version,
+					  (msg->flags & SLURM_PACK_COMPACT));
 		break;
 	case RESPONSE_PARTITION_INFO:
 		rc = _unpack_partition_info_msg((partition_info_msg_t **) &
@@ -1221,7 +1273,8 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 	case RESPONSE_NODE_INFO:
 		rc = _unpack_node_info_msg((node_info_msg_t **) &
 					   (msg->data), buffer,
-					   msg->protocol_version);
+					   msg->protocol_version,
+					   (msg->flags & SLURM_PACK_COMPACT));
 		break;
 	case MESSAGE_NODE_REGISTRATION_STATUS:
 		rc = _unpack_node_registration_status_msg(
@@ -1346,6 +1399,16 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 			& (msg->data), buffer,
 			msg->protocol_version);
 		break;
+	case RESPONSE_LAUNCH_TASKS_RELAY:
+		rc = _unpack_launch_tasks_relay_msg(
+			(launch_tasks_relay_msg_t **) &(msg->data), buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_IO_RELAY_PORT:
+		rc = _unpack_io_relay_port_msg(
+			(io_relay_port_msg_t **) &(msg->data), buffer,
+			msg->protocol_version);
+		break;
 	case TASK_USER_MANAGED_IO_STREAM:
 		_unpack_task_user_managed_io_stream_msg(
 			(task_user_managed_io_msg_t **) &msg->data, buffer,
@@ -1415,6 +1478,7 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 	case REQUEST_STEP_LAYOUT:
 	case REQUEST_JOB_STEP_STAT:
 	case REQUEST_JOB_STEP_PIDS:
+	case REQUEST_IO_RELAY_PORT:
 		_unpack_job_step_id_msg((job_step_id_msg_t **)&msg->data,
 					buffer,
 					msg->protocol_version);
@@ -1465,7 +1529,8 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 		rc = _unpack_job_step_info_response_msg(
 			(job_step_info_response_msg_t **)
 			& (msg->data), buffer,
-			msg->protocol_version);
+			msg->protocol_version,
+			(msg->flags & SLURM_PACK_COMPACT));
 		break;
 	case REQUEST_JOB_RESOURCE:
 		break;
@@ -2649,7 +2714,7 @@ unpack_error:
 
 static int
 _unpack_node_info_msg(node_info_msg_t ** msg, Buf buffer,
-		      uint16_t protocol_version)
+		      uint16_t protocol_version, bool compact)
 {
 	int i;
 	node_info_t *node = NULL;
@@ -2667,15 +2732,18 @@ _unpack_node_info_msg(node_info_msg_t ** msg, Buf buffer,
 			xmalloc(sizeof(node_info_t) * (*msg)->record_count);
 
 		/* load individual job info */
+		set_buf_compact(buffer, compact);
 		for (i = 0; i < (*msg)->record_count; i++) {
 			if (_unpack_node_info_members(&node[i], buffer,
 						      protocol_version))
 				goto unpack_error;
 		}
+		set_buf_compact(buffer, false);
 	}
 	return SLURM_SUCCESS;
 
 unpack_error:
+	set_buf_compact(buffer, false);
 	slurm_free_node_info_msg(*msg);
 	*msg = NULL;
 	return SLURM_ERROR;
@@ -3855,7 +3923,7 @@ unpack_error:
 static int
 _unpack_job_step_info_response_msg(job_step_info_response_msg_t** msg,
 				   Buf buffer,
-				   uint16_t protocol_version)
+				   uint16_t protocol_version, bool compact)
 {
 	int i = 0;
 	job_step_info_t *step;
@@ -3870,14 +3938,17 @@ _unpack_job_step_info_response_msg(job_step_info_response_msg_t** msg,
 		step = (*msg)->job_steps = xmalloc(sizeof(job_step_info_t)
 						   * (*msg)->job_step_count);
 
+		set_buf_compact(buffer, compact);
 		for (i = 0; i < (*msg)->job_step_count; i++)
 			if (_unpack_job_step_info_members(&step[i], buffer,
 							  protocol_version))
 				goto unpack_error;
+		set_buf_compact(buffer, false);
 	}
 	return SLURM_SUCCESS;
 
 unpack_error:
+	set_buf_compact(buffer, false);
 	slurm_free_job_step_info_response_msg(*msg);
 	*msg = NULL;
 	return SLURM_ERROR;
@@ -3892,7 +3963,7 @@ _pack_buffer_msg(slurm_msg_t * msg, Buf buffer)
 
 static int
 _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
-		     uint16_t protocol_version)
+		     uint16_t protocol_version, bool compact)
 {
 	int i;
 	job_info_t *job = NULL;
@@ -3908,15 +3979,18 @@ _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
 			xmalloc(sizeof(job_info_t) * (*msg)->record_count);
 
 		/* load individual job info */
+		set_buf_compact(buffer, compact);
 		for (i = 0; i < (*msg)->record_count; i++) {
 			if (_unpack_job_info_members(&job[i], buffer,
 						     protocol_version))
 				goto unpack_error;
 		}
+		set_buf_compact(buffer, false);
 	}
 	return SLURM_SUCCESS;
 
 unpack_error:
+	set_buf_compact(buffer, false);
 	slurm_free_job_info_msg(*msg);
 	*msg = NULL;
 	return SLURM_ERROR;
@@ -4284,6 +4358,7 @@ _pack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t * build_ptr, Buf buffer,
 		packstr(build_ptr->accounting_storage_type, buffer);
 		packstr(build_ptr->accounting_storage_user, buffer);
 
+		pack16(build_ptr->auth_session_timeout, buffer);
 		packstr(build_ptr->authtype, buffer);
 
 		packstr(build_ptr->backup_addr, buffer);
@@ -4352,6 +4427,7 @@ _pack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t * build_ptr, Buf buffer,
 		pack16(build_ptr->min_job_age, buffer);
 		packstr(build_ptr->mpi_default, buffer);
 		packstr(build_ptr->mpi_params, buffer);
+		pack16(build_ptr->msg_persist_timeout, buffer);
 		pack16(build_ptr->msg_timeout, buffer);
 
 		pack32(build_ptr->next_job_id, buffer);
@@ -4894,6 +4970,7 @@ _unpack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t **build_buffer_ptr,
 		safe_unpackstr_xmalloc(&build_ptr->accounting_storage_user,
 				       &uint32_tmp, buffer);
 
+		safe_unpack16(&build_ptr->auth_session_timeout, buffer);
 		safe_unpackstr_xmalloc(&build_ptr->authtype,
 				       &uint32_tmp, buffer);
 
@@ -4988,6 +5065,7 @@ _unpack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t **build_buffer_ptr,
 				       &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&build_ptr->mpi_params,
 				       &uint32_tmp, buffer);
+		safe_unpack16(&build_ptr->msg_persist_timeout, buffer);
 		safe_unpack16(&build_ptr->msg_timeout, buffer);
 
 		safe_unpack32(&build_ptr->next_job_id, buffer);
@@ -6816,6 +6894,90 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void
+_pack_launch_tasks_relay_msg(launch_tasks_relay_msg_t *msg, Buf buffer,
+			     uint16_t protocol_version)
+{
+	launch_tasks_response_msg_t *resp;
+	ListIterator itr;
+	uint32_t count = 0;
+
+	xassert(msg != NULL);
+	pack32(msg->job_id, buffer);
+	pack32(msg->job_step_id, buffer);
+	if (msg->resp_list)
+		count = list_count(msg->resp_list);
+	pack32(count, buffer);
+	if (count) {
+		itr = list_iterator_create(msg->resp_list);
+		while ((resp = list_next(itr)))
+			_pack_launch_tasks_response_msg(resp, buffer,
+							protocol_version);
+		list_iterator_destroy(itr);
+	}
+}
+
+static int
+_unpack_launch_tasks_relay_msg(launch_tasks_relay_msg_t **msg_ptr, Buf buffer,
+			       uint16_t protocol_version)
+{
+	launch_tasks_relay_msg_t *msg;
+	launch_tasks_response_msg_t *resp;
+	uint32_t count, i;
+
+	xassert(msg_ptr != NULL);
+	msg = xmalloc(sizeof(launch_tasks_relay_msg_t));
+	*msg_ptr = msg;
+
+	safe_unpack32(&msg->job_id, buffer);
+	safe_unpack32(&msg->job_step_id, buffer);
+	safe_unpack32(&count, buffer);
+	if (count > remaining_buf(buffer))
+		goto unpack_error;
+	msg->resp_list = list_create((ListDelF)
+				     slurm_free_launch_tasks_response_msg);
+	for (i = 0; i < count; i++) {
+		if (_unpack_launch_tasks_response_msg(&resp, buffer,
+						      protocol_version))
+			goto unpack_error;
+		list_append(msg->resp_list, resp);
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_launch_tasks_relay_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+static void
+_pack_io_relay_port_msg(io_relay_port_msg_t *msg, Buf buffer,
+			uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+	pack16(msg->port, buffer);
+}
+
+static int
+_unpack_io_relay_port_msg(io_relay_port_msg_t **msg_ptr, Buf buffer,
+			  uint16_t protocol_version)
+{
+	io_relay_port_msg_t *msg;
+
+	xassert(msg_ptr != NULL);
+	msg = xmalloc(sizeof(io_relay_port_msg_t));
+	*msg_ptr = msg;
+
+	safe_unpack16(&msg->port, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_io_relay_port_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_launch_tasks_request_msg(launch_tasks_request_msg_t * msg, Buf buffer,
 			       uint16_t protocol_version)
@@ -8994,6 +9156,12 @@ static void _pack_file_bcast(file_bcast_msg_t * msg , Buf buffer,
 	pack32 ( msg->block_len, buffer );
 	packmem ( msg->block, msg->block_len, buffer );
 	pack_sbcast_cred( msg->cred, buffer );
+
+	if (protocol_version >= SLURM_2_3_PROTOCOL_VERSION) {
+		pack16 ( msg->compress, buffer );
+		pack32 ( msg->uncomp_len, buffer );
+		pack64 ( msg->block_offset, buffer );
+	}
 }
 
 static int _unpack_file_bcast(file_bcast_msg_t ** msg_ptr , Buf buffer,
@@ -9028,6 +9196,16 @@ static int _unpack_file_bcast(file_bcast_msg_t ** msg_ptr , Buf buffer,
 	if (msg->cred == NULL)
 		goto unpack_error;
 
+	if (protocol_version >= SLURM_2_3_PROTOCOL_VERSION) {
+		safe_unpack16 ( & msg->compress, buffer );
+		safe_unpack32 ( & msg->uncomp_len, buffer );
+		safe_unpack64 ( & msg->block_offset, buffer );
+	} else {
+		msg->compress = COMPRESS_OFF;
+		msg->uncomp_len = msg->block_len;
+		msg->block_offset = BCAST_APPEND_OFFSET;
+	}
+
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -91,6 +91,13 @@ extern int unpack_header ( header_t * header , Buf buffer );
  */
 extern int pack_msg ( slurm_msg_t const * msg , Buf buffer );
 
+/* pack_msg_prepacked
+ * IN msg - the message to be sent
+ * RET true if the body of msg is msg->data, a buffer of msg->data_size
+ *	bytes already packed by the sender, which pack_msg would only copy
+ */
+extern bool pack_msg_prepacked ( slurm_msg_t const * msg );
+
 /* unpack_msg
  * unpacks a generic slurm protocol message body
  * OUT msg - the body structure to unpack (note: includes message type)
@@ -202,57 +202,24 @@ ssize_t _slurm_msg_recvfrom_timeout(slurm_fd_t fd, char **pbuf, size_t *lenp,
 	return (ssize_t) msglen;
 }
 
-ssize_t _slurm_msg_sendto(slurm_fd_t fd, char *buffer, size_t size,
-			  uint32_t flags)
-{
-	return _slurm_msg_sendto_timeout( fd, buffer, size, flags,
-				(slurm_get_msg_timeout() * 1000));
-}
-
-ssize_t _slurm_msg_sendto_timeout(slurm_fd_t fd, char *buffer, size_t size,
-				  uint32_t flags, int timeout)
-{
-	int   len;
-	uint32_t usize;
-	SigFunc *ohandler;
-
-	/*
-	 *  Ignore SIGPIPE so that send can return a error code if the
-	 *    other side closes the socket
-	 */
-	ohandler = xsignal(SIGPIPE, SIG_IGN);
-
-	usize = htonl(size);
-
-	if ((len = _slurm_send_timeout(
-				fd, (char *)&usize, sizeof(usize), 0,
-				timeout)) < 0)
-		goto done;
-
-	if ((len = _slurm_send_timeout(fd, buffer, size, 0, timeout)) < 0)
-		goto done;
-
-
-     done:
-	xsignal(SIGPIPE, ohandler);
-	return len;
-}
-
-/* Send slurm message with timeout
- * RET message size (as specified in argument) or SLURM_ERROR on error */
-int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
-			uint32_t flags, int timeout)
+/* Send the size bytes of iovcnt pieces in iov with timeout, iov is
+ * updated as pieces are sent
+ * RET size or SLURM_ERROR on error */
+static int _send_iov_timeout(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			     size_t size, uint32_t flags, int timeout)
 {
 	int rc;
 	int sent = 0;
 	int fd_flags;
 	struct pollfd ufds;
+	struct msghdr msg;
 	struct timeval tstart;
 	int timeleft = timeout;
 	char temp[2];
 
 	ufds.fd     = fd;
 	ufds.events = POLLOUT;
+	memset(&msg, 0, sizeof(msg));
 
 	fd_flags = _slurm_fcntl(fd, F_GETFL);
 	fd_set_nonblocking(fd);
@@ -307,7 +274,9 @@ int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
 			      ufds.revents);
 		}
 
-		rc = _slurm_send(fd, &buf[sent], (size - sent), flags);
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+		rc = sendmsg(fd, &msg, flags);
 		if (rc < 0) {
  			if (errno == EINTR)
 				continue;
@@ -331,6 +300,15 @@ int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
 		}
 
 		sent += rc;
+		while ((iovcnt > 0) && ((size_t) rc >= iov->iov_len)) {
+			rc -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (char *) iov->iov_base + rc;
+			iov->iov_len -= rc;
+		}
 	}
 
     done:
@@ -345,6 +323,81 @@ int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
 
 }
 
+ssize_t _slurm_msg_sendto(slurm_fd_t fd, char *buffer, size_t size,
+			  uint32_t flags)
+{
+	return _slurm_msg_sendto_timeout( fd, buffer, size, flags,
+				(slurm_get_msg_timeout() * 1000));
+}
+
+ssize_t _slurm_msg_sendto_timeout(slurm_fd_t fd, char *buffer, size_t size,
+				  uint32_t flags, int timeout)
+{
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len  = size;
+	return _slurm_msg_sendv_timeout(fd, &iov, 1, flags, timeout);
+}
+
+ssize_t _slurm_msg_sendv(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			 uint32_t flags)
+{
+	return _slurm_msg_sendv_timeout(fd, iov, iovcnt, flags,
+					(slurm_get_msg_timeout() * 1000));
+}
+
+ssize_t _slurm_msg_sendv_timeout(slurm_fd_t fd, struct iovec *iov,
+				 int iovcnt, uint32_t flags, int timeout)
+{
+	struct iovec msg_iov[SLURM_MSG_IOV_MAX + 1];
+	size_t size = 0;
+	int   i, len;
+	uint32_t usize;
+	SigFunc *ohandler;
+
+	if ((iovcnt < 1) || (iovcnt > SLURM_MSG_IOV_MAX)) {
+		slurm_seterrno(EINVAL);
+		return SLURM_ERROR;
+	}
+
+	/* the length goes out with the first piece rather than in a send
+	 * of its own */
+	for (i = 0; i < iovcnt; i++) {
+		msg_iov[i + 1] = iov[i];
+		size += iov[i].iov_len;
+	}
+	usize = htonl(size);
+	msg_iov[0].iov_base = &usize;
+	msg_iov[0].iov_len  = sizeof(usize);
+
+	/*
+	 *  Ignore SIGPIPE so that send can return a error code if the
+	 *    other side closes the socket
+	 */
+	ohandler = xsignal(SIGPIPE, SIG_IGN);
+
+	len = _send_iov_timeout(fd, msg_iov, iovcnt + 1,
+				size + sizeof(usize), 0, timeout);
+	if (len >= 0)
+		len -= sizeof(usize);
+
+	xsignal(SIGPIPE, ohandler);
+	return len;
+}
+
+/* Send slurm message with timeout
+ * RET message size (as specified in argument) or SLURM_ERROR on error */
+int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
+			uint32_t flags, int timeout)
+{
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len  = size;
+	return _send_iov_timeout(fd, &iov, 1, size, flags, timeout);
+}
+
 /* Get slurm message with timeout
  * RET message size (as specified in argument) or SLURM_ERROR on error */
 int _slurm_recv_timeout(slurm_fd_t fd, char *buffer, size_t size,
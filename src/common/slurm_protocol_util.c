@@ -162,6 +162,7 @@ void init_header(header_t *header, slurm_msg_t *msg, uint16_t flags)
 		header->version = SLURM_PROTOCOL_VERSION;
 
 	header->flags = flags;
+	header->msg_id = msg->msg_id;
 	header->msg_type = msg->msg_type;
 	header->body_length = 0;	/* over-written later */
 	header->forward = msg->forward;
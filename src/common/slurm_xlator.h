@@ -121,6 +121,15 @@
 #define fd_set_blocking		slurm_fd_set_blocking
 #define fd_set_nonblocking	slurm_fd_set_nonblocking
 
+/* hmac.[ch] functions */
+#define	sha256_init		slurm_sha256_init
+#define	sha256_update		slurm_sha256_update
+#define	sha256_final		slurm_sha256_final
+#define	hmac_sha256_key		slurm_hmac_sha256_key
+#define	hmac_sha256		slurm_hmac_sha256
+#define	hmac_sha256_iov		slurm_hmac_sha256_iov
+#define	hmac_compare		slurm_hmac_compare
+
 /* hostlist.[ch] functions */
 #define	hostlist_create		slurm_hostlist_create
 #define	hostlist_copy		slurm_hostlist_copy
@@ -168,6 +177,7 @@
 
 /* list.[ch] functions */
 #define	list_create		slurm_list_create
+#define	list_create_unlocked	slurm_list_create_unlocked
 #define	list_destroy		slurm_list_destroy
 #define	list_is_empty		slurm_list_is_empty
 #define	list_count		slurm_list_count
@@ -231,6 +241,9 @@
 #define	free_buf		slurm_free_buf
 #define grow_buf		slurm_grow_buf
 #define	init_buf		slurm_init_buf
+#define	init_pool_buf		slurm_init_pool_buf
+#define	free_pool_buf		slurm_free_pool_buf
+#define	set_buf_compact		slurm_set_buf_compact
 #define	xfer_buf_data		slurm_xfer_buf_data
 #define	pack_time		slurm_pack_time
 #define	unpack_time		slurm_unpack_time
@@ -356,11 +369,21 @@
 #define s_p_hashtbl_create		slurm_s_p_hashtbl_create
 #define s_p_parse_file			slurm_s_p_parse_file
 
+/* vector.[ch] functions */
+#define	vector_create		slurm_vector_create
+#define	vector_destroy		slurm_vector_destroy
+#define	vector_append		slurm_vector_append
+#define	vector_get		slurm_vector_get
+#define	vector_remove		slurm_vector_remove
+#define	vector_count		slurm_vector_count
+#define	vector_next		slurm_vector_next
+
 #endif /* USE_ALIAS */
 
 /* Include the function definitions after redefining their names. */
 #include "src/common/arg_desc.h"
 #include "src/common/bitstring.h"
+#include "src/common/hmac.h"
 #include "src/common/hostlist.h"
 #include "src/common/jobacct_common.h"
 #include "src/common/list.h"
@@ -373,6 +396,7 @@
 #include "src/common/slurm_auth.h"
 #include "src/common/strlcpy.h"
 #include "src/common/switch.h"
+#include "src/common/vector.h"
 #include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
@@ -64,6 +64,7 @@
 #include "src/common/slurm_jobacct_gather.h"
 #include "src/common/list.h"
 #include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/common/read_config.h"
 #include "src/common/stepd_api.h"
 
@@ -892,6 +893,67 @@ rwfail:
 	return -1;
 }
 
+/*
+ * Forward relayed launch responses to the slurmstepd, which packs them
+ * into its own relay message.  The list is left to the caller.
+ */
+int
+stepd_launch_relay(int fd, launch_tasks_relay_msg_t *sent)
+{
+	int req = REQUEST_STEP_LAUNCH_RELAY;
+	slurm_msg_t msg;
+	Buf buffer;
+	uint32_t len;
+	int rc;
+	int errnum = 0;
+
+	debug("Entering stepd_launch_relay, %d responses",
+	      list_count(sent->resp_list));
+	slurm_msg_t_init(&msg);
+	msg.msg_type = RESPONSE_LAUNCH_TASKS_RELAY;
+	msg.data = sent;
+	buffer = init_buf(0);
+	if (pack_msg(&msg, buffer) != SLURM_SUCCESS) {
+		free_buf(buffer);
+		return -1;
+	}
+	len = get_buf_offset(buffer);
+
+	safe_write(fd, &req, sizeof(int));
+	safe_write(fd, &len, sizeof(uint32_t));
+	safe_write(fd, get_buf_data(buffer), len);
+	free_buf(buffer);
+	buffer = NULL;
+
+	/* Receive the return code and errno */
+	safe_read(fd, &rc, sizeof(int));
+	safe_read(fd, &errnum, sizeof(int));
+
+	errno = errnum;
+	return rc;
+rwfail:
+	if (buffer)
+		free_buf(buffer);
+	return -1;
+}
+
+/*
+ * Get the port of the slurmstepd's I/O relay listener.
+ */
+int
+stepd_io_relay_port(int fd, uint16_t *port)
+{
+	int req = REQUEST_STEP_IO_RELAY_PORT;
+
+	safe_write(fd, &req, sizeof(int));
+	safe_read(fd, port, sizeof(uint16_t));
+
+	return SLURM_SUCCESS;
+rwfail:
+	*port = 0;
+	return SLURM_ERROR;
+}
+
 /*
  *
  * Returns jobacctinfo_t struct on success, NULL on error.
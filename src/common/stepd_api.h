@@ -74,6 +74,8 @@ typedef enum {
 	REQUEST_STEP_LIST_PIDS,
 	REQUEST_STEP_RECONFIGURE,
 	REQUEST_STEP_STAT,
+	REQUEST_STEP_LAUNCH_RELAY,
+	REQUEST_STEP_IO_RELAY_PORT,
 } step_msg_t;
 
 typedef enum {
@@ -235,6 +237,24 @@ int stepd_reconfig(int fd);
  */
 int stepd_completion(int fd, step_complete_msg_t *sent);
 
+/*
+ * Hand launch responses relayed by a child slurmstepd in the reverse
+ * tree to the local slurmstepd for forwarding toward srun.
+ *
+ * Returns SLURM_SUCCESS is successful.  On error returns SLURM_ERROR
+ * and sets errno.
+ */
+int stepd_launch_relay(int fd, launch_tasks_relay_msg_t *sent);
+
+/*
+ * Get the port on which the slurmstepd accepts I/O connections relayed
+ * from its children in the reverse tree, zero if it is not listening.
+ *
+ * Returns SLURM_SUCCESS is successful.  On error returns SLURM_ERROR
+ * and sets errno.
+ */
+int stepd_io_relay_port(int fd, uint16_t *port);
+
 /*
  *
  * Returns SLURM_SUCCESS on success or SLURM_ERROR on error.
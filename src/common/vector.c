@@ -0,0 +1,160 @@
+/*****************************************************************************\
+ *  src/common/vector.c - growable array of pointers with stable handles
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "src/common/macros.h"
+#include "src/common/vector.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+
+/*
+** Define slurm-specific aliases for use by plugins, see slurm_xlator.h
+** for details.
+*/
+strong_alias(vector_create,	slurm_vector_create);
+strong_alias(vector_destroy,	slurm_vector_destroy);
+strong_alias(vector_append,	slurm_vector_append);
+strong_alias(vector_get,	slurm_vector_get);
+strong_alias(vector_remove,	slurm_vector_remove);
+strong_alias(vector_count,	slurm_vector_count);
+strong_alias(vector_next,	slurm_vector_next);
+
+#define VECTOR_MAGIC	0x5ec70a
+
+struct vector {
+#ifndef NDEBUG
+	int magic;
+#endif
+	void **items;		/* slots, NULL for a hole */
+	int used;		/* slots ever used, holes included */
+	int size;		/* slots allocated */
+	int count;		/* items in the vector */
+	int *holes;		/* stack of free slots below used */
+	int hole_cnt;
+};
+
+extern vector_t *vector_create(int size)
+{
+	vector_t *v = xmalloc(sizeof(vector_t));
+
+	xassert(v->magic = VECTOR_MAGIC);
+	v->size = MAX(size, 16);
+	v->items = xmalloc(v->size * sizeof(void *));
+	v->holes = xmalloc(v->size * sizeof(int));
+	return v;
+}
+
+extern void vector_destroy(vector_t *v)
+{
+	if (!v)
+		return;
+	xassert(v->magic == VECTOR_MAGIC);
+	xassert(v->magic = ~VECTOR_MAGIC);
+	xfree(v->items);
+	xfree(v->holes);
+	xfree(v);
+}
+
+extern int vector_append(vector_t *v, void *x)
+{
+	int handle;
+
+	xassert(v->magic == VECTOR_MAGIC);
+	xassert(x);
+	if (v->hole_cnt) {
+		handle = v->holes[--v->hole_cnt];
+	} else {
+		if (v->used == v->size) {
+			v->size *= 2;
+			xrealloc(v->items, v->size * sizeof(void *));
+			xrealloc(v->holes, v->size * sizeof(int));
+		}
+		handle = v->used++;
+	}
+	v->items[handle] = x;
+	v->count++;
+	return handle;
+}
+
+extern void *vector_get(vector_t *v, int handle)
+{
+	xassert(v->magic == VECTOR_MAGIC);
+	if ((handle < 0) || (handle >= v->used))
+		return NULL;
+	return v->items[handle];
+}
+
+extern void *vector_remove(vector_t *v, int handle)
+{
+	void *x;
+
+	xassert(v->magic == VECTOR_MAGIC);
+	if ((handle < 0) || (handle >= v->used) || !(x = v->items[handle]))
+		return NULL;
+	v->items[handle] = NULL;
+	if (--v->count == 0) {
+		/* nothing left, start filling from the first slot again */
+		v->used = 0;
+		v->hole_cnt = 0;
+	} else
+		v->holes[v->hole_cnt++] = handle;
+	return x;
+}
+
+extern int vector_count(vector_t *v)
+{
+	xassert(v->magic == VECTOR_MAGIC);
+	return v->count;
+}
+
+extern void *vector_next(vector_t *v, int *handle)
+{
+	void **items = v->items;
+	int i;
+
+	xassert(v->magic == VECTOR_MAGIC);
+	for (i = MAX(*handle, 0); i < v->used; i++) {
+		if (items[i]) {
+			*handle = i + 1;
+			return items[i];
+		}
+	}
+	*handle = v->used;
+	return NULL;
+}
@@ -0,0 +1,79 @@
+/*****************************************************************************\
+ *  src/common/vector.h - growable array of pointers with stable handles
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _VECTOR_H
+#define _VECTOR_H
+
+/*
+ * A vector holds pointers in one contiguous array, so walking it touches
+ * consecutive memory rather than chasing list nodes. Each item is given a
+ * handle, its slot in the array, which does not change while the item is
+ * in the vector. Removing an item leaves a hole which a later append
+ * reuses, so the order of iteration is not the order of insertion.
+ *
+ * A vector has no lock of its own, callers must serialize access to it.
+ */
+typedef struct vector vector_t;
+
+/* Create an empty vector with room for "size" items before it grows */
+extern vector_t *vector_create(int size);
+
+/* Free the vector, the items themselves are not freed */
+extern void vector_destroy(vector_t *v);
+
+/* Add item "x" (not NULL) to the vector, RET its handle */
+extern int vector_append(vector_t *v, void *x);
+
+/* RET the item with the given handle, or NULL if there is none */
+extern void *vector_get(vector_t *v, int handle);
+
+/* Remove the item with the given handle, RET the item or NULL */
+extern void *vector_remove(vector_t *v, int handle);
+
+/* RET the number of items in the vector */
+extern int vector_count(vector_t *v);
+
+/*
+ * RET the first item with a handle of at least *handle and set *handle to
+ * one past it, or NULL at the end of the vector. Iterate with:
+ *	int i = 0;
+ *	while ((x = vector_next(v, &i)))
+ *		...
+ * where the handle of x is (i - 1). Items may be removed while iterating.
+ */
+extern void *vector_next(vector_t *v, int *handle);
+
+#endif /* !_VECTOR_H */
@@ -49,6 +49,9 @@
 #include <string.h>
 #include <stdio.h>
 #include <limits.h>	/* for INT_MAX */
+#ifdef WITH_PTHREADS
+#  include <pthread.h>
+#endif
 
 #include "src/common/xmalloc.h"
 #include "src/common/log.h"
@@ -77,6 +80,328 @@ static void malloc_assert_failed(char *, const char *, int,
           } _STMT_END
 #endif /* NDEBUG */
 
+/*
+ * Every block starts with two ints: XMALLOC_MAGIC with a tag saying where
+ * the block came from, and the size requested by the caller.
+ *
+ * Blocks of up to XMALLOC_MAX_CACHED bytes, header included, are rounded up
+ * to one of XMALLOC_CLASSES sizes and tagged with their class. A freed block
+ * goes to the calling thread's free list for its class, from which it is
+ * handed out again without calling malloc() or taking a lock. pool_lock is
+ * only taken to move XMALLOC_CACHE_BATCH blocks between a thread's cache and
+ * the global pools, when the cache runs empty or grows to twice that size,
+ * and when a thread exits. The global pools keep at most XMALLOC_POOL_MAX
+ * blocks of each class, the rest are given back to free().
+ *
+ * Set SLURM_XMALLOC_MALLOC in the environment to take every block straight
+ * from malloc(). The caches are also disabled by MEMORY_LEAK_DEBUG, so that
+ * valgrind can identify where exactly any leak originates.
+ */
+#define XMALLOC_HDR		(2 * sizeof(int))
+#define XMALLOC_CLASSES		16
+#define XMALLOC_CACHE_BATCH	32
+#define XMALLOC_POOL_MAX	4096
+
+#define XMALLOC_TAG_MALLOC	0	/* larger block, from malloc() */
+#define XMALLOC_TAG_ARENA	0xff	/* from an arena, freed with it */
+					/* others are size class + 1 */
+#define XMALLOC_TAG(p)		(((p)[0] >> 8) & 0xff)
+#define XMALLOC_MAGIC_OK(p)	(((p)[0] & 0xff) == XMALLOC_MAGIC)
+
+/* Link to the next free block of a class, kept after the header */
+#define XMALLOC_NEXT(p)		(*(void **) ((char *) (p) + XMALLOC_HDR))
+
+/* Arenas are carved from XARENA_CHUNK byte chunks, requests of over a
+ * quarter of that get a chunk of their own */
+#define XARENA_CHUNK		(64 * 1024)
+#define XARENA_ALIGN(n)		(((n) + 15) & ~((size_t) 15))
+#define XARENA_CHUNK_HDR	XARENA_ALIGN(sizeof(struct xarena_chunk))
+
+typedef struct xmalloc_cache {
+	void		*free[XMALLOC_CLASSES];	 /* free blocks by class */
+	int		count[XMALLOC_CLASSES];	 /* blocks in each list */
+	uint64_t	allocs;			 /* allocations by thread */
+	uint64_t	bytes;			 /* bytes they requested */
+} xmalloc_cache_t;
+
+struct xarena_chunk {
+	struct xarena_chunk *next;
+	size_t		size;			/* bytes after the header */
+	size_t		used;
+};
+
+struct xarena {
+	struct xarena_chunk *chunks;		/* chunk being carved first */
+};
+
+static const int class_size[XMALLOC_CLASSES] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256,
+	320, 384, 448, 512
+};
+static void *pool_free[XMALLOC_CLASSES];
+static int pool_count[XMALLOC_CLASSES];
+static int xmalloc_caching = 0;
+
+#ifdef WITH_PTHREADS
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t cache_key;
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+static int cache_key_ok = 0;
+#  define POOL_LOCK()		pthread_mutex_lock(&pool_lock)
+#  define POOL_UNLOCK()		pthread_mutex_unlock(&pool_lock)
+#else
+#  define POOL_LOCK()
+#  define POOL_UNLOCK()
+#endif
+
+/* Return the size class of a request of "size" bytes, -1 if too large */
+static inline int _size_class(size_t size)
+{
+	size_t n = size + XMALLOC_HDR;
+
+	if (n <= 128)
+		return (n - 1) >> 4;
+	if (n <= 256)
+		return 8 + ((n - 129) >> 5);
+	if (n <= 512)
+		return 12 + ((n - 257) >> 6);
+	return -1;
+}
+
+/* Move up to XMALLOC_CACHE_BATCH blocks of class "cls" from the global pool
+ * to the empty cache "c" */
+static void _cache_fill(xmalloc_cache_t *c, int cls)
+{
+	void *p;
+	int n = 0;
+
+	POOL_LOCK();
+	if ((p = pool_free[cls])) {
+		c->free[cls] = p;
+		for (n = 1; (n < XMALLOC_CACHE_BATCH) && XMALLOC_NEXT(p); n++)
+			p = XMALLOC_NEXT(p);
+		pool_free[cls] = XMALLOC_NEXT(p);
+		pool_count[cls] -= n;
+		XMALLOC_NEXT(p) = NULL;
+	}
+	POOL_UNLOCK();
+	c->count[cls] = n;
+}
+
+/* Move "n" blocks of class "cls" from cache "c" to the global pool, or give
+ * them back to free() if the pool is full */
+static void _cache_drain(xmalloc_cache_t *c, int cls, int n)
+{
+	void *first, *last, *next;
+	int i;
+
+	first = last = c->free[cls];
+	for (i = 1; i < n; i++)
+		last = XMALLOC_NEXT(last);
+	c->free[cls] = XMALLOC_NEXT(last);
+	c->count[cls] -= n;
+
+	POOL_LOCK();
+	if ((pool_count[cls] + n) <= XMALLOC_POOL_MAX) {
+		XMALLOC_NEXT(last) = pool_free[cls];
+		pool_free[cls] = first;
+		pool_count[cls] += n;
+		first = NULL;
+	}
+	POOL_UNLOCK();
+	if (!first)
+		return;
+
+	XMALLOC_NEXT(last) = NULL;
+	MALLOC_LOCK();
+	for ( ; first; first = next) {
+		next = XMALLOC_NEXT(first);
+		free(first);
+	}
+	MALLOC_UNLOCK();
+}
+
+static void _cache_init(void)
+{
+	char *backend = getenv("SLURM_XMALLOC_MALLOC");
+
+#ifndef MEMORY_LEAK_DEBUG
+	if (!backend || (atoi(backend) == 0))
+		xmalloc_caching = 1;
+#endif
+}
+
+#ifdef WITH_PTHREADS
+/* Return the blocks cached by an exiting thread to the global pools */
+static void _cache_destroy(void *arg)
+{
+	xmalloc_cache_t *c = arg;
+	int cls;
+
+	for (cls = 0; cls < XMALLOC_CLASSES; cls++) {
+		if (c->count[cls])
+			_cache_drain(c, cls, c->count[cls]);
+	}
+	MALLOC_LOCK();
+	free(c);
+	MALLOC_UNLOCK();
+}
+
+/* A child forked while another thread holds pool_lock must not inherit
+ * it locked */
+static void _atfork_prepare(void)
+{
+	pthread_mutex_lock(&pool_lock);
+}
+
+static void _atfork_release(void)
+{
+	pthread_mutex_unlock(&pool_lock);
+}
+
+static void _cache_key_init(void)
+{
+	_cache_init();
+	if (pthread_key_create(&cache_key, _cache_destroy) == 0)
+		cache_key_ok = 1;
+	else
+		xmalloc_caching = 0;
+	(void) pthread_atfork(_atfork_prepare, _atfork_release,
+			      _atfork_release);
+}
+#endif
+
+/* Return the calling thread's cache, NULL if it has none */
+static xmalloc_cache_t *_cache_get(void)
+{
+#ifdef WITH_PTHREADS
+	xmalloc_cache_t *c;
+
+	pthread_once(&cache_once, _cache_key_init);
+	if (!cache_key_ok)
+		return NULL;
+	if (!(c = pthread_getspecific(cache_key))) {
+		MALLOC_LOCK();
+		c = calloc(1, sizeof(xmalloc_cache_t));
+		MALLOC_UNLOCK();
+		if (c && (pthread_setspecific(cache_key, c) != 0)) {
+			MALLOC_LOCK();
+			free(c);
+			MALLOC_UNLOCK();
+			c = NULL;
+		}
+	}
+	return c;
+#else
+	static xmalloc_cache_t cache;
+	static int cache_init_done = 0;
+
+	if (!cache_init_done) {
+		_cache_init();
+		cache_init_done = 1;
+	}
+	return &cache;
+#endif
+}
+
+/* Allocate a zeroed block of "size" bytes, return its header or NULL */
+static int *_block_alloc(size_t size)
+{
+	xmalloc_cache_t *c = _cache_get();
+	int cls = -1, *p;
+
+	if (c) {
+		c->allocs++;
+		c->bytes += size;
+		if (xmalloc_caching)
+			cls = _size_class(size);
+	}
+	if (cls >= 0) {
+		if (!c->free[cls])
+			_cache_fill(c, cls);
+		if ((p = c->free[cls])) {
+			c->free[cls] = XMALLOC_NEXT(p);
+			c->count[cls]--;
+		} else {
+			MALLOC_LOCK();
+			p = (int *)malloc(class_size[cls]);
+			MALLOC_UNLOCK();
+		}
+	} else {
+		MALLOC_LOCK();
+		p = (int *)malloc(size + XMALLOC_HDR);
+		MALLOC_UNLOCK();
+	}
+	if (!p)
+		return NULL;
+
+	p[0] = XMALLOC_MAGIC | ((cls + 1) << 8); /* add "secret" magic cookie */
+	p[1] = (int)size;			  /* store size in buffer */
+	memset(&p[2], 0, size);
+	return p;
+}
+
+static void _block_free(int *p)
+{
+	int tag = XMALLOC_TAG(p), cls;
+	xmalloc_cache_t *c;
+
+	p[0] = 0;	/* make sure xfree isn't called twice */
+	if (tag == XMALLOC_TAG_ARENA)
+		return;
+	if ((tag != XMALLOC_TAG_MALLOC) && (c = _cache_get())) {
+		cls = tag - 1;
+		XMALLOC_NEXT(p) = c->free[cls];
+		c->free[cls] = p;
+		if (++c->count[cls] >= (XMALLOC_CACHE_BATCH * 2))
+			_cache_drain(c, cls, XMALLOC_CACHE_BATCH);
+		return;
+	}
+	MALLOC_LOCK();
+	free(p);
+	MALLOC_UNLOCK();
+}
+
+/* Resize the block with header "p", zeroing any new space. Return the new
+ * header, or NULL with the block unchanged. */
+static int *_block_realloc(int *p, size_t newsize)
+{
+	int tag = XMALLOC_TAG(p), old_size = p[1];
+	xmalloc_cache_t *c;
+	int *new;
+
+	if ((tag == XMALLOC_TAG_ARENA) ||
+	    ((tag != XMALLOC_TAG_MALLOC) &&
+	     ((newsize + XMALLOC_HDR) > class_size[tag - 1]))) {
+		/* move to a block of another class, or from the arena */
+		if (!(new = _block_alloc(newsize)))
+			return NULL;
+		memcpy(&new[2], &p[2], MIN((size_t)old_size, newsize));
+		_block_free(p);
+		return new;
+	}
+
+	if ((c = _cache_get())) {
+		c->allocs++;
+		c->bytes += newsize;
+	}
+	if (tag == XMALLOC_TAG_MALLOC) {
+		MALLOC_LOCK();
+		new = (int *)realloc(p, newsize + XMALLOC_HDR);
+		MALLOC_UNLOCK();
+		if (new == NULL)
+			return NULL;
+	} else
+		new = p;	/* still fits its class */
+
+	if (old_size < newsize) {
+		char *p_new = (char *)(&new[2]) + old_size;
+		memset(p_new, 0, (int)(newsize-old_size));
+	}
+	new[1] = (int)newsize;
+	return new;
+}
 
 /*
  * "Safe" version of malloc().
@@ -85,14 +410,10 @@ static void malloc_assert_failed(char *, const char *, int,
  */
 void *slurm_xmalloc(size_t size, const char *file, int line, const char *func)
 {
-	void *new;
 	int *p;
 
-
 	xmalloc_assert(size >= 0 && size <= INT_MAX);
-	MALLOC_LOCK();
-	p = (int *)malloc(size + 2*sizeof(int));
-	MALLOC_UNLOCK();
+	p = _block_alloc(size);
 	if (!p) {
 		/* don't call log functions here, we're probably OOM
 		 */
@@ -100,12 +421,7 @@ void *slurm_xmalloc(size_t size, const char *file, int line, const char *func)
 				file, line, func, (int)size);
 		exit(1);
 	}
-	p[0] = XMALLOC_MAGIC;	/* add "secret" magic cookie */
-	p[1] = (int)size;	/* store size in buffer */
-
-	new = &p[2];
-	memset(new, 0, size);
-	return new;
+	return &p[2];
 }
 
 /*
@@ -114,22 +430,14 @@ void *slurm_xmalloc(size_t size, const char *file, int line, const char *func)
 void *slurm_try_xmalloc(size_t size, const char *file, int line,
                         const char *func)
 {
-	void *new;
 	int *p;
 
 	xmalloc_assert(size >= 0 && size <= INT_MAX);
-	MALLOC_LOCK();
-	p = (int *)malloc(size + 2*sizeof(int));
-	MALLOC_UNLOCK();
+	p = _block_alloc(size);
 	if (!p) {
 		return NULL;
 	}
-	p[0] = XMALLOC_MAGIC;	/* add "secret" magic cookie */
-	p[1] = (int)size;	/* store size in buffer */
-
-	new = &p[2];
-	memset(new, 0, size);
-	return new;
+	return &p[2];
 }
 
 /*
@@ -147,40 +455,22 @@ void * slurm_xrealloc(void **item, size_t newsize,
 	xmalloc_assert(newsize >= 0 && (int)newsize <= INT_MAX);
 
 	if (*item != NULL) {
-		int old_size;
 		p = (int *)*item - 2;
 
 		/* magic cookie still there? */
-		xmalloc_assert(p[0] == XMALLOC_MAGIC);
-		old_size = p[1];
-
-		MALLOC_LOCK();
-		p = (int *)realloc(p, newsize + 2*sizeof(int));
-		MALLOC_UNLOCK();
-
+		xmalloc_assert(XMALLOC_MAGIC_OK(p));
+		p = _block_realloc(p, newsize);
 		if (p == NULL)
 			goto error;
-
-		if (old_size < newsize) {
-			char *p_new = (char *)(&p[2]) + old_size;
-			memset(p_new, 0, (int)(newsize-old_size));
-		}
-		xmalloc_assert(p[0] == XMALLOC_MAGIC);
+		xmalloc_assert(XMALLOC_MAGIC_OK(p));
 
 	} else {
 		/* Initalize new memory */
-		MALLOC_LOCK();
-		p = (int *)malloc(newsize + 2*sizeof(int));
-		MALLOC_UNLOCK();
-
+		p = _block_alloc(newsize);
 		if (p == NULL)
 			goto error;
-
-		memset(&p[2], 0, newsize);
-		p[0] = XMALLOC_MAGIC;
 	}
 
-	p[1] = (int)newsize;
 	*item = &p[2];
 	return *item;
 
@@ -203,40 +493,22 @@ int slurm_try_xrealloc(void **item, size_t newsize,
 	xmalloc_assert(newsize >= 0 && (int)newsize <= INT_MAX);
 
 	if (*item != NULL) {
-		int old_size;
 		p = (int *)*item - 2;
 
 		/* magic cookie still there? */
-		xmalloc_assert(p[0] == XMALLOC_MAGIC);
-		old_size = p[1];
-
-		MALLOC_LOCK();
-		p = (int *)realloc(p, newsize + 2*sizeof(int));
-		MALLOC_UNLOCK();
-
+		xmalloc_assert(XMALLOC_MAGIC_OK(p));
+		p = _block_realloc(p, newsize);
 		if (p == NULL)
 			return 0;
-
-		if (old_size < newsize) {
-			char *p_new = (char *)(&p[2]) + old_size;
-			memset(p_new, 0, (int)(newsize-old_size));
-		}
-		xmalloc_assert(p[0] == XMALLOC_MAGIC);
+		xmalloc_assert(XMALLOC_MAGIC_OK(p));
 
 	} else {
 		/* Initalize new memory */
-		MALLOC_LOCK();
-		p = (int *)malloc(newsize + 2*sizeof(int));
-		MALLOC_UNLOCK();
-
+		p = _block_alloc(newsize);
 		if (p == NULL)
 			return 0;
-
-		memset(&p[2], 0, newsize);
-		p[0] = XMALLOC_MAGIC;
 	}
 
-	p[1] = newsize;
 	*item = &p[2];
 	return 1;
 }
@@ -250,7 +522,7 @@ int slurm_xsize(void *item, const char *file, int line, const char *func)
 {
 	int *p = (int *)item - 2;
 	xmalloc_assert(item != NULL);
-	xmalloc_assert(p[0] == XMALLOC_MAGIC);
+	xmalloc_assert(XMALLOC_MAGIC_OK(p));
 	return p[1];
 }
 
@@ -264,13 +536,106 @@ void slurm_xfree(void **item, const char *file, int line, const char *func)
 	if (*item != NULL) {
 		int *p = (int *)*item - 2;
 		/* magic cookie still there? */
-		xmalloc_assert(p[0] == XMALLOC_MAGIC);
-		p[0] = 0;	/* make sure xfree isn't called twice */
+		xmalloc_assert(XMALLOC_MAGIC_OK(p));
+		_block_free(p);
+		*item = NULL;
+	}
+}
+
+/*
+ * Create an arena, from which memory is allocated with xarena_alloc() and
+ * released all at once with xarena_destroy().
+ */
+xarena_t *slurm_xarena_create(void)
+{
+	return xmalloc(sizeof(xarena_t));
+}
+
+/*
+ * Allocate zeroed memory from an arena.
+ *   arena (IN)		arena made by xarena_create()
+ *   size (IN)		number of bytes to allocate
+ *   RETURN		pointer to the memory, valid until the arena is
+ *			destroyed
+ */
+void *slurm_xarena_alloc(xarena_t *arena, size_t size,
+			 const char *file, int line, const char *func)
+{
+	struct xarena_chunk *chunk = arena->chunks;
+	size_t need = XARENA_ALIGN(size + XMALLOC_HDR), chunk_size;
+	xmalloc_cache_t *c;
+	int *p;
+
+	xmalloc_assert(size >= 0 && size <= INT_MAX);
+	if ((c = _cache_get())) {
+		c->allocs++;
+		c->bytes += size;
+	}
+
+	if (!chunk || ((chunk->used + need) > chunk->size)) {
+		/* each allocation gets a chunk of its own when the caches
+		 * are disabled, so valgrind sees them separately */
+		if (xmalloc_caching && (need <= (XARENA_CHUNK / 4)))
+			chunk_size = XARENA_CHUNK - XARENA_CHUNK_HDR;
+		else
+			chunk_size = need;
 		MALLOC_LOCK();
-		free(p);
+		chunk = malloc(XARENA_CHUNK_HDR + chunk_size);
 		MALLOC_UNLOCK();
-		*item = NULL;
+		if (!chunk) {
+			fprintf(log_fp(), "%s:%d: %s: xarena_alloc(%d) "
+				"failed\n", file, line, func, (int)size);
+			exit(1);
+		}
+		chunk->size = chunk_size;
+		chunk->used = 0;
+		if (arena->chunks && (chunk_size == need)) {
+			/* keep carving the partly used chunk */
+			chunk->next = arena->chunks->next;
+			arena->chunks->next = chunk;
+		} else {
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+		}
+	}
+
+	p = (int *)((char *)chunk + XARENA_CHUNK_HDR + chunk->used);
+	chunk->used += need;
+	p[0] = XMALLOC_MAGIC | (XMALLOC_TAG_ARENA << 8);
+	p[1] = (int)size;
+	memset(&p[2], 0, size);
+	return &p[2];
+}
+
+/*
+ * Release an arena and all memory allocated from it.
+ */
+void slurm_xarena_destroy(xarena_t *arena)
+{
+	struct xarena_chunk *chunk, *next;
+
+	if (!arena)
+		return;
+	MALLOC_LOCK();
+	for (chunk = arena->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
 	}
+	MALLOC_UNLOCK();
+	xfree(arena);
+}
+
+/*
+ * Return the count of allocations made by the calling thread with
+ * [try_]xmalloc(), [try_]xrealloc() and xarena_alloc(), and the bytes they
+ * requested.
+ */
+void slurm_xmalloc_thread_stats(uint64_t *allocs, uint64_t *bytes)
+{
+	xmalloc_cache_t *c = _cache_get();
+
+	*allocs = c ? c->allocs : 0;
+	*bytes  = c ? c->bytes  : 0;
 }
 
 #ifndef NDEBUG
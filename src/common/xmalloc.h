@@ -72,6 +72,19 @@
  * p. The memory must have been allocated with [try_]xmalloc() or
  * [try_]xrealloc().
  *
+ * xarena_t *xarena_create(void);
+ * void *xarena_alloc(xarena_t *arena, size_t size);
+ * void xarena_destroy(xarena_t *arena);
+ *
+ * xarena_alloc(arena, size) allocates zeroed memory from an arena, which is
+ * carved from large chunks and released all at once by xarena_destroy().
+ * xfree() and xsize() accept arena memory, xfree() only clearing the pointer.
+ * xrealloc() moves arena memory into an ordinary block, which must then be
+ * freed with xfree(). An arena must only be used by one thread at a time.
+ *
+ * xmalloc_thread_stats(&allocs, &bytes) returns the count of allocations
+ * made by the calling thread and the number of bytes requested by them.
+ *
 \*****************************************************************************/
 
 #ifndef _XMALLOC_H
@@ -81,6 +94,19 @@
 #  include <sys/types.h>
 #endif
 
+#if HAVE_CONFIG_H
+#  include "config.h"
+#  if HAVE_INTTYPES_H
+#    include <inttypes.h>
+#  else
+#    if HAVE_STDINT_H
+#      include <stdint.h>
+#    endif
+#  endif
+#else
+#  include <stdint.h>
+#endif
+
 #include "macros.h"
 
 #define xmalloc(__sz) \
@@ -110,6 +136,25 @@ void *slurm_xrealloc(void **, size_t, const char *, int, const char *);
 int  slurm_try_xrealloc(void **, size_t, const char *, int, const char *);
 int  slurm_xsize(void *, const char *, int, const char *);
 
+#define xarena_create() \
+	slurm_xarena_create()
+
+#define xarena_alloc(__a, __sz) \
+	slurm_xarena_alloc(__a, __sz, __FILE__, __LINE__, __CURRENT_FUNC__)
+
+#define xarena_destroy(__a) \
+	slurm_xarena_destroy(__a)
+
+#define xmalloc_thread_stats(__allocs, __bytes) \
+	slurm_xmalloc_thread_stats(__allocs, __bytes)
+
+typedef struct xarena xarena_t;
+
+xarena_t *slurm_xarena_create(void);
+void *slurm_xarena_alloc(xarena_t *, size_t, const char *, int, const char *);
+void slurm_xarena_destroy(xarena_t *);
+void slurm_xmalloc_thread_stats(uint64_t *, uint64_t *);
+
 #define XMALLOC_MAGIC 0x42
 
 #endif /* !_XMALLOC_H */
@@ -55,6 +55,7 @@
 
 #include <pwd.h>
 #include <grp.h>
+#include <sys/uio.h>
 #include <auth.h>
 
 #ifndef UNIX_PATH_MAX
@@ -233,6 +234,23 @@ slurm_auth_verify( slurm_auth_credential_t *cred, char *auth_info )
 	return SLURM_SUCCESS;
 }
 
+/*
+ * This plugin does not sign messages, a signed credential is the same
+ * as any other.
+ */
+slurm_auth_credential_t *
+slurm_auth_create_signed( void *argv[], char *auth_info, uid_t r_uid,
+			  gid_t r_gid, struct iovec *data, int iovcnt )
+{
+	return slurm_auth_create( argv, auth_info );
+}
+
+int
+slurm_auth_verify_signed( slurm_auth_credential_t *cred, char *auth_info,
+			  struct iovec *data, int iovcnt )
+{
+	return slurm_auth_verify( cred, auth_info );
+}
 
 uid_t
 slurm_auth_get_uid( slurm_auth_credential_t *cred, char *auth_info )
@@ -64,16 +64,43 @@
 #  include <string.h>
 #endif /* HAVE_CONFIG_H */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/uio.h>
+#include <time.h>
 
 #include <munge.h>
 
 #include "slurm/slurm_errno.h"
 #include "src/common/slurm_xlator.h"
+#include "src/common/slurm_protocol_api.h"
 
 #define MUNGE_ERRNO_OFFSET	1000
 
+/*
+ * Session credentials: with AuthSessionTimeout set, a process creates a
+ * random key for each user it sends signed messages to. The key travels
+ * in the payload of one munge credential which only that user (and group,
+ * if known) can decode, attached to all of the messages to that user
+ * until the key is renewed. Receivers decode that credential once and
+ * then only check an HMAC of the key id, a per message sequence number
+ * and the message itself. A window of recently seen sequence numbers
+ * takes the place of munge's replay detection.
+ */
+#define MUNGE_SESSION_VERSION	11	/* plugin_version of session creds */
+#define SESSION_MAGIC		0x534c5331
+#define SESSION_KEY_LEN		32
+#define SESSION_MAC_LEN		16	/* truncated HMAC-SHA256 */
+#define SESSION_PAYLOAD_LEN	(4 + 8 + 4 + SESSION_KEY_LEN)
+#define SESSION_WINDOW		1024	/* sequence numbers tracked per key */
+#define SESSION_HASH_SIZE	16384
+#define SESSION_CACHE_SIZE	65536	/* keys cached by a receiver */
+#define SESSION_SEND_HASH_SIZE	64
+#define SESSION_MAX_IOV		4	/* message parts signed */
+
 /*
  * These variables are required by the generic plugin interface.  If they
  * are not found in the plugin, the plugin loader will ignore it.
@@ -130,8 +157,54 @@ typedef struct _slurm_auth_credential {
 	uid_t   uid;       /* UID. valid only if verified == true            */
 	gid_t   gid;       /* GID. valid only if verified == true            */
 	int cr_errno;
+	bool     session;  /* m_str carries a session key                    */
+	uint64_t key_id;   /* session key identifier                         */
+	uint64_t seq;      /* message sequence number under the session key  */
+	unsigned char mac[SESSION_MAC_LEN];
 } slurm_auth_credential_t;
 
+/*
+ * A session key used to sign messages this process sends to one user
+ */
+typedef struct send_session {
+	uint64_t key_id;
+	hmac_sha256_key_t key;
+	char    *m_str;    /* munge credential carrying the key, malloc'd    */
+	time_t   renew;    /* create a new key after this time               */
+	uint64_t seq;
+	pid_t    pid;
+	uid_t    uid;
+	gid_t    gid;
+	uid_t    r_uid;    /* only this user may decode m_str                */
+	gid_t    r_gid;    /* and this group, unless SLURM_AUTH_ANY_GID      */
+	struct send_session *next;
+} send_session_t;
+
+/*
+ * A session key learned by this process from a received credential,
+ * found by a hash of the munge credential which carried it rather than
+ * by the key id the sender claims
+ */
+typedef struct recv_session {
+	unsigned char cred_hash[SHA256_DIGEST_LEN];
+	uint64_t key_id;
+	hmac_sha256_key_t key;
+	uid_t    uid;
+	gid_t    gid;
+	time_t   expire;
+	uint64_t seq_max;  /* highest sequence number seen                   */
+	uint64_t seq_seen[SESSION_WINDOW / 64];
+	struct recv_session *next;
+} recv_session_t;
+
+static pthread_mutex_t  send_lock = PTHREAD_MUTEX_INITIALIZER;
+static send_session_t  *send_hash[SESSION_SEND_HASH_SIZE];
+
+static pthread_mutex_t  recv_lock = PTHREAD_MUTEX_INITIALIZER;
+static recv_session_t  *recv_hash[SESSION_HASH_SIZE];
+static int              recv_cnt = 0;
+static time_t           recv_purge_time = 0;
+
 /*
  * Munge info structure for print* function
  */
@@ -153,6 +226,12 @@ static void           cred_info_destroy(munge_info_t *);
 static void           _print_cred_info(munge_info_t *mi);
 static void           _print_cred(munge_ctx_t ctx);
 static int            _decode_cred(slurm_auth_credential_t *c, char *socket);
+static slurm_auth_credential_t *_session_create(uint16_t lifetime,
+						uid_t r_uid, gid_t r_gid,
+						struct iovec *data,
+						int iovcnt);
+static int            _session_verify(slurm_auth_credential_t *c,
+				      struct iovec *data, int iovcnt);
 
 
 /*
@@ -181,10 +260,10 @@ slurm_auth_create( void *argv[], char *socket )
 	int retry = 2;
 	slurm_auth_credential_t *cred = NULL;
 	munge_err_t e = EMUNGE_SUCCESS;
-	munge_ctx_t ctx = munge_ctx_create();
+	munge_ctx_t ctx;
 	SigFunc *ohandler;
 
-	if (ctx == NULL) {
+	if ((ctx = munge_ctx_create()) == NULL) {
 		error("munge_ctx_create failure");
 		return NULL;
 	}
@@ -242,6 +321,28 @@ slurm_auth_create( void *argv[], char *socket )
 	return cred;
 }
 
+/*
+ * Allocate a credential for a message to a process of user r_uid. With
+ * AuthSessionTimeout set it is signed with this process' session key
+ * for that user, binding it to the message parts in data.
+ */
+slurm_auth_credential_t *
+slurm_auth_create_signed( void *argv[], char *socket, uid_t r_uid,
+			  gid_t r_gid, struct iovec *data, int iovcnt )
+{
+	slurm_auth_credential_t *cred;
+	uint16_t lifetime;
+
+	/* Messages to a different munged (the SlurmDBD's) are not signed
+	 * with session keys */
+	if ((socket == NULL) && (iovcnt <= SESSION_MAX_IOV) &&
+	    (lifetime = slurm_get_auth_session_timeout()) &&
+	    (cred = _session_create(lifetime, r_uid, r_gid, data, iovcnt)))
+		return cred;
+
+	return slurm_auth_create(argv, socket);
+}
+
 /*
  * Free a credential that was allocated with slurm_auth_alloc().
  */
@@ -292,6 +393,32 @@ slurm_auth_verify( slurm_auth_credential_t *c, char *socket )
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Verify a credential which may be signed with a session key, data
+ * being the message parts which the sender signed.
+ *
+ * Return SLURM_SUCCESS if the credential is in order and valid.
+ */
+int
+slurm_auth_verify_signed( slurm_auth_credential_t *c, char *socket,
+			  struct iovec *data, int iovcnt )
+{
+	if (!c) {
+		plugin_errno = SLURM_AUTH_BADARG;
+		return SLURM_ERROR;
+	}
+
+	xassert(c->magic == MUNGE_MAGIC);
+
+	if (c->verified)
+		return SLURM_SUCCESS;
+
+	if (c->session)
+		return _session_verify(c, data, iovcnt);
+
+	return slurm_auth_verify(c, socket);
+}
+
 /*
  * Obtain the Linux UID from the credential.  The accuracy of this data
  * is not assured until slurm_auth_verify() has been called for it.
@@ -357,11 +484,19 @@ slurm_auth_pack( slurm_auth_credential_t *cred, Buf buf )
 	 * type so that it can be sanity-checked at the receiving end.
 	 */
 	packstr( (char *) plugin_type, buf );
-	pack32( plugin_version, buf );
+	if (cred->session)
+		pack32(MUNGE_SESSION_VERSION, buf);
+	else
+		pack32( plugin_version, buf );
 	/*
 	 * Pack the data.
 	 */
 	packstr(cred->m_str, buf);
+	if (cred->session) {
+		pack64(cred->key_id, buf);
+		pack64(cred->seq, buf);
+		packmem((char *) cred->mac, SESSION_MAC_LEN, buf);
+	}
 
 	return SLURM_SUCCESS;
 }
@@ -410,10 +545,22 @@ slurm_auth_unpack( Buf buf )
 	xassert(cred->magic = MUNGE_MAGIC);
 
 	safe_unpackstr_malloc(&cred->m_str, &size, buf);
+	if (version >= MUNGE_SESSION_VERSION) {
+		char *mac;
+		cred->session = true;
+		safe_unpack64(&cred->key_id, buf);
+		safe_unpack64(&cred->seq, buf);
+		safe_unpackmem_ptr(&mac, &size, buf);
+		if (size != SESSION_MAC_LEN)
+			goto unpack_error;
+		memcpy(cred->mac, mac, SESSION_MAC_LEN);
+	}
 	return cred;
 
  unpack_error:
 	plugin_errno = SLURM_AUTH_UNPACK;
+	if (cred && cred->m_str)
+		free(cred->m_str);
 	xfree( cred );
 	return NULL;
 }
@@ -437,6 +584,10 @@ slurm_auth_print( slurm_auth_credential_t *cred, FILE *fp )
 
 	fprintf(fp, "BEGIN SLURM MUNGE AUTHENTICATION CREDENTIAL\n" );
 	fprintf(fp, "%s\n", cred->m_str );
+	if (cred->session) {
+		fprintf(fp, "SESSION KEY %"PRIx64" SEQUENCE %"PRIu64"\n",
+			cred->key_id, cred->seq);
+	}
 	fprintf(fp, "END SLURM MUNGE AUTHENTICATION CREDENTIAL\n" );
 	return SLURM_SUCCESS;
 }
@@ -495,6 +646,13 @@ _decode_cred(slurm_auth_credential_t *c, char *socket)
 	if (c->verified)
 		return SLURM_SUCCESS;
 
+	if (c->session) {
+		/* only slurm_auth_verify_signed() has the message */
+		error("Munge session credential without its message");
+		c->cr_errno = SLURM_AUTH_INVALID;
+		return SLURM_ERROR;
+	}
+
 	if ((ctx = munge_ctx_create()) == NULL) {
 		error("munge_ctx_create failure");
 		return SLURM_ERROR;
@@ -556,6 +714,479 @@ _decode_cred(slurm_auth_credential_t *c, char *socket)
 
 
 
+/*
+ * Session credential functions
+ */
+
+static void _put32(unsigned char *p, uint32_t val)
+{
+	int i;
+
+	for (i = 3; i >= 0; i--, val >>= 8)
+		p[i] = val & 0xff;
+}
+
+static void _put64(unsigned char *p, uint64_t val)
+{
+	int i;
+
+	for (i = 7; i >= 0; i--, val >>= 8)
+		p[i] = val & 0xff;
+}
+
+static uint32_t _get32(const unsigned char *p)
+{
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+	       ((uint32_t) p[2] << 8)  |  (uint32_t) p[3];
+}
+
+static uint64_t _get64(const unsigned char *p)
+{
+	return ((uint64_t) _get32(p) << 32) | _get32(p + 4);
+}
+
+static int _random_bytes(unsigned char *buf, int len)
+{
+	int fd, n;
+
+	if ((fd = open("/dev/urandom", O_RDONLY)) < 0)
+		return SLURM_ERROR;
+	while (len > 0) {
+		n = read(fd, buf, len);
+		if ((n < 0) && (errno == EINTR))
+			continue;
+		if (n <= 0)
+			break;
+		buf += n;
+		len -= n;
+	}
+	close(fd);
+	return len ? SLURM_ERROR : SLURM_SUCCESS;
+}
+
+/*
+ * Sign the key id and sequence number of a session credential and the
+ * message it is sent with, at most SESSION_MAX_IOV parts
+ */
+static void _session_mac(const hmac_sha256_key_t *key, uint64_t key_id,
+			 uint64_t seq, struct iovec *data, int iovcnt,
+			 unsigned char mac[SESSION_MAC_LEN])
+{
+	unsigned char ids[16], digest[SHA256_DIGEST_LEN];
+	struct iovec iov[SESSION_MAX_IOV + 1];
+	int i;
+
+	_put64(ids, key_id);
+	_put64(ids + 8, seq);
+	iov[0].iov_base = ids;
+	iov[0].iov_len  = sizeof(ids);
+	for (i = 0; i < iovcnt; i++)
+		iov[i + 1] = data[i];
+	hmac_sha256_iov(key, iov, iovcnt + 1, digest);
+	memcpy(mac, digest, SESSION_MAC_LEN);
+}
+
+/* Hash of a munge credential, identifying the session key it carries */
+static void _cred_hash(const char *m_str,
+		       unsigned char hash[SHA256_DIGEST_LEN])
+{
+	sha256_ctx_t ctx;
+
+	sha256_init(&ctx);
+	sha256_update(&ctx, m_str, strlen(m_str));
+	sha256_final(&ctx, hash);
+}
+
+static void _send_session_free(send_session_t *s)
+{
+	if (s == NULL)
+		return;
+	if (s->m_str)
+		free(s->m_str);
+	memset(s, 0, sizeof(send_session_t));
+	xfree(s);
+}
+
+/*
+ * Create a session key for messages to user r_uid and the munge
+ * credential carrying it, which only processes of r_uid (and r_gid,
+ * unless SLURM_AUTH_ANY_GID) can decode for "lifetime" seconds
+ */
+static send_session_t *_send_session_create(uint16_t lifetime, uid_t r_uid,
+					    gid_t r_gid)
+{
+	unsigned char payload[SESSION_PAYLOAD_LEN];
+	send_session_t *s;
+	munge_ctx_t ctx;
+	munge_err_t e;
+	SigFunc *ohandler;
+	int retry = 2;
+
+	if (_random_bytes(payload + 4, 8 + 4 + SESSION_KEY_LEN) < 0) {
+		error("auth_munge: unable to read /dev/urandom: %m");
+		return NULL;
+	}
+	_put32(payload, SESSION_MAGIC);
+	_put32(payload + 12, lifetime);
+
+	if ((ctx = munge_ctx_create()) == NULL) {
+		error("munge_ctx_create failure");
+		return NULL;
+	}
+	if ((munge_ctx_set(ctx, MUNGE_OPT_TTL, (int) lifetime) !=
+	     EMUNGE_SUCCESS) ||
+	    (munge_ctx_set(ctx, MUNGE_OPT_UID_RESTRICTION, r_uid) !=
+	     EMUNGE_SUCCESS) ||
+	    ((r_gid != SLURM_AUTH_ANY_GID) &&
+	     (munge_ctx_set(ctx, MUNGE_OPT_GID_RESTRICTION, r_gid) !=
+	      EMUNGE_SUCCESS))) {
+		error("munge_ctx_set failure");
+		munge_ctx_destroy(ctx);
+		return NULL;
+	}
+
+	s = xmalloc(sizeof(send_session_t));
+	s->key_id = _get64(payload + 4);
+	hmac_sha256_key(&s->key, payload + 16, SESSION_KEY_LEN);
+	s->renew  = time(NULL) + (lifetime / 2);
+	s->pid    = getpid();
+	s->uid    = geteuid();
+	s->gid    = getegid();
+	s->r_uid  = r_uid;
+	s->r_gid  = r_gid;
+
+	ohandler = xsignal(SIGALRM, SIG_BLOCK);
+    again:
+	if ((e = munge_encode(&s->m_str, ctx, payload, sizeof(payload)))) {
+		if (e == EMUNGE_SOCKET && retry--)
+			goto again;
+		error("Munge encode of session key failed: %s",
+		      munge_ctx_strerror(ctx));
+		plugin_errno = e + MUNGE_ERRNO_OFFSET;
+		_send_session_free(s);
+		s = NULL;
+	}
+	xsignal(SIGALRM, ohandler);
+
+	memset(payload, 0, sizeof(payload));
+	munge_ctx_destroy(ctx);
+	return s;
+}
+
+/* RET true if session key s must be replaced before it is used again */
+static bool _send_session_stale(send_session_t *s, time_t now)
+{
+	return ((now >= s->renew) || (s->pid != getpid()) ||
+		(s->uid != geteuid()) || (s->gid != getegid()));
+}
+
+/*
+ * Create a credential for a message to user r_uid signed with this
+ * process' session key for that user, renewing the key when it is half
+ * way through its lifetime or when the process has forked or changed
+ * its identity since it was created. Other stale keys found on the way
+ * are dropped.
+ * RET NULL if no session key could be created
+ */
+static slurm_auth_credential_t *_session_create(uint16_t lifetime,
+						uid_t r_uid, gid_t r_gid,
+						struct iovec *data,
+						int iovcnt)
+{
+	slurm_auth_credential_t *cred;
+	send_session_t **sp, *s, *found = NULL;
+	time_t now = time(NULL);
+
+	slurm_mutex_lock(&send_lock);
+	sp = &send_hash[r_uid % SESSION_SEND_HASH_SIZE];
+	while ((s = *sp)) {
+		if ((s->r_uid == r_uid) && (s->r_gid == r_gid) &&
+		    !_send_session_stale(s, now)) {
+			found = s;
+			sp = &s->next;
+		} else if (_send_session_stale(s, now)) {
+			*sp = s->next;
+			_send_session_free(s);
+		} else
+			sp = &s->next;
+	}
+	if ((s = found) == NULL) {
+		if ((s = _send_session_create(lifetime, r_uid, r_gid)) ==
+		    NULL) {
+			slurm_mutex_unlock(&send_lock);
+			return NULL;
+		}
+		s->next = send_hash[r_uid % SESSION_SEND_HASH_SIZE];
+		send_hash[r_uid % SESSION_SEND_HASH_SIZE] = s;
+	}
+
+	cred = xmalloc(sizeof(*cred));
+	cred->verified = false;
+	cred->cr_errno = SLURM_SUCCESS;
+	xassert(cred->magic = MUNGE_MAGIC);
+	cred->session = true;
+	cred->key_id  = s->key_id;
+	cred->seq     = ++s->seq;
+	cred->m_str   = strdup(s->m_str);
+	_session_mac(&s->key, cred->key_id, cred->seq, data, iovcnt,
+		     cred->mac);
+	slurm_mutex_unlock(&send_lock);
+
+	if (cred->m_str == NULL) {
+		xfree(cred);
+		return NULL;
+	}
+	return cred;
+}
+
+static uint32_t _recv_session_idx(const unsigned char *cred_hash)
+{
+	return _get32(cred_hash) % SESSION_HASH_SIZE;
+}
+
+static recv_session_t *_recv_session_find(const unsigned char *cred_hash)
+{
+	recv_session_t *r;
+
+	for (r = recv_hash[_recv_session_idx(cred_hash)]; r; r = r->next) {
+		if (!memcmp(r->cred_hash, cred_hash, SHA256_DIGEST_LEN))
+			return r;
+	}
+	return NULL;
+}
+
+/* Remove expired keys, at most once a second unless the cache is full */
+static void _recv_session_purge(time_t now)
+{
+	recv_session_t **rp, *r;
+	int i;
+
+	if ((now == recv_purge_time) && (recv_cnt < SESSION_CACHE_SIZE))
+		return;
+	recv_purge_time = now;
+
+	for (i = 0; i < SESSION_HASH_SIZE; i++) {
+		rp = &recv_hash[i];
+		while ((r = *rp)) {
+			if (r->expire > now) {
+				rp = &r->next;
+				continue;
+			}
+			*rp = r->next;
+			xfree(r);
+			recv_cnt--;
+		}
+	}
+}
+
+/*
+ * Cache a newly learned key. With the cache full of live keys, the one
+ * in the same hash chain closest to expiring is replaced. Its sender
+ * would have it learned again without the record of sequence numbers
+ * already seen, this only happens with more live senders than
+ * SESSION_CACHE_SIZE.
+ */
+static recv_session_t *_recv_session_add(recv_session_t *new, time_t now)
+{
+	recv_session_t **rp, **oldest = NULL, *r;
+
+	_recv_session_purge(now);
+	if (recv_cnt >= SESSION_CACHE_SIZE) {
+		for (rp = &recv_hash[_recv_session_idx(new->cred_hash)];
+		     (r = *rp); rp = &r->next) {
+			if (!oldest || (r->expire < (*oldest)->expire))
+				oldest = rp;
+		}
+		if (oldest) {
+			r = *oldest;
+			*oldest = r->next;
+			xfree(r);
+			recv_cnt--;
+		}
+	}
+	if (recv_cnt >= SESSION_CACHE_SIZE)
+		return NULL;
+
+	r = xmalloc(sizeof(recv_session_t));
+	memcpy(r, new, sizeof(recv_session_t));
+	r->next = recv_hash[_recv_session_idx(r->cred_hash)];
+	recv_hash[_recv_session_idx(r->cred_hash)] = r;
+	recv_cnt++;
+	return r;
+}
+
+/*
+ * Record the sequence number of a message signed with key r.
+ * RET SLURM_ERROR if it was already seen or is too old to tell
+ */
+static int _recv_session_seq(recv_session_t *r, uint64_t seq)
+{
+	uint64_t i;
+
+	if (seq > r->seq_max) {
+		if ((seq - r->seq_max) >= SESSION_WINDOW) {
+			memset(r->seq_seen, 0, sizeof(r->seq_seen));
+		} else {
+			for (i = r->seq_max + 1; i < seq; i++) {
+				r->seq_seen[(i % SESSION_WINDOW) / 64] &=
+					~((uint64_t) 1 << (i % 64));
+			}
+		}
+		r->seq_max = seq;
+	} else if ((r->seq_max - seq) >= SESSION_WINDOW) {
+		return SLURM_ERROR;
+	} else if (r->seq_seen[(seq % SESSION_WINDOW) / 64] &
+		   ((uint64_t) 1 << (seq % 64))) {
+		return SLURM_ERROR;
+	}
+	r->seq_seen[(seq % SESSION_WINDOW) / 64] |= (uint64_t) 1 << (seq % 64);
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Decode the munge credential carrying the session key of c into r.
+ * The same credential comes with every message signed with the key, so
+ * other processes on this node may have decoded it before. A replayed
+ * credential is accepted here since the message itself is checked
+ * against the sequence numbers seen under the key.
+ */
+static int _recv_session_decode(slurm_auth_credential_t *c,
+				recv_session_t *r, time_t now)
+{
+	munge_ctx_t ctx;
+	munge_err_t e;
+	unsigned char *payload = NULL;
+	int len = 0, ttl = 0, retry = 2, rc = SLURM_ERROR;
+	time_t encoded = 0;
+	uint32_t lifetime;
+
+	if ((ctx = munge_ctx_create()) == NULL) {
+		error("munge_ctx_create failure");
+		return SLURM_ERROR;
+	}
+
+    again:
+	e = munge_decode(c->m_str, ctx, (void **) &payload, &len, &r->uid,
+			 &r->gid);
+	if ((e == EMUNGE_SOCKET) && retry--) {
+		error ("Munge decode failed: %s (retrying ...)",
+		       munge_ctx_strerror(ctx));
+		goto again;
+	}
+	if ((e != EMUNGE_SUCCESS) && (e != EMUNGE_CRED_REPLAYED)) {
+		error("Munge decode of session key failed: %s",
+		      munge_ctx_strerror(ctx));
+		_print_cred(ctx);
+		if (e == EMUNGE_CRED_REWOUND)
+			error("Check for out of sync clocks");
+		c->cr_errno = e + MUNGE_ERRNO_OFFSET;
+		goto done;
+	}
+	if ((len != SESSION_PAYLOAD_LEN) ||
+	    (_get32(payload) != SESSION_MAGIC) ||
+	    (_get64(payload + 4) != c->key_id)) {
+		error("Munge credential does not carry session key %"PRIx64,
+		      c->key_id);
+		c->cr_errno = SLURM_AUTH_INVALID;
+		goto done;
+	}
+	(void) munge_ctx_get(ctx, MUNGE_OPT_ENCODE_TIME, &encoded);
+	(void) munge_ctx_get(ctx, MUNGE_OPT_TTL, &ttl);
+	lifetime = _get32(payload + 12);
+	r->key_id = c->key_id;
+	r->expire = encoded + MIN(lifetime, (uint32_t) ttl);
+	if (r->expire <= now) {
+		error("Munge session key %"PRIx64" expired", c->key_id);
+		c->cr_errno = SLURM_AUTH_INVALID;
+		goto done;
+	}
+	hmac_sha256_key(&r->key, payload + 16, SESSION_KEY_LEN);
+	rc = SLURM_SUCCESS;
+
+    done:
+	if (payload) {
+		memset(payload, 0, len);
+		free(payload);
+	}
+	munge_ctx_destroy(ctx);
+	return rc;
+}
+
+/*
+ * Verify a credential signed with a session key and the message parts
+ * in data it came with, decoding the munge credential only for a key
+ * not seen before
+ */
+static int _session_verify(slurm_auth_credential_t *c, struct iovec *data,
+			   int iovcnt)
+{
+	recv_session_t *r, new;
+	unsigned char mac[SESSION_MAC_LEN];
+	time_t now = time(NULL);
+	int rc = SLURM_ERROR;
+
+	if ((data == NULL) || (iovcnt > SESSION_MAX_IOV) ||
+	    (c->m_str == NULL)) {
+		c->cr_errno = SLURM_AUTH_INVALID;
+		return SLURM_ERROR;
+	}
+
+	memset(&new, 0, sizeof(recv_session_t));
+	_cred_hash(c->m_str, new.cred_hash);
+	slurm_mutex_lock(&recv_lock);
+	if ((r = _recv_session_find(new.cred_hash)) == NULL) {
+		slurm_mutex_unlock(&recv_lock);
+		if (_recv_session_decode(c, &new, now) < 0) {
+			memset(&new, 0, sizeof(recv_session_t));
+			return SLURM_ERROR;
+		}
+		slurm_mutex_lock(&recv_lock);
+		/* another thread may have learned the key meanwhile */
+		if (((r = _recv_session_find(new.cred_hash)) == NULL) &&
+		    ((r = _recv_session_add(&new, now)) == NULL)) {
+			error("Munge session key cache full");
+			c->cr_errno = SLURM_AUTH_INVALID;
+			goto done;
+		}
+	}
+
+	if (r->expire <= now) {
+		error("Munge session key %"PRIx64" expired", c->key_id);
+		c->cr_errno = SLURM_AUTH_INVALID;
+		goto done;
+	}
+	if (r->key_id != c->key_id) {
+		error("Munge credential does not carry session key %"PRIx64,
+		      c->key_id);
+		c->cr_errno = SLURM_AUTH_INVALID;
+		goto done;
+	}
+	_session_mac(&r->key, c->key_id, c->seq, data, iovcnt, mac);
+	if (hmac_compare(mac, c->mac, SESSION_MAC_LEN)) {
+		error("Munge session credential signature invalid, uid %u",
+		      (unsigned int) r->uid);
+		c->cr_errno = SLURM_AUTH_INVALID;
+		goto done;
+	}
+	if (_recv_session_seq(r, c->seq) < 0) {
+		error("Munge session credential replayed, uid %u",
+		      (unsigned int) r->uid);
+		c->cr_errno = SLURM_AUTH_INVALID;
+		goto done;
+	}
+
+	c->uid = r->uid;
+	c->gid = r->gid;
+	c->verified = true;
+	rc = SLURM_SUCCESS;
+
+    done:
+	slurm_mutex_unlock(&recv_lock);
+	memset(&new, 0, sizeof(recv_session_t));
+	return rc;
+}
+
+
 /*
  *  Allocate space for Munge credential info structure
  */
@@ -63,6 +63,7 @@
 #endif /* HAVE_CONFIG_H */
 
 #include <stdio.h>
+#include <sys/uio.h>
 
 #include "slurm/slurm_errno.h"
 #include "src/common/slurm_xlator.h"
@@ -210,6 +211,24 @@ slurm_auth_verify( slurm_auth_credential_t *cred, char *auth_info )
 	return SLURM_SUCCESS;
 }
 
+/*
+ * This plugin does not sign messages, a signed credential is the same
+ * as any other.
+ */
+slurm_auth_credential_t *
+slurm_auth_create_signed( void *argv[], char *auth_info, uid_t r_uid,
+			  gid_t r_gid, struct iovec *data, int iovcnt )
+{
+	return slurm_auth_create( argv, auth_info );
+}
+
+int
+slurm_auth_verify_signed( slurm_auth_credential_t *cred, char *auth_info,
+			  struct iovec *data, int iovcnt )
+{
+	return slurm_auth_verify( cred, auth_info );
+}
+
 /*
  * Obtain the Linux UID from the credential.  The accuracy of this data
  * is not assured until slurm_auth_verify() has been called for it.
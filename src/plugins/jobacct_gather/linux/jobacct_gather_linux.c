@@ -110,8 +110,27 @@ typedef struct prec {	/* process record */
 	int     pages;  /* pages */
 	int	rss;	/* rss */
 	int	vsize;	/* virtual size */
+	struct prec *child;	/* first child, see _build_prec_tree() */
+	struct prec *sibling;	/* next child of the same parent */
+	struct prec *hash_next;	/* next prec in the same pid hash bucket */
 } prec_t;
 
+/* Descriptors for /proc/<pid>/stat are kept open across polls and read with
+ * pread(), so a steady set of processes costs one system call per process
+ * per poll rather than an open/read/close plus a scan of /proc/<pid>/status
+ * to detect threads. A descriptor is dropped once its process exits (the
+ * read then fails) or the pid is no longer reported by a poll. */
+#define STAT_FD_HASH_SIZE	1024	/* must be a power of 2 */
+#define MAX_STAT_FDS		1024	/* descriptors kept open at once */
+
+typedef struct stat_fd {
+	pid_t	pid;
+	int	fd;
+	bool	lwp;		/* pid is a thread, not a process */
+	uint32_t poll_gen;	/* last poll reporting this pid */
+	struct stat_fd *next;	/* hash chain */
+} stat_fd_t;
+
 static int freq = 0;
 static DIR  *slash_proc = NULL;
 static pthread_mutex_t reading_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -121,60 +140,217 @@ static List task_list = NULL;
 static uint64_t cont_id = (uint64_t)NO_VAL;
 static bool pgid_plugin = false;
 
+static stat_fd_t *stat_fd_hash[STAT_FD_HASH_SIZE];
+static int stat_fd_cnt = 0;
+static uint32_t poll_gen = 0;
+
+static prec_t **prec_hash = NULL;	/* reused from poll to poll */
+static int prec_hash_size = 0;
+static prec_t **prec_stack = NULL;	/* sized like prec_hash */
+static int prec_cnt = 0;
+
 /* Finally, pre-define all local routines. */
 
 static void _acct_kill_step(void);
+static void _build_prec_tree(List prec_list);
 static void _destroy_prec(void *object);
+static prec_t *_find_prec(pid_t pid);
 static int  _is_a_lwp(uint32_t pid);
-static void _get_offspring_data(List prec_list, prec_t *ancestor, pid_t pid);
+static void _get_offspring_data(prec_t *ancestor, prec_t *total);
 static void _get_process_data(void);
 static int  _get_process_data_line(int in, prec_t *prec);
+static int  _read_proc_stat(pid_t pid, prec_t *prec);
+static void _stat_fd_purge(bool all);
 static void *_watch_tasks(void *arg);
 
 /*
- * _get_offspring_data() -- collect memory usage data for the offspring
- *
- * For each process that lists <pid> as its parent, add its memory
- * usage data to the ancestor's <prec> record. Recurse to gather data
- * for *all* subsequent generations.
- *
- * IN:	prec_list       list of prec's
- *      ancestor	The entry in precTable[] to which the data
- * 			should be added. Even as we recurse, this will
- * 			always be the prec for the base of the family
- * 			tree.
- * 	pid		The process for which we are currently looking
- * 			for offspring.
- *
- * OUT:	none.
- *
- * RETVAL:	none.
- *
- * THREADSAFE! Only one thread ever gets here.
+ * _build_prec_tree() -- index prec_list by pid and link each process
+ *	to its parent in one pass over the list
  */
-static void
-_get_offspring_data(List prec_list, prec_t *ancestor, pid_t pid) {
-
+static void _build_prec_tree(List prec_list)
+{
 	ListIterator itr;
-	prec_t *prec = NULL;
+	prec_t *prec, *parent;
+	int cnt = list_count(prec_list), inx;
+
+	if (prec_hash_size < cnt) {
+		if (!prec_hash_size)
+			prec_hash_size = 64;
+		while (prec_hash_size < cnt)
+			prec_hash_size *= 2;
+		xfree(prec_hash);
+		prec_hash = xmalloc(sizeof(prec_t *) * prec_hash_size);
+		prec_stack = xrealloc(prec_stack,
+				      sizeof(prec_t *) * prec_hash_size);
+	} else
+		memset(prec_hash, 0, sizeof(prec_t *) * prec_hash_size);
+	prec_cnt = cnt;
 
 	itr = list_iterator_create(prec_list);
-	while((prec = list_next(itr))) {
-		if (prec->ppid == pid) {
+	while ((prec = list_next(itr))) {
+		inx = prec->pid & (prec_hash_size - 1);
+		prec->hash_next = prec_hash[inx];
+		prec_hash[inx] = prec;
+	}
+	list_iterator_reset(itr);
+	while ((prec = list_next(itr))) {
+		parent = _find_prec(prec->ppid);
+		if (!parent || (parent == prec))
+			continue;
+		prec->sibling = parent->child;
+		parent->child = prec;
+	}
+	list_iterator_destroy(itr);
+}
+
+static prec_t *_find_prec(pid_t pid)
+{
+	prec_t *prec;
+
+	for (prec = prec_hash[pid & (prec_hash_size - 1)]; prec;
+	     prec = prec->hash_next) {
+		if (prec->pid == pid)
+			return prec;
+	}
+	return NULL;
+}
+
+/*
+ * _get_offspring_data() -- collect usage data for a process and all of
+ *	its descendants
+ *
+ * IN:	ancestor - process at the base of the family tree
+ * OUT:	total - sum of ancestor's usage and that of all its offspring
+ *
+ * THREADSAFE! Only one thread ever gets here.
+ */
+static void _get_offspring_data(prec_t *ancestor, prec_t *total)
+{
+	prec_t *prec, *child;
+	int depth = 0, visited = 0;
+
+	memset(total, 0, sizeof(prec_t));
+	prec_stack[depth++] = ancestor;
+	/* ppid values are read at slightly different times, so guard
+	 * against a loop left by pid reuse */
+	while (depth && (visited++ < prec_cnt)) {
+		prec = prec_stack[--depth];
 #if _DEBUG
-			info("pid:%u ppid:%u rss:%d KB",
-			     prec->pid, prec->ppid, prec->rss);
+		info("pid:%u ppid:%u rss:%d KB",
+		     prec->pid, prec->ppid, prec->rss);
 #endif
-			_get_offspring_data(prec_list, ancestor, prec->pid);
-			ancestor->usec += prec->usec;
-			ancestor->ssec += prec->ssec;
-			ancestor->pages += prec->pages;
-			ancestor->rss += prec->rss;
-			ancestor->vsize += prec->vsize;
+		total->usec  += prec->usec;
+		total->ssec  += prec->ssec;
+		total->pages += prec->pages;
+		total->rss   += prec->rss;
+		total->vsize += prec->vsize;
+		for (child = prec->child; child && (depth < prec_cnt);
+		     child = child->sibling)
+			prec_stack[depth++] = child;
+	}
+}
+
+static stat_fd_t *_stat_fd_find(pid_t pid)
+{
+	stat_fd_t *ent;
+
+	for (ent = stat_fd_hash[pid & (STAT_FD_HASH_SIZE - 1)]; ent;
+	     ent = ent->next) {
+		if (ent->pid == pid)
+			return ent;
+	}
+	return NULL;
+}
+
+static void _stat_fd_add(pid_t pid, int fd, bool lwp)
+{
+	int inx = pid & (STAT_FD_HASH_SIZE - 1);
+	stat_fd_t *ent = xmalloc(sizeof(stat_fd_t));
+
+	ent->pid = pid;
+	ent->fd = fd;
+	ent->lwp = lwp;
+	ent->poll_gen = poll_gen;
+	ent->next = stat_fd_hash[inx];
+	stat_fd_hash[inx] = ent;
+	stat_fd_cnt++;
+}
+
+/* Close descriptors of pids not seen by the current poll, or all of them */
+static void _stat_fd_purge(bool all)
+{
+	stat_fd_t **prev, *ent;
+	int i;
+
+	for (i = 0; i < STAT_FD_HASH_SIZE; i++) {
+		prev = &stat_fd_hash[i];
+		while ((ent = *prev)) {
+			if (!all && (ent->poll_gen == poll_gen)) {
+				prev = &ent->next;
+				continue;
+			}
+			*prev = ent->next;
+			(void) close(ent->fd);
+			xfree(ent);
+			stat_fd_cnt--;
 		}
 	}
-	list_iterator_destroy(itr);
-	return;
+}
+
+/*
+ * _read_proc_stat() - get usage data for one pid, reusing an open
+ *	/proc/<pid>/stat descriptor when there is one
+ *
+ * RETVAL:	==0 - no valid data, the process is gone or is a thread
+ * 		!=0 - data are valid
+ */
+static int _read_proc_stat(pid_t pid, prec_t *prec)
+{
+	stat_fd_t *ent = _stat_fd_find(pid);
+	char proc_stat_file[32];
+	bool lwp;
+	int fd;
+
+	if (ent) {
+		ent->poll_gen = poll_gen;
+		/* A read fails once the process has exited, even if the
+		 * pid has since been reused */
+		if (_get_process_data_line(ent->fd, prec) &&
+		    (prec->pid == pid))
+			return !ent->lwp;
+		ent->poll_gen = poll_gen - 1;	/* purged after this poll */
+		return 0;
+	}
+
+	snprintf(proc_stat_file, sizeof(proc_stat_file), "/proc/%d/stat",
+		 (int) pid);
+	if ((fd = open(proc_stat_file, O_RDONLY)) < 0)
+		return 0;	/* Assume the process went away */
+	/*
+	 * Close the file on exec() of user tasks.
+	 *
+	 * NOTE: If we fork() slurmstepd after the
+	 * open() above and before the fcntl() below,
+	 * then the user task may have this extra file
+	 * open, which can cause problems for
+	 * checkpoint/restart, but this should be a very rare
+	 * problem in practice.
+	 */
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	if (!_get_process_data_line(fd, prec)) {
+		(void) close(fd);
+		return 0;
+	}
+
+	/* If current pid corresponds to a Light Weight Process (Thread
+	 * POSIX) skip it, we will only account the original process
+	 * (pid==tgid) */
+	lwp = (_is_a_lwp(pid) > 0);
+	if (stat_fd_cnt < MAX_STAT_FDS)
+		_stat_fd_add(pid, fd, lwp);
+	else
+		(void) close(fd);
+	return !lwp;
 }
 
 /*
@@ -193,20 +369,15 @@ _get_offspring_data(List prec_list, prec_t *ancestor, pid_t pid) {
  */
 static void _get_process_data(void)
 {
-	static	int	slash_proc_open = 0;
-
 	struct	dirent *slash_proc_entry;
-	char		*iptr = NULL, *optr = NULL;
-	FILE		*stat_fp = NULL;
-	char		proc_stat_file[256];	/* Allow ~20x extra length */
+	char		*iptr = NULL;
 	List prec_list = NULL;
-	pid_t *pids = NULL;
+	pid_t *pids = NULL, pid;
 	int npids = 0;
 	uint32_t total_job_mem = 0, total_job_vsize = 0;
-	int		i, fd;
+	int		i;
 	ListIterator itr;
-	ListIterator itr2;
-	prec_t *prec = NULL;
+	prec_t *prec = NULL, total;
 	struct jobacctinfo *jobacct = NULL;
 	static int processing = 0;
 	long		hertz;
@@ -229,42 +400,26 @@ static void _get_process_data(void)
 		hertz = 100;	/* default on many systems */
 	}
 
+	slurm_mutex_lock(&reading_mutex);
+	poll_gen++;
 	if(!pgid_plugin) {
 		/* get only the processes in the proctrack container */
 		slurm_container_get_pids(cont_id, &pids, &npids);
 		if(!npids) {
 			debug4("no pids in this container %"PRIu64"", cont_id);
+			_stat_fd_purge(false);
+			slurm_mutex_unlock(&reading_mutex);
 			goto finished;
 		}
 		for (i = 0; i < npids; i++) {
-			snprintf(proc_stat_file, 256,
-				 "/proc/%d/stat", pids[i]);
-			if ((stat_fp = fopen(proc_stat_file, "r"))==NULL)
-				continue;  /* Assume the process went away */
-			/*
-			 * Close the file on exec() of user tasks.
-			 *
-			 * NOTE: If we fork() slurmstepd after the
-			 * fopen() above and before the fcntl() below,
-			 * then the user task may have this extra file
-			 * open, which can cause problems for
-			 * checkpoint/restart, but this should be a very rare
-			 * problem in practice.
-			 */
-			fd = fileno(stat_fp);
-			fcntl(fd, F_SETFD, FD_CLOEXEC);
-
 			prec = xmalloc(sizeof(prec_t));
-			if (_get_process_data_line(fd, prec))
+			if (_read_proc_stat(pids[i], prec))
 				list_append(prec_list, prec);
 			else
 				xfree(prec);
-			fclose(stat_fp);
 		}
 	} else {
-		slurm_mutex_lock(&reading_mutex);
-
-		if (slash_proc_open) {
+		if (slash_proc) {
 			rewinddir(slash_proc);
 		} else {
 			slash_proc=opendir("/proc");
@@ -273,63 +428,32 @@ static void _get_process_data(void)
 				slurm_mutex_unlock(&reading_mutex);
 				goto finished;
 			}
-			slash_proc_open=1;
 		}
-		strcpy(proc_stat_file, "/proc/");
 
 		while ((slash_proc_entry = readdir(slash_proc))) {
-
-			/* Save a few cyles by simulating
-			   strcat(statFileName, slash_proc_entry->d_name);
-			   strcat(statFileName, "/stat");
-			   while checking for a numeric filename (which really
-			   should be a pid).
-			*/
-			optr = proc_stat_file + sizeof("/proc");
+			/* Only numeric file names (which really should be
+			 * pids) are of interest */
 			iptr = slash_proc_entry->d_name;
-			i = 0;
+			pid = 0;
 			do {
-				if((*iptr < '0')
-				   || ((*optr++ = *iptr++) > '9')) {
-					i = -1;
+				if ((*iptr < '0') || (*iptr > '9')) {
+					pid = -1;
 					break;
 				}
+				pid = (pid * 10) + (*iptr++ - '0');
 			} while (*iptr);
-
-			if(i == -1)
+			if (pid <= 0)
 				continue;
-			iptr = (char*)"/stat";
-
-			do {
-				*optr++ = *iptr++;
-			} while (*iptr);
-			*optr = 0;
-
-			if ((stat_fp = fopen(proc_stat_file,"r"))==NULL)
-				continue;  /* Assume the process went away */
-			/*
-			 * Close the file on exec() of user tasks.
-			 *
-			 * NOTE: If we fork() slurmstepd after the
-			 * fopen() above and before the fcntl() below,
-			 * then the user task may have this extra file
-			 * open, which can cause problems for
-			 * checkpoint/restart, but this should be a very rare
-			 * problem in practice.
-			 */
-			fd = fileno(stat_fp);
-			fcntl(fd, F_SETFD, FD_CLOEXEC);
 
 			prec = xmalloc(sizeof(prec_t));
-			if (_get_process_data_line(fd, prec))
+			if (_read_proc_stat(pid, prec))
 				list_append(prec_list, prec);
 			else
 				xfree(prec);
-			fclose(stat_fp);
 		}
-		slurm_mutex_unlock(&reading_mutex);
-
 	}
+	_stat_fd_purge(false);
+	slurm_mutex_unlock(&reading_mutex);
 
 	if (!list_count(prec_list)) {
 		goto finished;	/* We have no business being here! */
@@ -341,39 +465,28 @@ static void _get_process_data(void)
 		goto finished;
 	}
 
+	_build_prec_tree(prec_list);
 	itr = list_iterator_create(task_list);
 	while((jobacct = list_next(itr))) {
-		itr2 = list_iterator_create(prec_list);
-		while((prec = list_next(itr2))) {
-			if (prec->pid == jobacct->pid) {
-#if _DEBUG
-				info("pid:%u ppid:%u rss:%d KB",
-				     prec->pid, prec->ppid, prec->rss);
-#endif
-				/* find all my descendents */
-				_get_offspring_data(prec_list,
-						    prec, prec->pid);
-				/* tally their usage */
-				jobacct->max_rss = jobacct->tot_rss =
-					MAX(jobacct->max_rss, prec->rss);
-				total_job_mem += prec->rss;
-				jobacct->max_vsize = jobacct->tot_vsize =
-					MAX(jobacct->max_vsize, prec->vsize);
-				total_job_vsize += prec->vsize;
-				jobacct->max_pages = jobacct->tot_pages =
-					MAX(jobacct->max_pages, prec->pages);
-				jobacct->min_cpu = jobacct->tot_cpu =
-					MAX(jobacct->min_cpu,
-					    (prec->ssec / hertz +
-					     prec->usec / hertz));
-				debug2("%d mem size %u %u time %u(%u+%u)",
-				       jobacct->pid, jobacct->max_rss,
-				       jobacct->max_vsize, jobacct->tot_cpu,
-				       prec->usec, prec->ssec);
-				break;
-			}
-		}
-		list_iterator_destroy(itr2);
+		if (!(prec = _find_prec(jobacct->pid)))
+			continue;
+		/* find all my descendents and tally their usage */
+		_get_offspring_data(prec, &total);
+		jobacct->max_rss = jobacct->tot_rss =
+			MAX(jobacct->max_rss, total.rss);
+		total_job_mem += total.rss;
+		jobacct->max_vsize = jobacct->tot_vsize =
+			MAX(jobacct->max_vsize, total.vsize);
+		total_job_vsize += total.vsize;
+		jobacct->max_pages = jobacct->tot_pages =
+			MAX(jobacct->max_pages, total.pages);
+		jobacct->min_cpu = jobacct->tot_cpu =
+			MAX(jobacct->min_cpu,
+			    (total.ssec / hertz + total.usec / hertz));
+		debug2("%d mem size %u %u time %u(%u+%u)",
+		       jobacct->pid, jobacct->max_rss,
+		       jobacct->max_vsize, jobacct->tot_cpu,
+		       total.usec, total.ssec);
 	}
 	list_iterator_destroy(itr);
 	slurm_mutex_unlock(&jobacct_lock);
@@ -415,6 +528,7 @@ static void _get_process_data(void)
 
 finished:
 	list_destroy(prec_list);
+	xfree(pids);
 	processing = 0;
 	return;
 }
@@ -493,7 +607,7 @@ static int _is_a_lwp(uint32_t pid) {
 
 /* _get_process_data_line() - get line of data from /proc/<pid>/stat
  *
- * IN:	in - input file descriptor
+ * IN:	in - input file descriptor, read from offset zero
  * OUT:	prec - the destination for the data
  *
  * RETVAL:	==0 - no valid data
@@ -513,12 +627,14 @@ static int _get_process_data_line(int in, prec_t *prec) {
 	long unsigned utime, stime, starttime, vsize;
 	long int cutime, cstime, priority, nice, timeout, itrealvalue, rss;
 
-	num_read = read(in, sbuf, (sizeof(sbuf) - 1));
+	num_read = pread(in, sbuf, (sizeof(sbuf) - 1), 0);
 	if (num_read <= 0)
 		return 0;
 	sbuf[num_read] = '\0';
 
 	tmp = strrchr(sbuf, ')');	/* split into "PID (cmd" and "<rest>" */
+	if (tmp == NULL)
+		return 0;
 	*tmp = '\0';			/* replace trailing ')' with NUL */
 	/* parse these two strings separately, skipping the leading "(". */
 	nvals = sscanf(sbuf, "%d (%39c", &prec->pid, cmd);
@@ -538,11 +654,6 @@ static int _get_process_data_line(int in, prec_t *prec) {
 	if ((nvals < 22) || (rss < 0))
 		return 0;
 
-	/* If current pid corresponds to a Light Weight Process (Thread POSIX) */
-	/* skip it, we will only account the original process (pid==tgid) */
-	if (_is_a_lwp(prec->pid) > 0)
-  		return 0;
-
 	/* Copy the values that slurm records into our data structure */
 	prec->ppid  = ppid;
 	prec->pages = majflt;
@@ -716,11 +827,13 @@ extern int jobacct_gather_p_endpoll()
 	task_list = NULL;
 	slurm_mutex_unlock(&jobacct_lock);
 
+	slurm_mutex_lock(&reading_mutex);
 	if (slash_proc) {
-		slurm_mutex_lock(&reading_mutex);
 		(void) closedir(slash_proc);
-		slurm_mutex_unlock(&reading_mutex);
+		slash_proc = NULL;
 	}
+	_stat_fd_purge(true);
+	slurm_mutex_unlock(&reading_mutex);
 
 
 	return SLURM_SUCCESS;
@@ -78,8 +78,9 @@ extern void fini( void )
 /**************************************************************************/
 extern List find_preemptable_jobs(struct job_record *job_ptr)
 {
-	ListIterator job_iterator;
+	ListIterator job_iterator, part_iterator;
 	struct job_record *job_p;
+	struct part_record *part_ptr;
 	List preemptee_job_list = NULL;
 
 	/* Validate the preemptor job */
@@ -103,6 +104,22 @@ extern List find_preemptable_jobs(struct job_record *job_ptr)
 		return preemptee_job_list;
 	}
 
+	/* Nothing to scan for unless some lower priority partition shares
+	 * nodes with this job's partition */
+	part_iterator = list_iterator_create(part_list);
+	if (part_iterator == NULL)
+		fatal("list_iterator_create: malloc failure");
+	while ((part_ptr = (struct part_record *) list_next(part_iterator))) {
+		if ((part_ptr->priority < job_ptr->part_ptr->priority) &&
+		    part_ptr->node_bitmap &&
+		    bit_overlap(part_ptr->node_bitmap,
+				job_ptr->part_ptr->node_bitmap))
+			break;
+	}
+	list_iterator_destroy(part_iterator);
+	if (part_ptr == NULL)
+		return preemptee_job_list;
+
 	/* Build an array of pointers to preemption candidates */
 	job_iterator = list_iterator_create(job_list);
 	while ((job_p = (struct job_record *) list_next(job_iterator))) {
@@ -83,6 +83,7 @@ extern List find_preemptable_jobs(struct job_record *job_ptr)
 {
 	ListIterator job_iterator;
 	struct job_record *job_p;
+	slurmdb_qos_rec_t *qos_ptr;
 	List preemptee_job_list = NULL;
 
 	/* Validate the preemptor job */
@@ -106,6 +107,12 @@ extern List find_preemptable_jobs(struct job_record *job_ptr)
 		return preemptee_job_list;
 	}
 
+	/* Nothing to scan for if this job's QOS can not preempt any QOS */
+	qos_ptr = (slurmdb_qos_rec_t *) job_ptr->qos_ptr;
+	if ((qos_ptr == NULL) || (qos_ptr->preempt_bitstr == NULL) ||
+	    (bit_ffs(qos_ptr->preempt_bitstr) == -1))
+		return preemptee_job_list;
+
 	/* Build an array of pointers to preemption candidates */
 	job_iterator = list_iterator_create(job_list);
 	while ((job_p = (struct job_record *) list_next(job_iterator))) {
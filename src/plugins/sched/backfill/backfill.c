@@ -96,6 +96,8 @@ typedef struct node_space_map {
 	time_t begin_time;
 	time_t end_time;
 	bitstr_t *avail_bitmap;
+	uint32_t *lic_avail;	/* available licenses, by license_list
+				 * index, NULL if none configured */
 	int next;	/* next record, by time, zero termination */
 } node_space_map_t;
 int backfilled_jobs = 0;
@@ -110,20 +112,33 @@ static uint32_t debug_flags = 0;
 static int backfill_interval = BACKFILL_INTERVAL;
 static int backfill_window = BACKFILL_WINDOW;
 static int max_backfill_job_cnt = 50;
+static int bf_lic_cnt = 0;	/* size of node_space_map_t.lic_avail */
 
 /*********************** local functions *********************/
+static void _add_lic_releases(time_t sched_start,
+			      node_space_map_t *node_space,
+			      int *node_space_recs);
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     bitstr_t *res_bitmap,
 			     node_space_map_t *node_space,
 			     int *node_space_recs);
 static int  _attempt_backfill(void);
+static void _copy_lic(node_space_map_t *dest, node_space_map_t *src);
 static bool _job_is_completing(void);
+static int  _lic_release_cnt(time_t sched_start);
+static bool _lic_release_job(struct job_record *job_ptr, time_t sched_start);
+static void _lic_remove(uint32_t *lic_need, time_t start_time,
+			time_t end_time, node_space_map_t *node_space);
+static time_t _lic_start_time(uint32_t *lic_need, time_t start_time,
+			      uint32_t duration,
+			      node_space_map_t *node_space);
 static void _load_config(void);
 static bool _many_pending_rpcs(void);
 static bool _more_work(time_t last_backfill_time);
 static void _my_sleep(int secs);
 static int  _num_feature_count(struct job_record *job_ptr);
 static void _reset_job_time_limit(struct job_record *job_ptr, time_t now,
+				  uint32_t *lic_need,
 				  node_space_map_t *node_space);
 static int  _start_job(struct job_record *job_ptr, bitstr_t *avail_bitmap);
 static bool _test_resv_overlap(node_space_map_t *node_space,
@@ -136,8 +151,8 @@ static int  _try_sched(struct job_record *job_ptr, bitstr_t **avail_bitmap,
 /* Log resource allocate table */
 static void _dump_node_space_table(node_space_map_t *node_space_ptr)
 {
-	int i = 0;
-	char begin_buf[32], end_buf[32], *node_list;
+	int i = 0, k;
+	char begin_buf[32], end_buf[32], *node_list, *lic_str;
 
 	info("=========================================");
 	while (1) {
@@ -146,9 +161,16 @@ static void _dump_node_space_table(node_space_map_t *node_space_ptr)
 		slurm_make_time_str(&node_space_ptr[i].end_time,
 				    end_buf, sizeof(end_buf));
 		node_list = bitmap2node_name(node_space_ptr[i].avail_bitmap);
-		info("Begin:%s End:%s Nodes:%s",
-		     begin_buf, end_buf, node_list);
+		lic_str = NULL;
+		for (k = 0; node_space_ptr[i].lic_avail && (k < bf_lic_cnt);
+		     k++) {
+			xstrfmtcat(lic_str, "%s%u", (k ? "," : " Licenses:"),
+				   node_space_ptr[i].lic_avail[k]);
+		}
+		info("Begin:%s End:%s Nodes:%s%s",
+		     begin_buf, end_buf, node_list, (lic_str ? lic_str : ""));
 		xfree(node_list);
+		xfree(lic_str);
 		if ((i = node_space_ptr[i].next) == 0)
 			break;
 	}
@@ -174,6 +196,8 @@ static bool _job_is_completing(void)
 
 	recent = time(NULL) - MAX(complete_wait, 5);
 	job_iterator = list_iterator_create(job_list);
+	if (job_iterator == NULL)
+		fatal("list_iterator_create: malloc failure");
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
 		if (IS_JOB_COMPLETING(job_ptr) &&
 		    (job_ptr->end_time >= recent)) {
@@ -280,6 +304,8 @@ static int  _try_sched(struct job_record *job_ptr, bitstr_t **avail_bitmap,
 		/* Restore the feature counts */
 		i = 0;
 		feat_iter = list_iterator_create(detail_ptr->feature_list);
+		if (feat_iter == NULL)
+			fatal("list_iterator_create: malloc failure");
 		while ((feat_ptr =
 			(struct feature_record *) list_next(feat_iter))) {
 			feat_ptr->count = feat_cnt_orig[i++];
@@ -442,16 +468,19 @@ static int _attempt_backfill(void)
 {
 	bool filter_root = false;
 	List job_queue;
+	xarena_t *job_queue_arena;
 	job_queue_rec_t *job_queue_rec;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
-	int i, j, node_space_recs;
+	int i, j, node_space_recs, node_space_size, lic_release_recs;
 	struct job_record *job_ptr;
 	struct part_record *part_ptr;
 	uint32_t end_time, end_reserve;
 	uint32_t time_limit, comp_time_limit, orig_time_limit;
 	uint32_t min_nodes, max_nodes, req_nodes;
+	uint32_t *lic_avail, *lic_need = NULL;
 	bitstr_t *avail_bitmap = NULL, *resv_bitmap = NULL;
 	time_t now = time(NULL), sched_start, later_start, start_res;
+	time_t lic_start;
 	node_space_map_t *node_space;
 	static int sched_timeout = 0;
 	int this_sched_timeout = 0, rc = 0;
@@ -479,20 +508,32 @@ static int _attempt_backfill(void)
 	if (slurm_get_root_filter())
 		filter_root = true;
 
-	job_queue = build_job_queue(true);
+	job_queue_arena = xarena_create();
+	job_queue = build_job_queue(true, job_queue_arena);
 	if (list_count(job_queue) <= 1) {
 		debug("backfill: no jobs to backfill");
 		list_destroy(job_queue);
+		xarena_destroy(job_queue_arena);
 		return 0;
 	}
 
-	node_space = xmalloc(sizeof(node_space_map_t) *
-			     (max_backfill_job_cnt + 3));
+	/* Licenses are planned in the same table as nodes. Running jobs
+	 * release their licenses at their expected end time, which may
+	 * split the table into additional records. */
+	node_space_size = max_backfill_job_cnt + 3;
+	lic_avail = license_get_avail_cnts(&bf_lic_cnt);
+	if (lic_avail)
+		node_space_size += _lic_release_cnt(sched_start);
+	node_space = xmalloc(sizeof(node_space_map_t) * node_space_size);
 	node_space[0].begin_time = sched_start;
 	node_space[0].end_time = sched_start + backfill_window;
 	node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
+	node_space[0].lic_avail = lic_avail;
 	node_space[0].next = 0;
 	node_space_recs = 1;
+	if (lic_avail)
+		_add_lic_releases(sched_start, node_space, &node_space_recs);
+	lic_release_recs = node_space_recs - 1;
 	if (debug_flags & DEBUG_FLAG_BACKFILL)
 		_dump_node_space_table(node_space);
 
@@ -526,8 +567,16 @@ static int _attempt_backfill(void)
 		if ((part_ptr->flags & PART_FLAG_ROOT_ONLY) && filter_root)
 			continue;
 
-		if ((!job_independent(job_ptr, 0)) ||
-		    (license_job_test(job_ptr, time(NULL)) != SLURM_SUCCESS))
+		if (!job_independent(job_ptr, 0))
+			continue;
+		/* Jobs waiting for licenses are planned using the license
+		 * counts in node_space rather than skipped */
+		j = license_job_test(job_ptr, time(NULL));
+		if (j == SLURM_ERROR)
+			continue;	/* never runnable */
+		xfree(lic_need);
+		lic_need = license_get_job_cnts(job_ptr, bf_lic_cnt);
+		if ((j != SLURM_SUCCESS) && !lic_need)
 			continue;
 
 		/* Determine minimum and maximum node counts */
@@ -573,11 +622,34 @@ static int _attempt_backfill(void)
  TRY_LATER:	FREE_NULL_BITMAP(avail_bitmap);
 		start_res   = later_start;
 		later_start = 0;
-		j = job_test_resv(job_ptr, &start_res, true, &avail_bitmap);
+		/* Licenses are planned below using node_space */
+		if (lic_need) {
+			j = job_test_resv_nodes(job_ptr, &start_res,
+						&avail_bitmap);
+		} else {
+			j = job_test_resv(job_ptr, &start_res, true,
+					  &avail_bitmap);
+		}
 		if (j != SLURM_SUCCESS) {
 			job_ptr->time_limit = orig_time_limit;
 			continue;
 		}
+		if (lic_need) {
+			lic_start = _lic_start_time(lic_need,
+						    MAX(start_res, now),
+						    time_limit * 60,
+						    node_space);
+			if ((lic_start >= (sched_start + backfill_window)) ||
+			    ((lic_start <= now) &&
+			     (license_job_test(job_ptr, now) !=
+			      SLURM_SUCCESS))) {
+				/* Licenses not available within the window,
+				 * or available ones held by a reservation */
+				job_ptr->time_limit = orig_time_limit;
+				continue;
+			}
+			start_res = MAX(start_res, lic_start);
+		}
 		if (start_res > now)
 			end_time = (time_limit * 60) + start_res;
 		else
@@ -658,6 +730,18 @@ static int _attempt_backfill(void)
 			job_ptr->start_time = start_res;
 			last_job_update = now;
 		}
+		if (lic_need && (job_ptr->start_time > start_res)) {
+			/* Nodes delayed the start, recheck licenses */
+			lic_start = _lic_start_time(lic_need,
+						    job_ptr->start_time,
+						    time_limit * 60,
+						    node_space);
+			if (lic_start > job_ptr->start_time) {
+				later_start = lic_start;
+				job_ptr->start_time = 0;
+				goto TRY_LATER;
+			}
+		}
 		if (job_ptr->start_time <= now) {
 			int rc = _start_job(job_ptr, resv_bitmap);
 			if (qos_ptr && (qos_ptr->flags & QOS_FLAG_NO_RESERVE))
@@ -667,12 +751,17 @@ static int _attempt_backfill(void)
 				job_ptr->time_limit = comp_time_limit;
 				job_ptr->end_time = job_ptr->start_time +
 						    (comp_time_limit * 60);
-				_reset_job_time_limit(job_ptr, now,
+				_reset_job_time_limit(job_ptr, now, lic_need,
 						      node_space);
 				time_limit = job_ptr->time_limit;
 			} else {
 				job_ptr->time_limit = orig_time_limit;
 			}
+			if ((rc == SLURM_SUCCESS) && lic_need) {
+				/* The job now holds these licenses */
+				_lic_remove(lic_need, now, job_ptr->end_time,
+					    node_space);
+			}
 			if (rc == ESLURM_ACCOUNTING_POLICY) {
 				/* Unknown future start time, just skip job */
 				job_ptr->start_time = 0;	
@@ -701,7 +790,8 @@ static int _attempt_backfill(void)
 			continue;
 		}
 
-		if (node_space_recs >= max_backfill_job_cnt) {
+		if (node_space_recs >= (max_backfill_job_cnt +
+					lic_release_recs)) {
 			/* Already have too many jobs to deal with */
 			break;
 		}
@@ -726,19 +816,26 @@ static int _attempt_backfill(void)
 		bit_not(avail_bitmap);
 		_add_reservation(job_ptr->start_time, end_reserve,
 				 avail_bitmap, node_space, &node_space_recs);
+		if (lic_need) {
+			_lic_remove(lic_need, job_ptr->start_time,
+				    end_reserve, node_space);
+		}
 		if (debug_flags & DEBUG_FLAG_BACKFILL)
 			_dump_node_space_table(node_space);
 	}
 	FREE_NULL_BITMAP(avail_bitmap);
 	FREE_NULL_BITMAP(resv_bitmap);
+	xfree(lic_need);
 
 	for (i=0; ; ) {
 		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
+		xfree(node_space[i].lic_avail);
 		if ((i = node_space[i].next) == 0)
 			break;
 	}
 	xfree(node_space);
 	list_destroy(job_queue);
+	xarena_destroy(job_queue_arena);
 	return rc;
 }
 
@@ -797,15 +894,26 @@ static int _start_job(struct job_record *job_ptr, bitstr_t *resv_bitmap)
  *	Avoid using resources reserved for pending jobs or in resource
  *	reservations */
 static void _reset_job_time_limit(struct job_record *job_ptr, time_t now,
+				  uint32_t *lic_need,
 				  node_space_map_t *node_space)
 {
-	int32_t j, resv_delay;
+	int32_t j, k, resv_delay;
 	uint32_t orig_time_limit = job_ptr->time_limit;
+	bool lic_overlap;
 
 	for (j=0; ; ) {
+		lic_overlap = false;
+		for (k = 0; lic_need && node_space[j].lic_avail &&
+			    (k < bf_lic_cnt); k++) {
+			if (lic_need[k] > node_space[j].lic_avail[k]) {
+				lic_overlap = true;
+				break;
+			}
+		}
 		if ((node_space[j].begin_time != now) &&
 		    (node_space[j].begin_time < job_ptr->end_time) &&
-		    (!bit_super_set(job_ptr->node_bitmap,
+		    (lic_overlap ||
+		     !bit_super_set(job_ptr->node_bitmap,
 				    node_space[j].avail_bitmap))) {
 			/* Job overlaps pending job's resource reservation */
 			resv_delay = difftime(node_space[j].begin_time, now);
@@ -860,6 +968,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			node_space[j].end_time = start_time;
 			node_space[i].avail_bitmap =
 				bit_copy(node_space[j].avail_bitmap);
+			_copy_lic(&node_space[i], &node_space[j]);
 			node_space[i].next = node_space[j].next;
 			node_space[j].next = i;
 			(*node_space_recs)++;
@@ -880,6 +989,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 				node_space[j].end_time = end_reserve;
 				node_space[i].avail_bitmap =
 					bit_copy(node_space[j].avail_bitmap);
+				_copy_lic(&node_space[i], &node_space[j]);
 				node_space[i].next = node_space[j].next;
 				node_space[j].next = i;
 				(*node_space_recs)++;
@@ -927,3 +1037,149 @@ static bool _test_resv_overlap(node_space_map_t *node_space,
 	}
 	return overlap;
 }
+
+/* Copy a node_space record's license counts into a new record */
+static void _copy_lic(node_space_map_t *dest, node_space_map_t *src)
+{
+	if (src->lic_avail == NULL) {
+		dest->lic_avail = NULL;
+		return;
+	}
+	dest->lic_avail = xmalloc(sizeof(uint32_t) * bf_lic_cnt);
+	memcpy(dest->lic_avail, src->lic_avail, sizeof(uint32_t) * bf_lic_cnt);
+}
+
+/* Test if a running job holding licenses is expected to end within the
+ *	backfill window, releasing them for use by pending jobs */
+static bool _lic_release_job(struct job_record *job_ptr, time_t sched_start)
+{
+	if (!IS_JOB_RUNNING(job_ptr) || (job_ptr->license_list == NULL))
+		return false;
+	if ((job_ptr->end_time <= sched_start) ||
+	    (job_ptr->end_time >= (sched_start + backfill_window)))
+		return false;
+	return true;
+}
+
+/* Return a count of running jobs expected to release licenses within the
+ *	backfill window, each of which may add one node_space record */
+static int _lic_release_cnt(time_t sched_start)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+	int cnt = 0;
+
+	job_iterator = list_iterator_create(job_list);
+	if (job_iterator == NULL)
+		fatal("list_iterator_create: malloc failure");
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		if (_lic_release_job(job_ptr, sched_start))
+			cnt++;
+	}
+	list_iterator_destroy(job_iterator);
+
+	return cnt;
+}
+
+/* Add to node_space the licenses which running jobs will release when
+ *	they reach their end time */
+static void _add_lic_releases(time_t sched_start,
+			      node_space_map_t *node_space,
+			      int *node_space_recs)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+	uint32_t *lic_held;
+	time_t end_time;
+	int i, j, k;
+
+	job_iterator = list_iterator_create(job_list);
+	if (job_iterator == NULL)
+		fatal("list_iterator_create: malloc failure");
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		if (!_lic_release_job(job_ptr, sched_start))
+			continue;
+		lic_held = license_get_job_cnts(job_ptr, bf_lic_cnt);
+		if (lic_held == NULL)
+			continue;
+		end_time = job_ptr->end_time;
+		for (j=0; ; ) {
+			if ((node_space[j].begin_time < end_time) &&
+			    (node_space[j].end_time   > end_time)) {
+				/* split record at the job's end time */
+				i = *node_space_recs;
+				node_space[i].begin_time = end_time;
+				node_space[i].end_time = node_space[j].end_time;
+				node_space[j].end_time = end_time;
+				node_space[i].avail_bitmap =
+					bit_copy(node_space[j].avail_bitmap);
+				_copy_lic(&node_space[i], &node_space[j]);
+				node_space[i].next = node_space[j].next;
+				node_space[j].next = i;
+				(*node_space_recs)++;
+			}
+			if (node_space[j].begin_time >= end_time) {
+				for (k = 0; k < bf_lic_cnt; k++) {
+					node_space[j].lic_avail[k] +=
+						lic_held[k];
+				}
+			}
+			if ((j = node_space[j].next) == 0)
+				break;
+		}
+		xfree(lic_held);
+	}
+	list_iterator_destroy(job_iterator);
+}
+
+/* Return the earliest time at or after start_time when the licenses a job
+ *	requires are available for the job's full duration. If they are not
+ *	available within the backfill window, then the window's end time is
+ *	returned. */
+static time_t _lic_start_time(uint32_t *lic_need, time_t start_time,
+			      uint32_t duration,
+			      node_space_map_t *node_space)
+{
+	time_t lic_start = start_time;
+	int j, k;
+
+	for (j=0; ; ) {
+		if (node_space[j].begin_time >= (lic_start + duration))
+			break;
+		if (node_space[j].end_time > lic_start) {
+			for (k = 0; k < bf_lic_cnt; k++) {
+				if (lic_need[k] > node_space[j].lic_avail[k]) {
+					lic_start = node_space[j].end_time;
+					break;
+				}
+			}
+		}
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+	return lic_start;
+}
+
+/* Remove the licenses allocated to a job from the node_space records
+ *	overlapping its time span */
+static void _lic_remove(uint32_t *lic_need, time_t start_time,
+			time_t end_time, node_space_map_t *node_space)
+{
+	int j, k;
+
+	for (j=0; ; ) {
+		if (node_space[j].begin_time >= end_time)
+			break;
+		if (node_space[j].end_time > start_time) {
+			for (k = 0; k < bf_lic_cnt; k++) {
+				if (node_space[j].lic_avail[k] > lic_need[k])
+					node_space[j].lic_avail[k] -=
+						lic_need[k];
+				else
+					node_space[j].lic_avail[k] = 0;
+			}
+		}
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+}
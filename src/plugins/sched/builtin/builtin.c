@@ -133,6 +133,7 @@ static void _compute_start_times(void)
 {
 	int j, rc = SLURM_SUCCESS, job_cnt = 0;
 	List job_queue;
+	xarena_t *job_queue_arena;
 	job_queue_rec_t *job_queue_rec;
 	List preemptee_candidates = NULL;
 	struct job_record *job_ptr;
@@ -146,7 +147,8 @@ static void _compute_start_times(void)
 	alloc_bitmap = bit_alloc(node_record_count);
 	if (alloc_bitmap == NULL)
 		fatal("bit_alloc: malloc failure");
-	job_queue = build_job_queue(true);
+	job_queue_arena = xarena_create();
+	job_queue = build_job_queue(true, job_queue_arena);
 	while ((job_queue_rec = (job_queue_rec_t *) 
 				list_pop_bottom(job_queue, sort_job_queue2))) {
 		job_ptr  = job_queue_rec->job_ptr;
@@ -215,6 +217,7 @@ static void _compute_start_times(void)
 		}
 	}
 	list_destroy(job_queue);
+	xarena_destroy(job_queue_arena);
 	FREE_NULL_BITMAP(alloc_bitmap);
 }
 
@@ -1465,24 +1465,123 @@ static uint16_t _get_job_node_req(struct job_record *job_ptr)
 	return NODE_CR_ONE_ROW;
 }
 
-static int _find_job (void *x, void *key)
+static int _job_ptr_cmp(const void *x, const void *y)
 {
-	struct job_record *job_ptr = (struct job_record *) x;
-	if (job_ptr == (struct job_record *) key)
+	const struct job_record *job1 = *(struct job_record **) x;
+	const struct job_record *job2 = *(struct job_record **) y;
+
+	if (job1 < job2)
+		return -1;
+	if (job1 > job2)
 		return 1;
 	return 0;
 }
 
-static bool _is_preemptable(struct job_record *job_ptr,
-			    List preemptee_candidates)
+/* Return an xmalloc'ed array of the preemptee candidates sorted by address
+ * so membership can be tested with bsearch() rather than a list scan */
+static struct job_record **_preemptee_index(List preemptee_candidates,
+					    int *cnt)
 {
+	struct job_record **index, *tmp_job_ptr;
+	ListIterator iter;
+	int i = 0;
+
+	*cnt = 0;
 	if (!preemptee_candidates)
+		return NULL;
+	index = xmalloc(sizeof(struct job_record *) *
+			(list_count(preemptee_candidates) + 1));
+	iter = list_iterator_create(preemptee_candidates);
+	if (iter == NULL)
+		fatal ("memory allocation failure");
+	while ((tmp_job_ptr = (struct job_record *) list_next(iter)))
+		index[i++] = tmp_job_ptr;
+	list_iterator_destroy(iter);
+	qsort(index, i, sizeof(struct job_record *), _job_ptr_cmp);
+	*cnt = i;
+	return index;
+}
+
+static bool _is_preemptable(struct job_record *job_ptr,
+			    struct job_record **index, int cnt)
+{
+	if (!index || !cnt)
 		return false;
-	if (list_find_first(preemptee_candidates, _find_job, job_ptr))
+	if (bsearch(&job_ptr, index, cnt, sizeof(struct job_record *),
+		    _job_ptr_cmp))
 		return true;
 	return false;
 }
 
+/* Return an xmalloc'ed array of the preemptee candidates which could be
+ * removed to make room for a job.  The order of the preempt plugin's list
+ * (lowest preemption cost first) is preserved and jobs with no nodes in
+ * node_map are skipped since removing them can not help. */
+static struct job_record **_removable_preemptees(List preemptee_candidates,
+						 bitstr_t *node_map, int *cnt)
+{
+	struct job_record **cand, *tmp_job_ptr;
+	ListIterator iter;
+	uint16_t mode;
+	int i = 0;
+
+	cand = xmalloc(sizeof(struct job_record *) *
+		       (list_count(preemptee_candidates) + 1));
+	iter = list_iterator_create(preemptee_candidates);
+	if (iter == NULL)
+		fatal ("memory allocation failure");
+	while ((tmp_job_ptr = (struct job_record *) list_next(iter))) {
+		if (!IS_JOB_RUNNING(tmp_job_ptr) &&
+		    !IS_JOB_SUSPENDED(tmp_job_ptr))
+			continue;
+		mode = slurm_job_preempt_mode(tmp_job_ptr);
+		if ((mode != PREEMPT_MODE_REQUEUE)    &&
+		    (mode != PREEMPT_MODE_CHECKPOINT) &&
+		    (mode != PREEMPT_MODE_CANCEL))
+			continue;	/* can't remove job */
+		if ((tmp_job_ptr->node_bitmap == NULL) ||
+		    (bit_overlap(node_map, tmp_job_ptr->node_bitmap) == 0))
+			continue;
+		cand[i++] = tmp_job_ptr;
+	}
+	list_iterator_destroy(iter);
+	*cnt = i;
+	return cand;
+}
+
+/* Test if a job could run once the first rm_cnt jobs in cand are removed
+ * from a copy of the current resource allocations */
+static int _test_without(struct job_record *job_ptr, bitstr_t *bitmap,
+			 bitstr_t *orig_map, uint32_t min_nodes,
+			 uint32_t max_nodes, uint32_t req_nodes,
+			 uint16_t job_node_req,
+			 struct job_record **cand, int rm_cnt)
+{
+	struct part_res_record *future_part;
+	struct node_use_record *future_usage;
+	int i, rc;
+
+	future_part = _dup_part_data(select_part_record);
+	if (future_part == NULL)
+		return SLURM_ERROR;
+	future_usage = _dup_node_usage(select_node_usage);
+	if (future_usage == NULL) {
+		_destroy_part_data(future_part);
+		return SLURM_ERROR;
+	}
+
+	for (i = 0; i < rm_cnt; i++)
+		_rm_job_from_res(future_part, future_usage, cand[i], 0);
+	bit_or(bitmap, orig_map);
+	rc = cr_job_test(job_ptr, bitmap, min_nodes, max_nodes, req_nodes,
+			 SELECT_MODE_WILL_RUN, cr_type, job_node_req,
+			 select_node_cnt, future_part, future_usage);
+
+	_destroy_part_data(future_part);
+	_destroy_node_data(future_usage, NULL);
+	return rc;
+}
+
 /* Determine if a job can ever run */
 static int _test_only(struct job_record *job_ptr, bitstr_t *bitmap,
 		      uint32_t min_nodes, uint32_t max_nodes,
@@ -1504,13 +1603,9 @@ static int _run_now(struct job_record *job_ptr, bitstr_t *bitmap,
 		    List preemptee_candidates, List *preemptee_job_list)
 {
 	int rc;
-	bitstr_t *orig_map;
-	struct job_record *tmp_job_ptr;
-	ListIterator job_iterator, preemptee_iterator;
-	struct part_res_record *future_part;
-	struct node_use_record *future_usage;
-	bool remove_some_jobs = false;
-	uint16_t mode;
+	bitstr_t *orig_map, *best_map = NULL;
+	struct job_record **cand;
+	int cand_cnt, i, lo, hi, mid;
 
 	orig_map = bit_copy(bitmap);
 	if (!orig_map)
@@ -1522,86 +1617,56 @@ static int _run_now(struct job_record *job_ptr, bitstr_t *bitmap,
 			 select_node_usage);
 
 	if ((rc != SLURM_SUCCESS) && preemptee_candidates) {
-		/* Remove preemptable jobs from simulated environment */
-		future_part = _dup_part_data(select_part_record);
-		if (future_part == NULL) {
-			FREE_NULL_BITMAP(orig_map);
-			return SLURM_ERROR;
-		}
-		future_usage = _dup_node_usage(select_node_usage);
-		if (future_usage == NULL) {
-			_destroy_part_data(future_part);
-			FREE_NULL_BITMAP(orig_map);
-			return SLURM_ERROR;
+		/* Find the shortest prefix of the cost ordered candidate
+		 * list whose removal lets the job run.  First see if the
+		 * job can run with every candidate gone, then bisect
+		 * rather than re-testing after each removal. */
+		cand = _removable_preemptees(preemptee_candidates, orig_map,
+					     &cand_cnt);
+		if (cand_cnt) {
+			rc = _test_without(job_ptr, bitmap, orig_map,
+					   min_nodes, max_nodes, req_nodes,
+					   job_node_req, cand, cand_cnt);
 		}
-
-		job_iterator = list_iterator_create(job_list);
-		if (job_iterator == NULL)
-			fatal ("memory allocation failure");
-		while ((tmp_job_ptr = (struct job_record *)
-			list_next(job_iterator))) {
-			if (!IS_JOB_RUNNING(tmp_job_ptr) &&
-			    !IS_JOB_SUSPENDED(tmp_job_ptr))
-				continue;
-			mode = slurm_job_preempt_mode(tmp_job_ptr);
-			if ((mode != PREEMPT_MODE_REQUEUE)    &&
-			    (mode != PREEMPT_MODE_CHECKPOINT) &&
-			    (mode != PREEMPT_MODE_CANCEL))
-				continue;	/* can't remove job */
-			if (_is_preemptable(tmp_job_ptr,
-					    preemptee_candidates)) {
-				/* Remove preemptable job now */
-				_rm_job_from_res(future_part, future_usage,
-						 tmp_job_ptr, 0);
-				bit_or(bitmap, orig_map);
-				rc = cr_job_test(job_ptr, bitmap, min_nodes,
-						 max_nodes, req_nodes,
-						 SELECT_MODE_WILL_RUN,
-						 cr_type, job_node_req,
-						 select_node_cnt,
-						 future_part, future_usage);
-				if (rc == SLURM_SUCCESS)
-					break;
+		if ((rc == SLURM_SUCCESS) && (cand_cnt > 1)) {
+			best_map = bit_copy(bitmap);
+			if (!best_map)
+				fatal("bit_copy: malloc failure");
+			lo = 0;		/* known not to fit */
+			hi = cand_cnt;	/* known to fit */
+			while ((hi - lo) > 1) {
+				mid = (lo + hi) / 2;
+				if (_test_without(job_ptr, bitmap, orig_map,
+						  min_nodes, max_nodes,
+						  req_nodes, job_node_req,
+						  cand, mid) == SLURM_SUCCESS) {
+					hi = mid;
+					bit_copybits(best_map, bitmap);
+				} else
+					lo = mid;
 			}
+			bit_copybits(bitmap, best_map);
+			FREE_NULL_BITMAP(best_map);
+			cand_cnt = hi;
 		}
-		list_iterator_destroy(job_iterator);
 
-		if ((rc == SLURM_SUCCESS) && preemptee_job_list &&
-		    preemptee_candidates) {
+		if ((rc == SLURM_SUCCESS) && preemptee_job_list) {
 			/* Build list of preemptee jobs whose resources are
 			 * actually used */
-			if (*preemptee_job_list == NULL) {
-				*preemptee_job_list = list_create(NULL);
-				if (*preemptee_job_list == NULL)
-					fatal("list_create malloc failure");
-			}
-			preemptee_iterator = list_iterator_create(
-				preemptee_candidates);
-			if (preemptee_iterator == NULL)
-				fatal ("memory allocation failure");
-			while ((tmp_job_ptr = (struct job_record *)
-				list_next(preemptee_iterator))) {
-				mode = slurm_job_preempt_mode(tmp_job_ptr);
-				if ((mode != PREEMPT_MODE_REQUEUE)    &&
-				    (mode != PREEMPT_MODE_CHECKPOINT) &&
-				    (mode != PREEMPT_MODE_CANCEL))
-					continue;
+			for (i = 0; i < cand_cnt; i++) {
 				if (bit_overlap(bitmap,
-						tmp_job_ptr->node_bitmap) == 0)
+						cand[i]->node_bitmap) == 0)
 					continue;
-				list_append(*preemptee_job_list,
-					    tmp_job_ptr);
-				remove_some_jobs = true;
-			}
-			list_iterator_destroy(preemptee_iterator);
-			if (!remove_some_jobs) {
-				list_destroy(*preemptee_job_list);
-				*preemptee_job_list = NULL;
+				if (*preemptee_job_list == NULL) {
+					*preemptee_job_list = list_create(NULL);
+					if (*preemptee_job_list == NULL)
+						fatal("list_create malloc "
+						      "failure");
+				}
+				list_append(*preemptee_job_list, cand[i]);
 			}
 		}
-
-		_destroy_part_data(future_part);
-		_destroy_node_data(future_usage, NULL);
+		xfree(cand);
 	}
 	FREE_NULL_BITMAP(orig_map);
 
@@ -1622,7 +1687,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 	List cr_job_list;
 	ListIterator job_iterator, preemptee_iterator;
 	bitstr_t *orig_map;
-	int action, rc = SLURM_ERROR;
+	struct job_record **preemptee_inx;
+	int action, preemptee_cnt, rc = SLURM_ERROR;
 	time_t now = time(NULL);
 
 	orig_map = bit_copy(bitmap);
@@ -1655,6 +1721,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 	}
 
 	/* Build list of running and suspended jobs */
+	preemptee_inx = _preemptee_index(preemptee_candidates, &preemptee_cnt);
 	cr_job_list = list_create(NULL);
 	if (!cr_job_list)
 		fatal("list_create: memory allocation error");
@@ -1669,7 +1736,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 			error("Job %u has zero end_time", tmp_job_ptr->job_id);
 			continue;
 		}
-		if (_is_preemptable(tmp_job_ptr, preemptee_candidates)) {
+		if (_is_preemptable(tmp_job_ptr, preemptee_inx,
+				    preemptee_cnt)) {
 			uint16_t mode = slurm_job_preempt_mode(tmp_job_ptr);
 			if (mode == PREEMPT_MODE_OFF)
 				continue;
@@ -1684,6 +1752,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 			list_append(cr_job_list, tmp_job_ptr);
 	}
 	list_iterator_destroy(job_iterator);
+	xfree(preemptee_inx);
 
 	/* Test with all preemptable jobs gone */
 	if (preemptee_candidates) {
@@ -168,7 +168,7 @@ int sattach(int argc, char *argv[])
 
 	io = client_io_handler_create(opt.fds, layout->task_cnt,
 				      layout->node_cnt, fake_cred,
-				      opt.labelio);
+				      opt.labelio, false);
 	client_io_handler_start(io);
 
 	if (opt.pty) {
@@ -64,23 +64,43 @@
 #define MAX_RETRIES     10
 #define MAX_THREADS      8	/* These can be huge messages, so
 				 * only run MAX_THREADS at one time */
+#define MAX_BLOCKS       4	/* Blocks in flight at one time */
+
+/* One file block being sent to every subtree of the nodes */
+typedef struct block {
+	file_bcast_msg_t *bcast_msg;	/* block to send, freed when done */
+	int thread_cnt;			/* threads still sending this block */
+} block_t;
+
 typedef struct thd {
 	pthread_t thread;	/* thread ID */
 	slurm_msg_t msg;	/* message to send */
-	int rc;			/* highest return codes from RPC */
-	char *nodelist;
+	char *nodelist;		/* nodes reached by this thread */
+	block_t *block;		/* block being sent */
 } thd_t;
 
 static pthread_mutex_t agent_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  agent_cnt_cond  = PTHREAD_COND_INITIALIZER;
-static int agent_cnt = 0;
+static int agent_cnt = 0;	/* blocks in flight */
+static int agent_rc = 0;	/* highest return code from any RPC */
+
+static char **span_nodelist = NULL;
+static int span_cnt = 0;
 
 static void *_agent_thread(void *args);
 
+static void _free_block(block_t *block)
+{
+	xfree(block->bcast_msg->block);
+	xfree(block->bcast_msg);
+	xfree(block);
+}
+
 static void *_agent_thread(void *args)
 {
 	List ret_list = NULL;
 	thd_t *thread_ptr = (thd_t *) args;
+	block_t *block = thread_ptr->block;
 	ListIterator itr;
 	ret_data_info_t *ret_data_info = NULL;
 	int rc = 0, msg_rc;
@@ -106,75 +126,95 @@ static void *_agent_thread(void *args)
 		rc = MAX(rc, msg_rc);
 	}
 
-	thread_ptr->rc = rc;
 	list_iterator_destroy(itr);
 	if (ret_list)
 		list_destroy(ret_list);
+	xfree(thread_ptr);
+
 	slurm_mutex_lock(&agent_cnt_mutex);
-	agent_cnt--;
-	pthread_cond_broadcast(&agent_cnt_cond);
+	agent_rc = MAX(agent_rc, rc);
+	if (--block->thread_cnt == 0) {
+		_free_block(block);
+		agent_cnt--;
+		pthread_cond_broadcast(&agent_cnt_cond);
+	}
 	slurm_mutex_unlock(&agent_cnt_mutex);
 	return NULL;
 }
 
-/* Issue the RPC to transfer the file's data */
-extern void send_rpc(file_bcast_msg_t *bcast_msg,
-		     job_sbcast_cred_msg_t *sbcast_cred)
+/* Split the job's nodes into one list per thread. The first node of each
+ * list forwards the message to the rest of its list */
+static void _build_span(job_sbcast_cred_msg_t *sbcast_cred)
 {
-	/* Preserve some data structures across calls for better performance */
-	static int threads_used = 0;
-	static thd_t thread_info[MAX_THREADS];
-
-	int i, fanout, rc = SLURM_SUCCESS;
-	int retries = 0;
-	pthread_attr_t attr;
+	hostlist_t hl;
+	hostlist_t new_hl;
+	int *span = NULL;
+	char *name = NULL;
+	int i, j, fanout;
 
-	if (threads_used == 0) {
-		hostlist_t hl;
-		hostlist_t new_hl;
-		int *span = NULL;
-		char *name = NULL;
+	if (params.fanout)
+		fanout = MIN(MAX_THREADS, params.fanout);
+	else
+		fanout = MAX_THREADS;
 
-		if (params.fanout)
-			fanout = MIN(MAX_THREADS, params.fanout);
-		else
-			fanout = MAX_THREADS;
+	span = set_span(sbcast_cred->node_cnt, fanout);
+	span_nodelist = xmalloc(sizeof(char *) * fanout);
 
-		span = set_span(sbcast_cred->node_cnt, fanout);
+	hl = hostlist_create(sbcast_cred->node_list);
 
-		hl = hostlist_create(sbcast_cred->node_list);
-
-		i = 0;
-		while (i < sbcast_cred->node_cnt) {
-			int j = 0;
+	i = 0;
+	while (i < sbcast_cred->node_cnt) {
+		name = hostlist_shift(hl);
+		if(!name) {
+			debug3("no more nodes to send to");
+			break;
+		}
+		new_hl = hostlist_create(name);
+		free(name);
+		i++;
+		for(j = 0; j < span[span_cnt]; j++) {
 			name = hostlist_shift(hl);
-			if(!name) {
-				debug3("no more nodes to send to");
+			if(!name)
 				break;
-			}
-			new_hl = hostlist_create(name);
+			hostlist_push(new_hl, name);
 			free(name);
 			i++;
-			for(j = 0; j < span[threads_used]; j++) {
-				name = hostlist_shift(hl);
-				if(!name)
-					break;
-				hostlist_push(new_hl, name);
-				free(name);
-				i++;
-			}
-			thread_info[threads_used].nodelist = 
-				hostlist_ranged_string_xmalloc(new_hl);
-			hostlist_destroy(new_hl);
-			slurm_msg_t_init(&thread_info[threads_used].msg);
-			thread_info[threads_used].msg.msg_type =
-				REQUEST_FILE_BCAST;
-			threads_used++;
 		}
-		xfree(span);
-		hostlist_destroy(hl);
-		debug("using %d threads", threads_used);
+		span_nodelist[span_cnt++] =
+			hostlist_ranged_string_xmalloc(new_hl);
+		hostlist_destroy(new_hl);
 	}
+	xfree(span);
+	hostlist_destroy(hl);
+	debug("using %d threads", span_cnt);
+}
+
+/* Issue the RPC to transfer the file's data. bcast_msg and its block are
+ * xmalloc'ed by the caller and freed here once every node has replied.
+ * Returns without waiting for the replies unless MAX_BLOCKS are already
+ * in flight, see send_rpc_wait() */
+extern void send_rpc(file_bcast_msg_t *bcast_msg,
+		     job_sbcast_cred_msg_t *sbcast_cred)
+{
+	block_t *block;
+	thd_t *thread_ptr;
+	int i, retries = 0;
+	pthread_attr_t attr;
+
+	if (span_cnt == 0)
+		_build_span(sbcast_cred);
+
+	slurm_mutex_lock(&agent_cnt_mutex);
+	while (agent_cnt >= MAX_BLOCKS)
+		pthread_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
+	agent_cnt++;
+	slurm_mutex_unlock(&agent_cnt_mutex);
+	if (agent_rc)
+		exit(1);
+
+	block = xmalloc(sizeof(block_t));
+	block->bcast_msg = bcast_msg;
+	block->thread_cnt = span_cnt;
 
 	slurm_attr_init(&attr);
 	if (pthread_attr_setstacksize(&attr, 3 * 1024*1024))
@@ -183,32 +223,34 @@ extern void send_rpc(file_bcast_msg_t *bcast_msg,
 			PTHREAD_CREATE_DETACHED))
 		error("pthread_attr_setdetachstate error %m");
 
-	for (i=0; i<threads_used; i++) {
-		thread_info[i].msg.data = bcast_msg;
-		slurm_mutex_lock(&agent_cnt_mutex);
-		agent_cnt++;
-		slurm_mutex_unlock(&agent_cnt_mutex);
+	for (i=0; i<span_cnt; i++) {
+		thread_ptr = xmalloc(sizeof(thd_t));
+		thread_ptr->nodelist = span_nodelist[i];
+		thread_ptr->block = block;
+		slurm_msg_t_init(&thread_ptr->msg);
+		thread_ptr->msg.msg_type = REQUEST_FILE_BCAST;
+		thread_ptr->msg.data = bcast_msg;
 
-		while (pthread_create(&thread_info[i].thread,
+		while (pthread_create(&thread_ptr->thread,
 				      &attr, _agent_thread,
-				      (void *) &thread_info[i])) {
+				      (void *) thread_ptr)) {
 			error("pthread_create error %m");
 			if (++retries > MAX_RETRIES)
 				fatal("Can't create pthread");
 			sleep(1);	/* sleep and retry */
 		}
 	}
+	pthread_attr_destroy(&attr);
+}
 
-	/* wait until pthreads complete */
+/* Wait for every block in flight to be acknowledged by all nodes */
+extern void send_rpc_wait(void)
+{
 	slurm_mutex_lock(&agent_cnt_mutex);
 	while (agent_cnt)
 		pthread_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
 	slurm_mutex_unlock(&agent_cnt_mutex);
-	pthread_attr_destroy(&attr);
-
-	for (i=0; i<threads_used; i++)
-		 rc = MAX(rc, thread_info[i].rc);
 
-	if (rc)
+	if (agent_rc)
 		exit(1);
 }
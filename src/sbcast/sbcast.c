@@ -45,6 +45,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
@@ -54,6 +55,7 @@
 #include "src/common/forward.h"
 #include "src/common/hostlist.h"
 #include "src/common/log.h"
+#include "src/common/lz_compress.h"
 #include "src/common/slurm_cred.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
@@ -184,47 +186,73 @@ static void _bcast_file(void)
 {
 	int buf_size;
 	ssize_t size_read = 0;
-	file_bcast_msg_t bcast_msg;
-	char *buffer;
+	file_bcast_msg_t bcast_tmpl, *bcast_msg;
+	char *buffer, *comp_buf;
+	uint32_t comp_len;
+	uint16_t block_no = 1, last_block;
 
 	if (params.block_size)
 		buf_size = MIN(params.block_size, f_stat.st_size);
 	else
 		buf_size = MIN((512 * 1024), f_stat.st_size);
 
-	bcast_msg.fname		= params.dst_fname;
-	bcast_msg.block_no	= 1;
-	bcast_msg.last_block	= 0;
-	bcast_msg.force		= params.force;
-	bcast_msg.modes		= f_stat.st_mode;
-	bcast_msg.uid		= f_stat.st_uid;
-	bcast_msg.gid		= f_stat.st_gid;
-	buffer			= xmalloc(buf_size);
-	bcast_msg.block		= buffer;
-	bcast_msg.block_len	= 0;
-	bcast_msg.cred          = sbcast_cred->sbcast_cred;
+	memset(&bcast_tmpl, 0, sizeof(file_bcast_msg_t));
+	bcast_tmpl.fname	= params.dst_fname;
+	bcast_tmpl.force	= params.force;
+	bcast_tmpl.modes	= f_stat.st_mode;
+	bcast_tmpl.uid		= f_stat.st_uid;
+	bcast_tmpl.gid		= f_stat.st_gid;
+	bcast_tmpl.cred		= sbcast_cred->sbcast_cred;
 
 	if (params.preserve) {
-		bcast_msg.atime     = f_stat.st_atime;
-		bcast_msg.mtime     = f_stat.st_mtime;
-	} else {
-		bcast_msg.atime     = 0;
-		bcast_msg.mtime     = 0;
+		bcast_tmpl.atime     = f_stat.st_atime;
+		bcast_tmpl.mtime     = f_stat.st_mtime;
 	}
 
+	/* The first block creates the file and the last one sets its
+	 * modes and times, so each of those is sent alone. Any blocks in
+	 * between are sent several at a time and may be written in any
+	 * order since each carries its offset in the file. */
 	while (1) {
-		bcast_msg.block_len = _get_block(buffer, buf_size);
-		debug("block %d, size %u", bcast_msg.block_no,
-		      bcast_msg.block_len);
-		size_read += bcast_msg.block_len;
+		bcast_msg = xmalloc(sizeof(file_bcast_msg_t));
+		memcpy(bcast_msg, &bcast_tmpl, sizeof(file_bcast_msg_t));
+		bcast_msg->block_no	= block_no;
+		bcast_msg->block_offset	= size_read;
+		buffer			= xmalloc(buf_size);
+		bcast_msg->block	= buffer;
+		bcast_msg->block_len	= _get_block(buffer, buf_size);
+		bcast_msg->uncomp_len	= bcast_msg->block_len;
+		debug("block %d, size %u", bcast_msg->block_no,
+		      bcast_msg->block_len);
+		size_read += bcast_msg->block_len;
 		if (size_read >= f_stat.st_size)
-			bcast_msg.last_block = 1;
+			bcast_msg->last_block = 1;
 
-		send_rpc(&bcast_msg, sbcast_cred);
-		if (bcast_msg.last_block)
+		if (params.compress && bcast_msg->block_len) {
+			comp_buf = xmalloc(bcast_msg->block_len);
+			comp_len = lz_compress(buffer, bcast_msg->block_len,
+					       comp_buf,
+					       bcast_msg->block_len - 1);
+			if (comp_len) {
+				debug2("block %d compressed to %u bytes",
+				       bcast_msg->block_no, comp_len);
+				xfree(buffer);
+				bcast_msg->block     = comp_buf;
+				bcast_msg->block_len = comp_len;
+				bcast_msg->compress  = COMPRESS_LZ;
+			} else
+				xfree(comp_buf);
+		}
+
+		/* bcast_msg belongs to the agent once sent */
+		last_block = bcast_msg->last_block;
+		if (last_block && (block_no > 1))
+			send_rpc_wait();
+		send_rpc(bcast_msg, sbcast_cred);
+		if (last_block || (block_no == 1))
+			send_rpc_wait();
+		if (last_block)
 			break;	/* end of file */
-		bcast_msg.block_no++;
+		block_no++;
 	}
-
-	xfree(buffer);
 }
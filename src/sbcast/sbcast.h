@@ -65,5 +65,6 @@ extern struct sbcast_parameters params;
 extern void parse_command_line(int argc, char *argv[]);
 extern void send_rpc(file_bcast_msg_t *bcast_msg,
 		     job_sbcast_cred_msg_t *sbcast_cred);
+extern void send_rpc_wait(void);
 
 #endif
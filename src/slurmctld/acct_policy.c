@@ -57,6 +57,12 @@ enum {
 	ACCT_POLICY_JOB_FINI
 };
 
+/* Bumped whenever association or QOS limits are changed or the
+ * records themselves are replaced, which invalidates every job's
+ * cached limit wait.  Zero is never used so a fresh job record
+ * never looks cached. */
+static uint32_t limit_epoch = 1;
+
 static void _cancel_job(struct job_record *job_ptr)
 {
 	time_t now = time(NULL);
@@ -102,6 +108,35 @@ static bool _valid_job_assoc(struct job_record *job_ptr)
 	return true;
 }
 
+/*
+ * _cached_wait - Return true if the job was held by a usage limit on an
+ *	earlier pass and nothing that could lift it has happened since.
+ *	Usage only goes down when a job finishes, which bumps the
+ *	release_gen of its QOS and every association up the chain.
+ */
+static bool _cached_wait(struct job_record *job_ptr)
+{
+	bool rc = false;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
+				   READ_LOCK, NO_LOCK, NO_LOCK };
+
+	if (job_ptr->limit_wait_epoch == 0)
+		return false;
+
+	/* The epoch is only changed under the assoc_mgr write lock,
+	 * before any removed record is freed, so the counter is safe
+	 * to read while the epoch still matches */
+	assoc_mgr_lock(&locks);
+	if ((job_ptr->limit_wait_epoch == limit_epoch) &&
+	    (*job_ptr->limit_wait_gen_ptr == job_ptr->limit_wait_gen))
+		rc = true;
+	assoc_mgr_unlock(&locks);
+
+	if (rc)
+		job_ptr->state_reason = job_ptr->limit_wait_reason;
+	return rc;
+}
+
 static void _adjust_limit_usage(int type, struct job_record *job_ptr)
 {
 	slurmdb_association_rec_t *assoc_ptr = NULL;
@@ -162,6 +197,7 @@ static void _adjust_limit_usage(int type, struct job_record *job_ptr)
 			used_limits->jobs++;
 			break;
 		case ACCT_POLICY_JOB_FINI:
+			qos_ptr->usage->release_gen++;
 			if(qos_ptr->usage->grp_used_jobs)
 				qos_ptr->usage->grp_used_jobs--;
 			else
@@ -216,6 +252,7 @@ static void _adjust_limit_usage(int type, struct job_record *job_ptr)
 			assoc_ptr->usage->grp_used_nodes += job_ptr->node_cnt;
 			break;
 		case ACCT_POLICY_JOB_FINI:
+			assoc_ptr->usage->release_gen++;
 			if (assoc_ptr->usage->used_jobs)
 				assoc_ptr->usage->used_jobs--;
 			else
@@ -286,6 +323,24 @@ extern void acct_policy_job_fini(struct job_record *job_ptr)
 	_adjust_limit_usage(ACCT_POLICY_JOB_FINI, job_ptr);
 }
 
+/*
+ * acct_policy_limits_changed - Note that association or QOS limits
+ *	were modified or the records reloaded, so any job held by a
+ *	limit must be evaluated again.
+ *	Call before a removed record is freed, or with the job write lock
+ *	held across the reload. Takes the assoc_mgr write lock.
+ */
+extern void acct_policy_limits_changed(void)
+{
+	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
+				   WRITE_LOCK, NO_LOCK, NO_LOCK };
+
+	assoc_mgr_lock(&locks);
+	if (++limit_epoch == 0)
+		limit_epoch = 1;
+	assoc_mgr_unlock(&locks);
+}
+
 extern bool acct_policy_validate(job_desc_msg_t *job_desc,
 				 struct part_record *part_ptr,
 				 slurmdb_association_rec_t *assoc_in,
@@ -803,6 +858,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 	int parent = 0; /*flag to tell us if we are looking at the
 			 * parent or not
 			 */
+	uint32_t *wait_gen = NULL;
 	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
 
@@ -819,6 +875,10 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 	if (!(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return true;
 
+	if (_cached_wait(job_ptr))
+		return false;
+	job_ptr->limit_wait_epoch = 0;
+
 	/* clear old state reason */
         if ((job_ptr->state_reason == WAIT_ASSOC_JOB_LIMIT) ||
 	    (job_ptr->state_reason == WAIT_ASSOC_RESOURCE_LIMIT) ||
@@ -882,6 +942,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 				       qos_ptr->usage->grp_used_cpus,
 				       job_ptr->details->min_cpus,
 				       qos_ptr->name);
+				wait_gen = &qos_ptr->usage->release_gen;
 				rc = false;
 				goto end_it;
 			}
@@ -897,7 +958,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 			       job_ptr->job_id,
 			       qos_ptr->grp_jobs,
 			       qos_ptr->usage->grp_used_jobs, qos_ptr->name);
-
+			wait_gen = &qos_ptr->usage->release_gen;
 			rc = false;
 			goto end_it;
 		}
@@ -934,6 +995,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 				       qos_ptr->usage->grp_used_nodes,
 				       job_ptr->details->min_nodes,
 				       qos_ptr->name);
+				wait_gen = &qos_ptr->usage->release_gen;
 				rc = false;
 				goto end_it;
 			}
@@ -1007,6 +1069,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 				       job_ptr->job_id,
 				       qos_ptr->max_jobs_pu,
 				       used_limits->jobs, qos_ptr->name);
+				wait_gen = &qos_ptr->usage->release_gen;
 				rc = false;
 				goto end_it;
 			}
@@ -1110,6 +1173,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 				       assoc_ptr->usage->grp_used_cpus,
 				       job_ptr->details->min_cpus,
 				       assoc_ptr->acct);
+				wait_gen = &assoc_ptr->usage->release_gen;
 				rc = false;
 				goto end_it;
 			}
@@ -1127,7 +1191,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 			       job_ptr->job_id, assoc_ptr->id,
 			       assoc_ptr->grp_jobs,
 			       assoc_ptr->usage->used_jobs, assoc_ptr->acct);
-
+			wait_gen = &assoc_ptr->usage->release_gen;
 			rc = false;
 			goto end_it;
 		}
@@ -1167,6 +1231,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 				       assoc_ptr->usage->grp_used_nodes,
 				       job_ptr->details->min_nodes,
 				       assoc_ptr->acct);
+				wait_gen = &assoc_ptr->usage->release_gen;
 				rc = false;
 				goto end_it;
 			}
@@ -1248,6 +1313,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 			       job_ptr->job_id, assoc_ptr->id,
 			       assoc_ptr->max_jobs,
 			       assoc_ptr->usage->used_jobs, assoc_ptr->acct);
+			wait_gen = &assoc_ptr->usage->release_gen;
 			rc = false;
 			goto end_it;
 		}
@@ -1296,6 +1362,16 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 		parent = 1;
 	}
 end_it:
+	if (wait_gen && !cancel_job) {
+		/* Remember what is holding the job.  Until a job in
+		 * that association or QOS finishes (or the limits are
+		 * changed) there is no point in walking the limits
+		 * again, see _cached_wait() */
+		job_ptr->limit_wait_gen_ptr = wait_gen;
+		job_ptr->limit_wait_gen = *wait_gen;
+		job_ptr->limit_wait_epoch = limit_epoch;
+		job_ptr->limit_wait_reason = job_ptr->state_reason;
+	}
 	assoc_mgr_unlock(&locks);
 
 	if(cancel_job)
@@ -1333,6 +1409,7 @@ extern int acct_policy_update_pending_job(struct job_record *job_ptr)
 		error("acct_policy_update_pending_job: no details");
 		return SLURM_ERROR;
 	}
+	job_ptr->limit_wait_epoch = 0;
 
 	/* set up the job desc to make sure things are the way we
 	 * need.
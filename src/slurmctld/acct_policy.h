@@ -66,6 +66,15 @@ extern void acct_policy_job_begin(struct job_record *job_ptr);
  */
 extern void acct_policy_job_fini(struct job_record *job_ptr);
 
+/*
+ * acct_policy_limits_changed - Note that association or QOS limits
+ *	were modified or the records reloaded, so any job held by a
+ *	limit must be evaluated again.
+ *	Call before a removed record is freed, or with the job write lock
+ *	held across the reload. Takes the assoc_mgr write lock.
+ */
+extern void acct_policy_limits_changed(void);
+
 extern bool acct_policy_validate(job_desc_msg_t *job_desc,
 				 struct part_record *part_ptr,
 				 slurmdb_association_rec_t *assoc_in,
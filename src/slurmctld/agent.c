@@ -832,6 +832,8 @@ static void *_thread_per_group_rpc(void *args)
 	slurm_msg_t_init(&msg);
 	msg.msg_type = msg_type;
 	msg.data     = task_ptr->msg_args_ptr;
+	if (!srun_agent)
+		slurm_msg_set_r_uid(&msg, slurm_get_slurmd_user_id());
 #if 0
  	info("sending message type %u to %s", msg_type, thread_ptr->nodelist);
 #endif
@@ -195,6 +195,8 @@ static void         _init_config(void);
 static void         _init_pidfile(void);
 static void         _kill_old_slurmctld(void);
 static void         _parse_commandline(int argc, char *argv[]);
+static bool         _persist_conn_allowed(void);
+static bool         _persist_conn_wait(slurm_fd_t fd);
 inline static int   _ping_backup_controller(void);
 static void         _remove_assoc(slurmdb_association_rec_t *rec);
 static void         _remove_qos(slurmdb_qos_rec_t *rec);
@@ -994,35 +996,59 @@ static void *_service_connection(void *arg)
 {
 	connection_arg_t *conn = (connection_arg_t *) arg;
 	void *return_code = NULL;
-	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	slurm_msg_t *msg;
+	uint16_t msg_type;
+	uint64_t allocs[2], bytes[2];
+	bool keep;
+
+	/* A persistent connection is serviced by this thread until it is
+	 * idle for too long, unless we are short of server threads or
+	 * running in the RPC manager thread itself */
+	do {
+		keep = false;
+		xmalloc_thread_stats(&allocs[0], &bytes[0]);
+		msg = xmalloc(sizeof(slurm_msg_t));
+		slurm_msg_t_init(msg);
+		/*
+		 * slurm_receive_msg sets msg connection fd to accepted fd.
+		 * This allows possibility for slurmctld_req() to close
+		 * accepted connection.
+		 */
+		if(slurm_receive_msg(conn->newsockfd, msg, 0) != 0) {
+			error("slurm_receive_msg: %m");
+			/* close should only be called when the socket
+			 * implementation is being used the following call
+			 * will be a no-op in a message/mongo implementation */
+			/* close the new socket */
+			slurm_close_accepted_conn(conn->newsockfd);
+			goto cleanup;
+		}
 
-	slurm_msg_t_init(msg);
-	/*
-	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
-	 * possibility for slurmctld_req() to close accepted connection.
-	 */
-	if(slurm_receive_msg(conn->newsockfd, msg, 0) != 0) {
-		error("slurm_receive_msg: %m");
-		/* close should only be called when the socket implementation
-		 * is being used the following call will be a no-op in a
-		 * message/mongo implementation */
-		/* close the new socket */
-		slurm_close_accepted_conn(conn->newsockfd);
-		goto cleanup;
-	}
+		if(errno != SLURM_SUCCESS) {
+			if (errno == SLURM_PROTOCOL_VERSION_ERROR) {
+				slurm_send_rc_msg(msg,
+						  SLURM_PROTOCOL_VERSION_ERROR);
+			} else
+				info("_service_connection/slurm_receive_msg %m");
+		} else {
+			keep = slurm_persist_conn_keep(msg,
+						       _persist_conn_allowed());
+			/* process the request */
+			slurmctld_req(msg);
+		}
+		msg_type = msg->msg_type;
+		slurm_free_msg(msg);
+		xmalloc_thread_stats(&allocs[1], &bytes[1]);
+		rpc_alloc_record(msg_type, allocs[1] - allocs[0],
+				 bytes[1] - bytes[0]);
+	} while (keep && _persist_conn_wait(conn->newsockfd));
 
-	if(errno != SLURM_SUCCESS) {
-		if (errno == SLURM_PROTOCOL_VERSION_ERROR) {
-			slurm_send_rc_msg(msg, SLURM_PROTOCOL_VERSION_ERROR);
-		} else
-			info("_service_connection/slurm_receive_msg %m");
-	} else {
-		/* process the request */
-		slurmctld_req(msg);
-	}
 	if ((conn->newsockfd >= 0)
 	    && slurm_close_accepted_conn(conn->newsockfd) < 0)
 		error ("close(%d): %m",  conn->newsockfd);
+	xfree(arg);
+	_free_server_thread();
+	return return_code;
 
 cleanup:
 	slurm_free_msg(msg);
@@ -1031,6 +1057,39 @@ cleanup:
 	return return_code;
 }
 
+/* Persistent connections each hold a server thread while idle, only
+ * keep them while at most half of the threads are in use */
+static bool _persist_conn_allowed(void)
+{
+	bool rc;
+
+	if (pthread_equal(pthread_self(), slurmctld_config.thread_id_rpc))
+		return false;
+	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+	rc = ((slurmctld_config.shutdown_time == 0) &&
+	      (slurmctld_config.server_thread_count <=
+	       (max_server_threads / 2)));
+	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+	return rc;
+}
+
+/* Wait for the next request on a persistent connection, RET true if one
+ * arrives before the connection is idle for MessagePersistTimeout plus
+ * MessageTimeout seconds, which leaves clients time to stop using it */
+static bool _persist_conn_wait(slurm_fd_t fd)
+{
+	int i, rc, idle;
+
+	idle = slurm_get_msg_persist_timeout() + slurm_get_msg_timeout();
+	for (i = 0; i < idle; i++) {
+		if (slurmctld_config.shutdown_time)
+			break;
+		if ((rc = slurm_persist_conn_wait(fd, 1000)))
+			return (rc > 0);
+	}
+	return false;
+}
+
 /* Increment slurmctld_config.server_thread_count and don't return
  * until its value is no larger than MAX_SERVER_THREADS,
  * RET true unless shutdown in progress */
@@ -1185,6 +1244,7 @@ static void _remove_assoc(slurmdb_association_rec_t *rec)
 {
 	int cnt = 0;
 
+	acct_policy_limits_changed();
 	cnt = job_cancel_by_assoc_id(rec->id);
 
 	if (cnt) {
@@ -1198,6 +1258,7 @@ static void _remove_qos(slurmdb_qos_rec_t *rec)
 {
 	int cnt = 0;
 
+	acct_policy_limits_changed();
 	cnt = job_cancel_by_qos_id(rec->id);
 
 	if (cnt) {
@@ -1214,6 +1275,7 @@ static void _update_assoc(slurmdb_association_rec_t *rec)
 	slurmctld_lock_t job_write_lock =
 		{ NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
 
+	acct_policy_limits_changed();
 	if (!job_list || !accounting_enforce
 	    || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
@@ -1238,6 +1300,7 @@ static void _update_qos(slurmdb_qos_rec_t *rec)
 	slurmctld_lock_t job_write_lock =
 		{ NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
 
+	acct_policy_limits_changed();
 	if (!job_list || !accounting_enforce
 	    || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
@@ -1276,6 +1339,7 @@ static void *_slurmctld_background(void *no_data)
 	static time_t last_node_acct;
 	static time_t last_ctld_bu_ping;
 	static time_t last_uid_update;
+	static time_t last_alloc_report;
 	static bool ping_msg_sent = false;
 	time_t now;
 	int no_resp_msg_interval, ping_interval, purge_job_interval;
@@ -1311,7 +1375,7 @@ static void *_slurmctld_background(void *no_data)
 	last_purge_job_time = last_trigger = last_health_check_time = now;
 	last_timelimit_time = last_assert_primary_time = now;
 	last_no_resp_msg_time = last_resv_time = last_ctld_bu_ping = now;
-	last_uid_update = now;
+	last_uid_update = last_alloc_report = now;
 
 	if ((slurmctld_conf.min_job_age > 0) &&
 	    (slurmctld_conf.min_job_age < PURGE_JOB_INTERVAL)) {
@@ -1505,6 +1569,12 @@ static void *_slurmctld_background(void *no_data)
 			_accounting_cluster_ready();
 		}
 
+		if (difftime(now, last_alloc_report) >= PERIODIC_ALLOC_REPORT) {
+			now = time(NULL);
+			last_alloc_report = now;
+			rpc_alloc_report();
+		}
+
 		/* Reassert this machine as the primary controller.
 		 * A network or security problem could result in
 		 * the backup controller assuming control even
@@ -1965,6 +2035,7 @@ static void *_assoc_cache_mgr(void *no_data)
 		}
 		lock_slurmctld(job_write_lock);
 		assoc_mgr_refresh_lists(acct_db_conn, NULL);
+		acct_policy_limits_changed();
 		if(running_cache)
 			unlock_slurmctld(job_write_lock);
 		slurm_mutex_unlock(&assoc_cache_mutex);
@@ -79,7 +79,8 @@ enum gs_flags {
 	GS_SUCCESS,
 	GS_ACTIVE,
 	GS_NO_ACTIVE,
-	GS_FILLER
+	GS_FILLER,
+	GS_NO_SIG
 };
 
 struct gs_job {
@@ -87,6 +88,9 @@ struct gs_job {
 	struct job_record *job_ptr;
 	uint16_t sig_state;
 	uint16_t row_state;
+	uint16_t sig_pending;	/* signal deferred until _flush_sig_queue() */
+	bool sig_queued;	/* record is in gs_sig_queue */
+	struct gs_job *hash_next;
 };
 
 struct gs_part {
@@ -102,6 +106,8 @@ struct gs_part {
 	bitstr_t *active_resmap;
 	uint16_t *active_cpus;
 	uint16_t array_size;
+	struct gs_job **job_hash; /* job_list records hashed by job_id */
+	bool row_dirty;		/* active row must be rebuilt */
 	struct gs_part *next;
 };
 
@@ -138,6 +144,18 @@ struct gs_part {
  * are applied first.
  *
  ******************************************
+ *
+ *	Incremental Updates
+ *
+ * A partition's active row is only rebuilt by _update_all_active_rows()
+ * when it is flagged "row_dirty": a job left the partition, or the set of
+ * shadows cast upon it changed. Job suspend/resume operations are not
+ * issued as they are decided, but queued in gs_sig_queue and issued once
+ * at the end of each pass by _flush_sig_queue(). A suspend and resume of
+ * the same job within one pass cancel each other, and all suspends are
+ * issued before any resumes.
+ *
+ ******************************************
  */
 
 
@@ -153,7 +171,16 @@ static pthread_mutex_t data_mutex = PTHREAD_MUTEX_INITIALIZER;
 static uint16_t *gs_bits_per_node = NULL;
 static uint32_t num_sorted_part = 0;
 
+#define GS_JOB_HASH_SIZE	1024
+#define GS_JOB_HASH_INX(_job_id) (_job_id % GS_JOB_HASH_SIZE)
+
+/* jobs with a deferred suspend or resume, see _queue_sig() */
+static struct gs_job **gs_sig_queue = NULL;
+static uint32_t gs_sig_cnt = 0;
+static uint32_t gs_sig_size = 0;
+
 /* function declarations */
+static int _sort_partitions(void *part1, void *part2);
 static void *_timeslicer_thread(void *arg);
 
 static char *_print_flag(int flag)
@@ -173,6 +200,8 @@ static char *_print_flag(int flag)
 			return "GS_NO_ACTIVE";
 		case GS_FILLER:
 			return "GS_FILLER";
+		case GS_NO_SIG:
+			return "GS_NO_SIG";
 		default:
 			return "unknown";
 	}
@@ -308,6 +337,7 @@ static void _destroy_parts(void *x)
 	FREE_NULL_BITMAP(gs_part_ptr->active_resmap);
 	xfree(gs_part_ptr->active_cpus);
 	xfree(gs_part_ptr->job_list);
+	xfree(gs_part_ptr->job_hash);
 	xfree(gs_part_ptr);
 }
 
@@ -341,10 +371,17 @@ static void _build_parts(void)
 		gs_part_ptr = xmalloc(sizeof(struct gs_part));
 		gs_part_ptr->part_name = xstrdup(p_ptr->name);
 		gs_part_ptr->priority = p_ptr->priority;
+		gs_part_ptr->row_dirty = true;
 		/* everything else is already set to zero/NULL */
 		list_append(gs_part_list, gs_part_ptr);
 	}
 	list_iterator_destroy(part_iterator);
+
+	/* Partition priorities only change on reconfiguration, so sort the
+	 * list here rather than on every pass. This way the shadows of any
+	 * high-priority jobs are appropriately adjusted before the lower
+	 * priority partitions are updated */
+	list_sort(gs_part_list, _sort_partitions);
 }
 
 /* Find the gs_part entity with the given name */
@@ -357,10 +394,29 @@ static int _find_gs_part(void *x, void *key)
 	return 0;
 }
 
+/* Find the gs_job record of the given job_id in the given partition */
+static struct gs_job *_find_gs_job(struct gs_part *p_ptr, uint32_t job_id)
+{
+	struct gs_job *j_ptr;
+
+	if (!p_ptr->job_hash)
+		return NULL;
+	j_ptr = p_ptr->job_hash[GS_JOB_HASH_INX(job_id)];
+	while (j_ptr) {
+		if (j_ptr->job_id == job_id)
+			return j_ptr;
+		j_ptr = j_ptr->hash_next;
+	}
+	return NULL;
+}
+
 /* Find the job_list index of the given job_id in the given partition */
 static int _find_job_index(struct gs_part *p_ptr, uint32_t job_id)
 {
 	int i;
+
+	if (!_find_gs_job(p_ptr, job_id))
+		return -1;
 	for (i = 0; i < p_ptr->num_jobs; i++) {
 		if (p_ptr->job_list[i]->job_ptr->job_id == job_id)
 			return i;
@@ -368,6 +424,35 @@ static int _find_job_index(struct gs_part *p_ptr, uint32_t job_id)
 	return -1;
 }
 
+static void _add_gs_job_hash(struct gs_part *p_ptr, struct gs_job *j_ptr)
+{
+	int inx = GS_JOB_HASH_INX(j_ptr->job_id);
+
+	if (!p_ptr->job_hash) {
+		p_ptr->job_hash = xmalloc(GS_JOB_HASH_SIZE *
+					  sizeof(struct gs_job *));
+	}
+	j_ptr->hash_next = p_ptr->job_hash[inx];
+	p_ptr->job_hash[inx] = j_ptr;
+}
+
+static void _del_gs_job_hash(struct gs_part *p_ptr, struct gs_job *j_ptr)
+{
+	struct gs_job **j_pptr;
+
+	if (!p_ptr->job_hash)
+		return;
+	j_pptr = &p_ptr->job_hash[GS_JOB_HASH_INX(j_ptr->job_id)];
+	while (*j_pptr) {
+		if (*j_pptr == j_ptr) {
+			*j_pptr = j_ptr->hash_next;
+			break;
+		}
+		j_pptr = &(*j_pptr)->hash_next;
+	}
+	j_ptr->hash_next = NULL;
+}
+
 /* Return 1 if job "cpu count" fits in this row, else return 0 */
 static int _can_cpus_fit(struct job_record *job_ptr, struct gs_part *p_ptr)
 {
@@ -591,6 +676,80 @@ static void _resume_job(uint32_t job_id)
 	}
 }
 
+/* Defer a suspend (GS_SUSPEND) or resume (GS_RESUME) of the given job
+ * until _flush_sig_queue(). A later request for the opposite operation
+ * within the same pass cancels the earlier one. */
+static void _queue_sig(struct gs_job *j_ptr, uint16_t sig)
+{
+	if (!j_ptr->sig_queued) {
+		if (gs_sig_cnt >= gs_sig_size) {
+			if (gs_sig_size == 0)
+				gs_sig_size = default_job_list_size;
+			else
+				gs_sig_size *= 2;
+			xrealloc(gs_sig_queue, gs_sig_size *
+				 sizeof(struct gs_job *));
+		}
+		gs_sig_queue[gs_sig_cnt++] = j_ptr;
+		j_ptr->sig_queued  = true;
+		j_ptr->sig_pending = sig;
+	} else if (j_ptr->sig_pending == GS_NO_SIG) {
+		j_ptr->sig_pending = sig;
+	} else if (j_ptr->sig_pending != sig) {
+		j_ptr->sig_pending = GS_NO_SIG;
+	}
+}
+
+/* Remove the given job from gs_sig_queue (e.g. before it is freed).
+ * Return the signal which was pending for it, if any */
+static uint16_t _dequeue_sig(struct gs_job *j_ptr)
+{
+	int i;
+
+	if (!j_ptr->sig_queued)
+		return GS_NO_SIG;
+	for (i = 0; i < gs_sig_cnt; i++) {
+		if (gs_sig_queue[i] == j_ptr) {
+			gs_sig_queue[i] = NULL;
+			break;
+		}
+	}
+	j_ptr->sig_queued = false;
+	return j_ptr->sig_pending;
+}
+
+/* Issue all suspend and resume operations queued by _queue_sig().
+ * Suspends are issued first so that the resources they release are
+ * available to the jobs being resumed. */
+static void _flush_sig_queue(void)
+{
+	int i, suspend_cnt = 0, resume_cnt = 0;
+	struct gs_job *j_ptr;
+
+	for (i = 0; i < gs_sig_cnt; i++) {
+		j_ptr = gs_sig_queue[i];
+		if (j_ptr && (j_ptr->sig_pending == GS_SUSPEND)) {
+			_suspend_job(j_ptr->job_id);
+			suspend_cnt++;
+		}
+	}
+	for (i = 0; i < gs_sig_cnt; i++) {
+		j_ptr = gs_sig_queue[i];
+		if (!j_ptr)
+			continue;
+		if (j_ptr->sig_pending == GS_RESUME) {
+			_resume_job(j_ptr->job_id);
+			resume_cnt++;
+		}
+		j_ptr->sig_queued = false;
+	}
+	if ((gs_debug_flags & DEBUG_FLAG_GANG) && gs_sig_cnt) {
+		info("gang: _flush_sig_queue: %u queued, %d suspended, "
+		     "%d resumed", gs_sig_cnt, suspend_cnt, resume_cnt);
+	}
+	gs_sig_cnt = 0;
+}
+
 void _preempt_job_list_del(void *x)
 {
 	xfree(x);
@@ -728,6 +887,7 @@ static void _cast_shadow(struct gs_job *j_ptr, uint16_t priority)
 						sizeof(struct gs_job *));
 		}
 		p_ptr->shadow[p_ptr->num_shadows++] = j_ptr;
+		p_ptr->row_dirty = true;
 	}
 	list_iterator_destroy(part_iterator);
 }
@@ -756,6 +916,7 @@ static void _clear_shadow(struct gs_job *j_ptr)
 			continue;
 
 		p_ptr->num_shadows--;
+		p_ptr->row_dirty = true;
 
 		/* shift all other jobs down */
 		for (; i < p_ptr->num_shadows; i++)
@@ -780,6 +941,9 @@ static void _update_active_row(struct gs_part *p_ptr, int add_new_jobs)
 		info("gang: update_active_row: rebuilding part %s...",
 		     p_ptr->part_name);
 	}
+	/* shadows cast below only affect lower priority partitions */
+	if (add_new_jobs)
+		p_ptr->row_dirty = false;
 	/* rebuild the active row, starting with any shadows */
 	p_ptr->jobs_active = 0;
 	for (i = 0; p_ptr->shadow && p_ptr->shadow[i]; i++) {
@@ -804,7 +968,7 @@ static void _update_active_row(struct gs_part *p_ptr, int add_new_jobs)
 				     PREEMPT_MODE_SUSPEND)) {
 					_preempt_job_queue(j_ptr->job_id);
 				} else
-					_suspend_job(j_ptr->job_id);
+					_queue_sig(j_ptr, GS_SUSPEND);
 				j_ptr->sig_state = GS_SUSPEND;
 				_clear_shadow(j_ptr);
 			}
@@ -828,7 +992,7 @@ static void _update_active_row(struct gs_part *p_ptr, int add_new_jobs)
 				     PREEMPT_MODE_SUSPEND)) {
 					_preempt_job_queue(j_ptr->job_id);
 				} else
-					_suspend_job(j_ptr->job_id);
+					_queue_sig(j_ptr, GS_SUSPEND);
 				j_ptr->sig_state = GS_SUSPEND;
 				_clear_shadow(j_ptr);
 			}
@@ -852,33 +1016,33 @@ static void _update_active_row(struct gs_part *p_ptr, int add_new_jobs)
 			j_ptr->row_state = GS_FILLER;
 			/* resume the job */
 			if (j_ptr->sig_state == GS_SUSPEND) {
-				_resume_job(j_ptr->job_id);
+				_queue_sig(j_ptr, GS_RESUME);
 				j_ptr->sig_state = GS_RESUME;
 			}
 		}
 	}
 }
 
-/* rebuild all active rows without reordering jobs:
+/* rebuild the active rows flagged as dirty without reordering jobs:
  * - attempt to preserve running jobs
  * - suspend any jobs that have been "shadowed" (preempted)
  * - resume any "filler" jobs that can be found
+ * gs_part_list is sorted by descending priority, so any shadows cast
+ * while updating one partition are applied to the lower priority
+ * partitions which follow it.
  */
 static void _update_all_active_rows(void)
 {
 	ListIterator part_iterator;
  	struct gs_part *p_ptr;
 
-	/* Sort the partitions. This way the shadows of any high-priority
-	 * jobs are appropriately adjusted before the lower priority
-	 * partitions are updated */
-	list_sort(gs_part_list, _sort_partitions);
-
 	part_iterator = list_iterator_create(gs_part_list);
 	if (part_iterator == NULL)
 		fatal("memory allocation failure");
-	while ((p_ptr = (struct gs_part *) list_next(part_iterator)))
-		_update_active_row(p_ptr, 1);
+	while ((p_ptr = (struct gs_part *) list_next(part_iterator))) {
+		if (p_ptr->row_dirty)
+			_update_active_row(p_ptr, 1);
+	}
 	list_iterator_destroy(part_iterator);
 }
 
@@ -892,6 +1056,8 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
 {
 	int i;
 	struct gs_job *j_ptr;
+	uint16_t sig_pending;
+	bool suspended;
 
 	if (!job_id || !p_ptr)
 		return;
@@ -917,9 +1083,22 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
 		p_ptr->job_list[i] = p_ptr->job_list[i+1];
 	}
 	p_ptr->job_list[i] = NULL;
+	_del_gs_job_hash(p_ptr, j_ptr);
+	/* the released resources may now be used by other jobs */
+	p_ptr->row_dirty = true;
+
+	/* a queued suspend or resume has not been issued yet, so the
+	 * job's actual state is the opposite of a pending sig_state */
+	sig_pending = _dequeue_sig(j_ptr);
+	if (sig_pending == GS_SUSPEND)
+		suspended = false;
+	else if (sig_pending == GS_RESUME)
+		suspended = true;
+	else
+		suspended = (j_ptr->sig_state == GS_SUSPEND);
 
 	/* make sure the job is not suspended, and then delete it */
-	if (!fini && (j_ptr->sig_state == GS_SUSPEND)) {
+	if (!fini && suspended) {
 		if (gs_debug_flags & DEBUG_FLAG_GANG) {
 			info("gang: _remove_job_from_part: resuming "
 			     "suspended job %u", j_ptr->job_id);
@@ -939,7 +1118,6 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
 static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 				 struct job_record *job_ptr)
 {
-	int i;
 	struct gs_job *j_ptr;
 
 	xassert(p_ptr);
@@ -962,8 +1140,7 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 	}
 
 	/* protect against duplicates */
-	i = _find_job_index(p_ptr, job_ptr->job_id);
-	if (i >= 0) {
+	if (_find_gs_job(p_ptr, job_ptr->job_id)) {
 		/* This job already exists, but the resource allocation
 		 * may have changed. In any case, remove the existing
 		 * job before adding this new one.
@@ -993,6 +1170,7 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 
 	/* append this job to the job_list */
 	p_ptr->job_list[p_ptr->num_jobs++] = j_ptr;
+	_add_gs_job_hash(p_ptr, j_ptr);
 
 	/* determine the immediate fate of this job (run or suspend) */
 	if (_job_fits_in_active_row(job_ptr, p_ptr)) {
@@ -1020,7 +1198,7 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 		     PREEMPT_MODE_SUSPEND)) {
 			_preempt_job_queue(job_ptr->job_id);
 		} else
-			_suspend_job(job_ptr->job_id);
+			_queue_sig(j_ptr, GS_SUSPEND);
 		j_ptr->sig_state = GS_SUSPEND;
 	}
 
@@ -1037,7 +1215,6 @@ static void _scan_slurm_job_list(void)
 {
 	struct job_record *job_ptr;
 	struct gs_part *p_ptr;
-	int i;
 	ListIterator job_iterator;
 
 	if (!job_list) {	/* no jobs */
@@ -1066,9 +1243,8 @@ static void _scan_slurm_job_list(void)
 						job_ptr->partition);
 			if (!p_ptr) /* no partition */
 				continue;
-			i = _find_job_index(p_ptr, job_ptr->job_id);
-			if (i >= 0) /* we're tracking it, so continue */
-				continue;
+			if (_find_gs_job(p_ptr, job_ptr->job_id))
+				continue;	/* we're tracking it */
 
 			/* We're not tracking this job. Resume it if it's
 			 * suspended, and then add it to the job list. */
@@ -1170,6 +1346,7 @@ extern int gs_init(void)
 	_build_parts();
 	/* load any currently running jobs */
 	_scan_slurm_job_list();
+	_flush_sig_queue();
 	pthread_mutex_unlock(&data_mutex);
 
 	/* spawn the timeslicer thread */
@@ -1203,6 +1380,8 @@ extern int gs_fini(void)
 	list_destroy(gs_part_list);
 	gs_part_list = NULL;
 	xfree(gs_bits_per_node);
+	xfree(gs_sig_queue);
+	gs_sig_cnt = gs_sig_size = 0;
 	pthread_mutex_unlock(&data_mutex);
 	if (gs_debug_flags & DEBUG_FLAG_GANG)
 		info("gang: leaving gs_fini");
@@ -1227,6 +1406,7 @@ extern int gs_job_start(struct job_record *job_ptr)
 		/* if this job is running then check for preemption */
 		if (job_state == GS_RESUME)
 			_update_all_active_rows();
+		_flush_sig_queue();
 	}
 	pthread_mutex_unlock(&data_mutex);
 
@@ -1253,6 +1433,7 @@ extern int gs_job_scan(void)
 		info("gang: entering gs_job_scan");
 	pthread_mutex_lock(&data_mutex);
 	_scan_slurm_job_list();
+	_flush_sig_queue();
 	pthread_mutex_unlock(&data_mutex);
 
 	_preempt_job_dequeue();	/* MUST BE OUTSIDE OF data_mutex lock */
@@ -1304,6 +1485,7 @@ extern int gs_job_fini(struct job_record *job_ptr)
 	/* this job may have preempted other jobs, so
 	 * check by updating all active rows */
 	_update_all_active_rows();
+	_flush_sig_queue();
 	pthread_mutex_unlock(&data_mutex);
 	if (gs_debug_flags & DEBUG_FLAG_GANG)
 		info("gang: leaving gs_job_fini");
@@ -1350,6 +1532,8 @@ extern int gs_reconfig(void)
 		info("gang: entering gs_reconfig");
 	pthread_mutex_lock(&data_mutex);
 
+	/* the queue references records in the old partition list */
+	_flush_sig_queue();
 	old_part_list = gs_part_list;
 	gs_part_list = NULL;
 
@@ -1426,6 +1610,7 @@ extern int gs_reconfig(void)
 	/* confirm all jobs. Scan the master job_list and confirm that we
 	 * are tracking all jobs */
 	_scan_slurm_job_list();
+	_flush_sig_queue();
 
 	list_destroy(old_part_list);
 	pthread_mutex_unlock(&data_mutex);
@@ -1491,6 +1676,8 @@ static void _cycle_job_list(struct gs_part *p_ptr)
 
 	if (gs_debug_flags & DEBUG_FLAG_GANG)
 		info("gang: entering _cycle_job_list");
+	/* the active row is rebuilt from scratch below */
+	p_ptr->row_dirty = false;
 	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE */
 	for (i = 0; i < p_ptr->num_jobs; i++) {
 		while (p_ptr->job_list[i]->row_state == GS_ACTIVE) {
@@ -1528,7 +1715,7 @@ static void _cycle_job_list(struct gs_part *p_ptr)
 			     PREEMPT_MODE_SUSPEND)) {
 				_preempt_job_queue(j_ptr->job_id);
 			} else
-				_suspend_job(j_ptr->job_id);
+				_queue_sig(j_ptr, GS_SUSPEND);
 			j_ptr->sig_state = GS_SUSPEND;
 			_clear_shadow(j_ptr);
 		}
@@ -1543,7 +1730,7 @@ static void _cycle_job_list(struct gs_part *p_ptr)
 		    		info("gang: _cycle_job_list: resuming job %u",
 				     j_ptr->job_id);
 			}
-			_resume_job(j_ptr->job_id);
+			_queue_sig(j_ptr, GS_RESUME);
 			j_ptr->sig_state = GS_RESUME;
 			_cast_shadow(j_ptr, p_ptr->priority);
 		}
@@ -1581,7 +1768,6 @@ static void *_timeslicer_thread(void *arg)
 
 		lock_slurmctld(job_write_lock);
 		pthread_mutex_lock(&data_mutex);
-		list_sort(gs_part_list, _sort_partitions);
 
 		/* scan each partition... */
 		if (gs_debug_flags & DEBUG_FLAG_GANG)
@@ -1601,6 +1787,10 @@ static void *_timeslicer_thread(void *arg)
 			}
 		}
 		list_iterator_destroy(part_iterator);
+		/* apply any shadows which were cast or cleared above to the
+		 * lower priority partitions which did not need cycling */
+		_update_all_active_rows();
+		_flush_sig_queue();
 		pthread_mutex_unlock(&data_mutex);
 
 		/* Preempt jobs that were formerly only suspended */
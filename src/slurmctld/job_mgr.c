@@ -112,6 +112,7 @@
 
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
+vector_t *job_vector = NULL;	/* job_record array, for full scans */
 time_t last_job_update;		/* time of last update to job records */
 
 /* Local variables */
@@ -237,6 +238,7 @@ struct job_record *create_job_record(int *error_code)
 			       * hasn't been set yet  */
 	if (list_append(job_list, job_ptr) == 0)
 		fatal("list_append memory allocation failure");
+	job_ptr->job_vector_inx = vector_append(job_vector, job_ptr);
 
 	return job_ptr;
 }
@@ -384,7 +386,7 @@ int dump_all_job_state(void)
 	/* Locks: Read config and job */
 	slurmctld_lock_t job_read_lock =
 		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	Buf buffer = init_buf(high_buffer_size);
 	time_t min_age = 0, now = time(NULL);
@@ -410,8 +412,7 @@ int dump_all_job_state(void)
 
 	/* write individual job records */
 	lock_slurmctld(job_read_lock);
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 		if ((min_age > 0) && (job_ptr->end_time < min_age) &&
 		    (! IS_JOB_COMPLETING(job_ptr)) && IS_JOB_FINISHED(job_ptr))
@@ -419,7 +420,6 @@ int dump_all_job_state(void)
 
 		_dump_job_state(job_ptr, buffer);
 	}
-	list_iterator_destroy(job_iterator);
 
 	/* write the buffer to file */
 	old_file = xstrdup(slurmctld_conf.state_save_location);
@@ -1939,7 +1939,8 @@ static void _rebuild_part_name_list(struct job_record  *job_ptr)
  */
 extern int kill_job_by_part_name(char *part_name)
 {
-	ListIterator job_iterator, part_iterator;
+	ListIterator part_iterator;
+	int job_inx = 0;
 	struct job_record  *job_ptr;
 	struct part_record *part_ptr, *part2_ptr;
 	int job_count = 0;
@@ -1949,8 +1950,7 @@ extern int kill_job_by_part_name(char *part_name)
 	if (part_ptr == NULL)	/* No such partition */
 		return 0;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		bool pending = false, suspended = false;
 
 		pending = IS_JOB_PENDING(job_ptr);
@@ -2026,7 +2026,6 @@ extern int kill_job_by_part_name(char *part_name)
 		job_ptr->part_ptr = NULL;
 		FREE_NULL_LIST(job_ptr->part_ptr_list);
 	}
-	list_iterator_destroy(job_iterator);
 
 	if (job_count)
 		last_job_update = now;
@@ -2043,7 +2042,7 @@ extern int kill_job_by_part_name(char *part_name)
 extern int kill_job_by_front_end_name(char *node_name)
 {
 #ifdef HAVE_FRONT_END
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record  *job_ptr;
 	struct node_record *node_ptr;
 	time_t now = time(NULL);
@@ -2052,8 +2051,7 @@ extern int kill_job_by_front_end_name(char *node_name)
 	if (node_name == NULL)
 		fatal("kill_job_by_front_end_name: node_name is NULL");
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		bool suspended = false;
 
 		if (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr) &&
@@ -2181,7 +2179,6 @@ extern int kill_job_by_front_end_name(char *node_name)
 			}
 		}
 	}
-	list_iterator_destroy(job_iterator);
 
 	if (job_count)
 		last_job_update = now;
@@ -2199,7 +2196,7 @@ extern int kill_job_by_front_end_name(char *node_name)
  */
 extern bool partition_in_use(char *part_name)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	struct part_record *part_ptr;
 
@@ -2207,18 +2204,13 @@ extern bool partition_in_use(char *part_name)
 	if (part_ptr == NULL)	/* No such partition */
 		return false;
 
-	job_iterator = list_iterator_create(job_list);
-	if (job_iterator == NULL)
-		fatal("list_iterator_create: malloc failure");
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (job_ptr->part_ptr == part_ptr) {
 			if (!IS_JOB_FINISHED(job_ptr)) {
-				list_iterator_destroy(job_iterator);
 				return true;
 			}
 		}
 	}
-	list_iterator_destroy(job_iterator);
 	return false;
 }
 
@@ -2230,7 +2222,7 @@ extern bool partition_in_use(char *part_name)
  */
 extern bool allocated_session_in_use(job_desc_msg_t *new_alloc)
 {
-	ListIterator job_iter;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	/* Locks: Read job */
 	slurmctld_lock_t job_read_lock = {
@@ -2240,11 +2232,8 @@ extern bool allocated_session_in_use(job_desc_msg_t *new_alloc)
 		return false;
 
 	lock_slurmctld(job_read_lock);
-	job_iter = list_iterator_create(job_list);
-	if (job_iter == NULL)
-		fatal("list_iterator_create: malloc failure");
 
-	while ((job_ptr = (struct job_record *)list_next(job_iter))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (job_ptr->batch_flag || IS_JOB_FINISHED(job_ptr))
 			continue;
 		if (job_ptr->alloc_node &&
@@ -2252,7 +2241,6 @@ extern bool allocated_session_in_use(job_desc_msg_t *new_alloc)
 		    (job_ptr->alloc_sid == new_alloc->alloc_sid))
 			break;
 	}
-	list_iterator_destroy(job_iter);
 	unlock_slurmctld(job_read_lock);
 
 	return job_ptr != NULL;
@@ -2266,7 +2254,7 @@ extern bool allocated_session_in_use(job_desc_msg_t *new_alloc)
  */
 extern int kill_running_job_by_node_name(char *node_name)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	struct node_record *node_ptr;
 	int bit_position;
@@ -2278,10 +2266,7 @@ extern int kill_running_job_by_node_name(char *node_name)
 		return 0;
 	bit_position = node_ptr - node_record_table_ptr;
 
-	job_iterator = list_iterator_create(job_list);
-	if (job_iterator == NULL)
-		fatal("list_iterator_create: malloc failure");
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		bool suspended = false;
 		if ((job_ptr->node_bitmap == NULL) ||
 		    (!bit_test(job_ptr->node_bitmap, bit_position)))
@@ -2415,7 +2400,6 @@ extern int kill_running_job_by_node_name(char *node_name)
 		}
 
 	}
-	list_iterator_destroy(job_iterator);
 	if (job_count)
 		last_job_update = now;
 
@@ -2664,6 +2648,7 @@ int init_job_conf(void)
 		job_list = list_create(_list_delete_job);
 		if (job_list == NULL)
 			fatal ("Memory allocation failure");
+		job_vector = vector_create(0);
 	}
 
 	last_job_update = time(NULL);
@@ -4716,7 +4701,7 @@ static bool _valid_pn_min_mem(job_desc_msg_t * job_desc_msg)
  */
 void job_time_limit(void)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	time_t now = time(NULL);
 	time_t old = now - (slurmctld_conf.inactive_limit * 4 / 3) +
@@ -4733,8 +4718,7 @@ void job_time_limit(void)
 		over_run = now - (slurmctld_conf.over_time_limit  * 60);
 
 	begin_job_resv_check();
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr =(struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		slurmdb_qos_rec_t *qos = NULL;
 		slurmdb_association_rec_t *assoc =	NULL;
 		assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
@@ -4954,7 +4938,6 @@ void job_time_limit(void)
 			srun_timeout (job_ptr);
 	}
 
-	list_iterator_destroy(job_iterator);
 	fini_job_resv_check();
 }
 
@@ -5123,6 +5106,7 @@ static void _list_delete_job(void *job_entry)
 	xassert(job_entry);
 	xassert (job_ptr->magic == JOB_MAGIC);
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
+	vector_remove(job_vector, job_ptr->job_vector_inx);
 
 	/* Remove the record from the hash table */
 	job_pptr = &job_hash[JOB_HASH_INX(job_ptr->job_id)];
@@ -5237,6 +5221,7 @@ static int _list_find_job_old(void *job_entry, void *key)
  * OUT buffer_size - set to size of the buffer in bytes
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
+ * IN compact - pack the job records with set_buf_compact()
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -5244,9 +5229,9 @@ static int _list_find_job_old(void *job_entry, void *key)
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid,
-			  uint16_t protocol_version)
+			  uint16_t protocol_version, bool compact)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	uint32_t jobs_packed = 0, tmp_offset;
 	Buf buffer;
@@ -5266,9 +5251,9 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 		min_age = now  - slurmctld_conf.min_job_age;
 
 	/* write individual job records */
+	set_buf_compact(buffer, compact);
 	part_filter_set(uid);
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 
 		if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
@@ -5290,7 +5275,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 		jobs_packed++;
 	}
 	part_filter_clear();
-	list_iterator_destroy(job_iterator);
+	set_buf_compact(buffer, false);
 
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
@@ -5318,7 +5303,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			uint32_t job_id, uint16_t show_flags, uid_t uid,
 			uint16_t protocol_version)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	uint32_t jobs_packed = 0;
 	Buf buffer;
@@ -5326,8 +5311,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (job_ptr->job_id != job_id)
 			continue;
 
@@ -5340,7 +5324,6 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 		jobs_packed++;
 		break;
 	}
-	list_iterator_destroy(job_iterator);
 	if (jobs_packed == 0)
 		return ESLURM_INVALID_JOB_ID;
 
@@ -5875,13 +5858,12 @@ static void _pack_pending_job_details(struct job_details *detail_ptr,
  */
 void purge_old_job(void)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record  *job_ptr;
 	time_t now = time(NULL);
 	int i;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (!IS_JOB_PENDING(job_ptr))
 			continue;
 		if (test_job_dependency(job_ptr) == 2) {
@@ -5896,7 +5878,6 @@ void purge_old_job(void)
 			srun_allocate_abort(job_ptr);
 		}
 	}
-	list_iterator_destroy(job_iterator);
 
 	i = list_delete_all(job_list, &_list_find_job_old, "");
 	if (i) {
@@ -5927,7 +5908,7 @@ static int _purge_job_record(uint32_t job_id)
  */
 void reset_job_bitmaps(void)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record  *job_ptr;
 	struct part_record *part_ptr;
 	List part_ptr_list = NULL;
@@ -5949,8 +5930,7 @@ void reset_job_bitmaps(void)
 	if (slurm_get_preempt_mode() == PREEMPT_MODE_GANG)
 		gang_flag = true;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 		job_fail = false;
 
@@ -6041,17 +6021,16 @@ void reset_job_bitmaps(void)
 		}
 	}
 
-	list_iterator_reset(job_iterator);
+	job_inx = 0;
 	/* This will reinitialize the select plugin database, which
 	 * we can only do after ALL job's states and bitmaps are set
 	 * (i.e. it needs to be in this second loop) */
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (select_g_select_nodeinfo_set(job_ptr) != SLURM_SUCCESS) {
 			error("select_g_select_nodeinfo_set(%u): %m",
 			      job_ptr->job_id);
 		}
 	}
-	list_iterator_destroy(job_iterator);
 
 	last_job_update = now;
 }
@@ -6194,7 +6173,7 @@ static void _set_job_prio(struct job_record *job_ptr)
  * priorities of all jobs to avoid decrementing the base down to zero */
 extern void sync_job_priorities(void)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	uint32_t prio_boost = 0;
 
@@ -6204,10 +6183,8 @@ extern void sync_job_priorities(void)
 	    (prio_boost < 1000000))
 		return;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator)))
+	while ((job_ptr = vector_next(job_vector, &job_inx)))
 		job_ptr->priority += prio_boost;
-	list_iterator_destroy(job_iterator);
 	lowest_prio += prio_boost;
 }
 
@@ -6216,18 +6193,16 @@ extern void sync_job_priorities(void)
  * which may have been held due to that node being unavailable */
 extern void reset_job_priority(void)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	int count = 0;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if ((job_ptr->priority == 1) && (!IS_JOB_FINISHED(job_ptr))) {
 			_set_job_prio(job_ptr);
 			count++;
 		}
 	}
-	list_iterator_destroy(job_iterator);
 	if (count)
 		last_job_update = time(NULL);
 }
@@ -6265,13 +6240,11 @@ static bool _top_priority(struct job_record *job_ptr)
 	if (job_ptr->priority == 0)	/* user held */
 		top = false;
 	else {
-		ListIterator job_iterator;
+		int job_inx = 0;
 		struct job_record *job_ptr2;
 
 		top = true;	/* assume top priority until found otherwise */
-		job_iterator = list_iterator_create(job_list);
-		while ((job_ptr2 = (struct job_record *)
-					list_next(job_iterator))) {
+		while ((job_ptr2 = vector_next(job_vector, &job_inx))) {
 			if (job_ptr2 == job_ptr)
 				continue;
 			if (!IS_JOB_PENDING(job_ptr2))
@@ -6314,7 +6287,6 @@ static bool _top_priority(struct job_record *job_ptr)
 				break;
 			}
 		}
-		list_iterator_destroy(job_iterator);
 	}
 
 	if ((!top) && detail_ptr) {	/* not top prio */
@@ -6415,6 +6387,10 @@ int update_job(job_desc_msg_t * job_specs, uid_t uid)
 		return ESLURM_INVALID_JOB_ID;
 	}
 
+	/* Any change to the job's size, time limit, account or QOS
+	 * can change what limit (if any) holds it */
+	job_ptr->limit_wait_epoch = 0;
+
 	error_code = job_submit_plugin_modify(job_specs, job_ptr,
 					      (uint32_t) uid);
 	if (error_code != SLURM_SUCCESS)
@@ -8027,7 +8003,7 @@ validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
  * but are not found. */
 static void _purge_missing_jobs(int node_inx, time_t now)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	struct node_record *node_ptr = node_record_table_ptr + node_inx;
 	uint16_t batch_start_timeout	= slurm_get_batch_start_timeout();
@@ -8043,8 +8019,7 @@ static void _purge_missing_jobs(int node_inx, time_t now)
 	batch_startup_time  = now - batch_start_timeout;
 	batch_startup_time -= msg_timeout;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		bool job_active = IS_JOB_RUNNING(job_ptr) ||
 				  IS_JOB_SUSPENDED(job_ptr);
 
@@ -8070,7 +8045,6 @@ static void _purge_missing_jobs(int node_inx, time_t now)
 						  now, node_boot_time);
 		}
 	}
-	list_iterator_destroy(job_iterator);
 }
 
 static void _notify_srun_missing_step(struct job_record *job_ptr, int node_inx,
@@ -8294,12 +8268,11 @@ static void _get_batch_job_dir_ids(List batch_dirs)
  *	remove it the list (of directories to be deleted) */
 static void _validate_job_files(List batch_dirs)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	int del_cnt;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (!job_ptr->batch_flag)
 			continue;
 		if (IS_JOB_FINISHED(job_ptr))
@@ -8318,7 +8291,6 @@ static void _validate_job_files(List batch_dirs)
 			job_completion_logger(job_ptr, false);
 		}
 	}
-	list_iterator_destroy(job_iterator);
 }
 
 /* List matching function, see common/list.h */
@@ -8542,6 +8514,8 @@ void job_fini (void)
 		list_destroy(job_list);
 		job_list = NULL;
 	}
+	vector_destroy(job_vector);
+	job_vector = NULL;
 	xfree(job_hash);
 }
 
@@ -9176,14 +9150,13 @@ extern int job_end_time(job_alloc_info_msg_t *time_req_msg,
  * Job write lock must be set before calling. */
 extern void update_job_nodes_completing(void)
 {
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 
 	if (!job_list)
 		return;
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if ((!IS_JOB_COMPLETING(job_ptr)) ||
 		    (job_ptr->node_bitmap == NULL))
 			continue;
@@ -9191,7 +9164,6 @@ extern void update_job_nodes_completing(void)
 		job_ptr->nodes_completing =
 			bitmap2node_name(job_ptr->node_bitmap);
 	}
-	list_iterator_destroy(job_iterator);
 }
 
 /*
@@ -9203,7 +9175,7 @@ extern void update_job_nodes_completing(void)
 extern int job_cancel_by_assoc_id(uint32_t assoc_id)
 {
 	int cnt = 0;
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	/* Write lock on jobs */
 	slurmctld_lock_t job_write_lock =
@@ -9213,8 +9185,7 @@ extern int job_cancel_by_assoc_id(uint32_t assoc_id)
 		return cnt;
 
 	lock_slurmctld(job_write_lock);
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (job_ptr->assoc_id != assoc_id)
 			continue;
 
@@ -9250,7 +9221,6 @@ extern int job_cancel_by_assoc_id(uint32_t assoc_id)
 		xfree(job_ptr->state_desc);
 		cnt++;
 	}
-	list_iterator_destroy(job_iterator);
 	unlock_slurmctld(job_write_lock);
 	return cnt;
 }
@@ -9264,7 +9234,7 @@ extern int job_cancel_by_assoc_id(uint32_t assoc_id)
 extern int job_cancel_by_qos_id(uint32_t qos_id)
 {
 	int cnt = 0;
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	/* Write lock on jobs */
 	slurmctld_lock_t job_write_lock =
@@ -9274,8 +9244,7 @@ extern int job_cancel_by_qos_id(uint32_t qos_id)
 		return cnt;
 
 	lock_slurmctld(job_write_lock);
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (job_ptr->qos_id != qos_id)
 			continue;
 
@@ -9304,7 +9273,6 @@ extern int job_cancel_by_qos_id(uint32_t qos_id)
 		xfree(job_ptr->state_desc);
 		cnt++;
 	}
-	list_iterator_destroy(job_iterator);
 	unlock_slurmctld(job_write_lock);
 	return cnt;
 }
@@ -9447,7 +9415,7 @@ extern int update_job_wckey(char *module, struct job_record *job_ptr,
 
 extern int send_jobs_to_accounting(void)
 {
-	ListIterator itr = NULL;
+	int job_inx = 0;
 	struct job_record *job_ptr;
 	slurmctld_lock_t job_write_lock = {
 		NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
@@ -9455,8 +9423,7 @@ extern int send_jobs_to_accounting(void)
 
 	/* send jobs in pending or running state */
 	lock_slurmctld(job_write_lock);
-	itr = list_iterator_create(job_list);
-	while ((job_ptr = list_next(itr))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if(!job_ptr->assoc_id) {
 			slurmdb_association_rec_t assoc_rec;
 			memset(&assoc_rec, 0,
@@ -9497,7 +9464,6 @@ extern int send_jobs_to_accounting(void)
 		if (IS_JOB_SUSPENDED(job_ptr))
 			jobacct_storage_g_job_suspend(acct_db_conn, job_ptr);
 	}
-	list_iterator_destroy(itr);
 	unlock_slurmctld(job_write_lock);
 
 	return SLURM_SUCCESS;
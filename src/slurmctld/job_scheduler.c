@@ -79,7 +79,8 @@
 static char **	_build_env(struct job_record *job_ptr);
 static void	_depend_list_del(void *dep_ptr);
 static void	_feature_list_delete(void *x);
-static void	_job_queue_append(List job_queue, struct job_record *job_ptr,
+static void	_job_queue_append(List job_queue, xarena_t *arena,
+				  struct job_record *job_ptr,
 				  struct part_record *part_ptr);
 static void	_job_queue_rec_del(void *x);
 static void *	_run_epilog(void *arg);
@@ -94,22 +95,19 @@ static int	_valid_node_feature(char *feature);
  *			  and an optional job name
  * IN  user_id - user id
  * IN  job_name - job name constraint
- * RET the job queue
+ * RET the job queue, for use by the calling thread only
  * NOTE: the caller must call list_destroy() on RET value to free memory
  */
 static List _build_user_job_list(uint32_t user_id, char* job_name)
 {
 	List job_queue;
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr = NULL;
 
-	job_queue = list_create(NULL);
+	job_queue = list_create_unlocked(NULL);
 	if (job_queue == NULL)
 		fatal("list_create memory allocation failure");
-	job_iterator = list_iterator_create(job_list);
-	if (job_iterator == NULL)
-		fatal("list_iterator_create malloc failure");
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 		if (job_ptr->user_id != user_id)
 			continue;
@@ -118,17 +116,21 @@ static List _build_user_job_list(uint32_t user_id, char* job_name)
 			continue;
 		list_append(job_queue, job_ptr);
 	}
-	list_iterator_destroy(job_iterator);
 
 	return job_queue;
 }
 
-static void _job_queue_append(List job_queue, struct job_record *job_ptr,
+static void _job_queue_append(List job_queue, xarena_t *arena,
+			      struct job_record *job_ptr,
 			      struct part_record *part_ptr)
 {
 	job_queue_rec_t *job_queue_rec;
 
-	job_queue_rec = xmalloc(sizeof(job_queue_rec_t));
+	/* xfree() of an arena record is a no-op */
+	if (arena)
+		job_queue_rec = xarena_alloc(arena, sizeof(job_queue_rec_t));
+	else
+		job_queue_rec = xmalloc(sizeof(job_queue_rec_t));
 	job_queue_rec->job_ptr  = job_ptr;
 	job_queue_rec->part_ptr = part_ptr;
 	list_append(job_queue, job_queue_rec);
@@ -142,25 +144,25 @@ static void _job_queue_rec_del(void *x)
 /*
  * build_job_queue - build (non-priority ordered) list of pending jobs
  * IN clear_start - if set then clear the start_time for pending jobs
- * RET the job queue
- * NOTE: the caller must call list_destroy() on RET value to free memory
+ * IN arena - if set then allocate the job queue records from it
+ * RET the job queue, for use by the calling thread only
+ * NOTE: the caller must call list_destroy() on RET value to free memory,
+ *	then xarena_destroy() on any arena
  */
-extern List build_job_queue(bool clear_start)
+extern List build_job_queue(bool clear_start, xarena_t *arena)
 {
 	List job_queue;
-	ListIterator job_iterator, part_iterator;
+	ListIterator part_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr = NULL;
 	struct part_record *part_ptr;
 	bool job_is_pending;
 	bool job_indepen = false;
 
-	job_queue = list_create(_job_queue_rec_del);
+	job_queue = list_create_unlocked(_job_queue_rec_del);
 	if (job_queue == NULL)
 		fatal("list_create memory allocation failure");
-	job_iterator = list_iterator_create(job_list);
-	if (job_iterator == NULL)
-		fatal("list_iterator_create memory allocation failure");
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 		job_is_pending = IS_JOB_PENDING(job_ptr);
 		if (!job_is_pending || IS_JOB_COMPLETING(job_ptr))
@@ -199,7 +201,8 @@ extern List build_job_queue(bool clear_start)
 				fatal("list_iterator_create malloc failure");
 			while ((part_ptr = (struct part_record *)
 					list_next(part_iterator))) {
-				_job_queue_append(job_queue, job_ptr, part_ptr);
+				_job_queue_append(job_queue, arena, job_ptr,
+						  part_ptr);
 			}
 			list_iterator_destroy(part_iterator);
 		} else {
@@ -216,11 +219,10 @@ extern List build_job_queue(bool clear_start)
 				      "part %s", job_ptr->job_id,
 				      job_ptr->partition);
 			}
-			_job_queue_append(job_queue, job_ptr,
+			_job_queue_append(job_queue, arena, job_ptr,
 					  job_ptr->part_ptr);
 		}
 	}
-	list_iterator_destroy(job_iterator);
 
 	return job_queue;
 }
@@ -235,7 +237,7 @@ extern List build_job_queue(bool clear_start)
 extern bool job_is_completing(void)
 {
 	bool completing = false;
-	ListIterator job_iterator;
+	int job_inx = 0;
 	struct job_record *job_ptr = NULL;
 	uint16_t complete_wait = slurm_get_complete_wait();
 	time_t recent;
@@ -244,15 +246,13 @@ extern bool job_is_completing(void)
 		return completing;
 
 	recent = time(NULL) - complete_wait;
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		if (IS_JOB_COMPLETING(job_ptr) &&
 		    (job_ptr->end_time >= recent)) {
 			completing = true;
 			break;
 		}
 	}
-	list_iterator_destroy(job_iterator);
 
 	return completing;
 }
@@ -265,13 +265,12 @@ extern void set_job_elig_time(void)
 {
 	struct job_record *job_ptr = NULL;
 	struct part_record *part_ptr = NULL;
-	ListIterator job_iterator;
+	int job_inx = 0;
 	slurmctld_lock_t job_write_lock =
 		{ READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK };
 
 	lock_slurmctld(job_write_lock);
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_ptr = vector_next(job_vector, &job_inx))) {
 		part_ptr = job_ptr->part_ptr;
 		if (!IS_JOB_PENDING(job_ptr))
 			continue;
@@ -292,7 +291,6 @@ extern void set_job_elig_time(void)
 		if (!job_independent(job_ptr, 0))
 			continue;
 	}
-	list_iterator_destroy(job_iterator);
 	unlock_slurmctld(job_write_lock);
 }
 
@@ -328,6 +326,7 @@ static bool _failed_partition(struct part_record *part_ptr,
 extern int schedule(uint32_t job_limit)
 {
 	List job_queue = NULL;
+	xarena_t *job_queue_arena;
 	int error_code, failed_part_cnt = 0, job_cnt = 0, i;
 	uint32_t job_depth = 0;
 	job_queue_rec_t *job_queue_rec;
@@ -422,7 +421,8 @@ extern int schedule(uint32_t job_limit)
 	save_avail_node_bitmap = bit_copy(avail_node_bitmap);
 
 	debug("sched: Running job scheduler");
-	job_queue = build_job_queue(false);
+	job_queue_arena = xarena_create();
+	job_queue = build_job_queue(false, job_queue_arena);
 	while ((job_queue_rec = list_pop_bottom(job_queue, sort_job_queue2))) {
 		job_ptr  = job_queue_rec->job_ptr;
 		part_ptr = job_queue_rec->part_ptr;
@@ -618,6 +618,7 @@ extern int schedule(uint32_t job_limit)
 	avail_node_bitmap = save_avail_node_bitmap;
 	xfree(failed_parts);
 	list_destroy(job_queue);
+	xarena_destroy(job_queue_arena);
 	unlock_slurmctld(job_write_lock);
 	END_TIMER2("schedule");
 	return job_cnt;
@@ -1193,7 +1194,7 @@ static void _delayed_job_start_time(struct job_record *job_ptr)
 	uint32_t job_size_cpus, job_size_nodes, job_time;
 	uint64_t cume_space_time = 0;
 	struct job_record *job_q_ptr;
-	ListIterator job_iterator;
+	int job_inx = 0;
 
 	if (job_ptr->part_ptr == NULL)
 		return;
@@ -1204,10 +1205,7 @@ static void _delayed_job_start_time(struct job_record *job_ptr)
 	else
 		part_cpus_per_node = 1;
 
-	job_iterator = list_iterator_create(job_list);
-	if (job_iterator == NULL)
-		fatal("list_iterator_create memory allocation failure");
-	while ((job_q_ptr = (struct job_record *) list_next(job_iterator))) {
+	while ((job_q_ptr = vector_next(job_vector, &job_inx))) {
 		if (!IS_JOB_PENDING(job_q_ptr) || !job_q_ptr->details ||
 		    (job_q_ptr->part_ptr != job_ptr->part_ptr) ||
 		    (job_q_ptr->priority < job_ptr->priority))
@@ -1228,7 +1226,6 @@ static void _delayed_job_start_time(struct job_record *job_ptr)
 			job_time = job_q_ptr->time_limit;
 		cume_space_time += job_size_cpus * job_time;
 	}
-	list_iterator_destroy(job_iterator);
 	cume_space_time /= part_cpu_cnt;/* Factor out size */
 	cume_space_time *= 60;		/* Minutes to seconds */
 	debug2("Increasing estimated start of job %u by %"PRIu64" secs",
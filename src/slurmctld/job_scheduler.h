@@ -60,10 +60,12 @@ extern int build_feature_list(struct job_record *job_ptr);
 /*
  * build_job_queue - build (non-priority ordered) list of pending jobs
  * IN clear_start - if set then clear the start_time for pending jobs
- * RET the job queue
- * NOTE: the caller must call list_destroy() on RET value to free memory
+ * IN arena - if set then allocate the job queue records from it
+ * RET the job queue, for use by the calling thread only
+ * NOTE: the caller must call list_destroy() on RET value to free memory,
+ *	then xarena_destroy() on any arena
  */
-extern List build_job_queue(bool clear_start);
+extern List build_job_queue(bool clear_start, xarena_t *arena);
 
 /*
  * epilog_slurmctld - execute the prolog_slurmctld for a job that has just
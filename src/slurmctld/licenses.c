@@ -489,3 +489,81 @@ extern bool license_list_overlap(List list_1, List list_2)
 
 	return match;
 }
+
+/*
+ * license_get_avail_cnts - Get the count of each configured license which
+ *	is not currently allocated to any job
+ * OUT lic_cnt - number of configured license types, which is the size of
+ *	the returned array
+ * RET array of available license counts, in the order of the configured
+ *	license_list, or NULL if no licenses are configured. Must be xfreed
+ *	by the caller.
+ */
+extern uint32_t *license_get_avail_cnts(int *lic_cnt)
+{
+	ListIterator iter;
+	licenses_t *license_entry;
+	uint32_t *avail_cnts = NULL;
+	int i = 0;
+
+	*lic_cnt = 0;
+	slurm_mutex_lock(&license_mutex);
+	if (license_list && (*lic_cnt = list_count(license_list))) {
+		avail_cnts = xmalloc(sizeof(uint32_t) * (*lic_cnt));
+		iter = list_iterator_create(license_list);
+		if (iter == NULL)
+			fatal("malloc failure from list_iterator_create");
+		while ((license_entry = (licenses_t *) list_next(iter))) {
+			if (license_entry->total > license_entry->used) {
+				avail_cnts[i] = license_entry->total -
+						license_entry->used;
+			}
+			i++;
+		}
+		list_iterator_destroy(iter);
+	}
+	slurm_mutex_unlock(&license_mutex);
+
+	return avail_cnts;
+}
+
+/*
+ * license_get_job_cnts - Get the count of each configured license which
+ *	a job requires
+ * IN job_ptr - job identification
+ * IN lic_cnt - number of configured license types, as returned by
+ *	license_get_avail_cnts()
+ * RET array of required license counts, in the order of the configured
+ *	license_list, or NULL if the job requires no licenses. Must be xfreed
+ *	by the caller.
+ */
+extern uint32_t *license_get_job_cnts(struct job_record *job_ptr,
+				      int lic_cnt)
+{
+	ListIterator iter;
+	licenses_t *license_entry;
+	uint32_t *job_cnts;
+	int i = 0;
+
+	if (!job_ptr->license_list || (lic_cnt == 0))
+		return NULL;
+
+	job_cnts = xmalloc(sizeof(uint32_t) * lic_cnt);
+	slurm_mutex_lock(&license_mutex);
+	iter = list_iterator_create(license_list);
+	if (iter == NULL)
+		fatal("malloc failure from list_iterator_create");
+	while ((license_entry = (licenses_t *) list_next(iter)) &&
+	       (i < lic_cnt)) {
+		licenses_t *match = list_find_first(job_ptr->license_list,
+						    _license_find_rec,
+						    license_entry->name);
+		if (match)
+			job_cnts[i] = match->total;
+		i++;
+	}
+	list_iterator_destroy(iter);
+	slurm_mutex_unlock(&license_mutex);
+
+	return job_cnts;
+}
@@ -109,4 +109,28 @@ extern List license_validate(char *licenses, bool *valid);
  */
 extern bool license_list_overlap(List list_1, List list_2);
 
+/*
+ * license_get_avail_cnts - Get the count of each configured license which
+ *	is not currently allocated to any job
+ * OUT lic_cnt - number of configured license types, which is the size of
+ *	the returned array
+ * RET array of available license counts, in the order of the configured
+ *	license_list, or NULL if no licenses are configured. Must be xfreed
+ *	by the caller.
+ */
+extern uint32_t *license_get_avail_cnts(int *lic_cnt);
+
+/*
+ * license_get_job_cnts - Get the count of each configured license which
+ *	a job requires
+ * IN job_ptr - job identification
+ * IN lic_cnt - number of configured license types, as returned by
+ *	license_get_avail_cnts()
+ * RET array of required license counts, in the order of the configured
+ *	license_list, or NULL if the job requires no licenses. Must be xfreed
+ *	by the caller.
+ */
+extern uint32_t *license_get_job_cnts(struct job_record *job_ptr,
+				      int lic_cnt);
+
 #endif /* !_LICENSES_H */
@@ -561,6 +561,7 @@ static bool _node_is_hidden(struct node_record *node_ptr)
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN protocol_version - slurm protocol version of client
+ * IN compact - pack the node records with set_buf_compact()
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
  * NOTE: change slurm_load_node() in api/node_info.c when data format changes
@@ -568,7 +569,7 @@ static bool _node_is_hidden(struct node_record *node_ptr)
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
-			   uint16_t protocol_version)
+			   uint16_t protocol_version, bool compact)
 {
 	int inx;
 	uint32_t nodes_packed, tmp_offset, node_scaling;
@@ -593,6 +594,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 		pack_time(now, buffer);
 
 		/* write node records */
+		set_buf_compact(buffer, compact);
 		part_filter_set(uid);
 		for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
 			xassert (node_ptr->magic == NODE_MAGIC);
@@ -623,6 +625,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			nodes_packed++;
 		}
 		part_filter_clear();
+		set_buf_compact(buffer, false);
 	} else {
 		error("pack_all_node: Unsupported slurm version %u",
 		      protocol_version);
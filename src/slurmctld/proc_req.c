@@ -71,6 +71,7 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_topology.h"
 #include "src/common/switch.h"
+#include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/agent.h"
@@ -160,6 +161,18 @@ inline static void _slurm_rpc_dump_spank(slurm_msg_t * msg);
 
 inline static void  _update_cred_key(void);
 
+/* Memory allocated while servicing each RPC type since the last report */
+#define RPC_ALLOC_TYPES 256
+typedef struct {
+	uint16_t msg_type;
+	uint32_t count;		/* RPCs serviced */
+	uint64_t allocs;	/* allocations made for them */
+	uint64_t bytes;		/* bytes requested by the allocations */
+} rpc_alloc_t;
+static rpc_alloc_t rpc_alloc[RPC_ALLOC_TYPES];
+static int rpc_alloc_cnt = 0;
+static pthread_mutex_t rpc_alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
 
 /*
  * slurmctld_req  - Process an individual RPC request
@@ -433,6 +446,73 @@ void slurmctld_req (slurm_msg_t * msg)
 	}
 }
 
+/*
+ * rpc_alloc_record - add the memory allocated while servicing one RPC to
+ *	the totals for its type
+ * IN msg_type - type of the RPC
+ * IN allocs - count of allocations made for it
+ * IN bytes - bytes requested by those allocations
+ */
+extern void rpc_alloc_record(uint16_t msg_type, uint64_t allocs,
+			     uint64_t bytes)
+{
+	int i;
+
+	slurm_mutex_lock(&rpc_alloc_lock);
+	for (i = 0; i < rpc_alloc_cnt; i++) {
+		if (rpc_alloc[i].msg_type == msg_type)
+			break;
+	}
+	if ((i == rpc_alloc_cnt) && (rpc_alloc_cnt < RPC_ALLOC_TYPES))
+		rpc_alloc[rpc_alloc_cnt++].msg_type = msg_type;
+	if (i < rpc_alloc_cnt) {
+		rpc_alloc[i].count++;
+		rpc_alloc[i].allocs += allocs;
+		rpc_alloc[i].bytes  += bytes;
+	}
+	slurm_mutex_unlock(&rpc_alloc_lock);
+}
+
+static int _rpc_alloc_cmp(const void *x, const void *y)
+{
+	const rpc_alloc_t *r1 = x, *r2 = y;
+
+	if (r1->bytes > r2->bytes)
+		return -1;
+	return (r1->bytes < r2->bytes);
+}
+
+/*
+ * rpc_alloc_report - log the memory allocated for each RPC type since the
+ *	last report if DebugFlags=XMalloc is set, then clear the totals
+ */
+extern void rpc_alloc_report(void)
+{
+	rpc_alloc_t stats[RPC_ALLOC_TYPES];
+	int i, cnt;
+
+	slurm_mutex_lock(&rpc_alloc_lock);
+	cnt = rpc_alloc_cnt;
+	memcpy(stats, rpc_alloc, cnt * sizeof(rpc_alloc_t));
+	rpc_alloc_cnt = 0;
+	memset(rpc_alloc, 0, sizeof(rpc_alloc));
+	slurm_mutex_unlock(&rpc_alloc_lock);
+
+	if (!(slurmctld_conf.debug_flags & DEBUG_FLAG_XMALLOC))
+		return;
+
+	/* largest consumers first */
+	qsort(stats, cnt, sizeof(rpc_alloc_t), _rpc_alloc_cmp);
+	for (i = 0; i < cnt; i++) {
+		info("XMalloc: RPC %u: %u requests, %"PRIu64" allocations "
+		     "of %"PRIu64" bytes, %"PRIu64" allocations of %"PRIu64" "
+		     "bytes per request", stats[i].msg_type, stats[i].count,
+		     stats[i].allocs, stats[i].bytes,
+		     stats[i].allocs / stats[i].count,
+		     stats[i].bytes / stats[i].count);
+	}
+}
+
 /*
  * _fill_ctld_conf - make a copy of current slurm configuration
  *	this is done with locks set so the data can change at other times
@@ -457,6 +537,7 @@ void _fill_ctld_conf(slurm_ctl_conf_t * conf_ptr)
 	conf_ptr->accounting_storage_user =
 		xstrdup(conf->accounting_storage_user);
 	conf_ptr->accounting_storage_port = conf->accounting_storage_port;
+	conf_ptr->auth_session_timeout = conf->auth_session_timeout;
 	conf_ptr->authtype            = xstrdup(conf->authtype);
 
 	conf_ptr->backup_addr         = xstrdup(conf->backup_addr);
@@ -526,6 +607,7 @@ void _fill_ctld_conf(slurm_ctl_conf_t * conf_ptr)
 	conf_ptr->min_job_age         = conf->min_job_age;
 	conf_ptr->mpi_default         = xstrdup(conf->mpi_default);
 	conf_ptr->mpi_params          = xstrdup(conf->mpi_params);
+	conf_ptr->msg_persist_timeout = conf->msg_persist_timeout;
 	conf_ptr->msg_timeout         = conf->msg_timeout;
 
 	conf_ptr->next_job_id         = get_next_job_id();
@@ -926,6 +1008,7 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	slurmctld_lock_t job_read_lock = {
 		READ_LOCK, READ_LOCK, NO_LOCK, WRITE_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	bool compact = (msg->flags & SLURM_PACK_COMPACT_OK);
 
 	START_TIMER;
 	debug3("Processing RPC: REQUEST_JOB_INFO from uid=%d", uid);
@@ -939,7 +1022,7 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 		pack_all_jobs(&dump, &dump_size,
 			      job_info_request_msg->show_flags,
 			      g_slurm_auth_get_uid(msg->auth_cred, NULL),
-			      msg->protocol_version);
+			      msg->protocol_version, compact);
 		unlock_slurmctld(job_read_lock);
 		END_TIMER2("_slurm_rpc_dump_jobs");
 /* 		info("_slurm_rpc_dump_jobs, size=%d %s", */
@@ -947,7 +1030,9 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 
 		/* init response_msg structure */
 		slurm_msg_t_init(&response_msg);
-		response_msg.flags = msg->flags;
+		response_msg.flags = msg->flags & ~SLURM_PACK_COMPACT;
+		if (compact)
+			response_msg.flags |= SLURM_PACK_COMPACT;
 		response_msg.protocol_version = msg->protocol_version;
 		response_msg.address = msg->address;
 		response_msg.msg_type = RESPONSE_JOB_INFO;
@@ -1151,6 +1236,7 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	slurmctld_lock_t node_write_lock = {
 		READ_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	bool compact = (msg->flags & SLURM_PACK_COMPACT_OK);
 
 	START_TIMER;
 	debug3("Processing RPC: REQUEST_NODE_INFO from uid=%d", uid);
@@ -1174,7 +1260,7 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	} else {
 
 		pack_all_node(&dump, &dump_size, node_req_msg->show_flags,
-			      uid, msg->protocol_version);
+			      uid, msg->protocol_version, compact);
 		unlock_slurmctld(node_write_lock);
 		END_TIMER2("_slurm_rpc_dump_nodes");
 		debug3("_slurm_rpc_dump_nodes, size=%d %s",
@@ -1182,7 +1268,9 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 
 		/* init response_msg structure */
 		slurm_msg_t_init(&response_msg);
-		response_msg.flags = msg->flags;
+		response_msg.flags = msg->flags & ~SLURM_PACK_COMPACT;
+		if (compact)
+			response_msg.flags |= SLURM_PACK_COMPACT;
 		response_msg.protocol_version = msg->protocol_version;
 		response_msg.address = msg->address;
 		response_msg.msg_type = RESPONSE_NODE_INFO;
@@ -1717,6 +1805,7 @@ static void _slurm_rpc_job_step_get_info(slurm_msg_t * msg)
 	slurmctld_lock_t job_read_lock = {
 		READ_LOCK, READ_LOCK, NO_LOCK, WRITE_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	bool compact = (msg->flags & SLURM_PACK_COMPACT_OK);
 
 	START_TIMER;
 	debug3("Processing RPC: REQUEST_JOB_STEP_INFO from uid=%d", uid);
@@ -1732,7 +1821,7 @@ static void _slurm_rpc_job_step_get_info(slurm_msg_t * msg)
 		error_code = pack_ctld_job_step_info_response_msg(
 			request->job_id, request->step_id,
 			uid, request->show_flags, buffer,
-			msg->protocol_version);
+			msg->protocol_version, compact);
 		unlock_slurmctld(job_read_lock);
 		END_TIMER2("_slurm_rpc_job_step_get_info");
 		if (error_code) {
@@ -1755,7 +1844,9 @@ static void _slurm_rpc_job_step_get_info(slurm_msg_t * msg)
 		slurm_msg_t response_msg;
 
 		slurm_msg_t_init(&response_msg);
-		response_msg.flags = msg->flags;
+		response_msg.flags = msg->flags & ~SLURM_PACK_COMPACT;
+		if (compact)
+			response_msg.flags |= SLURM_PACK_COMPACT;
 		response_msg.protocol_version = msg->protocol_version;
 		response_msg.address = msg->address;
 		response_msg.msg_type = RESPONSE_JOB_STEP_INFO;
@@ -76,5 +76,21 @@ extern int slurm_fail_job(uint32_t job_id);
  * strings in the array */
 extern char **xduparray(uint16_t size, char ** array);
 
+/*
+ * rpc_alloc_record - add the memory allocated while servicing one RPC to
+ *	the totals for its type
+ * IN msg_type - type of the RPC
+ * IN allocs - count of allocations made for it
+ * IN bytes - bytes requested by those allocations
+ */
+extern void rpc_alloc_record(uint16_t msg_type, uint64_t allocs,
+			     uint64_t bytes);
+
+/*
+ * rpc_alloc_report - log the memory allocated for each RPC type since the
+ *	last report if DebugFlags=XMalloc is set, then clear the totals
+ */
+extern void rpc_alloc_report(void);
+
 #endif /* !_HAVE_PROC_REQ_H */
 
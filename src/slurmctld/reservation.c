@@ -91,8 +91,22 @@ uint32_t  top_suffix = 0;
 uint32_t  cnodes_per_bp = 0;
 #endif
 
+/* resv_list records sorted by start_time, see _build_resv_index() */
+static slurmctld_resv_t **resv_index = NULL;
+static int       resv_index_cnt = 0;
+static int       resv_index_size = 0;
+static bool      resv_index_valid = false;
+static time_t    resv_index_max_dur = 0;	/* longest reservation */
+static time_t    resv_index_advance = 0;	/* earliest repeating end */
+/* Nodes reserved at any time in the window [resv_mask_start,
+ * resv_mask_end), valid only while the index is */
+static bitstr_t *resv_mask = NULL;
+static time_t    resv_mask_start = 0, resv_mask_end = 0;
+static bool      resv_mask_valid = false;
+
 static void _advance_resv_time(slurmctld_resv_t *resv_ptr);
 static void _advance_time(time_t *res_time, int day_cnt);
+static void _build_resv_index(time_t now);
 static int  _build_account_list(char *accounts, int *account_cnt,
 				char ***account_list);
 static int  _build_uid_list(char *users, int *user_cnt, uid_t **user_list);
@@ -102,17 +116,23 @@ static void _del_resv_rec(void *x);
 static void _dump_resv_req(resv_desc_msg_t *resv_ptr, char *mode);
 static int  _find_resv_id(void *x, void *key);
 static int  _find_resv_name(void *x, void *key);
+static int  _first_resv_index(time_t start_time);
 static void _generate_resv_id(void);
 static void _generate_resv_name(resv_desc_msg_t *resv_ptr);
 static uint32_t _get_job_duration(struct job_record *job_ptr);
+static void _invalidate_resv_index(void);
 static bool _is_account_valid(char *account);
 static bool _is_resv_used(slurmctld_resv_t *resv_ptr);
 static bool _job_overlap(time_t start_time, uint16_t flags,
 			 bitstr_t *node_bitmap);
+static int  _job_test_resv(struct job_record *job_ptr, time_t *when,
+			   bool move_time, bool test_lic,
+			   bitstr_t **node_bitmap);
 static List _list_dup(List license_list);
 static int  _open_resv_state_file(char **state_file);
 static void _pack_resv(slurmctld_resv_t *resv_ptr, Buf buffer,
 		       bool internal);
+static bitstr_t *_resv_window_mask(time_t start_time, time_t end_time);
 static bitstr_t *_pick_idle_nodes(bitstr_t *avail_nodes,
 				  resv_desc_msg_t *resv_desc_ptr);
 static int  _post_resv_create(slurmctld_resv_t *resv_ptr);
@@ -242,6 +262,7 @@ static void _swap_resv(slurmctld_resv_t *resv_backup,
 	memcpy(resv_backup, resv_ptr, sizeof(slurmctld_resv_t));
 	memcpy(resv_ptr, resv_copy_ptr, sizeof(slurmctld_resv_t));
 	xfree(resv_copy_ptr);
+	_invalidate_resv_index();
 }
 
 static void _del_resv_rec(void *x)
@@ -252,6 +273,7 @@ static void _del_resv_rec(void *x)
 	if (resv_ptr) {
 		xassert(resv_ptr->magic == RESV_MAGIC);
 		resv_ptr->magic = 0;
+		_invalidate_resv_index();
 		xfree(resv_ptr->accounts);
 		for (i=0; i<resv_ptr->account_cnt; i++)
 			xfree(resv_ptr->account_list[i]);
@@ -1393,6 +1415,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 	     resv_ptr->name, name1, val1, name2, val2,
 	     resv_ptr->node_list, start_time, end_time);
 	list_append(resv_list, resv_ptr);
+	_invalidate_resv_index();
 	last_resv_update = now;
 	schedule_resv_save();
 
@@ -1416,6 +1439,9 @@ extern void resv_fini(void)
 		list_destroy(resv_list);
 		resv_list = (List) NULL;
 	}
+	xfree(resv_index);
+	resv_index_cnt = resv_index_size = 0;
+	FREE_NULL_BITMAP(resv_mask);
 }
 
 /* Update an exiting resource reservation */
@@ -1993,6 +2019,7 @@ static bool _validate_one_reservation(slurmctld_resv_t *resv_ptr)
 		}
 		FREE_NULL_BITMAP(resv_ptr->node_bitmap);
 		resv_ptr->node_bitmap = node_bitmap;
+		_invalidate_resv_index();
 	}
 	return true;
 }
@@ -2090,6 +2117,7 @@ static void _validate_node_choice(slurmctld_resv_t *resv_ptr)
 		FREE_NULL_BITMAP(tmp_bitmap);
 		xfree(resv_ptr->node_list);
 		resv_ptr->node_list = bitmap2node_name(resv_ptr->node_bitmap);
+		_invalidate_resv_index();
 		info("modified reservation %s due to unusable nodes, "
 		     "new nodes: %s", resv_ptr->name, resv_ptr->node_list);
 	} else if (difftime(resv_ptr->start_time, time(NULL)) < 600) {
@@ -2242,6 +2270,7 @@ extern int load_all_resv_state(int recover)
 		safe_unpack32(&resv_ptr->duration,	buffer);
 
 		list_append(resv_list, resv_ptr);
+		_invalidate_resv_index();
 		info("Recovered state of reservation %s", resv_ptr->name);
 	}
 
@@ -2311,6 +2340,7 @@ static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt)
 	delta_node_cnt = resv_ptr->node_cnt - node_cnt;
 	if (delta_node_cnt == 0)	/* Already correct node count */
 		return SLURM_SUCCESS;
+	_invalidate_resv_index();
 
 	if (delta_node_cnt > 0) {	/* Must decrease node count */
 		if (bit_overlap(resv_ptr->node_bitmap, idle_node_bitmap)) {
@@ -2679,14 +2709,42 @@ extern int job_test_resv_now(struct job_record *job_ptr)
 	return SLURM_SUCCESS;
 }
 
-/* Adjust a job's time_limit and end_time as needed to avoid using
- *	reserved resources. Don't go below job's time_min value. */
-extern void job_time_adj_resv(struct job_record *job_ptr)
+/* Note that reservation records, their times or their nodes have changed,
+ *	so the index must be rebuilt before its next use */
+static void _invalidate_resv_index(void)
+{
+	resv_index_valid = false;
+	resv_mask_valid = false;
+}
+
+static int _resv_start_cmp(const void *x, const void *y)
+{
+	slurmctld_resv_t *resv1_ptr = *(slurmctld_resv_t **) x;
+	slurmctld_resv_t *resv2_ptr = *(slurmctld_resv_t **) y;
+
+	if (resv1_ptr->start_time < resv2_ptr->start_time)
+		return -1;
+	if (resv1_ptr->start_time > resv2_ptr->start_time)
+		return 1;
+	return 0;
+}
+
+/* Build resv_index, an array of all reservation records sorted by
+ *	start_time. Any repeating reservations which have ended are advanced
+ *	first. The index is rebuilt only when invalidated or when a repeating
+ *	reservation in it has ended. */
+static void _build_resv_index(time_t now)
 {
 	ListIterator iter;
-	slurmctld_resv_t * resv_ptr;
-	time_t now = time(NULL);
-	int32_t resv_begin_time;
+	slurmctld_resv_t *resv_ptr;
+
+	if (!resv_list) {
+		resv_index_cnt = 0;
+		return;
+	}
+	if (resv_index_valid &&
+	    ((resv_index_advance == 0) || (now < resv_index_advance)))
+		return;
 
 	iter = list_iterator_create(resv_list);
 	if (!iter)
@@ -2694,12 +2752,109 @@ extern void job_time_adj_resv(struct job_record *job_ptr)
 	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
 		if (resv_ptr->end_time <= now)
 			_advance_resv_time(resv_ptr);
+	}
+	list_iterator_reset(iter);
+
+	resv_index_cnt = 0;
+	resv_index_max_dur = 0;
+	resv_index_advance = 0;
+	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		if (resv_index_cnt >= resv_index_size) {
+			resv_index_size = MAX(16, resv_index_size * 2);
+			xrealloc(resv_index, resv_index_size *
+				 sizeof(slurmctld_resv_t *));
+		}
+		resv_index[resv_index_cnt++] = resv_ptr;
+		resv_index_max_dur = MAX(resv_index_max_dur,
+					 resv_ptr->end_time -
+					 resv_ptr->start_time);
+		if ((resv_ptr->flags & (RESERVE_FLAG_DAILY |
+					RESERVE_FLAG_WEEKLY)) &&
+		    ((resv_index_advance == 0) ||
+		     (resv_ptr->end_time < resv_index_advance)))
+			resv_index_advance = resv_ptr->end_time;
+	}
+	list_iterator_destroy(iter);
+
+	qsort(resv_index, resv_index_cnt, sizeof(slurmctld_resv_t *),
+	      _resv_start_cmp);
+	resv_index_valid = true;
+	resv_mask_valid = false;
+}
+
+/* Return the resv_index position of the first reservation starting at or
+ *	after start_time. No reservation is longer than resv_index_max_dur, so
+ *	every reservation overlapping a time window [T1, T2) is found scanning
+ *	from _first_resv_index(T1 - resv_index_max_dur) up to the first
+ *	reservation starting at or after T2. */
+static int _first_resv_index(time_t start_time)
+{
+	int lo = 0, hi = resv_index_cnt, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_index[mid]->start_time < start_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Return a bitmap of all nodes reserved at any time within the window
+ *	[start_time, end_time). The bitmap is cached for the last window
+ *	requested and must not be modified or freed by the caller. */
+static bitstr_t *_resv_window_mask(time_t start_time, time_t end_time)
+{
+	slurmctld_resv_t *resv_ptr;
+	int i;
+
+	if (resv_mask_valid && (resv_mask_start == start_time) &&
+	    (resv_mask_end == end_time))
+		return resv_mask;
+
+	if (resv_mask && (bit_size(resv_mask) != node_record_count))
+		FREE_NULL_BITMAP(resv_mask);
+	if (!resv_mask) {
+		resv_mask = bit_alloc(node_record_count);
+		if (resv_mask == NULL)
+			fatal("bit_alloc: malloc failure");
+	} else
+		bit_nclear(resv_mask, 0, (node_record_count - 1));
+
+	for (i = _first_resv_index(start_time - resv_index_max_dur);
+	     i < resv_index_cnt; i++) {
+		resv_ptr = resv_index[i];
+		if (resv_ptr->start_time >= end_time)
+			break;
+		if ((resv_ptr->node_bitmap == NULL) ||
+		    (resv_ptr->end_time <= start_time))
+			continue;
+		bit_or(resv_mask, resv_ptr->node_bitmap);
+	}
+	resv_mask_start = start_time;
+	resv_mask_end   = end_time;
+	resv_mask_valid = true;
+	return resv_mask;
+}
+
+/* Adjust a job's time_limit and end_time as needed to avoid using
+ *	reserved resources. Don't go below job's time_min value. */
+extern void job_time_adj_resv(struct job_record *job_ptr)
+{
+	slurmctld_resv_t * resv_ptr;
+	time_t now = time(NULL);
+	int32_t resv_begin_time;
+	int i;
+
+	_build_resv_index(now);
+	/* reservations which started already have been validated */
+	for (i = _first_resv_index(now + 1); i < resv_index_cnt; i++) {
+		resv_ptr = resv_index[i];
+		if (resv_ptr->start_time >= job_ptr->end_time)
+			break;		/* reservation starts after job ends */
 		if (job_ptr->resv_ptr == resv_ptr)
 			continue;	/* authorized user of reservation */
-		if (resv_ptr->start_time <= now)
-			continue;	/* already validated */
-		if (resv_ptr->start_time >= job_ptr->end_time)
-			continue;	/* reservation starts after job ends */
 		if (!license_list_overlap(job_ptr->license_list,
 					  resv_ptr->license_list) &&
 		    ((resv_ptr->node_bitmap == NULL) ||
@@ -2709,7 +2864,6 @@ extern void job_time_adj_resv(struct job_record *job_ptr)
 		resv_begin_time = difftime(resv_ptr->start_time, now) / 60;
 		job_ptr->time_limit = MIN(job_ptr->time_limit,resv_begin_time);
 	}
-	list_iterator_destroy(iter);
 	job_ptr->time_limit = MAX(job_ptr->time_limit, job_ptr->time_min);
 	job_ptr->end_time = job_ptr->start_time + (job_ptr->time_limit * 60);
 }
@@ -2778,19 +2932,17 @@ extern int job_test_lic_resv(struct job_record *job_ptr, char *lic_name,
 {
 	slurmctld_resv_t * resv_ptr;
 	time_t job_start_time, job_end_time, now = time(NULL);
-	ListIterator iter;
-	int resv_cnt = 0;
+	int i, resv_cnt = 0;
 
 	job_start_time = when;
 	job_end_time   = when + _get_job_duration(job_ptr);
-	iter = list_iterator_create(resv_list);
-	if (!iter)
-		fatal("malloc: list_iterator_create");
-	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-		if (resv_ptr->end_time <= now)
-			_advance_resv_time(resv_ptr);
-		if ((resv_ptr->start_time >= job_end_time) ||
-		    (resv_ptr->end_time   <= job_start_time))
+	_build_resv_index(now);
+	for (i = _first_resv_index(job_start_time - resv_index_max_dur);
+	     i < resv_index_cnt; i++) {
+		resv_ptr = resv_index[i];
+		if (resv_ptr->start_time >= job_end_time)
+			break;		/* reservation starts after job ends */
+		if (resv_ptr->end_time <= job_start_time)
 			continue;	/* reservation at different time */
 
 		if (job_ptr->resv_name &&
@@ -2799,7 +2951,6 @@ extern int job_test_lic_resv(struct job_record *job_ptr, char *lic_name,
 
 		resv_cnt += _license_cnt(resv_ptr->license_list, lic_name);
 	}
-	list_iterator_destroy(iter);
 
 	/* info("job %u blocked from %d licenses of type %s",
 	     job_ptr->job_id, resv_cnt, lic_name); */
@@ -2823,16 +2974,37 @@ extern int job_test_lic_resv(struct job_record *job_ptr, char *lic_name,
  */
 extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 			 bool move_time, bitstr_t **node_bitmap)
+{
+	return _job_test_resv(job_ptr, when, move_time, true, node_bitmap);
+}
+
+/*
+ * Same as job_test_resv() with move_time set, except that the start time
+ *	is not postponed for licenses. For callers planning license
+ *	availability themselves.
+ */
+extern int job_test_resv_nodes(struct job_record *job_ptr, time_t *when,
+			       bitstr_t **node_bitmap)
+{
+	return _job_test_resv(job_ptr, when, true, false, node_bitmap);
+}
+
+/* See job_test_resv(), postpone the start time for licenses only if
+ * test_lic is set */
+static int _job_test_resv(struct job_record *job_ptr, time_t *when,
+			  bool move_time, bool test_lic,
+			  bitstr_t **node_bitmap)
 {
 	slurmctld_resv_t * resv_ptr, *res2_ptr;
 	time_t job_start_time, job_end_time, lic_resv_time;
 	time_t now = time(NULL);
-	ListIterator iter;
-	int i, rc = SLURM_SUCCESS;
+	bitstr_t *resv_bitmap;
+	int i, j, rc = SLURM_SUCCESS;
 
 	job_start_time = *when;
 	job_end_time   = *when + _get_job_duration(job_ptr);
 	*node_bitmap = (bitstr_t *) NULL;
+	_build_resv_index(now);
 
 	if (job_ptr->resv_name) {
 		bool overlap_resv = false;
@@ -2878,15 +3050,18 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 
 		/* if there are any overlapping reservations, we need to
 		 * prevent the job from using those nodes (e.g. MAINT nodes) */
-		iter = list_iterator_create(resv_list);
-		if (!iter)
-			fatal("malloc: list_iterator_create");
-		while ((res2_ptr = (slurmctld_resv_t *) list_next(iter))) {
-			if ((resv_ptr->flags & RESERVE_FLAG_MAINT) ||
-			    (resv_ptr->flags & RESERVE_FLAG_OVERLAP) ||
-			    (res2_ptr == resv_ptr) ||
+		if ((resv_ptr->flags & RESERVE_FLAG_MAINT) ||
+		    (resv_ptr->flags & RESERVE_FLAG_OVERLAP))
+			j = resv_index_cnt;	/* no overlap test */
+		else
+			j = _first_resv_index(job_start_time -
+					      resv_index_max_dur);
+		for ( ; j < resv_index_cnt; j++) {
+			res2_ptr = resv_index[j];
+			if (res2_ptr->start_time >= job_end_time)
+				break;
+			if ((res2_ptr == resv_ptr) ||
 			    (res2_ptr->node_bitmap == NULL) ||
-			    (res2_ptr->start_time >= job_end_time) ||
 			    (res2_ptr->end_time   <= job_start_time))
 				continue;
 			bit_not(res2_ptr->node_bitmap);
@@ -2894,7 +3069,6 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 			bit_not(res2_ptr->node_bitmap);
 			overlap_resv = true;
 		}
-		list_iterator_destroy(iter);
 
 		if (slurm_get_debug_flags() & DEBUG_FLAG_RESERVATION) {
 			char *nodes=bitmap2node_name(*node_bitmap);
@@ -2918,14 +3092,26 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	for (i=0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		if (!iter)
-			fatal("malloc: list_iterator_create");
-		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-			if (resv_ptr->end_time <= now)
-				_advance_resv_time(resv_ptr);
+		/* Fast path: the job's only constraint is to avoid the nodes
+		 * of all reservations overlapping its time window */
+		resv_bitmap = _resv_window_mask(job_start_time, job_end_time);
+		if ((job_ptr->license_list == NULL) &&
+		    ((job_ptr->details->req_node_bitmap == NULL) ||
+		     !bit_overlap(job_ptr->details->req_node_bitmap,
+				  resv_bitmap))) {
+			bit_not(resv_bitmap);
+			bit_and(*node_bitmap, resv_bitmap);
+			bit_not(resv_bitmap);
+			j = resv_index_cnt;	/* skip the scan below */
+		} else {
+			j = _first_resv_index(job_start_time -
+					      resv_index_max_dur);
+		}
+		for ( ; j < resv_index_cnt; j++) {
+			resv_ptr = resv_index[j];
+			if (resv_ptr->start_time >= job_end_time)
+				break;
 			if ((resv_ptr->node_bitmap == NULL) ||
-			    (resv_ptr->start_time >= job_end_time) ||
 			    (resv_ptr->end_time   <= job_start_time))
 				continue;
 			if (job_ptr->details->req_node_bitmap &&
@@ -2948,9 +3134,8 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 			bit_and(*node_bitmap, resv_ptr->node_bitmap);
 			bit_not(resv_ptr->node_bitmap);
 		}
-		list_iterator_destroy(iter);
 
-		if ((rc == SLURM_SUCCESS) && move_time) {
+		if ((rc == SLURM_SUCCESS) && move_time && test_lic) {
 			if (license_job_test(job_ptr, job_start_time)
 			    == EAGAIN) {
 				/* Need to postpone for licenses. Time returned
@@ -3056,6 +3241,7 @@ static void _advance_resv_time(slurmctld_resv_t *resv_ptr)
 		resv_ptr->start_time_prev = resv_ptr->start_time;
 		resv_ptr->start_time_first = resv_ptr->start_time;
 		_advance_time(&resv_ptr->end_time, day_cnt);
+		_invalidate_resv_index();
 		_post_resv_create(resv_ptr);
 		last_resv_update = time(NULL);
 		schedule_resv_save();
@@ -128,6 +128,14 @@ extern int job_test_lic_resv(struct job_record *job_ptr, char *lic_name,
 extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 			 bool move_time, bitstr_t **node_bitmap);
 
+/*
+ * Same as job_test_resv() with move_time set, except that the start time
+ *	is not postponed for licenses. For callers planning license
+ *	availability themselves.
+ */
+extern int job_test_resv_nodes(struct job_record *job_ptr, time_t *when,
+			       bitstr_t **node_bitmap);
+
 /*
  * Determine if a job can start now based only upon its reservations
  *	specification, if any
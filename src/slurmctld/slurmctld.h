@@ -80,6 +80,7 @@
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/switch.h"
 #include "src/common/timers.h"
+#include "src/common/vector.h"
 #include "src/common/xmalloc.h"
 
 /*****************************************************************************\
@@ -130,6 +131,12 @@
 #define PERIODIC_NODE_ACCT 300
 #endif
 
+/* Log memory allocated for each RPC type every PERIODIC_ALLOC_REPORT
+ * seconds, if DebugFlags=XMalloc is set */
+#ifndef PERIODIC_ALLOC_REPORT
+#define PERIODIC_ALLOC_REPORT 300
+#endif
+
 /* Pathname of group file record for checking update times */
 #ifndef GROUP_FILE
 #define GROUP_FILE	"/etc/group"
@@ -462,6 +469,7 @@ struct job_record {
 	uint32_t group_id;		/* group submitted under */
 	uint32_t job_id;		/* job ID */
 	struct job_record *job_next;	/* next entry with same hash index */
+	int job_vector_inx;		/* handle of the record in job_vector */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
 	uint16_t job_state;	        /* state of the job */
 	uint16_t kill_on_node_fail;	/* 1 if job should be killed on
@@ -478,6 +486,13 @@ struct job_record {
 					 * a limit false if user set */
 	uint16_t limit_set_time;    	/* if time_limit was set from
 					 * a limit false if user set */
+	uint32_t limit_wait_epoch;	/* acct_policy limit epoch when the
+					 * job was last held by a limit,
+					 * 0 if not held */
+	uint32_t limit_wait_gen;	/* *limit_wait_gen_ptr at that time */
+	uint32_t *limit_wait_gen_ptr;	/* release_gen of the association or
+					 * QOS holding the job */
+	uint16_t limit_wait_reason;	/* state_reason it was held with */
 	uint16_t mail_type;		/* see MAIL_JOB_* in slurm.h */
 	char *mail_user;		/* user to get e-mail notification */
 	uint32_t magic;			/* magic cookie for data integrity */
@@ -617,6 +632,8 @@ struct 	step_record {
 };
 
 extern List job_list;			/* list of job_record entries */
+extern vector_t *job_vector;		/* the same job_record entries in an
+					 * array, faster to scan in full */
 
 /*****************************************************************************\
  *  Consumable Resources parameters and data structures
@@ -1324,6 +1341,7 @@ extern void node_no_resp_msg(void);
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN protocol_version - slurm protocol version of client
+ * IN compact - pack the job records with set_buf_compact()
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -1331,7 +1349,7 @@ extern void node_no_resp_msg(void);
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid,
-			  uint16_t protocol_version);
+			  uint16_t protocol_version, bool compact);
 
 /*
  * pack_all_node - dump all configuration and node information for all nodes
@@ -1341,6 +1359,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN protocol_version - slurm protocol version of client
+ * IN compact - pack the node records with set_buf_compact()
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
  * NOTE: change slurm_load_node() in api/node_info.c when data format changes
@@ -1348,7 +1367,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
-			   uint16_t protocol_version);
+			   uint16_t protocol_version, bool compact);
 
 /*
  * pack_ctld_job_step_info_response_msg - packs job step info
@@ -1358,12 +1377,14 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
  * IN show_flags - job step filtering options
  * OUT buffer - location to store data, pointers automatically advanced
  * IN protocol_version - slurm protocol version of client
+ * IN compact - pack the step records with set_buf_compact()
  * RET - 0 or error code
  * NOTE: MUST free_buf buffer
  */
 extern int pack_ctld_job_step_info_response_msg(
 	uint32_t job_id, uint32_t step_id, uid_t uid,
-	uint16_t show_flags, Buf buffer, uint16_t protocol_version);
+	uint16_t show_flags, Buf buffer, uint16_t protocol_version,
+	bool compact);
 
 /*
  * pack_all_part - dump all partition information for all partitions in
@@ -2236,12 +2236,14 @@ static void _pack_ctld_job_step_info(struct step_record *step_ptr, Buf buffer,
  * IN uid - user issuing request
  * IN show_flags - job step filtering options
  * OUT buffer - location to store data, pointers automatically advanced
+ * IN compact - pack the step records with set_buf_compact()
  * RET - 0 or error code
  * NOTE: MUST free_buf buffer
  */
 extern int pack_ctld_job_step_info_response_msg(
 	uint32_t job_id, uint32_t step_id, uid_t uid,
-	uint16_t show_flags, Buf buffer, uint16_t protocol_version)
+	uint16_t show_flags, Buf buffer, uint16_t protocol_version,
+	bool compact)
 {
 	ListIterator job_iterator;
 	ListIterator step_iterator;
@@ -2255,6 +2257,7 @@ extern int pack_ctld_job_step_info_response_msg(
 	pack_time(now, buffer);
 	pack32(steps_packed, buffer);	/* steps_packed placeholder */
 
+	set_buf_compact(buffer, compact);
 	part_filter_set(uid);
 
 	job_iterator = list_iterator_create(job_list);
@@ -2292,6 +2295,7 @@ extern int pack_ctld_job_step_info_response_msg(
 		error_code = ESLURM_INVALID_JOB_ID;
 
 	part_filter_clear();
+	set_buf_compact(buffer, false);
 
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
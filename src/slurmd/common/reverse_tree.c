@@ -0,0 +1,307 @@
+/*****************************************************************************\
+ *  src/slurmd/common/reverse_tree.c - step completion aggregation
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/bitstring.h"
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+#include "src/slurmd/common/reverse_tree.h"
+
+struct reverse_tree_agg {
+	int rank;
+	int children;		/* descendants, ranks rank+1 to rank+children */
+	bitstr_t *done;		/* descendants which have completed */
+	bitstr_t *sent;		/* descendants already forwarded */
+	bitstr_t *batch;	/* descendants in the batch being sent */
+	int done_cnt;
+	int sent_cnt;
+	int batch_pos;		/* next bit of batch to examine */
+	bool batch_own;		/* local rank not yet sent in this batch */
+	bool in_batch;
+	bool own_sent;
+	bool started;
+	bool closed;
+	time_t next_flush;
+	int sub_size;		/* ranks in each direct child's subtree */
+	int sub_cnt;		/* count of direct children */
+	int *sub_done;		/* completed ranks in each subtree */
+	int *sub_levels;	/* levels in each subtree */
+	time_t *sub_deadline;
+};
+
+/* Nodes in a full tree of the given width with "levels" below its root */
+static int _geometric_series(int width, int levels)
+{
+	int i, sum = 1, pow = 1;
+
+	for (i = 0; i < levels; i++) {
+		pow *= width;
+		sum += pow;
+	}
+	return sum;
+}
+
+/* Levels below the root of a subtree which holds "nodes" of a full
+ * subtree "levels" deep. Ranks fill the first child's subtree before
+ * moving to the next one, so the first child always is the deepest. */
+static int _subtree_height(int nodes, int levels, int width)
+{
+	int height = 0;
+
+	while ((nodes > 1) && (levels > 0)) {
+		levels--;
+		nodes = MIN(nodes - 1, _geometric_series(width, levels));
+		height++;
+	}
+	return height;
+}
+
+extern reverse_tree_agg_t *reverse_tree_agg_create(int rank, int children,
+						   int depth, int max_depth,
+						   int width)
+{
+	reverse_tree_agg_t *agg = xmalloc(sizeof(reverse_tree_agg_t));
+	int i, levels, nodes;
+
+	agg->rank = rank;
+	agg->children = MAX(children, 0);
+	if (agg->children == 0)
+		return agg;
+
+	agg->done  = bit_alloc(agg->children);
+	agg->sent  = bit_alloc(agg->children);
+	agg->batch = bit_alloc(agg->children);
+
+	levels = MAX(max_depth - depth - 1, 0);
+	agg->sub_size = _geometric_series(MAX(width, 1), levels);
+	agg->sub_cnt = (agg->children + agg->sub_size - 1) / agg->sub_size;
+	agg->sub_done = xmalloc(sizeof(int) * agg->sub_cnt);
+	agg->sub_levels = xmalloc(sizeof(int) * agg->sub_cnt);
+	agg->sub_deadline = xmalloc(sizeof(time_t) * agg->sub_cnt);
+	for (i = 0; i < agg->sub_cnt; i++) {
+		nodes = MIN(agg->sub_size, agg->children - i * agg->sub_size);
+		agg->sub_levels[i] = _subtree_height(nodes, levels, width) + 1;
+	}
+	return agg;
+}
+
+extern void reverse_tree_agg_destroy(reverse_tree_agg_t *agg)
+{
+	if (agg == NULL)
+		return;
+	FREE_NULL_BITMAP(agg->done);
+	FREE_NULL_BITMAP(agg->sent);
+	FREE_NULL_BITMAP(agg->batch);
+	xfree(agg->sub_done);
+	xfree(agg->sub_levels);
+	xfree(agg->sub_deadline);
+	xfree(agg);
+}
+
+extern int reverse_tree_agg_record(reverse_tree_agg_t *agg,
+				   int first, int last)
+{
+	int i, bit;
+
+	if (agg->closed || (first > last) || (first <= agg->rank) ||
+	    (last > agg->rank + agg->children))
+		return SLURM_ERROR;
+
+	for (i = first; i <= last; i++) {
+		bit = i - (agg->rank + 1);
+		if (bit_test(agg->done, bit))
+			continue;
+		bit_set(agg->done, bit);
+		agg->done_cnt++;
+		agg->sub_done[bit / agg->sub_size]++;
+	}
+	return SLURM_SUCCESS;
+}
+
+extern void reverse_tree_agg_start(reverse_tree_agg_t *agg, time_t now)
+{
+	int i;
+
+	if (agg->started)
+		return;
+	agg->started = true;
+	agg->next_flush = now + REVERSE_TREE_FLUSH_DELAY;
+	for (i = 0; i < agg->sub_cnt; i++) {
+		agg->sub_deadline[i] = now + REVERSE_TREE_CHILDREN_TIMEOUT +
+			REVERSE_TREE_LEVEL_TIMEOUT * agg->sub_levels[i];
+	}
+}
+
+extern void reverse_tree_agg_close(reverse_tree_agg_t *agg)
+{
+	agg->started = true;
+	agg->closed = true;
+}
+
+extern int reverse_tree_agg_pending(reverse_tree_agg_t *agg)
+{
+	return agg->children - agg->done_cnt;
+}
+
+/* Return true if every subtree still missing completions is past its
+ * deadline, otherwise set "wake" to the earliest deadline not yet hit */
+static bool _subtrees_expired(reverse_tree_agg_t *agg, time_t now,
+			      time_t *wake)
+{
+	bool expired = true;
+	int i, nodes;
+
+	for (i = 0; i < agg->sub_cnt; i++) {
+		nodes = MIN(agg->sub_size, agg->children - i * agg->sub_size);
+		if ((agg->sub_done[i] == nodes) ||
+		    (agg->sub_deadline[i] <= now))
+			continue;
+		if (expired || (agg->sub_deadline[i] < *wake))
+			*wake = agg->sub_deadline[i];
+		expired = false;
+	}
+	return expired;
+}
+
+extern bool reverse_tree_agg_expired(reverse_tree_agg_t *agg, time_t now)
+{
+	time_t wake;
+
+	if (agg->closed || (agg->done_cnt == agg->children))
+		return true;
+	if (!agg->started)
+		return false;
+	return _subtrees_expired(agg, now, &wake);
+}
+
+/* Get the next range of ranks in the batch being sent */
+static bool _batch_range(reverse_tree_agg_t *agg, int *first, int *last)
+{
+	int i = agg->batch_pos, f = -1, l = -1;
+
+	while ((i < agg->children) && !bit_test(agg->batch, i))
+		i++;
+	if (i < agg->children) {
+		f = i;
+		while ((i < agg->children) && bit_test(agg->batch, i))
+			i++;
+		l = i - 1;
+	}
+
+	if (agg->batch_own) {
+		/* This rank is not in the bitmap, prepend it to the
+		 * range of its first descendants if there is one */
+		agg->batch_own = false;
+		*first = agg->rank;
+		if (f == 0) {
+			*last = agg->rank + 1 + l;
+			agg->batch_pos = i;
+		} else
+			*last = agg->rank;
+		return true;
+	}
+	if (f < 0)
+		return false;
+
+	*first = agg->rank + 1 + f;
+	*last  = agg->rank + 1 + l;
+	agg->batch_pos = i;
+	return true;
+}
+
+extern int reverse_tree_agg_next(reverse_tree_agg_t *agg, time_t now,
+				 int *first, int *last, time_t *wake)
+{
+	bool complete, unsent;
+
+	if (!agg->started) {
+		*wake = now + REVERSE_TREE_FLUSH_DELAY;
+		return REVERSE_TREE_AGG_WAIT;
+	}
+
+	if (agg->in_batch) {
+		if (_batch_range(agg, first, last))
+			return REVERSE_TREE_AGG_SEND;
+		agg->in_batch = false;
+		agg->next_flush = now + REVERSE_TREE_FLUSH_DELAY;
+	}
+
+	complete = (agg->done_cnt == agg->children);
+	if (!agg->closed && !complete && _subtrees_expired(agg, now, wake))
+		agg->closed = true;
+
+	unsent = (!agg->own_sent || (agg->sent_cnt < agg->done_cnt));
+	if (unsent && (complete || agg->closed || (now >= agg->next_flush))) {
+		/* Everything completed but not yet sent forms the batch */
+		if (agg->children) {
+			bit_copybits(agg->batch, agg->sent);
+			bit_not(agg->batch);
+			bit_and(agg->batch, agg->done);
+			bit_or(agg->sent, agg->batch);
+		}
+		agg->sent_cnt = agg->done_cnt;
+		agg->batch_pos = 0;
+		agg->batch_own = !agg->own_sent;
+		agg->own_sent = true;
+		agg->in_batch = true;
+		if (_batch_range(agg, first, last))
+			return REVERSE_TREE_AGG_SEND;
+		agg->in_batch = false;
+	}
+
+	if (complete || agg->closed) {
+		agg->closed = true;
+		return REVERSE_TREE_AGG_DONE;
+	}
+
+	if (unsent && (agg->next_flush < *wake))
+		*wake = agg->next_flush;
+	return REVERSE_TREE_AGG_WAIT;
+}
+
+extern int reverse_tree_retry_delay(int attempt)
+{
+	int delay = REVERSE_TREE_RETRY_MIN;
+
+	while ((attempt-- > 0) && (delay < REVERSE_TREE_RETRY_MAX))
+		delay *= 2;
+	return MIN(delay, REVERSE_TREE_RETRY_MAX);
+}
@@ -39,8 +39,77 @@
 #ifndef _REVERSE_TREE_H
 #define _REVERSE_TREE_H
 
+#include <stdbool.h>
+#include <time.h>
+
 #define REVERSE_TREE_WIDTH 7
 #define REVERSE_TREE_CHILDREN_TIMEOUT 60 /* seconds */
-#define REVERSE_TREE_PARENT_RETRY 5	/* count, 1 sec per attempt */
+#define REVERSE_TREE_LEVEL_TIMEOUT 3	/* seconds per tree level below */
+#define REVERSE_TREE_FLUSH_DELAY 1	/* seconds to batch completions */
+#define REVERSE_TREE_PARENT_RETRY 5	/* seconds spent retrying parent */
+#define REVERSE_TREE_RETRY_MIN 50	/* msec, first retry backoff */
+#define REVERSE_TREE_RETRY_MAX 1000	/* msec, largest retry backoff */
+
+/* Return codes of reverse_tree_agg_next() */
+#define REVERSE_TREE_AGG_WAIT 0	/* nothing to send before "wake" */
+#define REVERSE_TREE_AGG_SEND 1	/* send range "first" to "last" now */
+#define REVERSE_TREE_AGG_DONE 2	/* everything sent, stop waiting */
+
+/*
+ * Step completion aggregator for one node of the reverse tree.
+ *
+ * Completions reported by descendant ranks are recorded as they arrive
+ * and forwarded toward the root in batches, at most one batch every
+ * REVERSE_TREE_FLUSH_DELAY seconds, rather than all at once after every
+ * descendant has reported.  Each direct child's subtree gets its own
+ * deadline based upon its height, so a slow or dead subtree only holds
+ * back itself.  The aggregator does no locking, I/O or sleeping; the
+ * caller drives it with the current time.
+ */
+typedef struct reverse_tree_agg reverse_tree_agg_t;
+
+/* Create an aggregator for "rank" with "children" descendants (ranks
+ * rank+1 through rank+children) at "depth" of a "width" wide tree
+ * which is "max_depth" deep. */
+extern reverse_tree_agg_t *reverse_tree_agg_create(int rank, int children,
+						   int depth, int max_depth,
+						   int width);
+extern void reverse_tree_agg_destroy(reverse_tree_agg_t *agg);
+
+/* Record completion of descendant ranks "first" through "last".
+ * Returns SLURM_ERROR if the range is invalid or the aggregator has
+ * stopped waiting, in which case the sender must go to slurmctld. */
+extern int reverse_tree_agg_record(reverse_tree_agg_t *agg,
+				   int first, int last);
+
+/* The local rank has completed at time "now", start the deadlines.
+ * Later calls keep the deadlines set by the first one. */
+extern void reverse_tree_agg_start(reverse_tree_agg_t *agg, time_t now);
+
+/* Stop waiting for descendants, anything recorded (and the local rank,
+ * even if reverse_tree_agg_start() was never called) is still sent */
+extern void reverse_tree_agg_close(reverse_tree_agg_t *agg);
+
+/* Return the count of descendants which have not yet completed */
+extern int reverse_tree_agg_pending(reverse_tree_agg_t *agg);
+
+/* True at "now" once there is nothing left worth waiting for: every
+ * descendant has completed, or every subtree missing completions is
+ * past its deadline.  False until reverse_tree_agg_start() is called. */
+extern bool reverse_tree_agg_expired(reverse_tree_agg_t *agg, time_t now);
+
+/*
+ * Determine what to do at time "now". Returns REVERSE_TREE_AGG_SEND
+ * with the next range of ranks to forward (the local rank is included
+ * in the first range sent), REVERSE_TREE_AGG_WAIT with the time at
+ * which to call again in "wake" (or earlier if a completion arrives),
+ * or REVERSE_TREE_AGG_DONE once there is nothing more to send.
+ */
+extern int reverse_tree_agg_next(reverse_tree_agg_t *agg, time_t now,
+				 int *first, int *last, time_t *wake);
+
+/* Return the delay in msec before retry "attempt" (zero origin) to the
+ * parent, doubling from REVERSE_TREE_RETRY_MIN to REVERSE_TREE_RETRY_MAX */
+extern int reverse_tree_retry_delay(int attempt);
 
 #endif /* !_REVERSE_TREE_H */
@@ -50,6 +50,7 @@
 #include <stdlib.h>
 #include <sys/param.h>		/* MAXPATHLEN */
 #include <sys/poll.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -64,6 +65,7 @@
 #include "src/common/jobacct_common.h"
 #include "src/common/list.h"
 #include "src/common/log.h"
+#include "src/common/lz_compress.h"
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
 #include "src/common/read_config.h"
@@ -80,7 +82,9 @@
 #include "src/common/xmalloc.h"
 
 #include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmd/req.h"
 #include "src/slurmd/slurmd/reverse_tree_math.h"
+#include "src/slurmd/slurmd/step_registry.h"
 #include "src/slurmd/slurmd/xcpu.h"
 
 #include "src/slurmd/common/proctrack.h"
@@ -153,6 +157,8 @@ static int  _rpc_file_bcast(slurm_msg_t *msg);
 static int  _rpc_ping(slurm_msg_t *);
 static int  _rpc_health_check(slurm_msg_t *);
 static int  _rpc_step_complete(slurm_msg_t *msg);
+static int  _rpc_launch_relay(slurm_msg_t *msg);
+static int  _rpc_io_relay_port(slurm_msg_t *msg);
 static int  _rpc_stat_jobacct(slurm_msg_t *msg);
 static int  _rpc_list_pids(slurm_msg_t *msg);
 static int  _rpc_daemon_status(slurm_msg_t *msg);
@@ -169,7 +175,7 @@ static int  _waiter_complete (uint32_t jobid);
 
 static bool _steps_completed_now(uint32_t jobid);
 static int  _valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid,
-			       uint16_t block_no);
+			       uint16_t block_no, uint32_t *job_id);
 static void _wait_state_completed(uint32_t jobid, int max_delay);
 static long _get_job_uid(uint32_t jobid);
 
@@ -195,10 +201,45 @@ static pthread_mutex_t launch_mutex = PTHREAD_MUTEX_INITIALIZER;
 static time_t startup = 0;		/* daemon startup time */
 static time_t last_slurmctld_msg = 0;
 
+/*
+ *  Pool of idle slurmstepd processes, see stepd_pool_fill()
+ */
+typedef struct stepd_pool_ent {
+	int to_stepd;		/* write end of the slurmstepd's stdin */
+	int to_slurmd;		/* read end of the slurmstepd's stdout */
+} stepd_pool_ent_t;
+
+static pthread_mutex_t stepd_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static stepd_pool_ent_t *stepd_pool = NULL;
+static int stepd_pool_cnt = 0;
+static int stepd_pool_size = 0;
+static uint32_t stepd_pool_gen = 0;	/* bumped by stepd_pool_flush() */
+static bool stepd_pool_filling = false;
+
 static pthread_mutex_t job_limits_mutex = PTHREAD_MUTEX_INITIALIZER;
 static List job_limits_list = NULL;
 static bool job_limits_loaded = false;
 
+/*
+ *  Files being written by sbcast, kept open across the blocks of a transfer
+ */
+#define BCAST_FILE_TIMEOUT 300	/* close files idle this many seconds */
+
+typedef struct bcast_file {
+	char *fname;		/* destination file name */
+	uint32_t job_id;	/* job the sbcast credential is for */
+	uid_t uid;		/* user who opened the file */
+	int fd;			/* file opened as that user */
+	int ref_cnt;		/* RPCs currently writing to fd */
+	bool removed;		/* off bcast_file_list, close when unused */
+	uint64_t next_offset;	/* end of last block appended */
+	time_t last_update;	/* time of last block written */
+	struct bcast_file *next;
+} bcast_file_t;
+
+static pthread_mutex_t bcast_file_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bcast_file_t *bcast_file_list = NULL;
+
 /* NUM_PARALLEL_SUSPEND controls the number of jobs suspended/resumed
  * at one time as well as the number of jobsteps per job that can be
  * suspended at one time */
@@ -237,6 +278,7 @@ slurmd_req(slurm_msg_t *msg)
 		_rpc_batch_job(msg);
 		last_slurmctld_msg = time(NULL);
 		slurm_free_job_launch_msg(msg->data);
+		stepd_pool_fill();
 		break;
 	case REQUEST_LAUNCH_TASKS:
 		debug2("Processing RPC: REQUEST_LAUNCH_TASKS");
@@ -244,6 +286,7 @@ slurmd_req(slurm_msg_t *msg)
 		_rpc_launch_tasks(msg);
 		slurm_free_launch_tasks_request_msg(msg->data);
 		slurm_mutex_unlock(&launch_mutex);
+		stepd_pool_fill();
 		break;
 	case REQUEST_SIGNAL_TASKS:
 		debug2("Processing RPC: REQUEST_SIGNAL_TASKS");
@@ -345,6 +388,14 @@ slurmd_req(slurm_msg_t *msg)
 		rc = _rpc_step_complete(msg);
 		slurm_free_step_complete_msg(msg->data);
 		break;
+	case RESPONSE_LAUNCH_TASKS_RELAY:
+		rc = _rpc_launch_relay(msg);
+		slurm_free_launch_tasks_relay_msg(msg->data);
+		break;
+	case REQUEST_IO_RELAY_PORT:
+		rc = _rpc_io_relay_port(msg);
+		slurm_free_job_step_id_msg(msg->data);
+		break;
 	case REQUEST_JOB_STEP_STAT:
 		rc = _rpc_stat_jobacct(msg);
 		slurm_free_job_step_id_msg(msg->data);
@@ -545,87 +596,28 @@ rwfail:
 
 
 /*
- * Fork and exec the slurmstepd, then send the slurmstepd its
- * initialization data.  Then wait for slurmstepd to send an "ok"
- * message before returning.  When the "ok" message is received,
- * the slurmstepd has created and begun listening on its unix
- * domain socket.
+ * Fork and exec a slurmstepd which reads its initialization data from
+ * to_stepd[0] and replies on to_slurmd[1].  Returns the pid of the
+ * intermediate child, which the caller must reap, or -1 on error.  The
+ * slurmstepd's ends of the pipes are closed in the parent.
  *
  * Note that this code forks twice and it is the grandchild that
  * becomes the slurmstepd process, so the slurmstepd's parent process
  * will be init, not slurmd.
  */
-static int
-_forkexec_slurmstepd(slurmd_step_type_t type, void *req,
-		     slurm_addr_t *cli, slurm_addr_t *self,
-		     const hostset_t step_hset)
+static pid_t
+_spawn_slurmstepd(int to_stepd[2], int to_slurmd[2])
 {
 	pid_t pid;
-	int to_stepd[2] = {-1, -1};
-	int to_slurmd[2] = {-1, -1};
-
-	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
-		error("_forkexec_slurmstepd pipe failed: %m");
-		return SLURM_FAILURE;
-	}
-
-	if (_add_starting_step(type, req)) {
-		error("_forkexec_slurmstepd failed in _add_starting_step: %m");
-		return SLURM_FAILURE;
-	}
 
 	if ((pid = fork()) < 0) {
-		error("_forkexec_slurmstepd: fork: %m");
-		close(to_stepd[0]);
-		close(to_stepd[1]);
-		close(to_slurmd[0]);
-		close(to_slurmd[1]);
-		_remove_starting_step(type, req);
-		return SLURM_FAILURE;
+		return -1;
 	} else if (pid > 0) {
-		int rc = 0;
-		time_t start_time = time(NULL);
-		/*
-		 * Parent sends initialization data to the slurmstepd
-		 * over the to_stepd pipe, and waits for the return code
-		 * reply on the to_slurmd pipe.
-		 */
 		if (close(to_stepd[0]) < 0)
 			error("Unable to close read to_stepd in parent: %m");
 		if (close(to_slurmd[1]) < 0)
 			error("Unable to close write to_slurmd in parent: %m");
-
-		if ((rc = _send_slurmstepd_init(to_stepd[1], type,
-						req, cli, self,
-						step_hset)) != 0) {
-			error("Unable to init slurmstepd");
-			goto done;
-		}
-		if (read(to_slurmd[0], &rc, sizeof(int)) != sizeof(int)) {
-			error("Error reading return code message "
-			      "from slurmstepd: %m");
-			rc = SLURM_FAILURE;
-		} else {
-			int delta_time = time(NULL) - start_time;
-			if (delta_time > 5) {
-				info("Warning: slurmstepd startup took %d sec, "
-				     "possible file system problem or full "
-				     "memory", delta_time);
-			}
-		}
-
-	done:
-		if (_remove_starting_step(type, req))
-			error("Error cleaning up starting_step list");
-
-		/* Reap child */
-		if (waitpid(pid, NULL, 0) < 0)
-			error("Unable to reap slurmd child process");
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in parent: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-		return rc;
+		return pid;
 	} else {
 		char slurm_stepd_path[MAXPATHLEN];
 		char *const argv[2] = { slurm_stepd_path, NULL};
@@ -644,11 +636,11 @@ _forkexec_slurmstepd(slurmd_step_type_t type, void *req,
 		 * Child forks and exits
 		 */
 		if (setsid() < 0) {
-			error("_forkexec_slurmstepd: setsid: %m");
+			error("_spawn_slurmstepd: setsid: %m");
 			failed = 1;
 		}
 		if ((pid = fork()) < 0) {
-			error("_forkexec_slurmstepd: "
+			error("_spawn_slurmstepd: "
 			      "Unable to fork grandchild: %m");
 			failed = 2;
 		} else if (pid > 0) { /* child */
@@ -688,6 +680,249 @@ _forkexec_slurmstepd(slurmd_step_type_t type, void *req,
 	}
 }
 
+/*
+ * Take an idle slurmstepd from the pool.  Its pipes are returned in
+ * *to_stepd (write end of its stdin) and *to_slurmd (read end of its
+ * stdout).  A pooled slurmstepd never writes before it is given a step,
+ * so one whose pipe reads as ready or hung up has died and is discarded.
+ * RET SLURM_SUCCESS or SLURM_ERROR if the pool is empty
+ */
+static int
+_stepd_pool_get(int *to_stepd, int *to_slurmd)
+{
+	struct pollfd pfd;
+	int rc = SLURM_ERROR;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	while (stepd_pool_cnt > 0) {
+		stepd_pool_cnt--;
+		pfd.fd = stepd_pool[stepd_pool_cnt].to_slurmd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if ((poll(&pfd, 1, 0) == 0) && (pfd.revents == 0)) {
+			*to_stepd  = stepd_pool[stepd_pool_cnt].to_stepd;
+			*to_slurmd = stepd_pool[stepd_pool_cnt].to_slurmd;
+			rc = SLURM_SUCCESS;
+			break;
+		}
+		debug("discarding defunct pooled slurmstepd");
+		close(stepd_pool[stepd_pool_cnt].to_stepd);
+		close(stepd_pool[stepd_pool_cnt].to_slurmd);
+	}
+	slurm_mutex_unlock(&stepd_pool_mutex);
+
+	return rc;
+}
+
+/*
+ * Set the number of idle slurmstepd processes to keep and start them.
+ */
+extern void
+stepd_pool_init(int size)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	stepd_pool_size = size;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+	if (size > 0)
+		info("keeping %d idle slurmstepd processes", size);
+	stepd_pool_fill();
+}
+
+/*
+ * Start slurmstepd processes until the pool holds stepd_pool_size
+ * of them.  Each one execs and then blocks reading its initialization
+ * data, so it is ready to accept a step as soon as it is taken.  Only one
+ * thread fills the pool at a time, others return at once.
+ */
+extern void
+stepd_pool_fill(void)
+{
+	int to_stepd[2], to_slurmd[2];
+	uint32_t gen;
+	pid_t pid;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	if (stepd_pool_filling || (stepd_pool_cnt >= stepd_pool_size)) {
+		slurm_mutex_unlock(&stepd_pool_mutex);
+		return;
+	}
+	stepd_pool_filling = true;
+	while (stepd_pool_cnt < stepd_pool_size) {
+		gen = stepd_pool_gen;
+		slurm_mutex_unlock(&stepd_pool_mutex);
+
+		if (pipe(to_stepd) < 0) {
+			error("stepd_pool_fill: pipe failed: %m");
+			slurm_mutex_lock(&stepd_pool_mutex);
+			break;
+		}
+		if (pipe(to_slurmd) < 0) {
+			error("stepd_pool_fill: pipe failed: %m");
+			close(to_stepd[0]);
+			close(to_stepd[1]);
+			slurm_mutex_lock(&stepd_pool_mutex);
+			break;
+		}
+		fd_set_close_on_exec(to_stepd[1]);
+		fd_set_close_on_exec(to_slurmd[0]);
+		if ((pid = _spawn_slurmstepd(to_stepd, to_slurmd)) < 0) {
+			error("stepd_pool_fill: fork: %m");
+			close(to_stepd[0]);
+			close(to_stepd[1]);
+			close(to_slurmd[0]);
+			close(to_slurmd[1]);
+			slurm_mutex_lock(&stepd_pool_mutex);
+			break;
+		}
+		if (waitpid(pid, NULL, 0) < 0)
+			error("Unable to reap slurmd child process");
+
+		slurm_mutex_lock(&stepd_pool_mutex);
+		if ((gen != stepd_pool_gen) ||
+		    (stepd_pool_cnt >= stepd_pool_size)) {
+			/* Pool flushed or resized while this one started */
+			close(to_stepd[1]);
+			close(to_slurmd[0]);
+			continue;
+		}
+		if (stepd_pool == NULL) {
+			stepd_pool = xmalloc(sizeof(stepd_pool_ent_t) *
+					     stepd_pool_size);
+		}
+		stepd_pool[stepd_pool_cnt].to_stepd  = to_stepd[1];
+		stepd_pool[stepd_pool_cnt].to_slurmd = to_slurmd[0];
+		stepd_pool_cnt++;
+	}
+	stepd_pool_filling = false;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+}
+
+/*
+ * Discard every idle slurmstepd in the pool.  Closing their pipes makes
+ * them exit, so slurm.conf changes or a new slurmstepd binary take effect
+ * on the next fill.
+ */
+extern void
+stepd_pool_flush(void)
+{
+	int i;
+
+	slurm_mutex_lock(&stepd_pool_mutex);
+	for (i = 0; i < stepd_pool_cnt; i++) {
+		close(stepd_pool[i].to_stepd);
+		close(stepd_pool[i].to_slurmd);
+	}
+	stepd_pool_cnt = 0;
+	stepd_pool_gen++;
+	xfree(stepd_pool);
+	slurm_mutex_unlock(&stepd_pool_mutex);
+}
+
+/*
+ * Empty the pool and stop refilling it, called at shutdown.
+ */
+extern void
+stepd_pool_fini(void)
+{
+	slurm_mutex_lock(&stepd_pool_mutex);
+	stepd_pool_size = 0;
+	slurm_mutex_unlock(&stepd_pool_mutex);
+	stepd_pool_flush();
+}
+
+/*
+ * Start a slurmstepd, taking one from the pool if available and
+ * otherwise forking and exec'ing a new one, then send the slurmstepd
+ * its initialization data.  Then wait for slurmstepd to send an "ok"
+ * message before returning.  When the "ok" message is received,
+ * the slurmstepd has created and begun listening on its unix
+ * domain socket.
+ */
+/* Record a slurmstepd which started successfully in the step registry */
+static void
+_register_step(slurmd_step_type_t type, void *req)
+{
+	if (type == LAUNCH_BATCH_JOB) {
+		batch_job_launch_msg_t *batch = req;
+		step_registry_add(batch->job_id, batch->step_id);
+	} else if (type == LAUNCH_TASKS) {
+		launch_tasks_request_msg_t *launch = req;
+		step_registry_add(launch->job_id, launch->job_step_id);
+	}
+}
+
+static int
+_forkexec_slurmstepd(slurmd_step_type_t type, void *req,
+		     slurm_addr_t *cli, slurm_addr_t *self,
+		     const hostset_t step_hset)
+{
+	pid_t pid = 0;
+	int to_stepd[2] = {-1, -1};
+	int to_slurmd[2] = {-1, -1};
+	int rc = 0;
+	time_t start_time = time(NULL);
+
+	if (_add_starting_step(type, req)) {
+		error("_forkexec_slurmstepd failed in _add_starting_step: %m");
+		return SLURM_FAILURE;
+	}
+
+	if (_stepd_pool_get(&to_stepd[1], &to_slurmd[0]) != SLURM_SUCCESS) {
+		if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
+			error("_forkexec_slurmstepd pipe failed: %m");
+			_remove_starting_step(type, req);
+			return SLURM_FAILURE;
+		}
+		if ((pid = _spawn_slurmstepd(to_stepd, to_slurmd)) < 0) {
+			error("_forkexec_slurmstepd: fork: %m");
+			close(to_stepd[0]);
+			close(to_stepd[1]);
+			close(to_slurmd[0]);
+			close(to_slurmd[1]);
+			_remove_starting_step(type, req);
+			return SLURM_FAILURE;
+		}
+	}
+
+	/*
+	 * Send initialization data to the slurmstepd over the to_stepd
+	 * pipe, and wait for the return code reply on the to_slurmd pipe.
+	 */
+	if ((rc = _send_slurmstepd_init(to_stepd[1], type,
+					req, cli, self,
+					step_hset)) != 0) {
+		error("Unable to init slurmstepd");
+		goto done;
+	}
+	if (read(to_slurmd[0], &rc, sizeof(int)) != sizeof(int)) {
+		error("Error reading return code message "
+		      "from slurmstepd: %m");
+		rc = SLURM_FAILURE;
+	} else {
+		int delta_time = time(NULL) - start_time;
+		if (delta_time > 5) {
+			info("Warning: slurmstepd startup took %d sec, "
+			     "possible file system problem or full "
+			     "memory", delta_time);
+		}
+		if (rc == SLURM_SUCCESS)
+			_register_step(type, req);
+	}
+
+done:
+	if (_remove_starting_step(type, req))
+		error("Error cleaning up starting_step list");
+
+	/* Reap child */
+	if ((pid > 0) && (waitpid(pid, NULL, 0) < 0))
+		error("Unable to reap slurmd child process");
+	if (close(to_stepd[1]) < 0)
+		error("close write to_stepd in parent: %m");
+	if (close(to_slurmd[0]) < 0)
+		error("close read to_slurmd in parent: %m");
+	return rc;
+}
+
 
 /*
  * The job(step) credential is the only place to get a definitive
@@ -1387,7 +1622,7 @@ _rpc_job_notify(slurm_msg_t *msg)
 		return;
 	}
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(req->job_id);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if ((stepd->jobid  != req->job_id) ||
@@ -1533,7 +1768,7 @@ _load_job_limits(void)
 		job_limits_list = list_create(_job_limits_free);
 	job_limits_loaded = true;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(NO_VAL);
 	step_iter = list_iterator_create(steps);
 	while ((stepd = list_next(step_iter))) {
 		job_limits_ptr = list_find_first(job_limits_list,
@@ -1660,7 +1895,7 @@ _enforce_job_mem_limit(void)
 		job_mem_info_ptr[i].vsize_limit *= (vsize_factor / 100.0);
 	}
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(NO_VAL);
 	step_iter = list_iterator_create(steps);
 	while ((stepd = list_next(step_iter))) {
 		for (job_inx=0; job_inx<job_cnt; job_inx++) {
@@ -2016,6 +2251,96 @@ done:
 	return rc;
 }
 
+/* Launch responses relayed by the slurmstepd of a child in the reverse
+ * tree, hand them to the local slurmstepd of the step */
+static int
+_rpc_launch_relay(slurm_msg_t *msg)
+{
+	launch_tasks_relay_msg_t *req = (launch_tasks_relay_msg_t *)msg->data;
+	int               rc = SLURM_SUCCESS;
+	int               fd;
+	uid_t             req_uid;
+
+	debug3("Entering _rpc_launch_relay");
+	/* only other slurmstepd relay launch responses */
+	req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	if (!_slurm_authorized_user(req_uid)) {
+		debug("launch relay from uid %ld for job %u.%u",
+		      (long) req_uid, req->job_id, req->job_step_id);
+		rc = ESLURM_USER_ID_MISSING;     /* or bad in this case */
+		goto done;
+	}
+
+	fd = stepd_connect(conf->spooldir, conf->node_name,
+			   req->job_id, req->job_step_id);
+	if (fd == -1) {
+		debug("stepd_connect to %u.%u failed: %m",
+		      req->job_id, req->job_step_id);
+		rc = ESLURM_INVALID_JOB_ID;
+		goto done;
+	}
+
+	rc = stepd_launch_relay(fd, req);
+	if (rc == -1)
+		rc = ESLURMD_JOB_NOTRUNNING;
+	close(fd);
+done:
+	slurm_send_rc_msg(msg, rc);
+
+	return rc;
+}
+
+/* Port of the local slurmstepd's I/O relay listener, asked for by the
+ * slurmstepd of a child in the reverse tree. The child runs as the job's
+ * user by then, so the job owner is allowed along with SlurmUser. */
+static int
+_rpc_io_relay_port(slurm_msg_t *msg)
+{
+	job_step_id_msg_t *req = (job_step_id_msg_t *)msg->data;
+	io_relay_port_msg_t resp;
+	slurm_msg_t resp_msg;
+	int fd;
+	uid_t req_uid;
+	long job_uid;
+
+	debug3("Entering _rpc_io_relay_port");
+	req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	job_uid = _get_job_uid(req->job_id);
+	if (job_uid < 0) {
+		slurm_send_rc_msg(msg, ESLURM_INVALID_JOB_ID);
+		return ESLURM_INVALID_JOB_ID;
+	}
+	if ((req_uid != job_uid) && (!_slurm_authorized_user(req_uid))) {
+		error("io relay port request from uid %ld for job %u "
+		      "owned by uid %ld",
+		      (long) req_uid, req->job_id, job_uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return ESLURM_USER_ID_MISSING;
+	}
+
+	fd = stepd_connect(conf->spooldir, conf->node_name,
+			   req->job_id, req->step_id);
+	if (fd == -1) {
+		debug("stepd_connect to %u.%u failed: %m",
+		      req->job_id, req->step_id);
+		slurm_send_rc_msg(msg, ESLURM_INVALID_JOB_ID);
+		return ESLURM_INVALID_JOB_ID;
+	}
+	if (stepd_io_relay_port(fd, &resp.port) != SLURM_SUCCESS) {
+		close(fd);
+		slurm_send_rc_msg(msg, ESLURMD_JOB_NOTRUNNING);
+		return ESLURMD_JOB_NOTRUNNING;
+	}
+	close(fd);
+
+	slurm_msg_t_copy(&resp_msg, msg);
+	resp_msg.msg_type = RESPONSE_IO_RELAY_PORT;
+	resp_msg.data     = &resp;
+	slurm_send_node_msg(msg->conn_fd, &resp_msg);
+
+	return SLURM_SUCCESS;
+}
+
 /* Get list of active jobs and steps, xfree returned value */
 static char *
 _get_step_list(void)
@@ -2026,7 +2351,7 @@ _get_step_list(void)
 	ListIterator i;
 	step_loc_t *stepd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		int fd;
@@ -2321,7 +2646,7 @@ static void  _rpc_pid2jid(slurm_msg_t *msg)
 	ListIterator i;
 	step_loc_t *stepd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		int fd;
@@ -2384,15 +2709,15 @@ _init_groups(uid_t my_uid, gid_t my_gid)
  * Munge without generating a credential replay error
  * RET SLURM_SUCCESS or an error code */
 static int
-_valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid, uint16_t block_no)
+_valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid, uint16_t block_no,
+		   uint32_t *job_id)
 {
 	int rc = SLURM_SUCCESS;
-	uint32_t job_id;
 	char *nodes = NULL;
 	hostset_t hset = NULL;
 
 	rc = extract_sbcast_cred(conf->vctx, req->cred, block_no,
-				 &job_id, &nodes);
+				 job_id, &nodes);
 	if (rc != 0) {
 		error("Security violation: Invalid sbcast_cred from uid %d",
 		      req_uid);
@@ -2416,58 +2741,88 @@ _valid_sbcast_cred(file_bcast_msg_t *req, uid_t req_uid, uint16_t block_no)
 	return rc;
 }
 
+/* Drop to the identity of the user requesting a file broadcast.
+ * Only called in a child process. RET -1 with errno set on failure */
 static int
-_rpc_file_bcast(slurm_msg_t *msg)
+_bcast_become_user(uid_t req_uid, gid_t req_gid)
 {
-	file_bcast_msg_t *req = msg->data;
-	int fd, flags, offset, inx, rc;
-	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
-	gid_t req_gid = g_slurm_auth_get_gid(msg->auth_cred, NULL);
+	if (_init_groups(req_uid, req_gid) < 0) {
+		error("sbcast: initgroups(%u): %m", req_uid);
+		return -1;
+	}
+	if (setgid(req_gid) < 0) {
+		error("sbcast: uid:%u setgid(%u): %s", req_uid, req_gid,
+		      strerror(errno));
+		return -1;
+	}
+	if (setuid(req_uid) < 0) {
+		error("sbcast: getuid(%u): %s", req_uid, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+/* Open the destination file with the user's permissions in a child
+ * process, which passes the file descriptor back over a socket pair so
+ * slurmd can keep writing to it without forking again.
+ * RET SLURM_SUCCESS or an errno value */
+static int
+_bcast_open(file_bcast_msg_t *req, uid_t req_uid, gid_t req_gid, int *fd_ptr)
+{
+	int fd, flags, rc, pair[2];
+	char cbuf[CMSG_SPACE(sizeof(int))], dummy = '\0';
+	struct iovec iov;
+	struct msghdr mh;
+	struct cmsghdr *cmsg;
 	pid_t child;
 
-#if 0
-	info("last_block=%u force=%u modes=%o",
-	     req->last_block, req->force, req->modes);
-	info("uid=%u gid=%u atime=%lu mtime=%lu block_len[0]=%u",
-	     req->uid, req->gid, req->atime, req->mtime, req->block_len);
-#if 0
-	/* when the file being transferred is binary, the following line
-	 * can break the terminal output for slurmd */
-	info("req->block[0]=%s, @ %lu", \
-	     req->block[0], (unsigned long) &req->block);
-#endif
-#endif
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) {
+		error("sbcast: socketpair: %m");
+		return errno;
+	}
 
-	if ((rc = _valid_sbcast_cred(req, req_uid, req->block_no)) !=
-	    SLURM_SUCCESS)
-		return rc;
+	memset(&mh, 0, sizeof(mh));
+	iov.iov_base = &dummy;
+	iov.iov_len  = 1;
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	mh.msg_control = cbuf;
+	mh.msg_controllen = sizeof(cbuf);
 
-	info("sbcast req_uid=%u fname=%s block_no=%u",
-	     req_uid, req->fname, req->block_no);
 	child = fork();
 	if (child == -1) {
 		error("sbcast: fork failure");
-		return errno;
+		rc = errno;
+		close(pair[0]);
+		close(pair[1]);
+		return rc;
 	} else if (child > 0) {
+		close(pair[1]);
+		*fd_ptr = -1;
+		if ((recvmsg(pair[0], &mh, 0) == 1) &&
+		    (cmsg = CMSG_FIRSTHDR(&mh)) &&
+		    (cmsg->cmsg_level == SOL_SOCKET) &&
+		    (cmsg->cmsg_type == SCM_RIGHTS))
+			memcpy(fd_ptr, CMSG_DATA(cmsg), sizeof(int));
+		close(pair[0]);
 		waitpid(child, &rc, 0);
-		return WEXITSTATUS(rc);
+		rc = WEXITSTATUS(rc);
+		if ((rc == 0) && (*fd_ptr == -1))
+			rc = SLURM_ERROR;
+		else if ((rc != 0) && (*fd_ptr != -1)) {
+			close(*fd_ptr);
+			*fd_ptr = -1;
+		}
+		if (*fd_ptr != -1)
+			fd_set_close_on_exec(*fd_ptr);
+		return rc;
 	}
 
-	/* The child actually performs the I/O and exits with
+	/* The child opens the file as the user and exits with
 	 * a return code, do not return! */
-	if (_init_groups(req_uid, req_gid) < 0) {
-		error("sbcast: initgroups(%u): %m", req_uid);
-		exit(errno);
-	}
-	if (setgid(req_gid) < 0) {
-		error("sbcast: uid:%u setgid(%u): %s", req_uid, req_gid,
-		      strerror(errno));
-		exit(errno);
-	}
-	if (setuid(req_uid) < 0) {
-		error("sbcast: getuid(%u): %s", req_uid, strerror(errno));
+	close(pair[0]);
+	if (_bcast_become_user(req_uid, req_gid) < 0)
 		exit(errno);
-	}
 
 	flags = O_WRONLY;
 	if (req->block_no == 1) {
@@ -2476,8 +2831,7 @@ _rpc_file_bcast(slurm_msg_t *msg)
 			flags |= O_TRUNC;
 		else
 			flags |= O_EXCL;
-	} else
-		flags |= O_APPEND;
+	}
 
 	fd = open(req->fname, flags, 0700);
 	if (fd == -1) {
@@ -2486,31 +2840,153 @@ _rpc_file_bcast(slurm_msg_t *msg)
 		exit(errno);
 	}
 
-	offset = 0;
-	while (req->block_len - offset) {
-		inx = write(fd, &req->block[offset],
-			    (req->block_len - offset));
-		if (inx == -1) {
-			if ((errno == EINTR) || (errno == EAGAIN))
-				continue;
-			error("sbcast: uid:%u can't write `%s`: %s",
-			      req_uid, req->fname, strerror(errno));
-			close(fd);
-			exit(errno);
+	mh.msg_controllen = sizeof(cbuf);
+	cmsg = CMSG_FIRSTHDR(&mh);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type  = SCM_RIGHTS;
+	cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+	if (sendmsg(pair[1], &mh, 0) != 1) {
+		error("sbcast: sendmsg: %m");
+		exit(errno);
+	}
+	exit(SLURM_SUCCESS);
+}
+
+/* Close an open broadcast file once no RPC is using it */
+static void
+_bcast_file_free(bcast_file_t *bfile)
+{
+	close(bfile->fd);
+	xfree(bfile->fname);
+	xfree(bfile);
+}
+
+/* Find the open file for a broadcast block, opening the file for the
+ * first block of a transfer or if the file was closed since the previous
+ * block. Sets *offset to where the block is to be written.
+ * RET SLURM_SUCCESS or an errno value */
+static int
+_bcast_file_get(file_bcast_msg_t *req, uint32_t job_id, uid_t req_uid,
+		gid_t req_gid, bcast_file_t **bfile_ptr, uint64_t *offset)
+{
+	bcast_file_t *bfile, **bfile_pp;
+	time_t now = time(NULL);
+	int fd = -1, rc;
+
+	slurm_mutex_lock(&bcast_file_mutex);
+	bfile_pp = &bcast_file_list;
+	while ((bfile = *bfile_pp)) {
+		if ((bfile->job_id == job_id) && (bfile->uid == req_uid) &&
+		    !strcmp(bfile->fname, req->fname) &&
+		    (req->block_no != 1))
+			break;
+		if ((bfile->ref_cnt == 0) &&
+		    (((now - bfile->last_update) > BCAST_FILE_TIMEOUT) ||
+		     ((bfile->job_id == job_id) &&
+		      (bfile->uid == req_uid) &&
+		      !strcmp(bfile->fname, req->fname)))) {
+			/* idle, or replaced by a new transfer */
+			*bfile_pp = bfile->next;
+			_bcast_file_free(bfile);
+			continue;
 		}
-		offset += inx;
+		bfile_pp = &bfile->next;
+	}
+	if (bfile) {
+		bfile->ref_cnt++;
+		bfile->last_update = now;
+		if (req->block_offset == BCAST_APPEND_OFFSET) {
+			*offset = bfile->next_offset;
+			bfile->next_offset += req->uncomp_len;
+		} else
+			*offset = req->block_offset;
+		slurm_mutex_unlock(&bcast_file_mutex);
+		*bfile_ptr = bfile;
+		return SLURM_SUCCESS;
 	}
-	if (req->last_block && fchmod(fd, (req->modes & 0777))) {
+	slurm_mutex_unlock(&bcast_file_mutex);
+
+	if ((rc = _bcast_open(req, req_uid, req_gid, &fd)))
+		return rc;
+
+	bfile = xmalloc(sizeof(bcast_file_t));
+	bfile->fname = xstrdup(req->fname);
+	bfile->job_id = job_id;
+	bfile->uid = req_uid;
+	bfile->fd = fd;
+	bfile->ref_cnt = 1;
+	bfile->last_update = now;
+	if (req->block_offset == BCAST_APPEND_OFFSET) {
+		/* in order transfer, append to what is already there */
+		*offset = (uint64_t) lseek(fd, 0, SEEK_END);
+		bfile->next_offset = *offset + req->uncomp_len;
+	} else
+		*offset = req->block_offset;
+
+	slurm_mutex_lock(&bcast_file_mutex);
+	bfile->next = bcast_file_list;
+	bcast_file_list = bfile;
+	slurm_mutex_unlock(&bcast_file_mutex);
+	*bfile_ptr = bfile;
+	return SLURM_SUCCESS;
+}
+
+/* Release a file found by _bcast_file_get(), closing it after the last
+ * block of the transfer */
+static void
+_bcast_file_put(bcast_file_t *bfile, bool last_block)
+{
+	bcast_file_t **bfile_pp;
+
+	slurm_mutex_lock(&bcast_file_mutex);
+	if (last_block && !bfile->removed) {
+		for (bfile_pp = &bcast_file_list; *bfile_pp;
+		     bfile_pp = &(*bfile_pp)->next) {
+			if (*bfile_pp == bfile) {
+				*bfile_pp = bfile->next;
+				break;
+			}
+		}
+		bfile->removed = true;
+	}
+	if ((--bfile->ref_cnt == 0) && bfile->removed)
+		_bcast_file_free(bfile);
+	slurm_mutex_unlock(&bcast_file_mutex);
+}
+
+/* Set the destination file's owner, modes and times as the user once
+ * its last block is written. RET SLURM_SUCCESS or an errno value */
+static int
+_bcast_file_finish(file_bcast_msg_t *req, int fd, uid_t req_uid,
+		   gid_t req_gid)
+{
+	pid_t child;
+	int rc;
+
+	child = fork();
+	if (child == -1) {
+		error("sbcast: fork failure");
+		return errno;
+	} else if (child > 0) {
+		waitpid(child, &rc, 0);
+		return WEXITSTATUS(rc);
+	}
+
+	/* The child sets the attributes as the user and exits with
+	 * a return code, do not return! */
+	if (_bcast_become_user(req_uid, req_gid) < 0)
+		exit(errno);
+
+	if (fchmod(fd, (req->modes & 0777))) {
 		error("sbcast: uid:%u can't chmod `%s`: %s",
 		      req_uid, req->fname, strerror(errno));
 	}
-	if (req->last_block && fchown(fd, req->uid, req->gid)) {
+	if (fchown(fd, req->uid, req->gid)) {
 		error("sbcast: uid:%u can't chown `%s`: %s",
 		      req_uid, req->fname, strerror(errno));
 	}
-	close(fd);
-	fd = 0;
-	if (req->last_block && req->atime) {
+	if (req->atime) {
 		struct utimbuf time_buf;
 		time_buf.actime  = req->atime;
 		time_buf.modtime = req->mtime;
@@ -2522,6 +2998,93 @@ _rpc_file_bcast(slurm_msg_t *msg)
 	exit(SLURM_SUCCESS);
 }
 
+static int
+_rpc_file_bcast(slurm_msg_t *msg)
+{
+	file_bcast_msg_t *req = msg->data;
+	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	gid_t req_gid = g_slurm_auth_get_gid(msg->auth_cred, NULL);
+	bcast_file_t *bfile = NULL;
+	char *data, *uncomp_buf = NULL;
+	uint32_t job_id, len;
+	uint64_t offset;
+	ssize_t inx;
+	int rc;
+
+#if 0
+	info("last_block=%u force=%u modes=%o",
+	     req->last_block, req->force, req->modes);
+	info("uid=%u gid=%u atime=%lu mtime=%lu block_len[0]=%u",
+	     req->uid, req->gid, req->atime, req->mtime, req->block_len);
+#if 0
+	/* when the file being transferred is binary, the following line
+	 * can break the terminal output for slurmd */
+	info("req->block[0]=%s, @ %lu", \
+	     req->block[0], (unsigned long) &req->block);
+#endif
+#endif
+
+	if ((rc = _valid_sbcast_cred(req, req_uid, req->block_no, &job_id))
+	    != SLURM_SUCCESS)
+		return rc;
+
+	info("sbcast req_uid=%u fname=%s block_no=%u",
+	     req_uid, req->fname, req->block_no);
+
+	data = req->block;
+	len  = req->block_len;
+	if (req->compress == COMPRESS_LZ) {
+		/* LZ expands at most 255 to 1, reject anything larger
+		 * rather than allocating it */
+		if (req->uncomp_len > (((uint64_t) req->block_len + 1) * 255)) {
+			error("sbcast: uid:%u bad block length for `%s`",
+			      req_uid, req->fname);
+			return EINVAL;
+		}
+		uncomp_buf = xmalloc(req->uncomp_len);
+		if (lz_decompress(req->block, req->block_len, uncomp_buf,
+				  req->uncomp_len) != req->uncomp_len) {
+			error("sbcast: uid:%u corrupt block for `%s`",
+			      req_uid, req->fname);
+			xfree(uncomp_buf);
+			return EINVAL;
+		}
+		data = uncomp_buf;
+		len  = req->uncomp_len;
+	} else if (req->compress != COMPRESS_OFF) {
+		error("sbcast: uid:%u unknown compression type %u",
+		      req_uid, req->compress);
+		return EINVAL;
+	}
+
+	if ((rc = _bcast_file_get(req, job_id, req_uid, req_gid, &bfile,
+				  &offset))) {
+		xfree(uncomp_buf);
+		return rc;
+	}
+
+	while (len) {
+		inx = pwrite(bfile->fd, data, len, offset);
+		if (inx == -1) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			rc = errno;
+			error("sbcast: uid:%u can't write `%s`: %s",
+			      req_uid, req->fname, strerror(errno));
+			break;
+		}
+		data   += inx;
+		len    -= inx;
+		offset += inx;
+	}
+	xfree(uncomp_buf);
+
+	if (req->last_block && (rc == SLURM_SUCCESS))
+		rc = _bcast_file_finish(req, bfile->fd, req_uid, req_gid);
+	_bcast_file_put(bfile, (req->last_block || rc));
+	return rc;
+}
+
 static void
 _rpc_reattach_tasks(slurm_msg_t *msg)
 {
@@ -2634,7 +3197,7 @@ _get_job_uid(uint32_t jobid)
 	int fd;
 	long uid = -1;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(jobid);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid != jobid) {
@@ -2683,7 +3246,7 @@ _kill_all_active_steps(uint32_t jobid, int sig, bool batch)
 	int step_cnt  = 0;
 	int fd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(jobid);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid != jobid) {
@@ -2734,7 +3297,7 @@ _terminate_all_steps(uint32_t jobid, bool batch)
 	int step_cnt  = 0;
 	int fd;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(jobid);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid != jobid) {
@@ -2778,7 +3341,7 @@ _job_still_running(uint32_t job_id)
 	ListIterator i;
 	step_loc_t  *s     = NULL;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(job_id);
 	i = list_iterator_create(steps);
 	while ((s = list_next(i))) {
 		if (s->jobid == job_id) {
@@ -2835,7 +3398,7 @@ _steps_completed_now(uint32_t jobid)
 	step_loc_t *stepd;
 	bool rc = true;
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(jobid);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid == jobid) {
@@ -2951,7 +3514,7 @@ _rpc_signal_job(slurm_msg_t *msg)
 	 * Loop through all job steps for this job and signal the
 	 * step's process group through the slurmstepd.
 	 */
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(req->job_id);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		if (stepd->jobid != req->job_id) {
@@ -3124,7 +3687,7 @@ _rpc_suspend_job(slurm_msg_t *msg)
 	 * as appropriate. Since the "suspend" action contains a 'sleep 1',
 	 * suspend multiple jobsteps in parallel.
 	 */
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(req->job_id);
 	i = list_iterator_create(steps);
 
 	while (1) {
@@ -3239,6 +3802,7 @@ _rpc_abort_job(slurm_msg_t *msg)
 		 */
 		_pause_for_job_completion (req->job_id, req->nodes, 0);
 	}
+	step_registry_remove_job(req->job_id);
 
 	/*
 	 *  Begin expiration period for cached information about job.
@@ -3426,6 +3990,7 @@ _rpc_terminate_job(slurm_msg_t *msg)
 		 */
 		_pause_for_job_completion (req->job_id, req->nodes, 0);
 	}
+	step_registry_remove_job(req->job_id);
 
 	/*
 	 *  Begin expiration period for cached information about job.
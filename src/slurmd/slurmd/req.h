@@ -50,6 +50,15 @@ void slurmd_req(slurm_msg_t *msg);
 
 void destroy_starting_step(void *x);
 
-int init_gids_cache(int cache);
+void init_gids_cache(int cache);
+
+/* Pool of idle slurmstepd processes used for step and batch job launch.
+ * stepd_pool_init() sets the pool size and starts them, stepd_pool_fill()
+ * replaces those used, stepd_pool_flush() discards them (e.g. after a
+ * reconfigure) and stepd_pool_fini() discards them for good. */
+extern void stepd_pool_init(int size);
+extern void stepd_pool_fill(void);
+extern void stepd_pool_flush(void);
+extern void stepd_pool_fini(void);
 
 #endif
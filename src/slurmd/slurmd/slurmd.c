@@ -93,9 +93,10 @@
 #include "src/slurmd/slurmd/slurmd.h"
 #include "src/slurmd/slurmd/req.h"
 #include "src/slurmd/slurmd/get_mach_stat.h"
+#include "src/slurmd/slurmd/step_registry.h"
 #include "src/slurmd/common/proctrack.h"
 
-#define GETOPT_ARGS	"cCd:Df:hL:Mn:N:vV"
+#define GETOPT_ARGS	"cCd:Df:hL:Mn:N:P:vV"
 
 #ifndef MAXHOSTNAMELEN
 #  define MAXHOSTNAMELEN	64
@@ -145,6 +146,8 @@ static void      _init_conf(void);
 static void      _install_fork_handlers(void);
 static void 	 _kill_old_slurmd(void);
 static void      _msg_engine(void);
+static bool      _persist_conn_allowed(void);
+static bool      _persist_conn_wait(slurm_fd_t fd);
 static void      _print_conf(void);
 static void      _print_config(void);
 static void      _process_cmdline(int ac, char **av);
@@ -312,8 +315,11 @@ main (int argc, char *argv[])
 	list_install_fork_handlers();
 	slurm_conf_install_fork_handlers();
 
+	stepd_pool_init(conf->stepd_pool_size);
+
 	_spawn_registration_engine();
 	_msg_engine();
+	stepd_pool_fini();
 
 	/*
 	 * Close fd here, otherwise we'll deadlock since create_pidfile()
@@ -506,24 +512,40 @@ static void *
 _service_connection(void *arg)
 {
 	conn_t *con = (conn_t *) arg;
-	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	slurm_msg_t *msg;
 	int rc = SLURM_SUCCESS;
+	bool keep;
 
 	debug3("in the service_connection");
-	slurm_msg_t_init(msg);
-	if((rc = slurm_receive_msg_and_forward(con->fd, con->cli_addr, msg, 0))
-	   != SLURM_SUCCESS) {
-		error("service_connection: slurm_receive_msg: %m");
-		/* if this fails we need to make sure the nodes we forward
-		   to are taken care of and sent back. This way the control
-		   also has a better idea what happened to us */
-		slurm_send_rc_msg(msg, rc);
-		goto cleanup;
-	}
-	debug2("got this type of message %d", msg->msg_type);
-	slurmd_req(msg);
+	/* A persistent connection is serviced by this thread until it is
+	 * idle for too long or the request handler takes it over */
+	do {
+		keep = false;
+		msg = xmalloc(sizeof(slurm_msg_t));
+		slurm_msg_t_init(msg);
+		if((rc = slurm_receive_msg_and_forward(con->fd, con->cli_addr,
+						       msg, 0))
+		   != SLURM_SUCCESS) {
+			error("service_connection: slurm_receive_msg: %m");
+			/* if this fails we need to make sure the nodes we
+			   forward to are taken care of and sent back. This
+			   way the control also has a better idea what
+			   happened to us */
+			slurm_send_rc_msg(msg, rc);
+			break;
+		}
+		debug2("got this type of message %d", msg->msg_type);
+		keep = slurm_persist_conn_keep(msg, _persist_conn_allowed());
+		slurmd_req(msg);
+		/* the handler took over the connection */
+		if (msg->conn_fd < 0)
+			keep = false;
+		else if (keep && _persist_conn_wait(con->fd))
+			slurm_free_msg(msg);
+		else
+			keep = false;
+	} while (keep);
 
-cleanup:
 	if ((msg->conn_fd >= 0) && slurm_close_accepted_conn(msg->conn_fd) < 0)
 		error ("close(%d): %m", con->fd);
 
@@ -534,6 +556,37 @@ cleanup:
 	return NULL;
 }
 
+/* Persistent connections each hold a thread while idle, only keep them
+ * while at most half of the threads are in use */
+static bool
+_persist_conn_allowed(void)
+{
+	bool rc;
+
+	if (_shutdown || pthread_equal(pthread_self(), msg_pthread))
+		return false;
+	slurm_mutex_lock(&active_mutex);
+	rc = (active_threads <= (MAX_THREADS / 2));
+	slurm_mutex_unlock(&active_mutex);
+	return rc;
+}
+
+/* Wait for the next request on a persistent connection, RET true if one
+ * arrives before the connection is idle for MessagePersistTimeout plus
+ * MessageTimeout seconds */
+static bool
+_persist_conn_wait(slurm_fd_t fd)
+{
+	int i, rc, idle;
+
+	idle = slurm_get_msg_persist_timeout() + slurm_get_msg_timeout();
+	for (i = 0; (i < idle) && !_shutdown; i++) {
+		if ((rc = slurm_persist_conn_wait(fd, 1000)))
+			return (rc > 0);
+	}
+	return false;
+}
+
 extern int
 send_registration_msg(uint32_t status, bool startup)
 {
@@ -631,7 +684,7 @@ _fill_registration_msg(slurm_node_registration_status_msg_t *msg)
 			error("switch_g_build_node_info: %m");
 	}
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(NO_VAL);
 	msg->job_count = list_count(steps);
 	msg->job_id    = xmalloc(msg->job_count * sizeof(*msg->job_id));
 	/* Note: Running batch jobs will have step_id == NO_VAL */
@@ -877,6 +930,12 @@ _reconfigure(void)
 	 */
 	slurm_cred_ctx_key_update(conf->vctx, conf->pubkey);
 
+	/*
+	 * Idle slurmstepds loaded the old configuration, replace them
+	 */
+	stepd_pool_flush();
+	stepd_pool_fill();
+
 	/*
 	 * Reinitialize the groups cache
 	 */
@@ -891,7 +950,7 @@ _reconfigure(void)
 	 * file handle
 	 */
 
-	steps = stepd_available(conf->spooldir, conf->node_name);
+	steps = step_registry_list(NO_VAL);
 	i = list_iterator_create(steps);
 	while ((stepd = list_next(i))) {
 		int fd;
@@ -1136,6 +1195,15 @@ _process_cmdline(int ac, char **av)
 		case 'N':
 			conf->node_name = xstrdup(optarg);
 			break;
+		case 'P':
+			conf->stepd_pool_size = strtol(optarg, &tmp_char, 10);
+			if ((tmp_char[0] != '\0') ||
+			    (conf->stepd_pool_size < 0)) {
+				error("Invalid option for -P option (idle "
+				      "slurmstepd count), ignored");
+				conf->stepd_pool_size = 0;
+			}
+			break;
 		case 'v':
 			conf->debug_level++;
 			break;
@@ -1277,6 +1345,9 @@ _slurmd_init(void)
 		stepd_cleanup_sockets(conf->spooldir, conf->node_name);
 	}
 
+	/* Pick up the steps which survived a restart */
+	step_registry_init();
+
 	if (conf->daemonize) {
 		if (conf->logfile && (conf->logfile[0] == '/')) {
 			char *slash_ptr, *work_dir;
@@ -1402,6 +1473,7 @@ _slurmd_fini(void)
 	fini_setproctitle();
 	slurm_select_fini();
 	slurm_jobacct_gather_fini();
+	step_registry_fini();
 	return SLURM_SUCCESS;
 }
 
@@ -1520,6 +1592,7 @@ Usage: %s [OPTIONS]\n\
    -M          Use mlock() to lock slurmd pages into memory.\n\
    -n value    Run the daemon at the specified nice value.\n\
    -N host     Run the daemon for specified hostname.\n\
+   -P count    Keep count idle slurmstepd processes ready for launch.\n\
    -v          Verbose mode. Multiple -v's increase verbosity.\n\
    -V          Print version information and exit.\n", conf->prog);
 	return;
@@ -112,6 +112,7 @@ typedef struct slurmd_config {
 	char         *epilog;		/* Path to Epilog script	   */
 	char         *prolog;		/* Path to prolog script           */
 	char         *stepd_loc;	/* Non-standard slurmstepd path    */
+	int           stepd_pool_size;	/* idle slurmstepds to keep (-P)   */
 	char         *task_prolog;	/* per-task prolog script          */
 	char         *task_epilog;	/* per-task epilog script          */
 	int           port;		/* local slurmd port               */
@@ -0,0 +1,218 @@
+/*****************************************************************************\
+ *  src/slurmd/slurmd/step_registry.c - in-memory index of local job steps
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/stepd_api.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmd/step_registry.h"
+
+#define STEP_HASH_SIZE 256
+
+typedef struct step_reg {
+	uint32_t jobid;
+	uint32_t stepid;
+	struct step_reg *next;
+} step_reg_t;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static step_reg_t *step_hash[STEP_HASH_SIZE];
+
+static void
+_free_step_loc(void *x)
+{
+	step_loc_t *loc = (step_loc_t *) x;
+
+	xfree(loc->directory);
+	xfree(loc->nodename);
+	xfree(loc);
+}
+
+/* Return true if the step's slurmstepd socket still exists */
+static bool
+_step_socket_exists(step_reg_t *step)
+{
+	struct stat stat_buf;
+	char *path = NULL;
+	int rc;
+
+	xstrfmtcat(path, "%s/%s_%u.%u", conf->spooldir, conf->node_name,
+		   step->jobid, step->stepid);
+	rc = stat(path, &stat_buf);
+	xfree(path);
+	return (rc == 0);
+}
+
+/* Add a step if not already present, registry_lock must be held */
+static void
+_add_step(uint32_t jobid, uint32_t stepid)
+{
+	int inx = jobid % STEP_HASH_SIZE;
+	step_reg_t *step;
+
+	for (step = step_hash[inx]; step; step = step->next) {
+		if ((step->jobid == jobid) && (step->stepid == stepid))
+			return;
+	}
+	step = xmalloc(sizeof(step_reg_t));
+	step->jobid = jobid;
+	step->stepid = stepid;
+	step->next = step_hash[inx];
+	step_hash[inx] = step;
+}
+
+/* Move the live steps of one hash chain onto List "l", dropping steps whose
+ * socket is gone, registry_lock must be held */
+static void
+_list_chain(List l, int inx, uint32_t jobid)
+{
+	step_reg_t **prev = &step_hash[inx], *step;
+	step_loc_t *loc;
+
+	while ((step = *prev)) {
+		if ((jobid != NO_VAL) && (step->jobid != jobid)) {
+			prev = &step->next;
+			continue;
+		}
+		if (!_step_socket_exists(step)) {
+			debug3("step %u.%u no longer running",
+			       step->jobid, step->stepid);
+			*prev = step->next;
+			xfree(step);
+			continue;
+		}
+		loc = xmalloc(sizeof(step_loc_t));
+		loc->directory = xstrdup(conf->spooldir);
+		loc->nodename = xstrdup(conf->node_name);
+		loc->jobid = step->jobid;
+		loc->stepid = step->stepid;
+		list_append(l, loc);
+		prev = &step->next;
+	}
+}
+
+extern void
+step_registry_init(void)
+{
+	List steps;
+	ListIterator i;
+	step_loc_t *stepd;
+
+	step_registry_fini();
+
+	steps = stepd_available(conf->spooldir, conf->node_name);
+	if (steps == NULL)
+		return;
+	slurm_mutex_lock(&registry_lock);
+	i = list_iterator_create(steps);
+	while ((stepd = list_next(i)))
+		_add_step(stepd->jobid, stepd->stepid);
+	list_iterator_destroy(i);
+	slurm_mutex_unlock(&registry_lock);
+	debug("found %d running job steps", list_count(steps));
+	list_destroy(steps);
+}
+
+extern void
+step_registry_fini(void)
+{
+	step_reg_t *step;
+	int inx;
+
+	slurm_mutex_lock(&registry_lock);
+	for (inx = 0; inx < STEP_HASH_SIZE; inx++) {
+		while ((step = step_hash[inx])) {
+			step_hash[inx] = step->next;
+			xfree(step);
+		}
+	}
+	slurm_mutex_unlock(&registry_lock);
+}
+
+extern void
+step_registry_add(uint32_t jobid, uint32_t stepid)
+{
+	slurm_mutex_lock(&registry_lock);
+	_add_step(jobid, stepid);
+	slurm_mutex_unlock(&registry_lock);
+}
+
+extern void
+step_registry_remove_job(uint32_t jobid)
+{
+	int inx = jobid % STEP_HASH_SIZE;
+	step_reg_t **prev, *step;
+
+	slurm_mutex_lock(&registry_lock);
+	prev = &step_hash[inx];
+	while ((step = *prev)) {
+		if (step->jobid == jobid) {
+			*prev = step->next;
+			xfree(step);
+		} else
+			prev = &step->next;
+	}
+	slurm_mutex_unlock(&registry_lock);
+}
+
+extern List
+step_registry_list(uint32_t jobid)
+{
+	List l = list_create(_free_step_loc);
+	int inx;
+
+	slurm_mutex_lock(&registry_lock);
+	if (jobid != NO_VAL)
+		_list_chain(l, jobid % STEP_HASH_SIZE, jobid);
+	else {
+		for (inx = 0; inx < STEP_HASH_SIZE; inx++)
+			_list_chain(l, inx, NO_VAL);
+	}
+	slurm_mutex_unlock(&registry_lock);
+
+	return l;
+}
@@ -0,0 +1,82 @@
+/*****************************************************************************\
+ *  src/slurmd/slurmd/step_registry.h - in-memory index of local job steps
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _SLURMD_STEP_REGISTRY_H
+#define _SLURMD_STEP_REGISTRY_H
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if HAVE_INTTYPES_H
+#  include <inttypes.h>
+#else
+#  if HAVE_STDINT_H
+#    include <stdint.h>
+#  endif
+#endif
+
+#include "src/common/list.h"
+
+/*
+ * slurmd records each slurmstepd it starts here so that signal, terminate
+ * and status requests find a job's steps without scanning the spool
+ * directory. The spool directory is only scanned by step_registry_init(),
+ * to pick up steps which survived a slurmd restart. A step is dropped once
+ * its slurmstepd's socket is gone.
+ */
+
+/* Build the registry from the spool directory, call once conf is loaded */
+extern void step_registry_init(void);
+
+/* Release all registry state */
+extern void step_registry_fini(void);
+
+/* Record a step whose slurmstepd reported a successful start */
+extern void step_registry_add(uint32_t jobid, uint32_t stepid);
+
+/* Forget every step of a job, once its slurmstepds are known to be gone */
+extern void step_registry_remove_job(uint32_t jobid);
+
+/*
+ * Return a List of step_loc_t (see stepd_api.h) for the running steps of
+ * "jobid", or of all jobs if jobid is NO_VAL. Steps whose socket has gone
+ * away are dropped from the registry and not returned. The caller must
+ * destroy the List. Usable wherever stepd_available() would be.
+ */
+extern List step_registry_list(uint32_t jobid);
+
+#endif /* _SLURMD_STEP_REGISTRY_H */
@@ -65,6 +65,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -76,13 +77,17 @@
 #include "src/common/macros.h"
 #include "src/common/fd.h"
 #include "src/common/list.h"
+#include "src/common/net.h"
 #include "src/common/read_config.h"
+#include "src/common/slurm_auth.h"
+#include "src/common/slurm_protocol_api.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xsignal.h"
 #include "src/common/xstring.h"
 #include "src/common/write_labelled_message.h"
 
 #include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/common/reverse_tree.h"
 #include "src/slurmd/slurmstepd/io.h"
 #include "src/slurmd/slurmstepd/fname.h"
 #include "src/slurmd/slurmstepd/slurmstepd.h"
@@ -131,6 +136,8 @@ struct client_io_info {
 	bool is_local_file;
 };
 
+#define CLIENT_WRITE_IOV 16	/* messages gathered per _client_write() */
+
 
 static bool _local_file_writable(eio_obj_t *);
 static int  _local_file_write(eio_obj_t *, List);
@@ -204,11 +211,100 @@ static void  _spawn_window_manager(slurmd_task_info_t *task, slurmd_job_t *job);
 static void *_window_manager(void *arg);
 #endif
 
+/**********************************************************************
+ * IO relay declarations
+ *
+ * With TASK_IO_AGGREGATE, nodes below IO_RELAY_DEPTH in the reverse tree
+ * connect to the slurmstepd of their parent instead of srun, so srun
+ * holds at most 1 + 7 + 49 I/O connections whatever the step size.  The
+ * parent announces each child with a SLURM_IO_NODE_INIT message and then
+ * passes the child's messages on unchanged.
+ **********************************************************************/
+#define IO_RELAY_DEPTH		3
+#define IO_RELAY_PORT_WAIT	2000	/* msec spent asking for the port */
+#define IO_RELAY_ACK_TIMEOUT	5000	/* msec */
+#define IO_RELAY_INIT_TIMEOUT	2	/* sec, well within the child's
+					 * IO_RELAY_ACK_TIMEOUT */
+
+static bool _relay_listen_readable(eio_obj_t *);
+static int  _relay_listen_read(eio_obj_t *, List);
+
+struct io_operations relay_listen_ops = {
+	.readable = &_relay_listen_readable,
+	.handle_read = &_relay_listen_read,
+};
+
+static bool _relay_child_readable(eio_obj_t *);
+static bool _relay_child_writable(eio_obj_t *);
+static int  _relay_child_read(eio_obj_t *, List);
+static int  _relay_child_write(eio_obj_t *, List);
+
+struct io_operations relay_child_ops = {
+	.readable = &_relay_child_readable,
+	.writable = &_relay_child_writable,
+	.handle_read = &_relay_child_read,
+	.handle_write = &_relay_child_write,
+};
+
+static bool _relay_init_readable(eio_obj_t *);
+static int  _relay_init_read(eio_obj_t *, List);
+
+struct io_operations relay_init_ops = {
+	.readable = &_relay_init_readable,
+	.handle_read = &_relay_init_read,
+};
+
+/* A child's connection until its io init msg has arrived */
+struct relay_init_info {
+#ifndef NDEBUG
+#define RELAY_INIT_MAGIC  0x10105
+	int                   magic;
+#endif
+	slurmd_job_t    *job;		 /* pointer back to job data   */
+	time_t deadline;	/* reject the connection after this */
+	char *data;		/* io_init_msg_packed_size() bytes */
+	int length;		/* bytes read so far */
+};
+
+struct relay_child_info {
+#ifndef NDEBUG
+#define RELAY_CHILD_MAGIC  0x10104
+	int                   magic;
+#endif
+	slurmd_job_t    *job;		 /* pointer back to job data   */
+	uint32_t nodeid;
+
+	/* messages from the subtree, passed on to relay_upstream */
+	struct slurm_io_header header;
+	struct io_buf *in_msg;
+	int32_t in_remaining;
+	bool in_eof;
+	int stdout_objs;	/* open streams of the whole subtree */
+	int stderr_objs;
+
+	/* stdin messages for the subtree */
+	List msg_queue;
+	struct io_buf *out_msg;
+	int32_t out_remaining;
+	bool out_eof;
+};
+
+static eio_obj_t *relay_upstream = NULL;  /* initial client, if listening */
+static eio_obj_t *relay_parent = NULL;    /* initial client, if our parent */
+static List relay_children = NULL;	  /* eio_obj_t of relay children */
+static uint16_t relay_port = 0;
+
+static bool _relay_listen(slurmd_job_t *job);
+static int  _relay_connect(srun_info_t *srun, slurmd_job_t *job, bool relay);
+static void _relay_stdin(slurmd_job_t *job, io_hdr_t *header,
+			 struct io_buf *in);
+
 /**********************************************************************
  * General declarations
  **********************************************************************/
 static void *_io_thr(void *);
-static int _send_io_init_msg(int sock, srun_key_t *key, slurmd_job_t *job);
+static int _send_io_init_msg(int sock, srun_key_t *key, slurmd_job_t *job,
+			     bool relay);
 static void _send_eof_msg(struct task_read_info *out);
 static struct io_buf *_task_build_message(struct task_read_info *out,
 					  slurmd_job_t *job, cbuf_t cbuf);
@@ -432,6 +528,17 @@ _client_read(eio_obj_t *obj, List objs)
 				break;
 			}
 		}
+
+		/* stdin for all tasks, or for a task further down the
+		 * reverse tree */
+		if ((obj == relay_upstream) &&
+		    ((client->header.type == SLURM_IO_ALLSTDIN) ||
+		     (client->in_msg->ref_count == 0)))
+			_relay_stdin(client->job, &client->header,
+				     client->in_msg);
+		if (client->in_msg->ref_count == 0)
+			list_enqueue(client->job->free_incoming,
+				     client->in_msg);
 	}
 	client->in_msg = NULL;
 	debug4("Leaving  _client_read");
@@ -439,14 +546,19 @@ _client_read(eio_obj_t *obj, List objs)
 }
 
 /*
- * Write outgoing packed messages to the client socket.
+ * Write outgoing packed messages to the client socket.  The rest of the
+ * message in progress and up to CLIENT_WRITE_IOV - 1 messages queued
+ * behind it are sent with a single writev(), so a task producing a lot
+ * of output does not cost one system call per MAX_MSG_LEN bytes.
  */
 static int
 _client_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct iovec iov[CLIENT_WRITE_IOV];
+	struct io_buf *msg;
+	ListIterator itr;
+	int iovcnt = 0, n;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
 
@@ -469,13 +581,21 @@ _client_write(eio_obj_t *obj, List objs)
 
 	debug5("  client->out_remaining = %d", client->out_remaining);
 
+	iov[iovcnt].iov_base = client->out_msg->data +
+		(client->out_msg->length - client->out_remaining);
+	iov[iovcnt++].iov_len = client->out_remaining;
+	itr = list_iterator_create(client->msg_queue);
+	while ((iovcnt < CLIENT_WRITE_IOV) && (msg = list_next(itr))) {
+		iov[iovcnt].iov_base = msg->data;
+		iov[iovcnt++].iov_len = msg->length;
+	}
+	list_iterator_destroy(itr);
+
 	/*
-	 * Write message to socket.
+	 * Write messages to socket.
 	 */
-	buf = client->out_msg->data +
-		(client->out_msg->length - client->out_remaining);
 again:
-	if ((n = write(obj->fd, buf, client->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, iovcnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
@@ -487,17 +607,21 @@ again:
 			return SLURM_SUCCESS;
 		}
 	}
-	if (n < client->out_remaining) {
-		error("Only wrote %d of %d bytes to socket", 
-		      n, client->out_remaining);
-	} else
-		debug5("Wrote %d bytes to socket", n);
-	client->out_remaining -= n;
-	if (client->out_remaining > 0)
-		return SLURM_SUCCESS;
+	debug5("Wrote %d bytes to socket", n);
 
-	_free_outgoing_msg(client->out_msg, client->job);
-	client->out_msg = NULL;
+	/* Release every message sent in full, the last one may be partial */
+	while (n >= client->out_remaining) {
+		n -= client->out_remaining;
+		_free_outgoing_msg(client->out_msg, client->job);
+		client->out_msg = NULL;
+		if (n == 0)
+			break;
+		client->out_msg = list_dequeue(client->msg_queue);
+		xassert(client->out_msg);
+		client->out_remaining = client->out_msg->length;
+	}
+	if (client->out_msg)
+		client->out_remaining -= n;
 
 	return SLURM_SUCCESS;
 }
@@ -1321,8 +1445,15 @@ _free_outgoing_msg(struct io_buf *msg, slurmd_job_t *job)
 
 	msg->ref_count--;
 	if (msg->ref_count == 0) {
-		/* Put the message back on the free List */
-		list_enqueue(job->free_outgoing, msg);
+		/* Put the message back on the free List, unless the pool
+		 * grew beyond STDIO_MAX_FREE_BUF for a burst of output and
+		 * enough buffers are already free */
+		if ((job->outgoing_count > STDIO_MAX_FREE_BUF) &&
+		    (list_count(job->free_outgoing) >= STDIO_MAX_MSG_CACHE)) {
+			free_io_buf(msg);
+			job->outgoing_count--;
+		} else
+			list_enqueue(job->free_outgoing, msg);
 
 		/* Try packing messages from tasks' output cbufs */
 		if (job->task == NULL)
@@ -1451,6 +1582,13 @@ _io_thr(void *arg)
 	debug("IO handler started pid=%lu", (unsigned long) getpid());
 	rc = eio_handle_mainloop(job->eio);
 	debug("IO handler exited, rc=%d", rc);
+
+	/* All our output is sent, let a parent relaying it know now rather
+	 * than when this slurmstepd exits */
+	if (relay_parent && (relay_parent->fd >= 0)) {
+		close(relay_parent->fd);
+		relay_parent->fd = -1;
+	}
 	return (void *)1;
 }
 
@@ -1520,6 +1658,7 @@ io_initial_client_connect(srun_info_t *srun, slurmd_job_t *job,
 	int sock = -1;
 	struct client_io_info *client;
 	eio_obj_t *obj;
+	bool relay, to_parent = true;
 
 	debug4 ("adding IO connection (logical node rank %d)", job->nodeid);
 
@@ -1534,17 +1673,24 @@ io_initial_client_connect(srun_info_t *srun, slurmd_job_t *job,
 		debug4("connecting IO back to %s:%d", ip, ntohs(port));
 	}
 
-	if ((sock = (int) slurm_open_stream(&srun->ioaddr)) < 0) {
-		error("connect io: %m");
-		/* XXX retry or silently fail?
-		 *     fail for now.
-		 */
-		return SLURM_ERROR;
-	}
+	/* Listen for our children before connecting, our io init msg
+	 * tells whether their I/O will follow ours */
+	relay = _relay_listen(job);
 
-	fd_set_blocking(sock);  /* just in case... */
+	if ((sock = _relay_connect(srun, job, relay)) < 0) {
+		to_parent = false;
+		if ((sock = (int) slurm_open_stream(&srun->ioaddr)) < 0) {
+			error("connect io: %m");
+			/* XXX retry or silently fail?
+			 *     fail for now.
+			 */
+			return SLURM_ERROR;
+		}
+
+		fd_set_blocking(sock);  /* just in case... */
 
-	_send_io_init_msg(sock, srun->key, job);
+		_send_io_init_msg(sock, srun->key, job, relay);
+	}
 
 	debug5("  back from _send_io_init_msg");
 	fd_set_nonblocking(sock);
@@ -1567,6 +1713,10 @@ io_initial_client_connect(srun_info_t *srun, slurmd_job_t *job,
 	obj = eio_obj_create(sock, &client_ops, (void *)client);
 	list_append(job->clients, (void *)obj);
 	eio_new_initial_obj(job->eio, (void *)obj);
+	if (relay)
+		relay_upstream = obj;
+	if (to_parent)
+		relay_parent = obj;
 	debug5("Now handling %d IO Client object(s)", list_count(job->clients));
 
 	return SLURM_SUCCESS;
@@ -1604,7 +1754,7 @@ io_client_connect(srun_info_t *srun, slurmd_job_t *job)
 
 	fd_set_blocking(sock);  /* just in case... */
 
-	_send_io_init_msg(sock, srun->key, job);
+	_send_io_init_msg(sock, srun->key, job, false);
 
 	debug5("  back from _send_io_init_msg");
 	fd_set_nonblocking(sock);
@@ -1634,8 +1784,13 @@ io_client_connect(srun_info_t *srun, slurmd_job_t *job)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * If "relay" is set this slurmstepd relays the I/O of its children, and
+ * announces an extra stdout stream which it closes once it stops taking
+ * new children, so that the client keeps reading until then.
+ */
 static int
-_send_io_init_msg(int sock, srun_key_t *key, slurmd_job_t *job)
+_send_io_init_msg(int sock, srun_key_t *key, slurmd_job_t *job, bool relay)
 {
 	struct slurm_io_init_msg msg;
 
@@ -1649,6 +1804,8 @@ _send_io_init_msg(int sock, srun_key_t *key, slurmd_job_t *job)
 		msg.stderr_objs = 0;
 	else
 		msg.stderr_objs = list_count(job->stderr_eio_objs);
+	if (relay)
+		msg.stdout_objs++;
 
 	if (io_init_msg_write_to_fd(sock, &msg) != SLURM_SUCCESS) {
 		error("Couldn't sent slurm_io_init_msg");
@@ -1877,6 +2034,16 @@ _incoming_buf_free(slurmd_job_t *job)
 	return false;
 }
 
+/* Outgoing buffers allowed to a step: STDIO_MAX_FREE_BUF, or more for
+ * steps with many local tasks so their output does not stall waiting
+ * for buffers */
+static int
+_outgoing_buf_max(slurmd_job_t *job)
+{
+	return MAX(STDIO_MAX_FREE_BUF,
+		   job->node_tasks * STDIO_FREE_BUF_PER_TASK);
+}
+
 static bool
 _outgoing_buf_free(slurmd_job_t *job)
 {
@@ -1884,7 +2051,7 @@ _outgoing_buf_free(slurmd_job_t *job)
 
 	if (list_count(job->free_outgoing) > 0) {
 		return true;
-	} else if (job->outgoing_count < STDIO_MAX_FREE_BUF) {
+	} else if (job->outgoing_count < _outgoing_buf_max(job)) {
 		buf = alloc_io_buf();
 		if (buf != NULL) {
 			list_enqueue(job->free_outgoing, buf);
@@ -1896,6 +2063,662 @@ _outgoing_buf_free(slurmd_job_t *job)
 	return false;
 }
 
+/**********************************************************************
+ * IO relay functions
+ **********************************************************************/
+/* Port of our relay listener for REQUEST_STEP_IO_RELAY_PORT, zero if
+ * we do not (or no longer) take children */
+extern uint16_t
+io_relay_port(void)
+{
+	return relay_port;
+}
+
+extern bool
+io_relay_active(void)
+{
+	return (relay_children && !list_is_empty(relay_children));
+}
+
+/* Queue a message for the initial client, message ref_count is taken
+ * over by the client's queue */
+static void
+_relay_enqueue(slurmd_job_t *job, struct io_buf *msg)
+{
+	struct client_io_info *client;
+
+	xassert(relay_upstream);
+	client = (struct client_io_info *) relay_upstream->arg;
+	xassert(client->magic == CLIENT_IO_MAGIC);
+
+	msg->ref_count = 0;
+	if (!client->out_eof && list_enqueue(client->msg_queue, msg)) {
+		msg->ref_count++;
+		return;
+	}
+	msg->ref_count = 1;
+	_free_outgoing_msg(msg, job);
+}
+
+/* Build a message for the initial client.  Like the eof messages of
+ * _send_eof_msg(), these may allocate beyond the buffer pool. */
+static struct io_buf *
+_relay_build_msg(slurmd_job_t *job, io_hdr_t *header,
+		 struct slurm_io_init_msg *init)
+{
+	struct io_buf *msg;
+	Buf packbuf;
+
+	if (_outgoing_buf_free(job))
+		msg = list_dequeue(job->free_outgoing);
+	else
+		msg = alloc_io_buf();
+
+	if (init)
+		header->length = io_node_init_packed_size();
+	packbuf = create_buf(msg->data,
+			     io_hdr_packed_size() + header->length);
+	io_hdr_pack(header, packbuf);
+	if (init)
+		io_node_init_pack(init, packbuf);
+	msg->length = io_hdr_packed_size() + header->length;
+	msg->ref_count = 0;
+
+	/* free the Buf packbuf, but not the memory to which it points */
+	packbuf->head = NULL;
+	free_buf(packbuf);
+
+	return msg;
+}
+
+static void
+_relay_send_eof(slurmd_job_t *job, uint16_t type)
+{
+	io_hdr_t header;
+
+	header.type = type;
+	header.gtaskid = (uint16_t)-1;
+	header.ltaskid = (uint16_t)-1;
+	header.length = 0;
+	_relay_enqueue(job, _relay_build_msg(job, &header, NULL));
+}
+
+/*
+ * Listen for the I/O connections of our children in the reverse tree.
+ * Returns true if listening.
+ */
+static bool
+_relay_listen(slurmd_job_t *job)
+{
+	eio_obj_t *obj;
+	int fd;
+	short port;
+
+	if (!(job->task_flags & TASK_IO_AGGREGATE) ||
+	    (step_complete.children == 0) ||
+	    ((step_complete.depth + 1) < IO_RELAY_DEPTH))
+		return false;
+
+	if (net_stream_listen(&fd, &port) < 0) {
+		error("unable to listen for relayed IO: %m");
+		return false;
+	}
+	fd_set_nonblocking(fd);
+	fd_set_close_on_exec(fd);
+
+	relay_children = list_create(NULL);
+	obj = eio_obj_create(fd, &relay_listen_ops, (void *)job);
+	eio_new_initial_obj(job->eio, (void *)obj);
+	relay_port = (uint16_t) port;
+	debug2("relaying IO of %d children on port %hu",
+	       step_complete.children, relay_port);
+
+	return true;
+}
+
+static bool
+_relay_listen_readable(eio_obj_t *obj)
+{
+	slurmd_job_t *job = (slurmd_job_t *) obj->arg;
+
+	if (obj->shutdown) {
+		if (obj->fd != -1) {
+			/* Children that have not connected yet go to
+			 * srun, close the stream our io init msg held
+			 * open for them */
+			relay_port = 0;
+			close(obj->fd);
+			obj->fd = -1;
+			_relay_send_eof(job, SLURM_IO_STDOUT);
+		}
+		debug5("  false, shutdown");
+		return false;
+	}
+	return true;
+}
+
+/* Wait up to "timeout" msec for fd to be readable */
+static bool
+_relay_wait_readable(int fd, int timeout)
+{
+	struct pollfd pfd;
+	int rc;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	while ((rc = poll(&pfd, 1, timeout)) < 0) {
+		if (errno != EINTR)
+			return false;
+	}
+	return ((rc == 1) && (pfd.revents & POLLIN));
+}
+
+/* Start relaying the IO of the child whose io init msg came on "sd" */
+static void
+_relay_add_child(slurmd_job_t *job, int sd, struct slurm_io_init_msg *init)
+{
+	struct relay_child_info *child;
+	eio_obj_t *obj;
+	io_hdr_t header;
+
+	debug2("relaying IO of node %u, %u stdout and %u stderr streams",
+	       init->nodeid, init->stdout_objs, init->stderr_objs);
+
+	child = xmalloc(sizeof(struct relay_child_info));
+#ifndef NDEBUG
+	child->magic = RELAY_CHILD_MAGIC;
+#endif
+	child->job = job;
+	child->nodeid = init->nodeid;
+	child->stdout_objs = init->stdout_objs;
+	child->stderr_objs = init->stderr_objs;
+	child->msg_queue = list_create(NULL);
+
+	obj = eio_obj_create(sd, &relay_child_ops, (void *)child);
+	list_append(relay_children, obj);
+	eio_new_obj(job->eio, (void *)obj);
+
+	/* Tell the client the node's streams come this way */
+	header.type = SLURM_IO_NODE_INIT;
+	header.gtaskid = (uint16_t)-1;
+	header.ltaskid = (uint16_t)-1;
+	_relay_enqueue(job, _relay_build_msg(job, &header, init));
+}
+
+/* Wait for the io init msg of a new connection without blocking the
+ * rest of the step's IO */
+static void
+_relay_accept(slurmd_job_t *job, int sd)
+{
+	struct relay_init_info *ri;
+	eio_obj_t *obj;
+
+	fd_set_nonblocking(sd);
+	fd_set_close_on_exec(sd);
+
+	ri = xmalloc(sizeof(struct relay_init_info));
+#ifndef NDEBUG
+	ri->magic = RELAY_INIT_MAGIC;
+#endif
+	ri->job = job;
+	ri->deadline = time(NULL) + IO_RELAY_INIT_TIMEOUT;
+	ri->data = xmalloc(io_init_msg_packed_size());
+
+	obj = eio_obj_create(sd, &relay_init_ops, (void *)ri);
+	eio_new_obj(job->eio, (void *)obj);
+}
+
+/* Drop the connection, or just forget it if "sd" was passed on */
+static void
+_relay_init_close(eio_obj_t *obj, bool reject)
+{
+	struct relay_init_info *ri = (struct relay_init_info *) obj->arg;
+
+	if (reject) {
+		error("rejecting relayed IO connection");
+		close(obj->fd);
+	}
+	obj->fd = -1;
+	obj->arg = NULL;
+	xfree(ri->data);
+	xfree(ri);
+}
+
+/* A connection the child has not completed in time is only noticed
+ * once the IO of the step wakes us, it holds nothing else up */
+static bool
+_relay_init_readable(eio_obj_t *obj)
+{
+	struct relay_init_info *ri = (struct relay_init_info *) obj->arg;
+
+	if (obj->fd == -1)
+		return false;
+	xassert(ri->magic == RELAY_INIT_MAGIC);
+	if (obj->shutdown || (time(NULL) >= ri->deadline)) {
+		_relay_init_close(obj, true);
+		return false;
+	}
+	return true;
+}
+
+static int
+_relay_init_read(eio_obj_t *obj, List objs)
+{
+	struct relay_init_info *ri = (struct relay_init_info *) obj->arg;
+	slurmd_job_t *job = ri->job;
+	srun_info_t *srun = list_peek(job->sruns);
+	struct slurm_io_init_msg init;
+	int size = io_init_msg_packed_size();
+	int rc = SLURM_SUCCESS;
+	Buf packbuf;
+	int n;
+
+	debug4("Entering _relay_init_read");
+	xassert(ri->magic == RELAY_INIT_MAGIC);
+
+again:
+	if ((n = read(obj->fd, ri->data + ri->length, size - ri->length)) < 0) {
+		if (errno == EINTR)
+			goto again;
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			return SLURM_SUCCESS;
+	}
+	if (n <= 0) {
+		_relay_init_close(obj, true);
+		return SLURM_SUCCESS;
+	}
+	ri->length += n;
+	if (ri->length < size)
+		return SLURM_SUCCESS;
+
+	packbuf = create_buf(ri->data, size);
+	n = io_init_msg_unpack(&init, packbuf);
+	packbuf->head = NULL;
+	free_buf(packbuf);
+	if ((n != SLURM_SUCCESS) ||
+	    (io_init_msg_validate(&init, (char *) srun->key->data) < 0) ||
+	    (init.nodeid >= job->nnodes) || (init.nodeid == job->nodeid)) {
+		_relay_init_close(obj, true);
+		return SLURM_SUCCESS;
+	}
+	/* Nothing else was sent on the socket yet, the ack fits */
+	if (write(obj->fd, &rc, sizeof(int)) != sizeof(int)) {
+		error("relayed IO ack to node %u: %m", init.nodeid);
+		_relay_init_close(obj, true);
+		return SLURM_SUCCESS;
+	}
+
+	_relay_add_child(job, obj->fd, &init);
+	_relay_init_close(obj, false);
+	return SLURM_SUCCESS;
+}
+
+static int
+_relay_listen_read(eio_obj_t *obj, List objs)
+{
+	slurmd_job_t *job = (slurmd_job_t *) obj->arg;
+	struct sockaddr_in addr;
+	socklen_t size;
+	int sd;
+
+	debug4("Entering _relay_listen_read");
+	while (1) {
+		size = sizeof(addr);
+		if ((sd = accept(obj->fd, (struct sockaddr *) &addr,
+				 &size)) < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+			    (errno != ECONNABORTED))
+				error("relayed IO accept: %m");
+			break;
+		}
+		_relay_accept(job, sd);
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/* Close the streams of a child's subtree that the child did not close
+ * itself and forget about the child */
+static void
+_relay_child_close(eio_obj_t *obj)
+{
+	struct relay_child_info *child = (struct relay_child_info *) obj->arg;
+	slurmd_job_t *job = child->job;
+	struct io_buf *msg;
+	ListIterator itr;
+	eio_obj_t *tmp;
+
+	if (child->in_msg) {
+		list_enqueue(job->free_outgoing, child->in_msg);
+		child->in_msg = NULL;
+	}
+	if ((child->stdout_objs > 0) || (child->stderr_objs > 0))
+		error("lost relayed IO of node %u, %d stdout and %d stderr "
+		      "streams still open", child->nodeid,
+		      child->stdout_objs, child->stderr_objs);
+	for ( ; child->stdout_objs > 0; child->stdout_objs--)
+		_relay_send_eof(job, SLURM_IO_STDOUT);
+	for ( ; child->stderr_objs > 0; child->stderr_objs--)
+		_relay_send_eof(job, SLURM_IO_STDERR);
+	child->in_eof = true;
+
+	child->out_eof = true;
+	if (child->out_msg) {
+		_free_incoming_msg(child->out_msg, job);
+		child->out_msg = NULL;
+	}
+	while ((msg = list_dequeue(child->msg_queue)))
+		_free_incoming_msg(msg, job);
+
+	itr = list_iterator_create(relay_children);
+	while ((tmp = list_next(itr))) {
+		if (tmp == obj) {
+			list_remove(itr);
+			break;
+		}
+	}
+	list_iterator_destroy(itr);
+
+	close(obj->fd);
+	obj->fd = -1;
+}
+
+/* Children are read until they close the connection, whether or not
+ * the rest of the IO is shut down */
+static bool
+_relay_child_readable(eio_obj_t *obj)
+{
+	struct relay_child_info *child = (struct relay_child_info *) obj->arg;
+
+	xassert(child->magic == RELAY_CHILD_MAGIC);
+	if (child->in_eof)
+		return false;
+	if ((child->in_msg != NULL) || _outgoing_buf_free(child->job))
+		return true;
+	return false;
+}
+
+static int
+_relay_child_read(eio_obj_t *obj, List objs)
+{
+	struct relay_child_info *child = (struct relay_child_info *) obj->arg;
+	slurmd_job_t *job = child->job;
+	struct slurm_io_init_msg init;
+	struct io_buf *msg;
+	Buf packbuf;
+	void *buf;
+	int n;
+
+	debug4("Entering _relay_child_read");
+	xassert(child->magic == RELAY_CHILD_MAGIC);
+
+	if (child->in_msg == NULL) {
+		if (!_outgoing_buf_free(job))
+			return SLURM_SUCCESS;
+		child->in_msg = list_dequeue(job->free_outgoing);
+		n = io_hdr_read_fd(obj->fd, &child->header);
+		if ((n > 0) && (child->header.length > MAX_MSG_LEN)) {
+			error("Message length of %u exceeds maximum of %u",
+			      child->header.length, MAX_MSG_LEN);
+			n = -1;
+		}
+		if (n <= 0) {
+			debug3("relayed IO of node %u closed", child->nodeid);
+			_relay_child_close(obj);
+			return SLURM_SUCCESS;
+		}
+		packbuf = create_buf(child->in_msg->data,
+				     io_hdr_packed_size());
+		io_hdr_pack(&child->header, packbuf);
+		packbuf->head = NULL;
+		free_buf(packbuf);
+		child->in_msg->length = io_hdr_packed_size() +
+					child->header.length;
+		child->in_remaining = child->header.length;
+	}
+
+	if (child->in_remaining > 0) {
+		buf = child->in_msg->data +
+			(child->in_msg->length - child->in_remaining);
+	again:
+		if ((n = read(obj->fd, buf, child->in_remaining)) < 0) {
+			if (errno == EINTR)
+				goto again;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				return SLURM_SUCCESS;
+			debug3("relayed IO read from node %u: %m",
+			       child->nodeid);
+		}
+		if (n <= 0) {
+			_relay_child_close(obj);
+			return SLURM_SUCCESS;
+		}
+		child->in_remaining -= n;
+		if (child->in_remaining > 0)
+			return SLURM_SUCCESS;
+	}
+
+	/* Keep count of the subtree's open streams and pass it on */
+	msg = child->in_msg;
+	child->in_msg = NULL;
+	switch (child->header.type) {
+	case SLURM_IO_STDOUT:
+		if (child->header.length == 0)
+			child->stdout_objs--;
+		break;
+	case SLURM_IO_STDERR:
+		if (child->header.length == 0)
+			child->stderr_objs--;
+		break;
+	case SLURM_IO_NODE_INIT:
+		packbuf = create_buf(msg->data + io_hdr_packed_size(),
+				     child->header.length);
+		if (io_node_init_unpack(&init, packbuf) == SLURM_SUCCESS) {
+			child->stdout_objs += init.stdout_objs;
+			child->stderr_objs += init.stderr_objs;
+		}
+		packbuf->head = NULL;
+		free_buf(packbuf);
+		break;
+	default:
+		error("relayed IO message type %u from node %u ignored",
+		      child->header.type, child->nodeid);
+		list_enqueue(job->free_outgoing, msg);
+		return SLURM_SUCCESS;
+	}
+	_relay_enqueue(job, msg);
+
+	return SLURM_SUCCESS;
+}
+
+static bool
+_relay_child_writable(eio_obj_t *obj)
+{
+	struct relay_child_info *child = (struct relay_child_info *) obj->arg;
+
+	xassert(child->magic == RELAY_CHILD_MAGIC);
+	if (child->out_eof)
+		return false;
+	return ((child->out_msg != NULL) || !list_is_empty(child->msg_queue));
+}
+
+static int
+_relay_child_write(eio_obj_t *obj, List objs)
+{
+	struct relay_child_info *child = (struct relay_child_info *) obj->arg;
+	slurmd_job_t *job = child->job;
+	struct io_buf *msg;
+	void *buf;
+	int n;
+
+	debug4("Entering _relay_child_write");
+	xassert(child->magic == RELAY_CHILD_MAGIC);
+
+	if (child->out_msg == NULL) {
+		child->out_msg = list_dequeue(child->msg_queue);
+		if (child->out_msg == NULL)
+			return SLURM_SUCCESS;
+		child->out_remaining = child->out_msg->length;
+	}
+
+	buf = child->out_msg->data +
+		(child->out_msg->length - child->out_remaining);
+again:
+	if ((n = write(obj->fd, buf, child->out_remaining)) < 0) {
+		if (errno == EINTR)
+			goto again;
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			return SLURM_SUCCESS;
+		debug3("relayed stdin write to node %u: %m", child->nodeid);
+		child->out_eof = true;
+		_free_incoming_msg(child->out_msg, job);
+		child->out_msg = NULL;
+		while ((msg = list_dequeue(child->msg_queue)))
+			_free_incoming_msg(msg, job);
+		return SLURM_SUCCESS;
+	}
+	child->out_remaining -= n;
+	if (child->out_remaining > 0)
+		return SLURM_SUCCESS;
+
+	_free_incoming_msg(child->out_msg, job);
+	child->out_msg = NULL;
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Pass a stdin message from the initial client on to every child, which
+ * forward it further down or hand it to their own tasks.
+ */
+static void
+_relay_stdin(slurmd_job_t *job, io_hdr_t *header, struct io_buf *in)
+{
+	struct relay_child_info *child;
+	struct io_buf *msg;
+	ListIterator itr;
+	eio_obj_t *obj;
+	Buf packbuf;
+
+	if ((relay_children == NULL) || list_is_empty(relay_children))
+		return;
+
+	if (_incoming_buf_free(job)) {
+		msg = list_dequeue(job->free_incoming);
+	} else {
+		msg = alloc_io_buf();
+		job->incoming_count++;
+	}
+	packbuf = create_buf(msg->data, io_hdr_packed_size());
+	io_hdr_pack(header, packbuf);
+	packbuf->head = NULL;
+	free_buf(packbuf);
+	if (header->length)
+		memcpy(msg->data + io_hdr_packed_size(), in->data,
+		       header->length);
+	msg->length = io_hdr_packed_size() + header->length;
+	msg->ref_count = 0;
+
+	itr = list_iterator_create(relay_children);
+	while ((obj = list_next(itr))) {
+		child = (struct relay_child_info *) obj->arg;
+		if (child->out_eof)
+			continue;
+		if (list_enqueue(child->msg_queue, msg))
+			msg->ref_count++;
+	}
+	list_iterator_destroy(itr);
+
+	if (msg->ref_count == 0)
+		list_enqueue(job->free_incoming, msg);
+}
+
+/* Ask the slurmd of our parent in the reverse tree for the port of its
+ * slurmstepd's relay listener, which may not be open quite yet */
+static uint16_t
+_relay_parent_port(slurmd_job_t *job)
+{
+	job_step_id_msg_t req;
+	slurm_msg_t req_msg, resp_msg;
+	uint16_t port = 0;
+	int i, delay, waited = 0;
+
+	req.job_id = job->jobid;
+	req.step_id = job->stepid;
+	for (i = 0; ; i++) {
+		slurm_msg_t_init(&req_msg);
+		slurm_msg_t_init(&resp_msg);
+		req_msg.msg_type = REQUEST_IO_RELAY_PORT;
+		req_msg.data = &req;
+		req_msg.address = step_complete.parent_addr;
+		if (slurm_send_recv_node_msg(&req_msg, &resp_msg, 0) == 0) {
+			if (resp_msg.auth_cred)
+				g_slurm_auth_destroy(resp_msg.auth_cred);
+			if (resp_msg.msg_type == RESPONSE_IO_RELAY_PORT)
+				port = ((io_relay_port_msg_t *)
+					resp_msg.data)->port;
+			slurm_free_msg_data(resp_msg.msg_type, resp_msg.data);
+			if (port)
+				break;
+		}
+		delay = reverse_tree_retry_delay(i);
+		if ((waited + delay) > IO_RELAY_PORT_WAIT)
+			break;
+		poll(NULL, 0, delay);
+		waited += delay;
+	}
+
+	return port;
+}
+
+/*
+ * Connect our I/O to the slurmstepd of our parent in the reverse tree
+ * if it relays I/O.  Returns the connected socket, or -1 if the I/O is
+ * to go straight to srun.
+ */
+static int
+_relay_connect(srun_info_t *srun, slurmd_job_t *job, bool relay)
+{
+	slurm_addr_t addr;
+	uint16_t port;
+	int sock, rc;
+
+	if (!(job->task_flags & TASK_IO_AGGREGATE) ||
+	    (step_complete.parent_rank < 0) ||
+	    (step_complete.depth < IO_RELAY_DEPTH))
+		return -1;
+
+	if ((port = _relay_parent_port(job)) == 0) {
+		debug("rank %d parent does not relay IO, connecting to srun",
+		      step_complete.rank);
+		return -1;
+	}
+	addr = step_complete.parent_addr;
+	addr.sin_port = htons(port);
+	if ((sock = (int) slurm_open_stream(&addr)) < 0) {
+		debug("connect to IO relay of rank %d: %m",
+		      step_complete.parent_rank);
+		return -1;
+	}
+	fd_set_blocking(sock);
+
+	if ((_send_io_init_msg(sock, srun->key, job, relay) !=
+	     SLURM_SUCCESS) ||
+	    !_relay_wait_readable(sock, IO_RELAY_ACK_TIMEOUT) ||
+	    (read(sock, &rc, sizeof(int)) != sizeof(int)) ||
+	    (rc != SLURM_SUCCESS)) {
+		debug("IO relay of rank %d refused us, connecting to srun",
+		      step_complete.parent_rank);
+		close(sock);
+		return -1;
+	}
+	debug2("IO relayed through rank %d", step_complete.parent_rank);
+
+	return sock;
+}
+
 /**********************************************************************
  * Functions specific to "user managed" IO
  **********************************************************************/
@@ -51,6 +51,13 @@
 #define STDIO_MAX_FREE_BUF 1024
 #define STDIO_MAX_MSG_CACHE 128
 
+/*
+ * The outgoing pool may grow to STDIO_FREE_BUF_PER_TASK buffers per local
+ * task when that exceeds STDIO_MAX_FREE_BUF, and shrinks back once the
+ * output drains.
+ */
+#define STDIO_FREE_BUF_PER_TASK 64
+
 struct io_buf {
 	int ref_count;
 	uint32_t length;
@@ -148,6 +155,18 @@ void io_find_filename_pattern(  slurmd_job_t *job,
  */
 int io_get_file_flags(slurmd_job_t *job);
 
+/*
+ *  Port on which the slurmstepd takes the I/O connections of its children
+ *  in the reverse tree, zero if it does not (or no longer) relay their I/O.
+ */
+uint16_t io_relay_port(void);
+
+/*
+ *  True while children in the reverse tree are relaying their I/O through
+ *  this slurmstepd.
+ */
+bool io_relay_active(void);
+
 /*
  *  Initialize "user managed" IO, where each task has a single TCP
  *  socket end point shared on stdin, stdout, and stderr.
@@ -0,0 +1,271 @@
+/*****************************************************************************\
+ *  src/slurmd/slurmstepd/launch_relay.c - relay launch responses to srun
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+
+#include "src/slurmd/slurmd/slurmd.h"
+
+#include "src/slurmd/common/reverse_tree.h"
+#include "src/slurmd/slurmstepd/launch_relay.h"
+#include "src/slurmd/slurmstepd/slurmstepd.h"
+
+/* How long to hold responses waiting for more of the subtree, msec */
+#define LAUNCH_RELAY_DELAY	50
+
+static pthread_mutex_t relay_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  relay_cond = PTHREAD_COND_INITIALIZER;
+static List relay_list = NULL;		/* launch_tasks_response_msg_t */
+static bool relay_active = false;
+static bool relay_closed = false;
+static int  relay_expect = 0;		/* responses from the whole subtree */
+static int  relay_count = 0;		/* responses received so far */
+static pthread_t relay_tid;
+static bool relay_thread_running = false;
+
+static void *_relay_agent(void *arg);
+static void  _relay(slurmd_job_t *job, List resp_list);
+
+/* Send responses to the parent, falling back to srun. Frees resp_list. */
+static void _relay(slurmd_job_t *job, List resp_list)
+{
+	slurm_msg_t msg;
+	launch_tasks_relay_msg_t relay;
+	srun_info_t *srun;
+	int rc;
+
+	relay.job_id = job->jobid;
+	relay.job_step_id = job->stepid;
+	relay.resp_list = resp_list;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = RESPONSE_LAUNCH_TASKS_RELAY;
+	msg.data = &relay;
+
+	if (step_complete.parent_rank != -1) {
+		debug3("Rank %d relaying %d launch responses to rank %d",
+		       step_complete.rank, list_count(resp_list),
+		       step_complete.parent_rank);
+		msg.address = step_complete.parent_addr;
+		if ((slurm_send_recv_rc_msg_only_one(&msg, &rc, 0) == 0) &&
+		    (rc == SLURM_SUCCESS))
+			goto done;
+		debug("Rank %d could not relay launch responses to rank %d, "
+		      "sending to srun", step_complete.rank,
+		      step_complete.parent_rank);
+	}
+
+	srun = list_peek(job->sruns);
+	msg.address = srun->resp_addr;
+	if (slurm_send_only_node_msg(&msg) != SLURM_SUCCESS)
+		error("failed to send RESPONSE_LAUNCH_TASKS_RELAY: %m");
+done:
+	list_destroy(resp_list);
+}
+
+/* Take the queued responses, called with relay_lock held */
+static List _take_list(void)
+{
+	List resp_list = relay_list;
+
+	relay_list = list_create((ListDelF)
+				 slurm_free_launch_tasks_response_msg);
+	return resp_list;
+}
+
+static void *_relay_agent(void *arg)
+{
+	slurmd_job_t *job = (slurmd_job_t *) arg;
+	struct timeval now;
+	struct timespec ts;
+	List resp_list;
+
+	pthread_mutex_lock(&relay_lock);
+	while (1) {
+		while (!relay_closed && (list_count(relay_list) == 0))
+			pthread_cond_wait(&relay_cond, &relay_lock);
+		if (list_count(relay_list) == 0)
+			break;
+
+		/* Give the rest of the subtree a moment to catch up, so a
+		 * level of the tree sends one message rather than many */
+		gettimeofday(&now, NULL);
+		ts.tv_sec  = now.tv_sec;
+		ts.tv_nsec = (now.tv_usec + LAUNCH_RELAY_DELAY * 1000) * 1000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		while (!relay_closed && (relay_count < relay_expect)) {
+			if (pthread_cond_timedwait(&relay_cond, &relay_lock,
+						   &ts) == ETIMEDOUT)
+				break;
+		}
+
+		resp_list = _take_list();
+		pthread_mutex_unlock(&relay_lock);
+		_relay(job, resp_list);
+		pthread_mutex_lock(&relay_lock);
+	}
+	pthread_mutex_unlock(&relay_lock);
+
+	return NULL;
+}
+
+extern void launch_relay_init(slurmd_job_t *job)
+{
+	pthread_attr_t attr;
+
+	if (job->batch || !(job->task_flags & TASK_LAUNCH_RELAY) ||
+	    (step_complete.rank < 0))
+		return;
+	/* A single node step gains nothing from the detour */
+	if ((step_complete.parent_rank == -1) && (step_complete.children <= 0))
+		return;
+
+	pthread_mutex_lock(&relay_lock);
+	relay_list = list_create((ListDelF)
+				 slurm_free_launch_tasks_response_msg);
+	relay_expect = step_complete.children + 1;
+	relay_count = 0;
+	relay_closed = false;
+	relay_active = true;
+
+	/* A leaf has nothing to wait for and relays from the caller */
+	if (step_complete.children > 0) {
+		slurm_attr_init(&attr);
+		if (pthread_create(&relay_tid, &attr, _relay_agent, job)) {
+			error("launch_relay: pthread_create: %m");
+			relay_active = false;
+			list_destroy(relay_list);
+			relay_list = NULL;
+		} else
+			relay_thread_running = true;
+		slurm_attr_destroy(&attr);
+	}
+	pthread_mutex_unlock(&relay_lock);
+
+	if (relay_active)
+		debug("launch_relay: rank %d relaying launch responses of %d "
+		      "children", step_complete.rank, step_complete.children);
+}
+
+extern int launch_relay_send(slurmd_job_t *job,
+			     launch_tasks_response_msg_t *resp)
+{
+	List resp_list = NULL;
+
+	pthread_mutex_lock(&relay_lock);
+	if (!relay_active || relay_closed) {
+		pthread_mutex_unlock(&relay_lock);
+		return SLURM_ERROR;
+	}
+	list_append(relay_list, resp);
+	relay_count++;
+	if (relay_thread_running)
+		pthread_cond_signal(&relay_cond);
+	else
+		resp_list = _take_list();
+	pthread_mutex_unlock(&relay_lock);
+
+	if (resp_list)
+		_relay(job, resp_list);
+	return SLURM_SUCCESS;
+}
+
+extern int launch_relay_add(List resp_list)
+{
+	launch_tasks_response_msg_t *resp;
+
+	pthread_mutex_lock(&relay_lock);
+	if (!relay_active || relay_closed || !relay_thread_running) {
+		pthread_mutex_unlock(&relay_lock);
+		return SLURM_ERROR;
+	}
+	while ((resp = list_pop(resp_list))) {
+		list_append(relay_list, resp);
+		relay_count++;
+	}
+	pthread_cond_signal(&relay_cond);
+	pthread_mutex_unlock(&relay_lock);
+
+	return SLURM_SUCCESS;
+}
+
+extern void launch_relay_fini(slurmd_job_t *job)
+{
+	List resp_list = NULL;
+
+	pthread_mutex_lock(&relay_lock);
+	if (!relay_active) {
+		pthread_mutex_unlock(&relay_lock);
+		return;
+	}
+	relay_closed = true;
+	pthread_cond_signal(&relay_cond);
+	pthread_mutex_unlock(&relay_lock);
+
+	if (relay_thread_running) {
+		pthread_join(relay_tid, NULL);
+		relay_thread_running = false;
+	}
+
+	pthread_mutex_lock(&relay_lock);
+	if (list_count(relay_list))
+		resp_list = _take_list();
+	list_destroy(relay_list);
+	relay_list = NULL;
+	relay_active = false;
+	pthread_mutex_unlock(&relay_lock);
+
+	if (resp_list)
+		_relay(job, resp_list);
+}
@@ -0,0 +1,73 @@
+/*****************************************************************************\
+ *  src/slurmd/slurmstepd/launch_relay.h - relay launch responses to srun
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _STEPD_LAUNCH_RELAY_H
+#define _STEPD_LAUNCH_RELAY_H
+
+#include "src/slurmd/slurmstepd/slurmstepd_job.h"
+
+/*
+ * If srun asked for it (TASK_LAUNCH_RELAY), launch responses travel up
+ * the same reverse tree as step completions: each slurmstepd collects
+ * its own response with those relayed by its children's slurmd and
+ * passes them to its parent as one RESPONSE_LAUNCH_TASKS_RELAY
+ * message, and rank 0 sends the lot to srun. Any slurmstepd which
+ * cannot reach its parent sends what it holds to srun directly.
+ *
+ * Call after the reverse tree information has been received from slurmd
+ * and before the message thread starts.
+ */
+extern void launch_relay_init(slurmd_job_t *job);
+
+/*
+ * Queue this node's launch response for relaying, taking ownership of
+ * resp. Returns SLURM_ERROR, leaving resp to the caller, if relaying is
+ * not in use for this step.
+ */
+extern int launch_relay_send(slurmd_job_t *job,
+			     launch_tasks_response_msg_t *resp);
+
+/*
+ * Queue the launch responses relayed by a child, moving them out of
+ * resp_list. Returns SLURM_ERROR if relaying is not in use or has ended,
+ * the child then sends them to srun itself.
+ */
+extern int launch_relay_add(List resp_list);
+
+/* Flush anything still queued and stop the relay thread */
+extern void launch_relay_fini(slurmd_job_t *job);
+
+#endif /* _STEPD_LAUNCH_RELAY_H */
@@ -107,7 +107,9 @@
 #include "src/slurmd/slurmstepd/mgr.h"
 #include "src/slurmd/slurmstepd/task.h"
 #include "src/slurmd/slurmstepd/io.h"
+#include "src/slurmd/slurmstepd/launch_relay.h"
 #include "src/slurmd/slurmstepd/pdebug.h"
+#include "src/slurmd/slurmstepd/pmi_local.h"
 #include "src/slurmd/slurmstepd/req.h"
 #include "src/slurmd/slurmstepd/pam_ses.h"
 #include "src/slurmd/slurmstepd/ulimits.h"
@@ -142,8 +144,7 @@ step_complete_t step_complete = {
 	{},
 	-1,
 	-1,
-	true,
-	(bitstr_t *)NULL,
+	(reverse_tree_agg_t *)NULL,
 	0,
 	NULL
 };
@@ -179,6 +180,7 @@ static void _wait_for_io(slurmd_job_t *job);
 static int  _send_exit_msg(slurmd_job_t *job, uint32_t *tid, int n,
 			   int status);
 static void _wait_for_children_slurmstepd(slurmd_job_t *job);
+static void _one_step_complete_msg(slurmd_job_t *job, int first, int last);
 static int  _send_pending_exit_msgs(slurmd_job_t *job);
 static void _send_step_complete_msgs(slurmd_job_t *job);
 static void _wait_for_all_tasks(slurmd_job_t *job);
@@ -643,44 +645,55 @@ _send_exit_msg(slurmd_job_t *job, uint32_t *tid, int n, int status)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Forward step completions toward slurmctld as descendants report them.
+ * Completions which arrive close together are sent as one batch, each
+ * child's subtree is waited for until its own deadline, and we return
+ * once every descendant has been accounted for or given up on.
+ */
 static void
 _wait_for_children_slurmstepd(slurmd_job_t *job)
 {
-	int left = 0;
-	int rc;
+	int rc, first, last;
+	time_t now, wake;
 	struct timespec ts = {0, 0};
 
 	pthread_mutex_lock(&step_complete.lock);
 
-	/* wait an extra 3 seconds for every level of tree below this level */
-	if (step_complete.children > 0) {
-		ts.tv_sec += 3 * (step_complete.max_depth-step_complete.depth);
-		ts.tv_sec += time(NULL) + REVERSE_TREE_CHILDREN_TIMEOUT;
-
-		while((left = bit_clear_count(step_complete.bits)) > 0) {
+	step_complete.step_rc = _get_exit_code(job);
+	now = time(NULL);
+	/* the deadlines may already run from _wait_for_io() */
+	reverse_tree_agg_start(step_complete.agg, now);
+	while ((rc = reverse_tree_agg_next(step_complete.agg, now, &first,
+					   &last, &wake)) !=
+	       REVERSE_TREE_AGG_DONE) {
+		if (rc == REVERSE_TREE_AGG_SEND) {
+			_one_step_complete_msg(job, first, last);
+		} else {
 			debug3("Rank %d waiting for %d (of %d) children",
-			     step_complete.rank, left, step_complete.children);
-			rc = pthread_cond_timedwait(&step_complete.cond,
-						    &step_complete.lock, &ts);
-			if (rc == ETIMEDOUT) {
-				debug2("Rank %d timed out waiting for %d"
-				       " (of %d) children", step_complete.rank,
-				       left, step_complete.children);
-				break;
-			}
-		}
-		if (left == 0) {
-			debug2("Rank %d got all children completions",
-			       step_complete.rank);
+			       step_complete.rank,
+			       reverse_tree_agg_pending(step_complete.agg),
+			       step_complete.children);
+			ts.tv_sec = wake;
+			pthread_cond_timedwait(&step_complete.cond,
+					       &step_complete.lock, &ts);
 		}
-	} else {
+		now = time(NULL);
+	}
+
+	if (step_complete.children <= 0) {
 		debug2("Rank %d has no children slurmstepd",
 		       step_complete.rank);
+	} else if (reverse_tree_agg_pending(step_complete.agg)) {
+		debug2("Rank %d timed out waiting for %d (of %d) children",
+		       step_complete.rank,
+		       reverse_tree_agg_pending(step_complete.agg),
+		       step_complete.children);
+	} else {
+		debug2("Rank %d got all children completions",
+		       step_complete.rank);
 	}
 
-	step_complete.step_rc = _get_exit_code(job);
-	step_complete.wait_children = false;
-
 	pthread_mutex_unlock(&step_complete.lock);
 }
 
@@ -688,8 +701,11 @@ _wait_for_children_slurmstepd(slurmd_job_t *job)
 /*
  * Send a single step completion message, which represents a single range
  * of complete job step nodes.
+ *
+ * Caller is holding step_complete.lock, which is released while the
+ * message is in flight so that completions from children can still be
+ * recorded.
  */
-/* caller is holding step_complete.lock */
 static void
 _one_step_complete_msg(slurmd_job_t *job, int first, int last)
 {
@@ -697,7 +713,7 @@ _one_step_complete_msg(slurmd_job_t *job, int first, int last)
 	step_complete_msg_t msg;
 	int rc = -1;
 	int retcode;
-	int i;
+	int i, delay, waited;
 	uint16_t port = 0;
 	char ip_buf[16];
 	static bool acct_sent = false;
@@ -712,18 +728,25 @@ _one_step_complete_msg(slurmd_job_t *job, int first, int last)
 	msg.step_rc = step_complete.step_rc;
 	msg.jobacct = jobacct_gather_g_create(NULL);
 	/************* acct stuff ********************/
+	/* slurmctld sums the accounting of every message, so send our own
+	 * data once and the children's data as it has been gathered since
+	 * the previous message */
 	if(!acct_sent) {
 		jobacct_gather_g_aggregate(step_complete.jobacct, job->jobacct);
-		jobacct_gather_g_getinfo(step_complete.jobacct,
-					 JOBACCT_DATA_TOTAL, msg.jobacct);
 		acct_sent = true;
 	}
+	jobacct_gather_g_getinfo(step_complete.jobacct,
+				 JOBACCT_DATA_TOTAL, msg.jobacct);
+	jobacct_gather_g_destroy(step_complete.jobacct);
+	step_complete.jobacct = jobacct_gather_g_create(NULL);
 	/*********************************************/
 	slurm_msg_t_init(&req);
 	req.msg_type = REQUEST_STEP_COMPLETE;
 	req.data = &msg;
 	req.address = step_complete.parent_addr;
 
+	pthread_mutex_unlock(&step_complete.lock);
+
 	/* Do NOT change this check to "step_complete.rank == 0", because
 	 * there are odd situations where SlurmUser or root could
 	 * craft a launch without a valid credential, and no tree information
@@ -747,14 +770,22 @@ _one_step_complete_msg(slurmd_job_t *job, int first, int last)
 	       step_complete.rank, step_complete.parent_rank, first, last);
 	/* On error, pause then try sending to parent again.
 	 * The parent slurmstepd may just not have started yet, because
-	 * of the way that the launch message forwarding works.
+	 * of the way that the launch message forwarding works.  Back off
+	 * exponentially for up to REVERSE_TREE_PARENT_RETRY seconds.
+	 * A parent which has stopped waiting for its children will never
+	 * accept the range, so go to the slurmctld right away.
 	 */
-	for (i = 0; i < REVERSE_TREE_PARENT_RETRY; i++) {
-		if (i)
-			sleep(1);
+	for (i = 0, waited = 0; ; i++) {
 		retcode = slurm_send_recv_rc_msg_only_one(&req, &rc, 0);
 		if (retcode == 0 && rc == 0)
 			goto finished;
+		if (retcode == 0 && rc == ESLURMD_JOB_NOTRUNNING)
+			break;
+		delay = reverse_tree_retry_delay(i);
+		if ((waited + delay) > (REVERSE_TREE_PARENT_RETRY * 1000))
+			break;
+		poll(NULL, 0, delay);
+		waited += delay;
 	}
 	/* on error AGAIN, send to the slurmctld instead */
 	debug3("Rank %d sending complete to slurmctld instead, range %d to %d",
@@ -768,88 +799,27 @@ _one_step_complete_msg(slurmd_job_t *job, int first, int last)
 	}
 finished:
 	jobacct_gather_g_destroy(msg.jobacct);
-}
-
-/* Given a starting bit in the step_complete.bits bitstring, "start",
- * find the next contiguous range of set bits and return the first
- * and last indices of the range in "first" and "last".
- *
- * caller is holding step_complete.lock
- */
-static int
-_bit_getrange(int start, int size, int *first, int *last)
-{
-	int i;
-	bool found_first = false;
-
-	for (i = start; i < size; i++) {
-		if (bit_test(step_complete.bits, i)) {
-			if (found_first) {
-				*last = i;
-				continue;
-			} else {
-				found_first = true;
-				*first = i;
-				*last = i;
-			}
-		} else {
-			if (!found_first) {
-				continue;
-			} else {
-				*last = i - 1;
-				break;
-			}
-		}
-	}
-
-	if (found_first)
-		return 1;
-	else
-		return 0;
+	pthread_mutex_lock(&step_complete.lock);
 }
 
 /*
- * Send as many step completion messages as necessary to represent
- * all completed nodes in the job step.  There may be nodes that have
- * not yet signalled their completion, so there will be gaps in the
- * completed node bitmap, requiring that more than one message be sent.
+ * Stop waiting for children and send as many step completion messages
+ * as necessary to represent all completed nodes in the job step which
+ * have not yet been forwarded.  There may be nodes that have not
+ * signalled their completion, so there will be gaps in the completed
+ * node bitmap, requiring that more than one message be sent.
  */
 static void
 _send_step_complete_msgs(slurmd_job_t *job)
 {
-	int start, size;
-	int first=-1, last=-1;
-	bool sent_own_comp_msg = false;
+	int first, last;
+	time_t wake;
 
 	pthread_mutex_lock(&step_complete.lock);
-	start = 0;
-	size = bit_size(step_complete.bits);
-
-	/* If no children, send message and return early */
-	if (size == 0) {
-		_one_step_complete_msg(job, step_complete.rank,
-				       step_complete.rank);
-		pthread_mutex_unlock(&step_complete.lock);
-		return;
-	}
-
-	while(_bit_getrange(start, size, &first, &last)) {
-		/* THIS node is not in the bit string, so we need to prepend
-		   the local rank */
-		if (start == 0 && first == 0) {
-			sent_own_comp_msg = true;
-			first = -1;
-		}
-
-		_one_step_complete_msg(job, (first + step_complete.rank + 1),
-	      			       (last + step_complete.rank + 1));
-		start = last + 1;
-	}
-
-	if (!sent_own_comp_msg)
-		_one_step_complete_msg(job, step_complete.rank,
-				       step_complete.rank);
-
+	reverse_tree_agg_close(step_complete.agg);
+	while (reverse_tree_agg_next(step_complete.agg, time(NULL), &first,
+				     &last, &wake) == REVERSE_TREE_AGG_SEND)
+		_one_step_complete_msg(job, first, last);
 	pthread_mutex_unlock(&step_complete.lock);
 }
 
@@ -967,6 +937,13 @@ job_manager(slurmd_job_t *job)
 		goto fail2;
 	}
 
+	/* Collect the local tasks' PMI key-pairs if PMI_AGGREGATE is set */
+	if (pmi_local_init(job) != SLURM_SUCCESS) {
+		rc = ESLURMD_SETUP_ENVIRONMENT_ERROR;
+		io_close_task_fds(job);
+		goto fail2;
+	}
+
 	/* fork necessary threads for checkpoint */
 	if (checkpoint_stepd_prefork(job) != SLURM_SUCCESS) {
 		error("Failed checkpoint_stepd_prefork");
@@ -1033,6 +1010,7 @@ job_manager(slurmd_job_t *job)
 		slurm_container_wait(job->cont_id);
 	}
 	step_terminate_monitor_stop();
+	pmi_local_fini();
 	if (!job->batch) {
 		if (interconnect_postfini(job->switch_job, job->jmgr_pid,
 				job->jobid, job->stepid) < 0)
@@ -1071,6 +1049,7 @@ job_manager(slurmd_job_t *job)
 		_wait_for_children_slurmstepd(job);
 		_send_step_complete_msgs(job);
 	}
+	launch_relay_fini(job);
 
 	xfree(ckpt_type);
 	return(rc);
@@ -1571,6 +1550,24 @@ static void _delay_kill_thread(pthread_t thread_id, int secs)
 	slurm_attr_destroy(&attr);
 }
 
+/* True once no child in the reverse tree is worth waiting for: all have
+ * reported their step complete or their subtrees are past the deadlines
+ * of step completion, which start with the first call as our own tasks
+ * are done */
+static bool
+_children_done(void)
+{
+	time_t now = time(NULL);
+	bool done;
+
+	pthread_mutex_lock(&step_complete.lock);
+	reverse_tree_agg_start(step_complete.agg, now);
+	done = reverse_tree_agg_expired(step_complete.agg, now);
+	pthread_mutex_unlock(&step_complete.lock);
+
+	return done;
+}
+
 /*
  * Wait for IO
  */
@@ -1584,6 +1581,13 @@ _wait_for_io(slurmd_job_t *job)
 	 * Wait until IO thread exits or kill it after 300 seconds
 	 */
 	if (job->ioid) {
+		/* Children relaying their IO through us may run on for a
+		 * long time, only start the clock once they are done or
+		 * have all reported their step complete, which they do
+		 * after their own IO, or the time allowed for that is up.
+		 * A relay still open then is hung. */
+		while (io_relay_active() && !_children_done())
+			usleep(100000);
 		_delay_kill_thread(job->ioid, 300);
 		pthread_join(job->ioid, NULL);
 	} else
@@ -1766,7 +1770,7 @@ _send_launch_resp(slurmd_job_t *job, int rc)
 {
 	int i;
 	slurm_msg_t resp_msg;
-	launch_tasks_response_msg_t resp;
+	launch_tasks_response_msg_t *resp;
 	srun_info_t *srun = list_peek(job->sruns);
 
 	if (job->batch)
@@ -1774,28 +1778,31 @@ _send_launch_resp(slurmd_job_t *job, int rc)
 
 	debug("Sending launch resp rc=%d", rc);
 
-	slurm_msg_t_init(&resp_msg);
-	resp_msg.address	= srun->resp_addr;
-	resp_msg.data		= &resp;
-	resp_msg.msg_type	= RESPONSE_LAUNCH_TASKS;
-
-	resp.node_name		= xstrdup(job->node_name);
-	resp.return_code	= rc;
-	resp.count_of_pids	= job->node_tasks;
+	resp = xmalloc(sizeof(launch_tasks_response_msg_t));
+	resp->node_name		= xstrdup(job->node_name);
+	resp->return_code	= rc;
+	resp->count_of_pids	= job->node_tasks;
 
-	resp.local_pids = xmalloc(job->node_tasks * sizeof(*resp.local_pids));
-	resp.task_ids = xmalloc(job->node_tasks * sizeof(*resp.task_ids));
+	resp->local_pids = xmalloc(job->node_tasks * sizeof(*resp->local_pids));
+	resp->task_ids = xmalloc(job->node_tasks * sizeof(*resp->task_ids));
 	for (i = 0; i < job->node_tasks; i++) {
-		resp.local_pids[i] = job->task[i]->pid;
-		resp.task_ids[i] = job->task[i]->gtid;
+		resp->local_pids[i] = job->task[i]->pid;
+		resp->task_ids[i] = job->task[i]->gtid;
 	}
 
+	/* Relayed through the reverse tree if srun asked for it */
+	if (launch_relay_send(job, resp) == SLURM_SUCCESS)
+		return;
+
+	slurm_msg_t_init(&resp_msg);
+	resp_msg.address	= srun->resp_addr;
+	resp_msg.data		= resp;
+	resp_msg.msg_type	= RESPONSE_LAUNCH_TASKS;
+
 	if (_send_launch_resp_msg(&resp_msg, job->nnodes) != SLURM_SUCCESS)
 		error("failed to send RESPONSE_LAUNCH_TASKS: %m");
 
-	xfree(resp.local_pids);
-	xfree(resp.task_ids);
-	xfree(resp.node_name);
+	slurm_free_launch_tasks_response_msg(resp);
 }
 
 
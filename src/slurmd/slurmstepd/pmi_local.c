@@ -0,0 +1,334 @@
+/*****************************************************************************\
+ *  src/slurmd/slurmstepd/pmi_local.c - node-local PMI key-pair aggregation
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slurm/slurm_errno.h"
+
+#include "src/api/slurm_pmi.h"
+#include "src/common/env.h"
+#include "src/common/fd.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_auth.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+
+#include "src/slurmd/slurmstepd/pmi_local.h"
+
+static slurmd_job_t *pmi_job = NULL;
+static slurm_fd_t pmi_local_fd = -1;
+static pthread_t pmi_local_tid;
+static bool pmi_local_running = false;
+
+/* Key-pairs put by local tasks since the last barrier. The records are
+ * simply collected here; srun merges them by name. */
+static struct kvs_comm **kvs_comm_ptr = NULL;
+static uint16_t kvs_comm_cnt = 0;
+
+/* Reply address of each local task at the barrier, by local task id */
+static struct kvs_hosts *barrier_ptr = NULL;
+static uint32_t barrier_resp_cnt = 0;
+
+static void *_agent(void *arg);
+static int   _barrier_xmit(void);
+static int   _handle_get(kvs_get_msg_t *kvs_get_ptr);
+static void  _handle_put(struct kvs_comm_set *kvs_set_ptr);
+static int   _local_task_id(uint32_t gtid);
+static struct kvs_comm_set *_take_local_kvs(void);
+static bool  _valid_uid(slurm_msg_t *msg);
+
+/* Map a global task id onto this node's task table, -1 if not ours */
+static int _local_task_id(uint32_t gtid)
+{
+	int i;
+
+	for (i = 0; i < pmi_job->node_tasks; i++) {
+		if (pmi_job->task[i]->gtid == gtid)
+			return i;
+	}
+	return -1;
+}
+
+static bool _valid_uid(slurm_msg_t *msg)
+{
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	if ((uid == pmi_job->uid) || (uid == 0) ||
+	    (uid == slurm_get_slurm_user_id()))
+		return true;
+	error("pmi_local: message type %u from uid %u rejected",
+	      msg->msg_type, (unsigned int) uid);
+	return false;
+}
+
+/* Hand over the key-pairs collected so far as a kvs_comm_set */
+static struct kvs_comm_set *_take_local_kvs(void)
+{
+	struct kvs_comm_set *kvs_set = xmalloc(sizeof(struct kvs_comm_set));
+
+	kvs_set->kvs_comm_recs = kvs_comm_cnt;
+	kvs_set->kvs_comm_ptr = kvs_comm_ptr;
+	kvs_comm_ptr = NULL;
+	kvs_comm_cnt = 0;
+	return kvs_set;
+}
+
+static void _handle_put(struct kvs_comm_set *kvs_set_ptr)
+{
+	int i;
+
+	xrealloc(kvs_comm_ptr, sizeof(struct kvs_comm *) *
+		 (kvs_comm_cnt + kvs_set_ptr->kvs_comm_recs));
+	for (i = 0; i < kvs_set_ptr->kvs_comm_recs; i++) {
+		kvs_comm_ptr[kvs_comm_cnt++] = kvs_set_ptr->kvs_comm_ptr[i];
+		kvs_set_ptr->kvs_comm_ptr[i] = NULL;
+	}
+	kvs_set_ptr->kvs_comm_recs = 0;
+	slurm_free_kvs_comm_set(kvs_set_ptr);
+}
+
+static int _handle_get(kvs_get_msg_t *kvs_get_ptr)
+{
+	int inx = _local_task_id(kvs_get_ptr->task_id);
+
+	if (inx < 0) {
+		error("pmi_local: barrier request from task %u not on node",
+		      kvs_get_ptr->task_id);
+		return SLURM_ERROR;
+	}
+	if (barrier_ptr[inx].port == 0)
+		barrier_resp_cnt++;
+	else {
+		error("pmi_local: duplicate barrier request from task %u",
+		      kvs_get_ptr->task_id);
+		xfree(barrier_ptr[inx].hostname);
+	}
+	barrier_ptr[inx].task_id  = kvs_get_ptr->task_id;
+	barrier_ptr[inx].port     = kvs_get_ptr->port;
+	barrier_ptr[inx].hostname = kvs_get_ptr->hostname;
+	kvs_get_ptr->hostname = NULL;	/* just moved the pointer */
+	return SLURM_SUCCESS;
+}
+
+/* Every local task is at the barrier: send this node's key-pairs to srun
+ * as one message, join srun's barrier as node "nodeid" of "nnodes", then
+ * hand srun's response to each local task. */
+static int _barrier_xmit(void)
+{
+	struct kvs_comm_set *kvs_set, *kvs_resp = NULL;
+	slurm_msg_t msg_send;
+	int i, rc = SLURM_SUCCESS, msg_rc;
+
+	if (kvs_comm_cnt) {
+		kvs_set = _take_local_kvs();
+		rc = slurm_send_kvs_comm_set(kvs_set, pmi_job->nodeid,
+					     pmi_job->nnodes);
+		if (rc != SLURM_SUCCESS)
+			error("pmi_local: key-pair send to srun: %m");
+		slurm_free_kvs_comm_set(kvs_set);
+	}
+
+	/* Responses from srun already carry any forwarding requests for
+	 * other nodes, which slurm_get_kvs_comm_set() services */
+	if (rc == SLURM_SUCCESS) {
+		rc = slurm_get_kvs_comm_set(&kvs_resp, pmi_job->nodeid,
+					    pmi_job->nnodes);
+		if (rc != SLURM_SUCCESS)
+			error("pmi_local: barrier with srun: %m");
+	}
+
+	/* Tasks are released even on failure so they do not hang; an empty
+	 * response leaves them without the remote key-pairs and their PMI
+	 * library reports the missing keys */
+	if (kvs_resp == NULL)
+		kvs_resp = xmalloc(sizeof(struct kvs_comm_set));
+	kvs_resp->host_cnt = 0;
+	for (i = 0; i < pmi_job->node_tasks; i++) {
+		if (barrier_ptr[i].port == 0)
+			continue;
+		slurm_msg_t_init(&msg_send);
+		msg_send.msg_type = PMI_KVS_GET_RESP;
+		msg_send.data = (void *) kvs_resp;
+		slurm_set_addr(&msg_send.address, barrier_ptr[i].port,
+			       barrier_ptr[i].hostname);
+		if (slurm_send_recv_rc_msg_only_one(&msg_send,
+						    &msg_rc, 0) < 0) {
+			error("pmi_local: could not send key-pairs to "
+			      "task %u", barrier_ptr[i].task_id);
+		}
+		xfree(barrier_ptr[i].hostname);
+		barrier_ptr[i].port = 0;
+	}
+	barrier_resp_cnt = 0;
+	slurm_free_kvs_comm_set(kvs_resp);
+
+	return rc;
+}
+
+static void *_agent(void *arg)
+{
+	slurm_addr_t cli_addr;
+	slurm_fd_t fd;
+	slurm_msg_t *msg;
+	int rc;
+
+	while (1) {
+		fd = slurm_accept_msg_conn(pmi_local_fd, &cli_addr);
+		if (fd < 0) {
+			if (errno != EINTR)
+				error("pmi_local: slurm_accept_msg_conn: %m");
+			continue;
+		}
+
+		/* Leave the message exchange with a task intact */
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+		msg = xmalloc(sizeof(slurm_msg_t));
+		slurm_msg_t_init(msg);
+		if (slurm_receive_msg(fd, msg, 0) != 0) {
+			error("pmi_local: slurm_receive_msg: %m");
+		} else if (!_valid_uid(msg)) {
+			slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
+			slurm_free_msg_data(msg->msg_type, msg->data);
+		} else if (msg->msg_type == PMI_KVS_PUT_REQ) {
+			_handle_put((struct kvs_comm_set *) msg->data);
+			slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		} else if (msg->msg_type == PMI_KVS_GET_REQ) {
+			rc = _handle_get((kvs_get_msg_t *) msg->data);
+			slurm_send_rc_msg(msg, rc);
+			slurm_free_get_kvs_msg((kvs_get_msg_t *) msg->data);
+		} else {
+			error("pmi_local: unexpected message type %u",
+			      msg->msg_type);
+			slurm_send_rc_msg(msg, SLURM_UNEXPECTED_MSG_ERROR);
+			slurm_free_msg_data(msg->msg_type, msg->data);
+		}
+		slurm_free_msg(msg);
+		slurm_close_accepted_conn(fd);
+		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+
+		/* The srun barrier may wait on other nodes for a long time,
+		 * so it remains cancelable should the step end meanwhile */
+		if (barrier_resp_cnt == pmi_job->node_tasks)
+			(void) _barrier_xmit();
+	}
+
+	return NULL;
+}
+
+extern int pmi_local_init(slurmd_job_t *job)
+{
+	char *host, *port, *pmi_time;
+	slurm_addr_t addr;
+	pthread_attr_t attr;
+
+	if (job->batch || (getenvp(job->env, "PMI_AGGREGATE") == NULL))
+		return SLURM_SUCCESS;
+	host = getenvp(job->env, "SLURM_SRUN_COMM_HOST");
+	port = getenvp(job->env, "SLURM_SRUN_COMM_PORT");
+	if ((host == NULL) || (port == NULL)) {
+		debug("PMI_AGGREGATE ignored, no srun communication address");
+		return SLURM_SUCCESS;
+	}
+
+	/* Stagger this node's RPCs to srun the way the tasks would have */
+	if ((pmi_time = getenvp(job->env, "PMI_TIME")))
+		setenv("PMI_TIME", pmi_time, 1);
+	slurm_pmi_set_srun_addr(host, (uint16_t) atol(port));
+
+	if ((pmi_local_fd = slurm_init_msg_engine_port(0)) < 0) {
+		error("pmi_local: slurm_init_msg_engine_port: %m");
+		return SLURM_ERROR;
+	}
+	fd_set_close_on_exec(pmi_local_fd);
+	if (slurm_get_stream_addr(pmi_local_fd, &addr) < 0) {
+		error("pmi_local: slurm_get_stream_addr: %m");
+		slurm_shutdown_msg_engine(pmi_local_fd);
+		pmi_local_fd = -1;
+		return SLURM_ERROR;
+	}
+
+	pmi_job = job;
+	barrier_ptr = xmalloc(sizeof(struct kvs_hosts) * job->node_tasks);
+	barrier_resp_cnt = 0;
+
+	slurm_attr_init(&attr);
+	if (pthread_create(&pmi_local_tid, &attr, _agent, NULL)) {
+		error("pmi_local: pthread_create: %m");
+		slurm_attr_destroy(&attr);
+		slurm_shutdown_msg_engine(pmi_local_fd);
+		pmi_local_fd = -1;
+		xfree(barrier_ptr);
+		return SLURM_ERROR;
+	}
+	slurm_attr_destroy(&attr);
+	pmi_local_running = true;
+
+	setenvf(&job->env, "SLURM_PMI_STEPD_PORT", "%u",
+		ntohs(addr.sin_port));
+	debug("PMI key-pairs of %u local tasks aggregated on port %u",
+	      job->node_tasks, ntohs(addr.sin_port));
+	return SLURM_SUCCESS;
+}
+
+extern void pmi_local_fini(void)
+{
+	int i;
+
+	if (!pmi_local_running)
+		return;
+
+	pthread_cancel(pmi_local_tid);
+	pthread_join(pmi_local_tid, NULL);
+	pmi_local_running = false;
+
+	slurm_shutdown_msg_engine(pmi_local_fd);
+	pmi_local_fd = -1;
+	slurm_pmi_finalize();
+
+	slurm_free_kvs_comm_set(_take_local_kvs());
+	for (i = 0; i < pmi_job->node_tasks; i++)
+		xfree(barrier_ptr[i].hostname);
+	xfree(barrier_ptr);
+	barrier_resp_cnt = 0;
+	pmi_job = NULL;
+}
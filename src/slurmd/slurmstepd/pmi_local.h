@@ -0,0 +1,58 @@
+/*****************************************************************************\
+ *  src/slurmd/slurmstepd/pmi_local.h - node-local PMI key-pair aggregation
+ *****************************************************************************
+ *  Copyright (C) 2011 SchedMD LLC <http://www.schedmd.com>.
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _STEPD_PMI_LOCAL_H
+#define _STEPD_PMI_LOCAL_H
+
+#include "src/slurmd/slurmstepd/slurmstepd_job.h"
+
+/*
+ * If the step's environment contains PMI_AGGREGATE, open a port on which
+ * this step's local tasks send their PMI key-pairs and barrier requests,
+ * and export it to the tasks as SLURM_PMI_STEPD_PORT. Once every local task
+ * has reached a barrier, the node's key-pairs are sent to srun as one
+ * message and srun's reply is relayed back to the tasks, so srun handles
+ * one request per node rather than one per task.
+ *
+ * Call before the tasks are forked. Returns SLURM_SUCCESS if aggregation
+ * was not requested.
+ */
+extern int pmi_local_init(slurmd_job_t *job);
+
+/* Stop the aggregation thread and release its state */
+extern void pmi_local_fini(void);
+
+#endif /* _STEPD_PMI_LOCAL_H */
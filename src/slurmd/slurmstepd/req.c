@@ -52,6 +52,7 @@
 #include "src/common/fd.h"
 #include "src/common/eio.h"
 #include "src/common/parse_time.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/slurmd/common/proctrack.h"
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_jobacct_gather.h"
@@ -61,6 +62,7 @@
 
 #include "src/slurmd/slurmd/slurmd.h"
 #include "src/slurmd/slurmstepd/io.h"
+#include "src/slurmd/slurmstepd/launch_relay.h"
 #include "src/slurmd/slurmstepd/mgr.h"
 #include "src/slurmd/slurmstepd/pdebug.h"
 #include "src/slurmd/slurmstepd/req.h"
@@ -84,6 +86,8 @@ static int _handle_suspend(int fd, slurmd_job_t *job, uid_t uid);
 static int _handle_resume(int fd, slurmd_job_t *job, uid_t uid);
 static int _handle_terminate(int fd, slurmd_job_t *job, uid_t uid);
 static int _handle_completion(int fd, slurmd_job_t *job, uid_t uid);
+static int _handle_launch_relay(int fd, slurmd_job_t *job, uid_t uid);
+static int _handle_io_relay_port(int fd, slurmd_job_t *job);
 static int _handle_stat_jobacct(int fd, slurmd_job_t *job, uid_t uid);
 static int _handle_task_info(int fd, slurmd_job_t *job);
 static int _handle_list_pids(int fd, slurmd_job_t *job);
@@ -519,6 +523,14 @@ _handle_request(int fd, slurmd_job_t *job, uid_t uid, gid_t gid)
 		debug("Handling REQUEST_STEP_COMPLETION");
 		rc = _handle_completion(fd, job, uid);
 		break;
+	case REQUEST_STEP_LAUNCH_RELAY:
+		debug("Handling REQUEST_STEP_LAUNCH_RELAY");
+		rc = _handle_launch_relay(fd, job, uid);
+		break;
+	case REQUEST_STEP_IO_RELAY_PORT:
+		debug("Handling REQUEST_STEP_IO_RELAY_PORT");
+		rc = _handle_io_relay_port(fd, job);
+		break;
 	case REQUEST_STEP_TASK_INFO:
 		debug("Handling REQUEST_STEP_TASK_INFO");
 		rc = _handle_task_info(fd, job);
@@ -1300,32 +1312,18 @@ _handle_completion(int fd, slurmd_job_t *job, uid_t uid)
 	 * Record the completed nodes
 	 */
 	pthread_mutex_lock(&step_complete.lock);
-	if (! step_complete.wait_children) {
+	/* The aggregator rejects the range once this step has stopped
+	 * waiting for its children, or if it has no children because
+	 * SlurmUser or root crafted a launch without a valid credential
+	 * ("srun --no-alloc ...") and no tree information could be built
+	 * without the hostlist from the credential. */
+	if (reverse_tree_agg_record(step_complete.agg, first, last) < 0) {
+		debug2("Rejecting completion of range %d to %d",
+		       first, last);
 		rc = -1;
 		errnum = ETIMEDOUT; /* not used anyway */
 		goto timeout;
 	}
-
-	/* SlurmUser or root can craft a launch without a valid credential
-	 * ("srun --no-alloc ...") and no tree information can be built
-	 *  without the hostlist from the credential. */
-	if (step_complete.rank >= 0) {
-#if 0
-		char bits_string[128];
-		debug2("Setting range %d (bit %d) through %d(bit %d)",
-		       first, first-(step_complete.rank+1),
-		       last, last-(step_complete.rank+1));
-		bit_fmt(bits_string, sizeof(bits_string), step_complete.bits);
-		debug2("  before bits: %s", bits_string);
-#endif
-		bit_nset(step_complete.bits,
-			 first - (step_complete.rank+1),
-			 last - (step_complete.rank+1));
-#if 0
-		bit_fmt(bits_string, sizeof(bits_string), step_complete.bits);
-		debug2("  after bits: %s", bits_string);
-#endif
-	}
 	step_complete.step_rc = MAX(step_complete.step_rc, step_rc);
 
 	/************* acct stuff ********************/
@@ -1347,6 +1345,72 @@ rwfail:
 	return SLURM_FAILURE;
 }
 
+/* Largest packed relay message accepted from slurmd */
+#define LAUNCH_RELAY_MAX_LEN	(16 * 1024 * 1024)
+
+static int
+_handle_launch_relay(int fd, slurmd_job_t *job, uid_t uid)
+{
+	int rc = SLURM_SUCCESS;
+	int errnum = 0;
+	uint32_t len;
+	char *data = NULL;
+	Buf buffer;
+	slurm_msg_t msg;
+	launch_tasks_relay_msg_t *relay;
+
+	debug("_handle_launch_relay for job %u.%u",
+	      job->jobid, job->stepid);
+
+	debug3("  uid = %d", uid);
+	if (!_slurm_authorized_user(uid)) {
+		debug("launch relay message from uid %ld for job %u.%u ",
+		      (long)uid, job->jobid, job->stepid);
+		rc = -1;
+		errnum = EPERM;
+		/* Send the return code and errno */
+		safe_write(fd, &rc, sizeof(int));
+		safe_write(fd, &errnum, sizeof(int));
+		return SLURM_SUCCESS;
+	}
+
+	safe_read(fd, &len, sizeof(uint32_t));
+	if (len > LAUNCH_RELAY_MAX_LEN) {
+		error("launch relay message too long (%u bytes)", len);
+		return SLURM_FAILURE;
+	}
+	data = xmalloc(len);
+	safe_read(fd, data, len);
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = RESPONSE_LAUNCH_TASKS_RELAY;
+	buffer = create_buf(data, len);	/* buffer now owns data */
+	data = NULL;
+	if (unpack_msg(&msg, buffer) != SLURM_SUCCESS) {
+		rc = -1;
+		errnum = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+	} else {
+		relay = (launch_tasks_relay_msg_t *) msg.data;
+		if ((relay->job_id != job->jobid) ||
+		    (relay->job_step_id != job->stepid) ||
+		    (launch_relay_add(relay->resp_list) != SLURM_SUCCESS)) {
+			/* the sender goes to srun directly */
+			rc = -1;
+			errnum = ESLURMD_JOB_NOTRUNNING;
+		}
+		slurm_free_launch_tasks_relay_msg(relay);
+	}
+	free_buf(buffer);
+
+	/* Send the return code and errno */
+	safe_write(fd, &rc, sizeof(int));
+	safe_write(fd, &errnum, sizeof(int));
+	return SLURM_SUCCESS;
+rwfail:
+	xfree(data);
+	return SLURM_FAILURE;
+}
+
 static int
 _handle_stat_jobacct(int fd, slurmd_job_t *job, uid_t uid)
 {
@@ -1436,6 +1500,20 @@ rwfail:
 	return SLURM_FAILURE;
 }
 
+static int
+_handle_io_relay_port(int fd, slurmd_job_t *job)
+{
+	uint16_t port = io_relay_port();
+
+	debug("_handle_io_relay_port for job %u.%u, port %hu",
+	      job->jobid, job->stepid, port);
+	safe_write(fd, &port, sizeof(uint16_t));
+
+	return SLURM_SUCCESS;
+rwfail:
+	return SLURM_FAILURE;
+}
+
 static int
 _handle_reconfig(int fd, slurmd_job_t *job, uid_t uid)
 {
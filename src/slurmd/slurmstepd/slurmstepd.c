@@ -58,7 +58,9 @@
 #include "src/slurmd/common/slurmstepd_init.h"
 #include "src/slurmd/common/setproctitle.h"
 #include "src/slurmd/common/proctrack.h"
+#include "src/slurmd/common/task_plugin.h"
 #include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmstepd/launch_relay.h"
 #include "src/slurmd/slurmstepd/mgr.h"
 #include "src/slurmd/slurmstepd/req.h"
 #include "src/slurmd/slurmstepd/slurmstepd.h"
@@ -109,6 +111,14 @@ main (int argc, char *argv[])
 	if (slurm_select_init(1) != SLURM_SUCCESS )
 		fatal( "failed to initialize node selection plugin" );
 
+	/* Load the plugins every step needs before waiting for the step.
+	 * A slurmstepd kept idle in slurmd's pool does this ahead of time,
+	 * any failure is reported by job_manager() when it loads them. */
+	(void) switch_init();
+	(void) slurmd_task_init();
+	(void) slurm_proctrack_init();
+	(void) slurm_jobacct_gather_init();
+
 	/* Receive job parameters from the slurmd */
 	_init_from_slurmd(STDIN_FILENO, argv, &cli, &self, &msg,
 			  &ngids, &gids);
@@ -133,6 +143,10 @@ main (int argc, char *argv[])
 	list_install_fork_handlers();
 	slurm_conf_install_fork_handlers();
 
+	/* relayed launch responses may arrive as soon as the message
+	 * thread is up */
+	launch_relay_init(job);
+
 	/* sets job->msg_handle and job->msgid */
 	if (msg_thr_create(job) == SLURM_ERROR) {
 		_send_fail_to_slurmd(STDOUT_FILENO);
@@ -224,8 +238,16 @@ _init_from_slurmd(int sock, char **argv,
 
 	log_init(argv[0], lopts, LOG_DAEMON, NULL);
 
-	/* receive job type from slurmd */
-	safe_read(sock, &step_type, sizeof(int));
+	/* receive job type from slurmd.  An idle pooled slurmstepd sees
+	 * EOF here when slurmd discards it, just exit quietly. */
+	while ((len = read(sock, &step_type, sizeof(int))) < 0) {
+		if ((errno != EINTR) && (errno != EAGAIN))
+			break;
+	}
+	if (len == 0)
+		exit(0);
+	if (len != sizeof(int))
+		goto rwfail;
 	debug3("step_type = %d", step_type);
 
 	/* receive reverse-tree info from slurmd */
@@ -236,7 +258,11 @@ _init_from_slurmd(int sock, char **argv,
 	safe_read(sock, &step_complete.depth, sizeof(int));
 	safe_read(sock, &step_complete.max_depth, sizeof(int));
 	safe_read(sock, &step_complete.parent_addr, sizeof(slurm_addr_t));
-	step_complete.bits = bit_alloc(step_complete.children);
+	step_complete.agg = reverse_tree_agg_create(step_complete.rank,
+						    step_complete.children,
+						    step_complete.depth,
+						    step_complete.max_depth,
+						    REVERSE_TREE_WIDTH);
 	step_complete.jobacct = jobacct_gather_g_create(NULL);
 	pthread_mutex_unlock(&step_complete.lock);
 
@@ -432,6 +458,7 @@ _step_cleanup(slurmd_job_t *job, slurm_msg_t *msg, int rc)
 		break;
 	}
 	jobacct_gather_g_destroy(step_complete.jobacct);
+	reverse_tree_agg_destroy(step_complete.agg);
 
 	xfree(msg);
 }
@@ -41,6 +41,7 @@
 #define _SLURMSTEPD_H
 
 #include "src/common/bitstring.h"
+#include "src/slurmd/common/reverse_tree.h"
 
 #define STEPD_MESSAGE_COMP_WAIT 3 /* seconds */
 #define MAX_RETRIES    3
@@ -56,8 +57,7 @@ typedef struct {
 	slurm_addr_t parent_addr;
 	int children;
 	int max_depth;
-	bool wait_children;
-	bitstr_t *bits;
+	reverse_tree_agg_t *agg;
 	int step_rc;
 	jobacctinfo_t *jobacct;
 } step_complete_t;
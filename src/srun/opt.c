@@ -117,6 +117,8 @@
 #define OPT_ACCTG_FREQ  0x15
 #define OPT_WCKEY       0x16
 #define OPT_SIGNAL      0x17
+#define OPT_LAUNCH_RELAY 0x18
+#define OPT_IO_AGGREGATE 0x19
 
 /* generic getopt_long flags, integers and *not* valid characters */
 #define LONG_OPT_HELP        0x100
@@ -182,6 +184,8 @@
 #define LONG_OPT_TIME_MIN        0x150
 #define LONG_OPT_GRES            0x151
 #define LONG_OPT_ALPS            0x152
+#define LONG_OPT_LAUNCH_RELAY    0x153
+#define LONG_OPT_IO_AGGREGATE    0x154
 
 extern char **environ;
 
@@ -390,6 +394,8 @@ static void _opt_default()
 
 	opt.quit_on_intr = false;
 	opt.disable_status = false;
+	opt.launch_relay = false;
+	opt.io_aggregate = false;
 	opt.test_only   = false;
 	opt.preserve_env = false;
 
@@ -495,8 +501,10 @@ env_vars_t env_vars[] = {
 {"SLURM_JOBID",         OPT_INT,        &opt.jobid,         NULL             },
 {"SLURM_JOB_ID",        OPT_INT,        &opt.jobid,         NULL             },
 {"SLURM_JOB_NAME",      OPT_STRING,     &opt.job_name,  &opt.job_name_set_env},
+{"SLURM_IO_AGGREGATE",  OPT_IO_AGGREGATE, NULL,             NULL             },
 {"SLURM_KILL_BAD_EXIT", OPT_INT,        &opt.kill_bad_exit, NULL             },
 {"SLURM_LABELIO",       OPT_INT,        &opt.labelio,       NULL             },
+{"SLURM_LAUNCH_RELAY",  OPT_LAUNCH_RELAY, NULL,             NULL             },
 {"SLURM_LINUX_IMAGE",   OPT_STRING,     &opt.linuximage,    NULL             },
 {"SLURM_MEM_BIND",      OPT_MEM_BIND,   NULL,               NULL             },
 {"SLURM_MLOADER_IMAGE", OPT_STRING,     &opt.mloaderimage,  NULL             },
@@ -680,6 +688,14 @@ _process_env_var(env_vars_t *e, const char *val)
 		}
 		break;
 
+	case OPT_LAUNCH_RELAY:
+		opt.launch_relay = true;
+		break;
+
+	case OPT_IO_AGGREGATE:
+		opt.io_aggregate = true;
+		break;
+
 	default:
 		/* do nothing */
 		break;
@@ -778,8 +794,10 @@ static void set_options(const int argc, char **argv)
 		{"gres",             required_argument, 0, LONG_OPT_GRES},
 		{"help",             no_argument,       0, LONG_OPT_HELP},
 		{"hint",             required_argument, 0, LONG_OPT_HINT},
+		{"io-aggregate",     no_argument,       0, LONG_OPT_IO_AGGREGATE},
 		{"ioload-image",     required_argument, 0, LONG_OPT_RAMDISK_IMAGE},
 		{"jobid",            required_argument, 0, LONG_OPT_JOBID},
+		{"launch-relay",     no_argument,       0, LONG_OPT_LAUNCH_RELAY},
 		{"linux-image",      required_argument, 0, LONG_OPT_LINUX_IMAGE},
 		{"mail-type",        required_argument, 0, LONG_OPT_MAIL_TYPE},
 		{"mail-user",        required_argument, 0, LONG_OPT_MAIL_USER},
@@ -1300,6 +1318,12 @@ static void set_options(const int argc, char **argv)
 		case LONG_OPT_MULTI:
 			opt.multi_prog = true;
 			break;
+		case LONG_OPT_LAUNCH_RELAY:
+			opt.launch_relay = true;
+			break;
+		case LONG_OPT_IO_AGGREGATE:
+			opt.io_aggregate = true;
+			break;
 		case LONG_OPT_COMMENT:
 			xfree(opt.comment);
 			opt.comment = xstrdup(optarg);
@@ -2354,6 +2378,8 @@ static void _opt_list()
 	info("task_prolog    : %s", opt.task_prolog);
 	info("task_epilog    : %s", opt.task_epilog);
 	info("multi_prog     : %s", opt.multi_prog ? "yes" : "no");
+	info("launch_relay   : %s", opt.launch_relay ? "yes" : "no");
+	info("io_aggregate   : %s", opt.io_aggregate ? "yes" : "no");
 	info("sockets-per-node  : %d", opt.sockets_per_node);
 	info("cores-per-socket  : %d", opt.cores_per_socket);
 	info("threads-per-core  : %d", opt.threads_per_core);
@@ -2406,7 +2432,8 @@ static void _usage(void)
 "            [--mail-type=type] [--mail-user=user] [--nice[=value]]\n"
 "            [--prolog=fname] [--epilog=fname]\n"
 "            [--task-prolog=fname] [--task-epilog=fname]\n"
-"            [--ctrl-comm-ifhn=addr] [--multi-prog]\n"
+"            [--ctrl-comm-ifhn=addr] [--multi-prog] [--launch-relay]\n"
+"            [--io-aggregate]\n"
 "            [-w hosts...] [-x hosts...] executable [args...]\n");
 }
 
@@ -2436,6 +2463,8 @@ static void _help(void)
 "  -H, --hold                  submit job in held state\n"
 "  -i, --input=in              location of stdin redirection\n"
 "  -I, --immediate[=secs]      exit if resources not available in \"secs\"\n"
+"      --io-aggregate          relay task I/O through the nodes, gather output\n"
+"                              into fewer writes\n"
 "      --jobid=id              run under already allocated job\n"
 "  -J, --job-name=jobname      name of job\n"
 "  -k, --no-kill               do not kill job on node failure\n"
@@ -2443,6 +2472,7 @@ static void _help(void)
 "                              non-zero exit code\n"
 "  -l, --label                 prepend task number to lines of stdout/err\n"
 "  -L, --licenses=names        required license, comma separated\n"
+"      --launch-relay          relay task launch responses through the nodes\n"
 "  -m, --distribution=type     distribution method for processes to nodes\n"
 "                              (type = block|cyclic|arbitrary)\n"
 "      --mail-type=type        notify on state change: BEGIN, END, FAIL or ALL\n"
@@ -167,6 +167,8 @@ typedef struct srun_options {
 	int  max_wait;		/* --wait,    -W		*/
 	bool quit_on_intr;      /* --quit-on-interrupt, -q      */
 	bool disable_status;    /* --disable-status, -X         */
+	bool launch_relay;	/* --launch-relay		*/
+	bool io_aggregate;	/* --io-aggregate		*/
 	int  quiet;
 	bool parallel_debug;	/* srun controlled by debugger	*/
 	bool debugger_test;	/* --debugger-test		*/
@@ -454,6 +454,8 @@ int srun(int ac, char **av)
 	launch_params.argc = opt.argc;
 	launch_params.argv = opt.argv;
 	launch_params.multi_prog = opt.multi_prog ? true : false;
+	launch_params.launch_relay = opt.launch_relay;
+	launch_params.io_aggregate = opt.io_aggregate;
 	launch_params.cwd = opt.cwd;
 	launch_params.slurmd_debug = opt.slurmd_debug;
 	launch_params.buffered_stdio = !opt.unbuffered;
@@ -113,7 +113,10 @@ void task_state_update (task_state_t ts, int taskid, task_state_type_t t)
 
 	switch (t) {
 	case TS_START_SUCCESS:
-		bit_set (ts->running, taskid);
+		/* A relayed launch response may arrive after the exit */
+		if (!bit_test(ts->normal_exit, taskid) &&
+		    !bit_test(ts->abnormal_exit, taskid))
+			bit_set (ts->running, taskid);
 		ts->n_started++;
 		break;
 	case TS_START_FAILURE:
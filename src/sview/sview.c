@@ -638,6 +638,14 @@ static void _get_current_debug_flags(GtkToggleAction *action)
 	new_state = debug_flags & DEBUG_FLAG_WIKI;
 	if (orig_state != new_state)
 		gtk_toggle_action_set_active(toggle_action, new_state);
+
+	debug_action = gtk_action_group_get_action(menu_action_group,
+						  "flags_xmalloc");
+	toggle_action = GTK_TOGGLE_ACTION(debug_action);
+	orig_state = gtk_toggle_action_get_active(toggle_action);
+	new_state = debug_flags & DEBUG_FLAG_XMALLOC;
+	if (orig_state != new_state)
+		gtk_toggle_action_set_active(toggle_action, new_state);
 }
 
 static void _set_debug(GtkRadioAction *action,
@@ -747,6 +755,10 @@ static void _set_flags_wiki(GtkToggleAction *action)
 {
 	_set_flags(action, DEBUG_FLAG_WIKI);
 }
+static void _set_flags_xmalloc(GtkToggleAction *action)
+{
+	_set_flags(action, DEBUG_FLAG_XMALLOC);
+}
 
 static void _tab_pos(GtkRadioAction *action,
 		     GtkRadioAction *extra,
@@ -880,6 +892,7 @@ static char *_get_ui_description()
 		"        <menuitem action='flags_steps'/>"
 		"        <menuitem action='flags_triggers'/>"
 		"        <menuitem action='flags_wiki'/>"
+		"        <menuitem action='flags_xmalloc'/>"
 		"      </menu>"
 		"      <separator/>"
 		"      <menuitem action='exit'/>"
@@ -1122,6 +1135,8 @@ static GtkWidget *_get_menubar_menu(GtkWidget *window, GtkWidget *notebook)
 		 "Triggers", G_CALLBACK(_set_flags_triggers), FALSE},
 		{"flags_wiki", NULL, "Wiki", NULL,
 		 "Wiki", G_CALLBACK(_set_flags_wiki), FALSE},
+		{"flags_xmalloc", NULL, "XMalloc", NULL,
+		 "XMalloc", G_CALLBACK(_set_flags_xmalloc), FALSE},
 	};
 
 	/* Make an accelerator group (shortcut keys) */
@@ -0,0 +1,109 @@
+/*****************************************************************************\
+ *  test7.15.prog.c - Time many small RPCs to slurmctld from several
+ *  threads.
+ *****************************************************************************
+ *  Copyright (C) 2011 Lawrence Livermore National Security.
+ *  Produced at Lawrence Livermore National Laboratory (cf, DISCLAIMER).
+ *  CODE-OCEC-09-009. All rights reserved.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <https://computing.llnl.gov/linux/slurm/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+
+static int rpc_cnt = 0;
+static int err_cnt = 0;
+static time_t part_time = 0;
+static pthread_mutex_t cnt_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Each RPC is a partition load which the controller answers with
+ * SLURM_NO_CHANGE_IN_DATA, so the time is spent in connection setup,
+ * authentication and message handling rather than in the payload */
+static void *_rpc_thread(void *arg)
+{
+	partition_info_msg_t *part_ptr;
+	int i, iters = *(int *) arg, errs = 0;
+
+	for (i = 0; i < iters; i++) {
+		part_ptr = NULL;
+		if (slurm_load_partitions(part_time, &part_ptr, 0) ==
+		    SLURM_SUCCESS)
+			slurm_free_partition_info_msg(part_ptr);
+		else if (slurm_get_errno() != SLURM_NO_CHANGE_IN_DATA)
+			errs++;
+	}
+
+	pthread_mutex_lock(&cnt_lock);
+	rpc_cnt += iters;
+	err_cnt += errs;
+	pthread_mutex_unlock(&cnt_lock);
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	partition_info_msg_t *part_ptr = NULL;
+	pthread_t *threads;
+	struct timeval start, end;
+	int i, thread_cnt, iters;
+	long usec;
+
+	if (argc < 3) {
+		printf("Usage: thread_count rpcs_per_thread\n");
+		exit(1);
+	}
+	thread_cnt = atoi(argv[1]);
+	iters = atoi(argv[2]);
+	if ((thread_cnt < 1) || (iters < 1)) {
+		printf("Invalid arguments\n");
+		exit(1);
+	}
+
+	if (slurm_load_partitions(0, &part_ptr, 0) != SLURM_SUCCESS) {
+		slurm_perror("slurm_load_partitions");
+		exit(1);
+	}
+	part_time = part_ptr->last_update;
+	slurm_free_partition_info_msg(part_ptr);
+
+	threads = malloc(sizeof(pthread_t) * thread_cnt);
+	gettimeofday(&start, NULL);
+	for (i = 0; i < thread_cnt; i++) {
+		if (pthread_create(&threads[i], NULL, _rpc_thread, &iters)) {
+			perror("pthread_create");
+			exit(1);
+		}
+	}
+	for (i = 0; i < thread_cnt; i++)
+		pthread_join(threads[i], NULL);
+	gettimeofday(&end, NULL);
+	free(threads);
+
+	usec = (end.tv_sec - start.tv_sec) * 1000000 +
+	       (end.tv_usec - start.tv_usec);
+	if (usec < 1)
+		usec = 1;
+	printf("rpcs:%d errors:%d usec:%ld rate:%ld\n",
+	       rpc_cnt, err_cnt, usec, (long) rpc_cnt * 1000000 / usec);
+	exit(0);
+}
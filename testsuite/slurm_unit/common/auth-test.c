@@ -0,0 +1,293 @@
+/* Test of the HMAC-SHA256 in src/common/hmac.c and timing of message
+ * authentication credentials with and without AuthSessionTimeout.
+ * The credential timing needs slurm.conf and a working authentication
+ * plugin (munged running for auth/munge), it is skipped otherwise.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <slurm/slurm_errno.h>
+#include <src/common/hmac.h>
+#include <src/common/pack.h>
+#include <src/common/read_config.h>
+#include <src/common/slurm_auth.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+
+#include <testsuite/dejagnu.h>
+
+#define MAC_CNT		200000	/* HMACs timed */
+#define CRED_CNT	2000	/* credentials timed */
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+static void _hex(const unsigned char *data, int len, char *str)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		sprintf(str + (i * 2), "%02x", data[i]);
+}
+
+static int _check_mac(const char *key, int key_len, const char *data,
+		      const char *expect)
+{
+	hmac_sha256_key_t hkey;
+	unsigned char mac[SHA256_DIGEST_LEN];
+	char str[SHA256_DIGEST_LEN * 2 + 1];
+
+	hmac_sha256_key(&hkey, key, key_len);
+	hmac_sha256(&hkey, data, strlen(data), mac);
+	_hex(mac, SHA256_DIGEST_LEN, str);
+	return strcmp(str, expect);
+}
+
+static int _check_hash(const char *data, const char *expect)
+{
+	sha256_ctx_t ctx;
+	unsigned char digest[SHA256_DIGEST_LEN];
+	char str[SHA256_DIGEST_LEN * 2 + 1];
+	int i, len = strlen(data);
+
+	/* feed it in odd sized pieces to exercise the block buffer */
+	sha256_init(&ctx);
+	for (i = 0; i < len; i += 7)
+		sha256_update(&ctx, data + i, MIN(7, len - i));
+	sha256_final(&ctx, digest);
+	_hex(digest, SHA256_DIGEST_LEN, str);
+	return strcmp(str, expect);
+}
+
+/* A message for credentials to be signed with */
+static char msg_head[] = "header", msg_body[] = "message body";
+static struct iovec msg_data[2] = {
+	{ msg_head, sizeof(msg_head) },
+	{ msg_body, sizeof(msg_body) }
+};
+
+/* Create a credential for a message to user r_uid, pack and unpack it
+ * RET the unpacked credential or NULL */
+static void *_auth_cred_to(Buf buf, uid_t r_uid)
+{
+	void *cred;
+
+	cred = g_slurm_auth_create_signed(NULL, 2, NULL, r_uid,
+					  SLURM_AUTH_ANY_GID, msg_data, 2);
+	if (cred == NULL)
+		return NULL;
+	g_slurm_auth_pack(cred, buf);
+	g_slurm_auth_destroy(cred);
+	set_buf_offset(buf, 0);
+	return g_slurm_auth_unpack(buf);
+}
+
+static void *_auth_cred(Buf buf)
+{
+	return _auth_cred_to(buf, getuid());
+}
+
+/* Create, pack, unpack and verify cnt credentials
+ * RET the number which failed to verify as ours */
+static int _auth_cycle(int cnt, double *rate)
+{
+	struct timeval start;
+	void *cred;
+	Buf buf;
+	int i, bad = 0;
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < cnt; i++) {
+		buf = init_buf(1024);
+		cred = _auth_cred(buf);
+		if (!cred ||
+		    g_slurm_auth_verify_signed(cred, NULL, 2, NULL,
+					       msg_data, 2) ||
+		    (g_slurm_auth_get_uid(cred, NULL) != getuid()))
+			bad++;
+		if (cred)
+			g_slurm_auth_destroy(cred);
+		free_buf(buf);
+	}
+	*rate = cnt / _elapsed(&start);
+	return bad;
+}
+
+/* Verify the same packed credential twice, RET true if the second
+ * verification is refused */
+static bool _replay_refused(void)
+{
+	void *cred;
+	Buf buf = init_buf(1024);
+	int i, rc[2] = { SLURM_ERROR, SLURM_ERROR };
+
+	for (i = 0; i < 2; i++) {
+		set_buf_offset(buf, 0);
+		if ((cred = (i ? g_slurm_auth_unpack(buf) : _auth_cred(buf)))) {
+			rc[i] = g_slurm_auth_verify_signed(cred, NULL, 2, NULL,
+							   msg_data, 2);
+			g_slurm_auth_destroy(cred);
+		}
+	}
+	free_buf(buf);
+	return ((rc[0] == SLURM_SUCCESS) && (rc[1] != SLURM_SUCCESS));
+}
+
+/* RET true if a credential is refused with a message other than the one
+ * it was created for, without its message or by another user */
+static bool _forgery_refused(void)
+{
+	char body[] = "message bodY";
+	struct iovec data[2] = {
+		{ msg_head, sizeof(msg_head) },
+		{ body, sizeof(body) }
+	};
+	void *cred;
+	Buf buf = init_buf(1024);
+	int rc[3] = { SLURM_SUCCESS, SLURM_SUCCESS, SLURM_SUCCESS };
+
+	if ((cred = _auth_cred(buf))) {
+		rc[0] = g_slurm_auth_verify_signed(cred, NULL, 2, NULL,
+						   data, 2);
+		g_slurm_auth_destroy(cred);
+	}
+	set_buf_offset(buf, 0);
+	if ((cred = _auth_cred(buf))) {
+		rc[1] = g_slurm_auth_verify(cred, NULL, 2, NULL);
+		g_slurm_auth_destroy(cred);
+	}
+	set_buf_offset(buf, 0);
+	if ((cred = _auth_cred_to(buf, getuid() + 1))) {
+		rc[2] = g_slurm_auth_verify_signed(cred, NULL, 2, NULL,
+						   msg_data, 2);
+		g_slurm_auth_destroy(cred);
+	}
+	free_buf(buf);
+	return ((rc[0] != SLURM_SUCCESS) && (rc[1] != SLURM_SUCCESS) &&
+		(rc[2] != SLURM_SUCCESS));
+}
+
+int main (int argc, char *argv[])
+{
+	hmac_sha256_key_t hkey;
+	unsigned char mac[SHA256_DIGEST_LEN], data[16];
+	char key[131], *conf_file, *auth_type;
+	struct iovec iov[2];
+	struct timeval start;
+	slurm_ctl_conf_t *conf;
+	double rate, session_rate;
+	int i, bad;
+
+	TEST(_check_hash("abc", "ba7816bf8f01cfea414140de5dae2223"
+			 "b00361a396177a9cb410ff61f20015ad"),
+	     "SHA-256 of \"abc\"");
+	TEST(_check_hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnop"
+			 "nopq", "248d6a61d20638b8e5c026930c3e6039"
+			 "a33ce45964ff2167f6ecedd419db06c1"),
+	     "SHA-256 of two blocks");
+
+	/* RFC 4231 test cases 1, 2 and 6 */
+	memset(key, 0x0b, 20);
+	TEST(_check_mac(key, 20, "Hi There",
+			"b0344c61d8db38535ca8afceaf0bf12b"
+			"881dc200c9833da726e9376c2e32cff7"),
+	     "HMAC-SHA256 RFC 4231 case 1");
+	TEST(_check_mac("Jefe", 4, "what do ya want for nothing?",
+			"5bdcc146bf60754e6a042426089575c7"
+			"5a003f089d2739839dec58b964ec3843"),
+	     "HMAC-SHA256 RFC 4231 case 2");
+	memset(key, 0xaa, 131);
+	TEST(_check_mac(key, 131, "Test Using Larger Than Block-Size Key - "
+			"Hash Key First",
+			"60e431591ee0b67f0d8a26aacbf5b77f"
+			"8e0bc6213728c5140546040f0ee37f54"),
+	     "HMAC-SHA256 RFC 4231 case 6");
+	iov[0].iov_base = "what do ya ";
+	iov[0].iov_len  = 11;
+	iov[1].iov_base = "want for nothing?";
+	iov[1].iov_len  = 17;
+	hmac_sha256_key(&hkey, "Jefe", 4);
+	hmac_sha256_iov(&hkey, iov, 2, mac);
+	_hex(mac, SHA256_DIGEST_LEN, key);
+	TEST(strcmp(key, "5bdcc146bf60754e6a042426089575c7"
+			 "5a003f089d2739839dec58b964ec3843"),
+	     "HMAC-SHA256 of a message in parts");
+	TEST(hmac_compare((unsigned char *) "abcd",
+			  (unsigned char *) "abce", 4) == 0,
+	     "MAC comparison");
+
+	/* The MAC of a small message */
+	memset(data, 0, sizeof(data));
+	hmac_sha256_key(&hkey, key, 32);
+	gettimeofday(&start, NULL);
+	for (i = 0; i < MAC_CNT; i++) {
+		data[15] = i;
+		hmac_sha256(&hkey, data, sizeof(data), mac);
+	}
+	note("%.0f HMAC-SHA256 per second", MAC_CNT / _elapsed(&start));
+
+	conf_file = getenv("SLURM_CONF");
+	if (conf_file == NULL)
+		conf_file = default_slurm_config_file;
+	if (access(conf_file, R_OK) != 0) {
+		note("no %s, skipping credential timing", conf_file);
+		totals();
+		return failed;
+	}
+	conf = slurm_conf_lock();
+	auth_type = xstrdup(conf->authtype);
+	conf->auth_session_timeout = 0;
+	slurm_conf_unlock();
+	if ((slurm_auth_init(NULL) != SLURM_SUCCESS) ||
+	    (_auth_cycle(1, &rate) != 0)) {
+		note("%s not working, skipping credential timing", auth_type);
+		xfree(auth_type);
+		totals();
+		return failed;
+	}
+
+	bad = _auth_cycle(CRED_CNT, &rate);
+	TEST(bad, "credentials verified");
+	note("%s: %.0f credentials per second", auth_type, rate);
+
+	if (strcmp(auth_type, "auth/munge") == 0) {
+		conf = slurm_conf_lock();
+		conf->auth_session_timeout = 60;
+		slurm_conf_unlock();
+		bad = _auth_cycle(CRED_CNT, &session_rate);
+		TEST(bad, "session credentials verified");
+		note("%s with AuthSessionTimeout: %.0f credentials per "
+		     "second, %.1f times faster", auth_type, session_rate,
+		     session_rate / rate);
+		TEST(!_replay_refused(), "session credential replay refused");
+		TEST(!_forgery_refused(),
+		     "session credential bound to its message");
+	}
+	xfree(auth_type);
+
+	totals();
+	return failed;
+}
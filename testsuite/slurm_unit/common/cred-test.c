@@ -0,0 +1,167 @@
+/* Test and timing of src/common/slurm_cred.c verification.
+ * Needs a configured crypto plugin and credential keys, so it is
+ * skipped on a host without slurm.conf.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <slurm/slurm_errno.h>
+#include <src/common/bitstring.h>
+#include <src/common/read_config.h>
+#include <src/common/slurm_cred.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+
+#include <testsuite/dejagnu.h>
+
+#define JOB_CNT		4096	/* cached job states */
+#define CRED_CNT	2000	/* credentials verified */
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+static slurm_cred_t *_create_cred(slurm_cred_ctx_t ctx, uint32_t jobid,
+				  uint32_t stepid)
+{
+	slurm_cred_arg_t arg;
+	uint16_t cores_per_socket = 4, sockets_per_node = 2;
+	uint32_t sock_core_rep_count = 1;
+	slurm_cred_t *cred;
+
+	memset(&arg, 0, sizeof(arg));
+	arg.jobid  = jobid;
+	arg.stepid = stepid;
+	arg.uid    = getuid();
+	arg.cores_per_socket    = &cores_per_socket;
+	arg.sockets_per_node    = &sockets_per_node;
+	arg.sock_core_rep_count = &sock_core_rep_count;
+	arg.job_core_bitmap  = bit_alloc(8);
+	arg.step_core_bitmap = bit_alloc(8);
+	bit_nset(arg.job_core_bitmap, 0, 7);
+	bit_nset(arg.step_core_bitmap, 0, 7);
+	arg.job_hostlist  = "localhost";
+	arg.job_nhosts    = 1;
+	arg.step_hostlist = "localhost";
+
+	cred = slurm_cred_create(ctx, &arg);
+	bit_free(arg.job_core_bitmap);
+	bit_free(arg.step_core_bitmap);
+	return cred;
+}
+
+int main (int argc, char *argv[])
+{
+	slurm_ctl_conf_t *conf;
+	slurm_cred_ctx_t cctx, vctx;
+	slurm_cred_t **creds;
+	slurm_cred_arg_t arg;
+	struct timeval start;
+	char *conf_file, *priv_key, *pub_key;
+	int i, bad;
+	double secs;
+
+	conf_file = getenv("SLURM_CONF");
+	if (conf_file == NULL)
+		conf_file = default_slurm_config_file;
+	if (access(conf_file, R_OK) != 0) {
+		printf("no %s, skipping credential test\n", conf_file);
+		return 77;
+	}
+
+	conf = slurm_conf_lock();
+	priv_key = xstrdup(conf->job_credential_private_key);
+	pub_key  = xstrdup(conf->job_credential_public_certificate);
+	slurm_conf_unlock();
+
+	cctx = slurm_cred_creator_ctx_create(priv_key);
+	vctx = slurm_cred_verifier_ctx_create(pub_key);
+	xfree(priv_key);
+	xfree(pub_key);
+	if (!cctx || !vctx) {
+		printf("no credential keys, skipping credential test\n");
+		return 77;
+	}
+
+	note("Caching %d job states", JOB_CNT);
+	for (i = 0; i < JOB_CNT; i++)
+		slurm_cred_insert_jobid(vctx, 100000 + i);
+	TEST(!slurm_cred_jobid_cached(vctx, 100000 + JOB_CNT - 1),
+	     "job state cached");
+
+	creds = xmalloc(sizeof(slurm_cred_t *) * CRED_CNT);
+	for (i = 0; i < CRED_CNT; i++)
+		creds[i] = _create_cred(cctx, 100000 + (i % JOB_CNT), i);
+
+	/* First verification of each credential checks its signature */
+	bad = 0;
+	gettimeofday(&start, NULL);
+	for (i = 0; i < CRED_CNT; i++) {
+		if (slurm_cred_verify(vctx, creds[i], &arg) < 0)
+			bad++;
+		else
+			slurm_cred_free_args(&arg);
+	}
+	secs = _elapsed(&start);
+	TEST(bad, "verify new credentials");
+	note("%.0f new credential verifications per second",
+	     CRED_CNT / secs);
+
+	/* Verifying again without a rewind is a replay */
+	TEST((slurm_cred_verify(vctx, creds[0], &arg) == 0) ||
+	     (slurm_get_errno() != ESLURMD_CREDENTIAL_REPLAYED),
+	     "detect replayed credential");
+
+	/* After a rewind the cached signature is used */
+	bad = 0;
+	gettimeofday(&start, NULL);
+	for (i = 0; i < CRED_CNT; i++) {
+		slurm_cred_rewind(vctx, creds[i]);
+		if (slurm_cred_verify(vctx, creds[i], &arg) < 0)
+			bad++;
+		else
+			slurm_cred_free_args(&arg);
+	}
+	secs = _elapsed(&start);
+	TEST(bad, "verify rewound credentials");
+	note("%.0f rewound credential verifications per second",
+	     CRED_CNT / secs);
+
+	/* A revoked job's credentials are rejected */
+	slurm_cred_revoke(vctx, 100000 + 1, time(NULL), 0);
+	slurm_cred_rewind(vctx, creds[1]);
+	TEST((slurm_cred_verify(vctx, creds[1], &arg) == 0) ||
+	     (slurm_get_errno() != ESLURMD_CREDENTIAL_REVOKED),
+	     "reject revoked credential");
+
+	for (i = 0; i < CRED_CNT; i++)
+		slurm_cred_destroy(creds[i]);
+	xfree(creds);
+	slurm_cred_ctx_destroy(cctx);
+	slurm_cred_ctx_destroy(vctx);
+
+	totals();
+	return failed;
+}
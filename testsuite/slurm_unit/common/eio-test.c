@@ -0,0 +1,244 @@
+/* Test of the eio main loop in src/common/eio.c and timing of loop
+ * iterations with its epoll and poll backends.
+ * The timing passes a token around a ring of objects, each end of a
+ * socketpair being one object, so every iteration has a single ready
+ * object however many are waiting. Ring sizes needing more descriptors
+ * than the process may open are skipped.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <src/common/eio.h>
+#include <src/common/fd.h>
+#include <src/common/xmalloc.h>
+
+#include <testsuite/dejagnu.h>
+
+#define MAX_RING	10000
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static int ring_size, hops, hop_limit;
+static int *ring;
+static bool done;
+
+static int writes, write_limit;
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+static double _cpu_secs(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+	return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+	       ((ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0);
+}
+
+static void _set_backend(char *backend)
+{
+	if (strcmp(backend, "poll") == 0)
+		setenv("SLURM_EIO_POLL", "1", 1);
+	else
+		unsetenv("SLURM_EIO_POLL");
+}
+
+static bool _ring_readable(eio_obj_t *obj)
+{
+	return !done;
+}
+
+static int _ring_read(eio_obj_t *obj, List objs)
+{
+	int next = ((long) obj->arg + 1) % ring_size;
+	char c;
+
+	if (read(obj->fd, &c, 1) != 1)
+		return SLURM_SUCCESS;
+	if (++hops >= hop_limit)
+		done = true;
+	else if (write(ring[next ^ 1], &c, 1) != 1)	/* next's peer */
+		done = true;
+	return SLURM_SUCCESS;
+}
+
+struct io_operations ring_ops = {
+	readable:	&_ring_readable,
+	handle_read:	&_ring_read,
+};
+
+static bool _file_writable(eio_obj_t *obj)
+{
+	return (writes < write_limit);
+}
+
+static int _file_write(eio_obj_t *obj, List objs)
+{
+	if (write(obj->fd, "x", 1) == 1)
+		writes++;
+	return SLURM_SUCCESS;
+}
+
+struct io_operations file_ops = {
+	writable:	&_file_writable,
+	handle_write:	&_file_write,
+};
+
+/* Pass the token around a ring of "size" objects, along with "extra"
+ * objects. Returns the number of hops made or -1 on error. */
+static int _run_ring(char *backend, int size, int limit, eio_obj_t **extra,
+		     int extra_cnt, double *secs, double *cpu)
+{
+	eio_handle_t *eio;
+	struct timeval start;
+	double cpu_start;
+	long i;
+	int rc;
+
+	ring_size = size;
+	ring = xmalloc(size * sizeof(int));
+	for (i = 0; i < size; i += 2) {
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, &ring[i]) < 0) {
+			while ((i -= 2) >= 0) {
+				close(ring[i]);
+				close(ring[i + 1]);
+			}
+			xfree(ring);
+			return -1;
+		}
+		fd_set_nonblocking(ring[i]);
+		fd_set_nonblocking(ring[i + 1]);
+	}
+
+	_set_backend(backend);
+	eio = eio_handle_create();
+	for (i = 0; i < size; i++) {
+		eio_new_initial_obj(eio, eio_obj_create(ring[i], &ring_ops,
+							(void *) i));
+	}
+	for (i = 0; i < extra_cnt; i++)
+		eio_new_initial_obj(eio, extra[i]);
+
+	hops = 0;
+	hop_limit = limit;
+	done = false;
+	gettimeofday(&start, NULL);
+	cpu_start = _cpu_secs();
+	if (write(ring[1], "t", 1) != 1)
+		done = true;
+	rc = eio_handle_mainloop(eio);
+	*cpu = _cpu_secs() - cpu_start;
+	*secs = _elapsed(&start);
+
+	eio_handle_destroy(eio);
+	for (i = 0; i < size; i++)
+		close(ring[i]);
+	xfree(ring);
+	return (rc < 0) ? -1 : hops;
+}
+
+static void _time_ring(char *backend, int size)
+{
+	char msg[128];
+	double secs, cpu;
+	int limit, rc;
+
+	limit = MAX(2000, 1000000 / size);
+	rc = _run_ring(backend, size, limit, NULL, 0, &secs, &cpu);
+	snprintf(msg, sizeof(msg), "%s: ring of %d objects", backend, size);
+	TEST(rc != limit, msg);
+	if (rc != limit)
+		return;
+	note("%s: %5d objects: %8.0f iterations per second, "
+	     "%7.2f usec CPU per iteration", backend, size, rc / secs,
+	     (cpu * 1000000.0) / rc);
+}
+
+/* Objects epoll can not watch, a regular file and two objects sharing a
+ * descriptor, must be polled along with the rest */
+static void _test_fallback(char *backend)
+{
+	char msg[128], file[] = "/tmp/eio-test.XXXXXX", buf[1024];
+	eio_obj_t *extra[3];
+	double secs, cpu;
+	int fd, pfd[2], rc, piped;
+
+	if ((fd = mkstemp(file)) < 0) {
+		note("mkstemp: %m, skipping fallback test");
+		return;
+	}
+	unlink(file);
+	if (pipe(pfd) < 0) {
+		note("pipe: %m, skipping fallback test");
+		close(fd);
+		return;
+	}
+
+	writes = 0;
+	write_limit = 300;
+	extra[0] = eio_obj_create(fd, &file_ops, NULL);
+	extra[1] = eio_obj_create(pfd[1], &file_ops, NULL);
+	extra[2] = eio_obj_create(pfd[1], &file_ops, NULL);
+	rc = _run_ring(backend, 10, 1000, extra, 3, &secs, &cpu);
+	fd_set_nonblocking(pfd[0]);
+	piped = read(pfd[0], buf, sizeof(buf));
+	snprintf(msg, sizeof(msg), "%s: regular file and shared fd", backend);
+	TEST((rc != 1000) || (writes != write_limit) || (piped <= 0) ||
+	     ((lseek(fd, 0, SEEK_END) + piped) != write_limit), msg);
+	close(fd);
+	close(pfd[0]);
+	close(pfd[1]);
+}
+
+int main (int argc, char *argv[])
+{
+	char *backends[] = { "epoll", "poll", NULL };
+	struct rlimit rlim;
+	int i, size;
+
+	if (getrlimit(RLIMIT_NOFILE, &rlim) == 0) {
+		rlim.rlim_cur = rlim.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rlim);
+		getrlimit(RLIMIT_NOFILE, &rlim);
+	}
+
+	for (i = 0; backends[i]; i++) {
+		_test_fallback(backends[i]);
+		for (size = 10; size <= MAX_RING; size *= 10) {
+			if ((size + 64) > rlim.rlim_cur) {
+				note("%s: %d objects needs %d files, skipped",
+				     backends[i], size, size + 64);
+				continue;
+			}
+			_time_ring(backends[i], size);
+		}
+	}
+
+	totals();
+	return failed;
+}
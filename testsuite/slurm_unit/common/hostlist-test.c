@@ -0,0 +1,237 @@
+/* Test of host lookup in src/common/hostlist.c and timing of find, delete
+ * and hostset operations on lists of 100k nodes.
+ * A contiguous list is a single range. A fragmented list holds every
+ * other node, one range per node, which is the worst case for a search
+ * through the ranges.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/time.h>
+
+#include <src/common/hostlist.h>
+
+#include <testsuite/dejagnu.h>
+
+#define NODE_CNT	100000
+#define LOOKUP_CNT	10000
+#define DELETE_CNT	2000
+#define SET_CNT		20000
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+/* Return the number of hosts of hl whose position hostlist_find() gets
+ * wrong, the position of a host being that of its first copy */
+static int _check_find(hostlist_t hl)
+{
+	char *host, *other;
+	int i, j, expect, bad = 0, cnt = hostlist_count(hl);
+
+	for (i = 0; i < cnt; i++) {
+		host = hostlist_nth(hl, i);
+		expect = i;
+		for (j = 0; j < i; j++) {
+			other = hostlist_nth(hl, j);
+			if (!strcmp(host, other))
+				expect = MIN(expect, j);
+			free(other);
+		}
+		if (hostlist_find(hl, host) != expect)
+			bad++;
+		free(host);
+	}
+	return bad;
+}
+
+static void _test_find(void)
+{
+	char *missing[] = { "n0", "n21", "f2", "zzz", "p4", "abc1", NULL };
+	char host[32];
+	hostlist_t hl;
+	int i, n, bad;
+
+	hl = hostlist_create("n[1-10],n[5-20],n7,abc,p[001-003],abc,m1,n3");
+	for (i = 1; i < 40; i += 2) {
+		snprintf(host, sizeof(host), "f%d", i);
+		hostlist_push_host(hl, host);
+	}
+	hostlist_push_host(hl, "f5");
+
+	/* the first searches go through the ranges, later ones use the
+	 * index built on the unchanged list */
+	for (n = 0, bad = 0; n < 3; n++)
+		bad += _check_find(hl);
+	for (i = 0; missing[i]; i++)
+		bad += (hostlist_find(hl, missing[i]) != -1);
+	TEST(bad, "find first copy of each host");
+
+	i = hostlist_count(hl);
+	bad = (hostlist_delete_host(hl, "n7") != 1) +
+	      (hostlist_delete_host(hl, "abc") != 1) +
+	      (hostlist_delete_host(hl, "p002") != 1) +
+	      (hostlist_delete_host(hl, "f5") != 1) +
+	      (hostlist_delete_host(hl, "f2") != 0) +
+	      (hostlist_count(hl) != (i - 4));
+	for (n = 0; n < 3; n++)
+		bad += _check_find(hl);
+	TEST(bad, "find after delete");
+
+	hostlist_destroy(hl);
+}
+
+static hostlist_t _fragmented(void)
+{
+	hostlist_t hl = hostlist_create(NULL);
+	char host[32];
+	int i;
+
+	for (i = 0; i < NODE_CNT; i++) {
+		snprintf(host, sizeof(host), "tux%06d", i * 2);
+		hostlist_push_host(hl, host);
+	}
+	return hl;
+}
+
+static void _time_find(char *name, hostlist_t hl, int step)
+{
+	struct timeval start;
+	char host[32], msg[128];
+	int i, n, bad = 0;
+
+	srand(1);
+	gettimeofday(&start, NULL);
+	for (i = 0; i < LOOKUP_CNT; i++) {
+		n = rand() % NODE_CNT;
+		snprintf(host, sizeof(host), "tux%06d", n * step);
+		if (hostlist_find(hl, host) != n)
+			bad++;
+	}
+	snprintf(msg, sizeof(msg), "find, %s", name);
+	note("%s: %.2f usec per host", msg,
+	     (_elapsed(&start) * 1000000.0) / LOOKUP_CNT);
+	TEST(bad, msg);
+}
+
+static void _time_delete(void)
+{
+	struct timeval start;
+	hostlist_t hl = _fragmented();
+	char host[32];
+	int i, bad = 0;
+
+	srand(1);
+	gettimeofday(&start, NULL);
+	for (i = 0; i < DELETE_CNT; i++) {
+		snprintf(host, sizeof(host), "tux%06d",
+			 (rand() % NODE_CNT) * 2);
+		hostlist_delete_host(hl, host);
+	}
+	note("delete, fragmented: %.2f usec per host",
+	     (_elapsed(&start) * 1000000.0) / DELETE_CNT);
+	for (i = 0; i < NODE_CNT; i++) {
+		snprintf(host, sizeof(host), "tux%06d", i * 2);
+		bad += hostlist_find(hl, host) >= 0;
+	}
+	TEST((bad != hostlist_count(hl)) || (bad >= NODE_CNT) ||
+	     (bad < NODE_CNT - DELETE_CNT), "delete, fragmented");
+	hostlist_destroy(hl);
+}
+
+static void _time_hostset(void)
+{
+	struct timeval start;
+	hostset_t hs = hostset_create(NULL);
+	char host[32];
+	int i, n, tmp, *order, bad = 0;
+
+	order = malloc(SET_CNT * sizeof(int));
+	for (i = 0; i < SET_CNT; i++)
+		order[i] = i;
+	srand(1);
+	for (i = SET_CNT - 1; i > 0; i--) {
+		n = rand() % (i + 1);
+		tmp = order[i];
+		order[i] = order[n];
+		order[n] = tmp;
+	}
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < SET_CNT; i++) {
+		snprintf(host, sizeof(host), "tux%06d", order[i] * 2);
+		hostset_insert(hs, host);
+	}
+	note("hostset_insert, %d hosts in random order: %.2f usec per host",
+	     SET_CNT, (_elapsed(&start) * 1000000.0) / SET_CNT);
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < SET_CNT * 2; i++) {
+		snprintf(host, sizeof(host), "tux%06d", i);
+		if (hostset_within(hs, host) != !(i & 1))
+			bad++;
+	}
+	note("hostset_within, %d ranges: %.2f usec per host", SET_CNT,
+	     (_elapsed(&start) * 1000000.0) / (SET_CNT * 2));
+	TEST(bad || (hostset_count(hs) != SET_CNT), "hostset, fragmented");
+
+	gettimeofday(&start, NULL);
+	for (i = 0, bad = 0; i < SET_CNT / 2; i++) {
+		snprintf(host, sizeof(host), "tux%06d", order[i] * 2);
+		if (hostset_delete_host(hs, host) != 1)
+			bad++;
+	}
+	note("hostset_delete_host, %d ranges: %.2f usec per host", SET_CNT,
+	     (_elapsed(&start) * 1000000.0) / (SET_CNT / 2));
+	for (i = 0; i < SET_CNT; i++) {
+		snprintf(host, sizeof(host), "tux%06d", order[i] * 2);
+		if (hostset_within(hs, host) != (i >= SET_CNT / 2))
+			bad++;
+	}
+	TEST(bad || (hostset_count(hs) != SET_CNT - SET_CNT / 2),
+	     "hostset delete, fragmented");
+
+	hostset_destroy(hs);
+	free(order);
+}
+
+int main (int argc, char *argv[])
+{
+	hostlist_t hl;
+
+	_test_find();
+
+	hl = hostlist_create("tux[000000-049999],tux[050000-099999]");
+	_time_find("contiguous", hl, 1);
+	hostlist_destroy(hl);
+
+	hl = _fragmented();
+	_time_find("fragmented", hl, 2);
+	hostlist_destroy(hl);
+
+	_time_delete();
+	_time_hostset();
+
+	totals();
+	return failed;
+}
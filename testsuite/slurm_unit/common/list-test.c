@@ -0,0 +1,157 @@
+/* Test of the List container in src/common/list.c and timing of list,
+ * node and iterator allocation by concurrent threads.
+ * Each thread repeatedly builds a private list, walks it and empties it,
+ * which is how most slurmctld RPC threads use lists. A list filled by one
+ * thread and destroyed by another moves nodes between thread caches.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <src/common/list.h>
+#include <src/common/xmalloc.h>
+
+#include <testsuite/dejagnu.h>
+
+#define MAX_THREADS	64
+#define ITEMS		32	/* items per list */
+#define ROUNDS		100000	/* lists built, shared by all threads */
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+static int items[ITEMS];
+static int rounds;
+static bool unlocked;
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+static void *_worker(void *arg)
+{
+	long bad = 0;
+	int i, j, sum;
+	ListIterator itr;
+	List l;
+	int *x;
+
+	for (i = 0; i < rounds; i++) {
+		l = unlocked ? list_create_unlocked(NULL) : list_create(NULL);
+		for (j = 0; j < ITEMS; j++)
+			list_append(l, &items[j]);
+		sum = 0;
+		itr = list_iterator_create(l);
+		while ((x = list_next(itr)))
+			sum += *x;
+		list_iterator_destroy(itr);
+		while (list_pop(l))
+			;
+		list_destroy(l);
+		if (sum != (ITEMS * (ITEMS - 1)) / 2)
+			bad++;
+	}
+	return (void *) bad;
+}
+
+/* Returns list operations per second, or -1 on error */
+static double _run(int threads)
+{
+	pthread_t tid[MAX_THREADS];
+	struct timeval start;
+	void *bad;
+	long errors = 0;
+	int i;
+
+	rounds = ROUNDS / threads;
+	gettimeofday(&start, NULL);
+	for (i = 0; i < threads; i++) {
+		if (pthread_create(&tid[i], NULL, _worker, NULL))
+			return -1;
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(tid[i], &bad);
+		errors += (long) bad;
+	}
+	if (errors)
+		return -1;
+	/* create, appends, iterator, pops and destroy */
+	return (rounds * threads * (ITEMS * 2 + 3)) / _elapsed(&start);
+}
+
+static void *_fill(void *arg)
+{
+	List l = arg;
+	int j;
+
+	for (j = 0; j < ITEMS * 100; j++)
+		list_append(l, &items[j % ITEMS]);
+	return NULL;
+}
+
+int main (int argc, char *argv[])
+{
+	char msg[128];
+	pthread_t tid;
+	double rate;
+	int i, j, threads;
+	List l;
+
+	for (i = 0; i < ITEMS; i++)
+		items[i] = i;
+
+	/* nodes allocated by one thread, freed by another */
+	for (i = 0; i < 10; i++) {
+		l = list_create(NULL);
+		pthread_create(&tid, NULL, _fill, l);
+		pthread_join(tid, NULL);
+		j = list_count(l);
+		list_destroy(l);
+		if (j != ITEMS * 100)
+			break;
+	}
+	TEST(i != 10, "nodes freed by another thread");
+
+	l = list_create_unlocked(NULL);
+	for (i = 0; i < ITEMS; i++)
+		list_prepend(l, &items[i]);
+	TEST((list_count(l) != ITEMS) ||
+	     (*(int *) list_peek(l) != ITEMS - 1) ||
+	     (*(int *) list_dequeue(l) != ITEMS - 1) ||
+	     (list_count(l) != ITEMS - 1), "unlocked list");
+	list_destroy(l);
+
+	for (j = 0; j < 2; j++) {
+		unlocked = j;
+		for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+			rate = _run(threads);
+			snprintf(msg, sizeof(msg), "%s lists, %d threads",
+				 unlocked ? "unlocked" : "locked", threads);
+			TEST(rate < 0, msg);
+			if (rate >= 0)
+				note("%s: %.0f list operations per second",
+				     msg, rate);
+		}
+	}
+
+	totals();
+	return failed;
+}
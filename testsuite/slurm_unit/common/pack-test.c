@@ -1,4 +1,13 @@
 /* $Id$ */
+/* Test of src/common/pack.c and timing of packing and unpacking
+ * multi-megabyte buffers of job-like records, as pack_all_jobs() and
+ * pack_all_node() build them for squeue and sinfo, and of sending such a
+ * buffer by copying it after a message header, as pack_msg() did, or by
+ * handing both to _slurm_msg_sendv(). The compact encoding of
+ * set_buf_compact() is compared with the fixed one, each with and without
+ * LZ compression, on a job dump whose users, partitions and node lists
+ * repeat as on a busy cluster.
+ */
 
 #if HAVE_CONFIG_H
 #  include <config.h>
@@ -12,11 +21,20 @@
 #  endif
 #endif
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
 
+#include <slurm/slurm.h>
+
+#include <src/common/lz_compress.h>
 #include <src/common/pack.h>
+#include <src/common/slurm_protocol_interface.h>
 #include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
 
 #include <testsuite/dejagnu.h>
 
@@ -29,6 +47,533 @@
 		pass( _msg );       \
 } while (0)
 
+#define RECORD_CNT	50000
+#define ROUNDS		5
+#define HEADER_SIZE	200	/* about a header and munge credential */
+#define MSG_TIMEOUT	10000
+#define USER_CNT	300
+#define NODELIST_CNT	2000
+
+static char *users[USER_CNT], *nodelists[NODELIST_CNT];
+static char *partitions[] = { "debug", "batch", "long", "gpu" };
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+/* About what _pack_job_info_members() packs for one job */
+static void _pack_record(int i, Buf buffer)
+{
+	uint32_t cpus[4] = { i, 2, 4, 8 };
+
+	pack32(i, buffer);
+	pack32(i + 1000, buffer);
+	pack16(i & 0xffff, buffer);
+	pack16(3, buffer);
+	pack_time((time_t) i * 60, buffer);
+	pack_time((time_t) i * 60 + 3600, buffer);
+	packdouble(0.5, buffer);
+	packstr("job_name", buffer);
+	packstr("tux[0000-1023]", buffer);
+	packstr("/home/user/work/output_file.txt", buffer);
+	packstr(NULL, buffer);
+	pack32_array(cpus, 4, buffer);
+	pack8(1, buffer);
+}
+
+static int _unpack_record(int i, Buf buffer)
+{
+	uint32_t u32, cnt, *cpus = NULL;
+	uint16_t u16;
+	uint8_t u8;
+	time_t t;
+	double d;
+	char *str = NULL;
+	int bad = 0;
+
+	bad |= unpack32(&u32, buffer) || (u32 != i);
+	bad |= unpack32(&u32, buffer) || (u32 != i + 1000);
+	bad |= unpack16(&u16, buffer) || (u16 != (i & 0xffff));
+	bad |= unpack16(&u16, buffer);
+	bad |= unpack_time(&t, buffer) || (t != (time_t) i * 60);
+	bad |= unpack_time(&t, buffer);
+	bad |= unpackdouble(&d, buffer);
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer) ||
+	       strcmp(str, "job_name");
+	xfree(str);
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer);
+	xfree(str);
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer);
+	xfree(str);
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer) || str;
+	bad |= unpack32_array(&cpus, &cnt, buffer) || (cnt != 4) ||
+	       (cpus[0] != i);
+	xfree(cpus);
+	bad |= unpack8(&u8, buffer) || (u8 != 1);
+	return bad;
+}
+
+static void _time_pack(void)
+{
+	struct timeval start;
+	double pack_secs = 0, unpack_secs = 0, mb = 0;
+	Buf buffer;
+	char *data;
+	int i, r, size, bad = 0;
+
+	for (r = 0; r < ROUNDS; r++) {
+		gettimeofday(&start, NULL);
+		buffer = init_buf(0);
+		for (i = 0; i < RECORD_CNT; i++)
+			_pack_record(i, buffer);
+		pack_secs += _elapsed(&start);
+
+		size = get_buf_offset(buffer);
+		mb += size / (1024.0 * 1024.0);
+		data = xfer_buf_data(buffer);
+		buffer = create_buf(data, size);
+		gettimeofday(&start, NULL);
+		for (i = 0; i < RECORD_CNT; i++)
+			bad += _unpack_record(i, buffer);
+		bad += (remaining_buf(buffer) != 0);
+		unpack_secs += _elapsed(&start);
+		free_buf(buffer);
+	}
+	TEST(bad, "un/pack of large buffers");
+	note("%d records, %.1f MB per buffer: pack %.0f MB/s, unpack %.0f MB/s",
+	     RECORD_CNT, mb / ROUNDS, mb / pack_secs, mb / unpack_secs);
+}
+
+static void _test_compact(void)
+{
+	Buf buffer;
+	char long_str[2000], *str, *data;
+	uint16_t u16;
+	uint32_t u32, cnt;
+	uint64_t u64;
+	time_t t, now = time(NULL);
+	int size, bad = 0;
+
+	memset(long_str, 'x', sizeof(long_str) - 1);
+	long_str[sizeof(long_str) - 1] = '\0';
+
+	/* a fixed header, as the dumps of slurmctld have, with its count
+	 * packed again at the end */
+	buffer = init_buf(0);
+	pack32(0, buffer);
+	pack_time(now, buffer);
+	set_buf_compact(buffer, true);
+	pack16(0, buffer);
+	pack16(0xffff, buffer);
+	pack16((uint16_t) NO_VAL, buffer);
+	pack32(0, buffer);
+	pack32(NO_VAL, buffer);
+	pack32(INFINITE, buffer);
+	pack32(0x12345678, buffer);
+	pack64(0, buffer);
+	pack64(0xffffffffffffffffULL, buffer);
+	pack64(0x123456789abcdefULL, buffer);
+	pack_time(0, buffer);
+	pack_time(now, buffer);
+	pack_time(now - 100, buffer);
+	pack_time((time_t) -5, buffer);
+	pack_time(now + 86400 * 365, buffer);
+	packstr("batch", buffer);
+	packstr("batch", buffer);
+	packstr("ab", buffer);
+	packstr(NULL, buffer);
+	packstr("", buffer);
+	packstr(long_str, buffer);
+	packstr(long_str, buffer);
+	packstr("batch", buffer);
+	packstr("batch", buffer);
+	packmem("batch", 5, buffer);
+	set_buf_compact(buffer, false);
+	pack32(0xabcdef, buffer);
+	size = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(7, buffer);
+	set_buf_offset(buffer, size);
+
+	data = xfer_buf_data(buffer);
+	buffer = create_buf(data, size);
+	bad |= unpack32(&u32, buffer) || (u32 != 7);
+	bad |= unpack_time(&t, buffer) || (t != now);
+	set_buf_compact(buffer, true);
+	bad |= unpack16(&u16, buffer) || (u16 != 0);
+	bad |= unpack16(&u16, buffer) || (u16 != 0xffff);
+	bad |= unpack16(&u16, buffer) || (u16 != (uint16_t) NO_VAL);
+	bad |= unpack32(&u32, buffer) || (u32 != 0);
+	bad |= unpack32(&u32, buffer) || (u32 != NO_VAL);
+	bad |= unpack32(&u32, buffer) || (u32 != INFINITE);
+	bad |= unpack32(&u32, buffer) || (u32 != 0x12345678);
+	bad |= unpack64(&u64, buffer) || (u64 != 0);
+	bad |= unpack64(&u64, buffer) || (u64 != 0xffffffffffffffffULL);
+	bad |= unpack64(&u64, buffer) || (u64 != 0x123456789abcdefULL);
+	bad |= unpack_time(&t, buffer) || (t != 0);
+	bad |= unpack_time(&t, buffer) || (t != now);
+	bad |= unpack_time(&t, buffer) || (t != now - 100);
+	bad |= unpack_time(&t, buffer) || (t != (time_t) -5);
+	bad |= unpack_time(&t, buffer) || (t != now + 86400 * 365);
+	TEST(bad, "compact integers and times");
+
+	bad = unpackstr_ptr(&str, &cnt, buffer) || strcmp(str, "batch");
+	bad |= unpackstr_ptr(&str, &cnt, buffer) || strcmp(str, "batch");
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer) || strcmp(str, "ab");
+	xfree(str);
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer) || str;
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer) || strcmp(str, "");
+	xfree(str);
+	bad |= unpackstr_xmalloc(&str, &cnt, buffer) || strcmp(str, long_str);
+	xfree(str);
+	bad |= unpackstr_malloc(&str, &cnt, buffer) || strcmp(str, long_str);
+	free(str);
+	bad |= unpackstr_malloc(&str, &cnt, buffer) || strcmp(str, "batch");
+	free(str);
+	bad |= unpackmem(long_str, &cnt, buffer) || (cnt != 6) ||
+	       strcmp(long_str, "batch");
+	bad |= unpackmem_xmalloc(&str, &cnt, buffer) || (cnt != 5) ||
+	       memcmp(str, "batch", 5);
+	xfree(str);
+	set_buf_compact(buffer, false);
+	bad |= unpack32(&u32, buffer) || (u32 != 0xabcdef) ||
+	       remaining_buf(buffer);
+	TEST(bad, "compact strings");
+	free_buf(buffer);
+
+	/* a reference to a string not yet seen, and a value too large */
+	buffer = init_buf(0);
+	set_buf_compact(buffer, true);
+	packstr("batch", buffer);
+	pack32(NO_VAL, buffer);
+	set_buf_compact(buffer, false);
+	pack8(5, buffer);		/* reference to string 2 */
+	pack8(0x80, buffer);
+	pack8(0x80, buffer);
+	pack8(0x80, buffer);
+	pack8(0x80, buffer);
+	pack8(0x10, buffer);		/* 2^32 */
+	size = get_buf_offset(buffer);
+	data = xfer_buf_data(buffer);
+	buffer = create_buf(data, size);
+	set_buf_compact(buffer, true);
+	bad = unpackstr_ptr(&str, &cnt, buffer) ||
+	      unpack32(&u32, buffer) || (u32 != NO_VAL) ||
+	      (unpackstr_ptr(&str, &cnt, buffer) == SLURM_SUCCESS) ||
+	      (unpack32(&u32, buffer) == SLURM_SUCCESS);
+	TEST(bad, "compact unpack of bad data");
+	free_buf(buffer);
+}
+
+static void _test_pool(void)
+{
+	Buf buffer, other;
+	char *head, *mem;
+	uint32_t out32;
+
+	buffer = init_pool_buf();
+	pack32(1, buffer);
+	head = get_buf_data(buffer);
+	free_pool_buf(buffer);
+	buffer = init_pool_buf();
+	other = init_pool_buf();
+	TEST((get_buf_data(buffer) != head) || (get_buf_offset(buffer) != 0) ||
+	     (size_buf(buffer) < BUF_SIZE) || (get_buf_data(other) == head),
+	     "buffer pool reuse");
+
+	/* grown past what the pool keeps */
+	mem = xmalloc(BUF_SIZE * 8);
+	packmem_array(mem, BUF_SIZE, buffer);
+	packmem_array(mem, BUF_SIZE * 8, buffer);
+	pack32(7, buffer);
+	set_buf_offset(buffer, BUF_SIZE * 9);
+	TEST(unpack32(&out32, buffer) || (out32 != 7), "buffer growth");
+	free_pool_buf(buffer);
+	free_pool_buf(other);
+	xfree(mem);
+}
+
+typedef struct {
+	int fd;
+	char *data;
+	size_t len;
+} recv_arg_t;
+
+static void *_recv_msg(void *arg)
+{
+	recv_arg_t *recv_arg = arg;
+
+	if (_slurm_msg_recvfrom_timeout(recv_arg->fd, &recv_arg->data,
+					&recv_arg->len, 0, MSG_TIMEOUT) < 0)
+		recv_arg->data = NULL;
+	return NULL;
+}
+
+/* Send a header and a dump of dump_size bytes as one message, copied into
+ * one buffer or as two pieces. RET the message as received, or NULL. */
+static char *_send_dump(bool copy, char *dump, int dump_size, size_t *len,
+			double *secs)
+{
+	struct timeval start;
+	struct iovec iov[2];
+	pthread_t tid;
+	recv_arg_t recv_arg;
+	Buf buffer;
+	int fd[2], i;
+	ssize_t rc;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) < 0)
+		return NULL;
+	recv_arg.fd = fd[1];
+	pthread_create(&tid, NULL, _recv_msg, &recv_arg);
+
+	gettimeofday(&start, NULL);
+	buffer = init_pool_buf();
+	for (i = 0; i < HEADER_SIZE; i++)
+		pack8(i, buffer);
+	if (copy) {
+		packmem_array(dump, dump_size, buffer);
+		rc = _slurm_msg_sendto_timeout(fd[0], get_buf_data(buffer),
+					       get_buf_offset(buffer), 0,
+					       MSG_TIMEOUT);
+	} else {
+		iov[0].iov_base = get_buf_data(buffer);
+		iov[0].iov_len  = get_buf_offset(buffer);
+		iov[1].iov_base = dump;
+		iov[1].iov_len  = dump_size;
+		rc = _slurm_msg_sendv_timeout(fd[0], iov, 2, 0, MSG_TIMEOUT);
+	}
+	free_pool_buf(buffer);
+	pthread_join(tid, NULL);
+	*secs += _elapsed(&start);
+
+	close(fd[0]);
+	close(fd[1]);
+	*len = recv_arg.len;
+	if (rc != HEADER_SIZE + dump_size) {
+		xfree(recv_arg.data);
+		return NULL;
+	}
+	return recv_arg.data;
+}
+
+static void _time_send(void)
+{
+	double secs[2] = { 0, 0 };
+	Buf buffer;
+	char *dump, *data, msg[128];
+	size_t len;
+	int i, r, copy, dump_size, bad;
+
+	buffer = init_buf(0);
+	for (i = 0; i < RECORD_CNT; i++)
+		_pack_record(i, buffer);
+	dump_size = get_buf_offset(buffer);
+	dump = xfer_buf_data(buffer);
+
+	for (copy = 0; copy < 2; copy++) {
+		for (r = 0, bad = 0; r < ROUNDS; r++) {
+			data = _send_dump(copy, dump, dump_size, &len,
+					  &secs[copy]);
+			bad += !data || (len != HEADER_SIZE + dump_size) ||
+			       (data[HEADER_SIZE - 1] !=
+				(char) (HEADER_SIZE - 1)) ||
+			       memcmp(data + HEADER_SIZE, dump, dump_size);
+			xfree(data);
+		}
+		snprintf(msg, sizeof(msg), "send of dump, %s",
+			 copy ? "copied" : "scatter-gather");
+		TEST(bad, msg);
+	}
+	note("send of %.1f MB dump: copied %.2f ms, scatter-gather %.2f ms",
+	     dump_size / (1024.0 * 1024.0), (secs[1] * 1000) / ROUNDS,
+	     (secs[0] * 1000) / ROUNDS);
+	xfree(dump);
+}
+
+/* About what pack_job() packs for one job of a busy cluster: the same few
+ * partitions, a few hundred users and many node lists */
+static void _pack_job(int i, Buf buffer)
+{
+	time_t submit = 1300000000 + i * 3;
+
+	pack32(i % 500, buffer);
+	pack32(1000 + i, buffer);
+	pack32(5000 + (i % USER_CNT), buffer);
+	pack32(100, buffer);
+	pack16(i & 1, buffer);
+	pack16(1, buffer);
+	pack16(0, buffer);
+	pack16(0, buffer);
+	pack16(0, buffer);
+	pack32(0, buffer);
+	pack32((i & 3) ? 60 : INFINITE, buffer);
+	pack32(NO_VAL, buffer);
+	pack16(NICE_OFFSET, buffer);
+	pack_time(submit, buffer);
+	pack_time(submit, buffer);
+	pack_time((i & 1) ? submit + 60 : 0, buffer);
+	pack_time((i & 1) ? submit + 3660 : 0, buffer);
+	pack_time(0, buffer);
+	pack_time(0, buffer);
+	pack_time(0, buffer);
+	pack_time(0, buffer);
+	pack32(10000 - (i % 1000), buffer);
+	packstr((i & 1) ? nodelists[i % NODELIST_CNT] : NULL, buffer);
+	packstr(partitions[i & 3], buffer);
+	packstr(users[i % USER_CNT], buffer);
+	packnull(buffer);
+	packnull(buffer);
+	packnull(buffer);
+	packstr((i & 1) ? nodelists[i % NODELIST_CNT] : NULL, buffer);
+	packnull(buffer);
+	packstr("normal", buffer);
+	packnull(buffer);
+	packstr((i & 1) ? NULL : "Priority", buffer);
+	packnull(buffer);
+	pack32(0, buffer);
+	pack32(0, buffer);
+	pack32(NO_VAL, buffer);
+	packstr("run_simulation.sh", buffer);
+	packnull(buffer);
+	packstr("login1", buffer);
+	packstr((i & 1) ? "0-15" : NULL, buffer);
+}
+
+static int _unpack_job(int i, Buf buffer)
+{
+	uint32_t u32, cnt;
+	uint16_t u16;
+	time_t t;
+	char *str = NULL;
+	int j, bad = 0;
+
+	bad |= unpack32(&u32, buffer);
+	bad |= unpack32(&u32, buffer) || (u32 != 1000 + i);
+	for (j = 0; j < 2; j++)
+		bad |= unpack32(&u32, buffer);
+	for (j = 0; j < 5; j++)
+		bad |= unpack16(&u16, buffer);
+	for (j = 0; j < 3; j++)
+		bad |= unpack32(&u32, buffer);
+	bad |= unpack16(&u16, buffer) || (u16 != NICE_OFFSET);
+	bad |= unpack_time(&t, buffer) || (t != 1300000000 + i * 3);
+	for (j = 0; j < 7; j++)
+		bad |= unpack_time(&t, buffer);
+	bad |= unpack32(&u32, buffer);
+	for (j = 0; j < 12; j++) {
+		bad |= unpackstr_xmalloc(&str, &cnt, buffer);
+		if (j == 2)
+			bad |= !str || strcmp(str, users[i % USER_CNT]);
+		xfree(str);
+	}
+	for (j = 0; j < 3; j++)
+		bad |= unpack32(&u32, buffer);
+	for (j = 0; j < 4; j++) {
+		bad |= unpackstr_xmalloc(&str, &cnt, buffer);
+		xfree(str);
+	}
+	return bad;
+}
+
+/* Time a dump of RECORD_CNT jobs packed with the fixed or compact
+ * encoding, and optionally compressed as slurm_send_node_msg() does for
+ * peers setting SLURM_COMPRESS_OK: its packing, sending over a socketpair
+ * and unpacking. RET non-zero on error. */
+static int _time_dump(bool compact, bool lz, int *wire_size, double *secs)
+{
+	struct timeval start;
+	uint32_t cnt, size, comp_size = 0;
+	time_t now;
+	size_t len;
+	Buf buffer;
+	char *data, *comp = NULL, *recvd;
+	int i, bad = 0;
+
+	gettimeofday(&start, NULL);
+	buffer = init_buf(0);
+	pack32(RECORD_CNT, buffer);
+	pack_time(time(NULL), buffer);
+	set_buf_compact(buffer, compact);
+	for (i = 0; i < RECORD_CNT; i++)
+		_pack_job(i, buffer);
+	set_buf_compact(buffer, false);
+	size = get_buf_offset(buffer);
+	data = xfer_buf_data(buffer);
+	if (lz) {
+		comp = xmalloc(size);
+		comp_size = lz_compress(data, size, comp, size);
+		bad += (comp_size == 0);
+	}
+	secs[0] += _elapsed(&start);
+
+	*wire_size = lz ? comp_size : size;
+	recvd = _send_dump(false, lz ? comp : data, *wire_size, &len,
+			   &secs[1]);
+	bad += !recvd;
+	xfree(recvd);
+
+	gettimeofday(&start, NULL);
+	if (lz) {
+		memset(data, 0, size);
+		bad += (lz_decompress(comp, comp_size, data, size) != size);
+		xfree(comp);
+	}
+	buffer = create_buf(data, size);
+	bad += unpack32(&cnt, buffer) || (cnt != RECORD_CNT);
+	bad += unpack_time(&now, buffer);
+	set_buf_compact(buffer, compact);
+	for (i = 0; i < RECORD_CNT; i++)
+		bad += _unpack_job(i, buffer);
+	set_buf_compact(buffer, false);
+	bad += (remaining_buf(buffer) != 0);
+	free_buf(buffer);
+	secs[2] += _elapsed(&start);
+	return bad;
+}
+
+static void _time_dumps(void)
+{
+	char *name[] = { "fixed", "fixed, LZ", "compact", "compact, LZ" };
+	double secs[4][3], link_ms;
+	int size[4], i, j, r, bad;
+
+	for (i = 0; i < USER_CNT; i++)
+		users[i] = xstrdup_printf("user%03d", i);
+	for (i = 0; i < NODELIST_CNT; i++) {
+		nodelists[i] = xstrdup_printf("tux[%04d-%04d,%04d]", i * 4,
+					      i * 4 + 2, (i * 7) % 8192);
+	}
+
+	memset(secs, 0, sizeof(secs));
+	for (j = 0; j < 4; j++) {
+		for (r = 0, bad = 0; r < ROUNDS; r++)
+			bad += _time_dump(j / 2, j % 2, &size[j], secs[j]);
+		TEST(bad, name[j]);
+	}
+	/* what a remote client on a 100 Mb/s link waits for */
+	for (j = 0; j < 4; j++) {
+		link_ms = (size[j] * 8.0) / (100 * 1000);
+		note("%d jobs, %s: %.2f MB, pack %.1f ms, send %.1f ms, "
+		     "unpack %.1f ms, total at 100 Mb/s %.0f ms", RECORD_CNT,
+		     name[j], size[j] / (1024.0 * 1024.0),
+		     (secs[j][0] * 1000) / ROUNDS,
+		     (secs[j][1] * 1000) / ROUNDS,
+		     (secs[j][2] * 1000) / ROUNDS,
+		     ((secs[j][0] + secs[j][2]) * 1000) / ROUNDS + link_ms);
+	}
+
+	for (i = 0; i < USER_CNT; i++)
+		xfree(users[i]);
+	for (i = 0; i < NODELIST_CNT; i++)
+		xfree(nodelists[i]);
+}
+
 int main (int argc, char *argv[])
 {
 	Buf buffer;
@@ -95,6 +640,13 @@ int main (int argc, char *argv[])
 	xfree(outstring);
 
 	free_buf(buffer);
+
+	_test_pool();
+	_test_compact();
+	_time_pack();
+	_time_dumps();
+	_time_send();
+
 	totals();
 	return failed;
 
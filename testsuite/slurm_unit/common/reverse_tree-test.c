@@ -0,0 +1,301 @@
+/* Simulation of step completion aggregation by
+ * src/slurmd/common/reverse_tree.c over a large reverse tree with slow
+ * and dead nodes injected.
+ * Messages are delivered instantly and time advances one second per
+ * round. A node sending to a dead parent is blocked for the whole
+ * parent retry budget before it goes to slurmctld.
+ * Also the wait of slurmstepd's _wait_for_io() for the IO relayed by its
+ * children, one of which holds its connection open and never reports.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <slurm/slurm_errno.h>
+#include <src/common/macros.h>
+#include <src/common/xmalloc.h>
+#include <src/slurmd/common/reverse_tree.h>
+
+#include <testsuite/dejagnu.h>
+
+#define NODE_CNT	10000
+#define SIM_LIMIT	600	/* seconds of simulated time */
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+typedef struct {
+	int parent;
+	int children;
+	int depth;
+	int finish;		/* time the local tasks end, -1 if dead */
+	int busy;		/* blocked retrying a dead parent until */
+	bool started;
+	bool done;
+	reverse_tree_agg_t *agg;
+} sim_node_t;
+
+static sim_node_t nodes[NODE_CNT];
+static int ctld_time[NODE_CNT];	/* when slurmctld learned of each rank */
+static int max_depth, retry_secs;
+static int ctld_msgs, tree_msgs, dup_ranks;
+
+static int _geometric_series(int width, int levels)
+{
+	int i, sum = 1, pow = 1;
+
+	for (i = 0; i < levels; i++) {
+		pow *= width;
+		sum += pow;
+	}
+	return sum;
+}
+
+/* Lay out ranks as slurmd's reverse_tree_info() does: each child's
+ * subtree is a full tree one level shorter, filled in rank order */
+static void _build(int rank, int levels, int depth)
+{
+	int child, last, sub;
+
+	nodes[rank].depth = depth;
+	last = MIN(rank + _geometric_series(REVERSE_TREE_WIDTH, levels) - 1,
+		   NODE_CNT - 1);
+	nodes[rank].children = last - rank;
+	if (levels == 0)
+		return;
+	sub = _geometric_series(REVERSE_TREE_WIDTH, levels - 1);
+	for (child = rank + 1; child <= last; child += sub) {
+		nodes[child].parent = rank;
+		_build(child, levels - 1, depth + 1);
+	}
+}
+
+static void _send(int rank, int first, int last, int now)
+{
+	int i, parent = nodes[rank].parent;
+
+	if (parent >= 0) {
+		if ((nodes[parent].finish >= 0) &&
+		    (reverse_tree_agg_record(nodes[parent].agg, first, last) ==
+		     SLURM_SUCCESS)) {
+			tree_msgs++;
+			return;
+		}
+		if (nodes[parent].finish < 0) {
+			now += retry_secs;
+			nodes[rank].busy = now;
+		}
+	}
+
+	ctld_msgs++;
+	for (i = first; i <= last; i++) {
+		if (ctld_time[i] >= 0)
+			dup_ranks++;
+		else
+			ctld_time[i] = now;
+	}
+}
+
+/* Run one simulation, return the time at which every live node is done */
+static int _simulate(int *finish)
+{
+	int first, last, i, rc, t, active = 0;
+	time_t wake;
+
+	ctld_msgs = tree_msgs = dup_ranks = 0;
+	for (i = 0; i < NODE_CNT; i++) {
+		nodes[i].finish = finish[i];
+		nodes[i].busy = 0;
+		nodes[i].started = false;
+		nodes[i].done = false;
+		nodes[i].agg = NULL;
+		ctld_time[i] = -1;
+		if (finish[i] < 0)
+			continue;
+		nodes[i].agg = reverse_tree_agg_create(i, nodes[i].children,
+						       nodes[i].depth,
+						       max_depth,
+						       REVERSE_TREE_WIDTH);
+		active++;
+	}
+
+	for (t = 0; (t < SIM_LIMIT) && active; t++) {
+		/* children have higher ranks than their parents */
+		for (i = NODE_CNT - 1; i >= 0; i--) {
+			sim_node_t *n = &nodes[i];
+			if ((n->finish < 0) || n->done || (n->finish > t) ||
+			    (n->busy > t))
+				continue;
+			if (!n->started) {
+				reverse_tree_agg_start(n->agg, t);
+				n->started = true;
+			}
+			while ((rc = reverse_tree_agg_next(n->agg, t, &first,
+							   &last, &wake)) ==
+			       REVERSE_TREE_AGG_SEND) {
+				_send(i, first, last, t);
+				if (n->busy > t)
+					break;
+			}
+			if (rc == REVERSE_TREE_AGG_DONE) {
+				n->done = true;
+				active--;
+			}
+		}
+	}
+
+	for (i = 0; i < NODE_CNT; i++)
+		reverse_tree_agg_destroy(nodes[i].agg);
+	return active ? -1 : t;
+}
+
+/* Check what slurmctld saw. Ranks in the subtree of a node which
+ * finished late (or never) may be held back, all others must arrive
+ * by "prompt". Every live rank must arrive by "limit" exactly once. */
+static int _check(int *finish, int prompt, int limit, int *last_time)
+{
+	int held[NODE_CNT];
+	int i, j, bad = 0;
+
+	memset(held, 0, sizeof(held));
+	for (i = 0; i < NODE_CNT; i++) {
+		if ((finish[i] == 0) || held[i])
+			continue;
+		for (j = i + 1; j <= i + nodes[i].children; j++)
+			held[j] = 1;
+	}
+
+	*last_time = 0;
+	for (i = 0; i < NODE_CNT; i++) {
+		if (finish[i] < 0) {
+			if (ctld_time[i] >= 0)
+				bad++;
+			continue;
+		}
+		if ((ctld_time[i] < 0) || (ctld_time[i] > limit))
+			bad++;
+		else if (!held[i] && (finish[i] == 0) &&
+			 (ctld_time[i] > prompt))
+			bad++;
+		*last_time = MAX(*last_time, ctld_time[i]);
+	}
+	return bad + dup_ranks;
+}
+
+static void _run(char *name, int *finish, int prompt, int limit)
+{
+	char msg[128];
+	int done, last_time, bad;
+
+	done = _simulate(finish);
+	bad = _check(finish, prompt, limit, &last_time);
+	snprintf(msg, sizeof(msg), "%s: all live ranks reported once", name);
+	TEST(bad || (done < 0), msg);
+	note("%s: %d tree and %d slurmctld messages, last rank reported "
+	     "at %ds, done at %ds", name, tree_msgs, ctld_msgs, last_time,
+	     done);
+}
+
+/* Wait as _wait_for_io() does while a relay child's connection stays
+ * open, then finish as _wait_for_children_slurmstepd() does. Children
+ * "silent" and up never report. */
+static void _relay_wait(int depth, int silent)
+{
+	reverse_tree_agg_t *agg;
+	int children = REVERSE_TREE_WIDTH, first, last, rc, t, sent = 0;
+	int limit, bad = 0;
+	time_t wake;
+
+	agg = reverse_tree_agg_create(0, children, depth, depth + 1,
+				      REVERSE_TREE_WIDTH);
+	bad += reverse_tree_agg_expired(agg, 0);
+	for (t = 1; t < silent; t++)
+		bad += (reverse_tree_agg_record(agg, t, t) != SLURM_SUCCESS);
+
+	/* the relay of a silent child never closes */
+	for (t = 0; t < SIM_LIMIT; t++) {
+		reverse_tree_agg_start(agg, t);
+		if (reverse_tree_agg_expired(agg, t))
+			break;
+	}
+	limit = (silent > children) ? 0 : (REVERSE_TREE_CHILDREN_TIMEOUT +
+					   REVERSE_TREE_LEVEL_TIMEOUT);
+	bad += (t != limit);
+
+	reverse_tree_agg_start(agg, t);
+	while ((rc = reverse_tree_agg_next(agg, t, &first, &last, &wake)) ==
+	       REVERSE_TREE_AGG_SEND)
+		sent += last - first + 1;
+	bad += (rc != REVERSE_TREE_AGG_DONE) || (sent != MIN(silent, 8));
+	reverse_tree_agg_destroy(agg);
+
+	TEST(bad, (silent > children) ? "relay wait, all children report" :
+					"relay wait, silent child");
+}
+
+int main (int argc, char *argv[])
+{
+	int finish[NODE_CNT];
+	int i, prompt, timeout, slow = 40, very_slow = 150;
+
+	memset(nodes, 0, sizeof(nodes));
+	nodes[0].parent = -1;
+	for (max_depth = 0;
+	     _geometric_series(REVERSE_TREE_WIDTH, max_depth) < NODE_CNT;
+	     max_depth++)
+		;
+	_build(0, max_depth, 0);
+	for (i = 0; ; i++) {
+		int delay = reverse_tree_retry_delay(i);
+		if ((retry_secs + delay) > (REVERSE_TREE_PARENT_RETRY * 1000))
+			break;
+		retry_secs += delay;
+	}
+	retry_secs = (retry_secs + 999) / 1000;
+
+	TEST((reverse_tree_retry_delay(0) != REVERSE_TREE_RETRY_MIN) ||
+	     (reverse_tree_retry_delay(1) != (REVERSE_TREE_RETRY_MIN * 2)) ||
+	     (reverse_tree_retry_delay(30) != REVERSE_TREE_RETRY_MAX),
+	     "retry backoff");
+
+	/* Completions flow up a level per flush, the rest of the tree
+	 * must not wait on a slow or dead subtree */
+	prompt = REVERSE_TREE_FLUSH_DELAY * (max_depth + 1);
+	timeout = REVERSE_TREE_CHILDREN_TIMEOUT +
+		  REVERSE_TREE_LEVEL_TIMEOUT * max_depth;
+
+	memset(finish, 0, sizeof(finish));
+	_run("no faults", finish, 0, 0);
+
+	for (i = 5; i < NODE_CNT; i += 997)
+		finish[i] = slow;
+	_run("slow nodes", finish, prompt, slow + prompt);
+
+	memset(finish, 0, sizeof(finish));
+	for (i = 7; i < NODE_CNT; i += 1499)
+		finish[i] = -1;
+	/* and the root of a whole subtree, second child of rank 0 */
+	finish[1 + _geometric_series(REVERSE_TREE_WIDTH, max_depth - 1)] = -1;
+	_run("dead nodes", finish, prompt, prompt + retry_secs);
+
+	for (i = 5; i < NODE_CNT; i += 997)
+		finish[i] = very_slow;
+	_run("dead and very slow nodes", finish, prompt,
+	     very_slow + prompt + timeout);
+
+	_relay_wait(2, REVERSE_TREE_WIDTH);
+	_relay_wait(2, REVERSE_TREE_WIDTH + 1);
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,165 @@
+/* Test of the vector in src/common/vector.c and timing of full scans of
+ * 100k job-sized records kept in a List and in a vector, as slurmctld
+ * keeps job_list and job_vector.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <src/common/list.h>
+#include <src/common/vector.h>
+#include <src/common/xmalloc.h>
+
+#include <testsuite/dejagnu.h>
+
+#define JOB_CNT		100000
+#define SCAN_CNT	200
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+/* About the size of a struct job_record */
+typedef struct {
+	int job_id;
+	int job_state;
+	int handle;
+	char other[600];
+} fake_job_t;
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+static int _scan_list(List l)
+{
+	ListIterator itr = list_iterator_create(l);
+	fake_job_t *job;
+	int pending = 0;
+
+	while ((job = list_next(itr))) {
+		if (job->job_state == 0)
+			pending++;
+	}
+	list_iterator_destroy(itr);
+	return pending;
+}
+
+static int _scan_vector(vector_t *v)
+{
+	fake_job_t *job;
+	int i = 0, pending = 0;
+
+	while ((job = vector_next(v, &i))) {
+		if (job->job_state == 0)
+			pending++;
+	}
+	return pending;
+}
+
+static void _time_scans(char *name, List l, vector_t *v, int expect)
+{
+	struct timeval start;
+	double list_secs, vector_secs;
+	char msg[128];
+	int i, bad = 0;
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < SCAN_CNT; i++)
+		bad += (_scan_list(l) != expect);
+	list_secs = _elapsed(&start);
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < SCAN_CNT; i++)
+		bad += (_scan_vector(v) != expect);
+	vector_secs = _elapsed(&start);
+
+	snprintf(msg, sizeof(msg), "%s: scans agree", name);
+	TEST(bad, msg);
+	note("%s: %d jobs, List %.2f ms, vector %.2f ms per scan", name,
+	     list_count(l), (list_secs * 1000) / SCAN_CNT,
+	     (vector_secs * 1000) / SCAN_CNT);
+}
+
+static int _find_odd(void *x, void *key)
+{
+	return (((fake_job_t *) x)->job_id & 1);
+}
+
+static void _del_job(void *x)
+{
+	xfree(x);
+}
+
+int main (int argc, char *argv[])
+{
+	fake_job_t *job;
+	vector_t *v;
+	List l;
+	int a, b, c, i, pending = 0;
+
+	v = vector_create(0);
+	a = vector_append(v, "a");
+	b = vector_append(v, "b");
+	c = vector_append(v, "c");
+	TEST((vector_count(v) != 3) || strcmp(vector_get(v, b), "b"),
+	     "append and get");
+	TEST(strcmp(vector_remove(v, b), "b") || vector_get(v, b) ||
+	     vector_remove(v, b) || (vector_count(v) != 2) ||
+	     strcmp(vector_get(v, c), "c"), "remove keeps other handles");
+	TEST((vector_append(v, "d") != b) || strcmp(vector_get(v, a), "a"),
+	     "hole reused");
+	i = 0;
+	while (vector_next(v, &i))
+		vector_remove(v, i - 1);
+	TEST(vector_count(v) || vector_next(v, &i) ||
+	     (vector_append(v, "e") != 0), "remove while iterating");
+	vector_destroy(v);
+
+	/* Records appended to both in the order slurmctld creates them,
+	 * then the odd ones purged as old jobs are */
+	l = list_create(_del_job);
+	v = vector_create(0);
+	for (i = 0; i < JOB_CNT; i++) {
+		job = xmalloc(sizeof(fake_job_t));
+		job->job_id = i;
+		job->job_state = i % 3;
+		if (job->job_state == 0)
+			pending++;
+		list_append(l, job);
+		job->handle = vector_append(v, job);
+	}
+	_time_scans("all jobs", l, v, pending);
+
+	for (i = 0; i < JOB_CNT; i++) {
+		job = vector_get(v, i);
+		if (job->job_id & 1) {
+			if (job->job_state == 0)
+				pending--;
+			vector_remove(v, job->handle);
+		}
+	}
+	list_delete_all(l, _find_odd, "");
+	_time_scans("half purged", l, v, pending);
+
+	list_destroy(l);
+	vector_destroy(v);
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,252 @@
+/* Test of the size-class caches and arenas in src/common/xmalloc.c and
+ * timing of small allocations by concurrent threads.
+ * Each thread repeatedly allocates a batch of blocks of the sizes most
+ * strings and records have, then frees them, with xmalloc() and xfree(),
+ * with malloc() and free() as a reference, and from an arena destroyed
+ * after each batch. Blocks allocated by one thread and freed by another
+ * move between thread caches.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <src/common/xmalloc.h>
+
+#include <testsuite/dejagnu.h>
+
+#define MAX_THREADS	16
+#define BATCH		32	/* blocks allocated before freeing them */
+#define ROUNDS		100000	/* batches, shared by all threads */
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {			\
+	if (_tst)				\
+		fail( _msg );			\
+	else					\
+		pass( _msg );			\
+} while (0)
+
+typedef enum {
+	ALLOC_XMALLOC,
+	ALLOC_MALLOC,
+	ALLOC_ARENA
+} alloc_type_t;
+
+static char *alloc_names[] = { "xmalloc", "malloc", "arena" };
+static alloc_type_t alloc_type;
+static int rounds;
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) +
+	       ((now.tv_usec - start->tv_usec) / 1000000.0);
+}
+
+/* Return non-zero unless the first "size" bytes of "p" are all "c" */
+static int _not_filled(char *p, int size, char c)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		if (p[i] != c)
+			return 1;
+	}
+	return 0;
+}
+
+static void _test_sizes(void)
+{
+	char *p[600];
+	int i, bad = 0;
+
+	/* every size class and the larger blocks beyond them, reused */
+	for (i = 0; i < 600; i++) {
+		p[i] = xmalloc(i);
+		bad += (xsize(p[i]) != i) || _not_filled(p[i], i, 0);
+		memset(p[i], 'x', i);
+	}
+	for (i = 0; i < 600; i += 2)
+		xfree(p[i]);
+	for (i = 0; i < 600; i += 2) {
+		p[i] = xmalloc(i);
+		bad += (xsize(p[i]) != i) || _not_filled(p[i], i, 0);
+		memset(p[i], 'x', i);
+	}
+	for (i = 0; i < 600; i++) {
+		bad += _not_filled(p[i], i, 'x');
+		xfree(p[i]);
+		bad += (p[i] != NULL);
+	}
+	TEST(bad, "allocation sizes");
+
+	/* grow within a class, across classes and to a larger block */
+	p[0] = xmalloc(20);
+	memset(p[0], 'x', 20);
+	xrealloc(p[0], 4);
+	xrealloc(p[0], 24);
+	bad = (xsize(p[0]) != 24) || _not_filled(p[0], 4, 'x') ||
+	      _not_filled(p[0] + 4, 20, 0);
+	memset(p[0], 'x', 24);
+	xrealloc(p[0], 300);
+	bad += (xsize(p[0]) != 300) || _not_filled(p[0], 24, 'x') ||
+	       _not_filled(p[0] + 24, 276, 0);
+	memset(p[0], 'x', 300);
+	xrealloc(p[0], 5000);
+	bad += (xsize(p[0]) != 5000) || _not_filled(p[0], 300, 'x') ||
+	       _not_filled(p[0] + 300, 4700, 0);
+	xrealloc(p[0], 10);
+	bad += (xsize(p[0]) != 10) || _not_filled(p[0], 10, 'x');
+	xfree(p[0]);
+	TEST(bad, "xrealloc");
+}
+
+static void _test_arena(void)
+{
+	uint64_t allocs[2], bytes[2];
+	xarena_t *arena;
+	char *p[200], *q;
+	int i, bad = 0;
+
+	xmalloc_thread_stats(&allocs[0], &bytes[0]);
+	arena = xarena_create();
+	for (i = 0; i < 200; i++) {
+		/* enough to fill a few chunks, some beyond a chunk */
+		p[i] = xarena_alloc(arena, (i % 50) ? i * 10 : 100000);
+		bad += (xsize(p[i]) != ((i % 50) ? i * 10 : 100000)) ||
+		       _not_filled(p[i], xsize(p[i]), 0);
+		memset(p[i], i, xsize(p[i]));
+	}
+	for (i = 0; i < 200; i++)
+		bad += _not_filled(p[i], xsize(p[i]), i);
+	q = p[7];
+	xfree(p[7]);
+	bad += (p[7] != NULL);
+	xrealloc(p[8], 200);
+	bad += (xsize(p[8]) != 200) || _not_filled(p[8], 80, 8) ||
+	       _not_filled(p[8] + 80, 120, 0);
+	xfree(p[8]);
+	xarena_destroy(arena);
+	xmalloc_thread_stats(&allocs[1], &bytes[1]);
+	TEST(bad || (q == NULL), "arena");
+
+	/* the arena, its 200 allocations and the xrealloc() */
+	TEST((allocs[1] - allocs[0]) != 202, "thread allocation counts");
+}
+
+static void *_alloc_batch(void *arg)
+{
+	char **p = arg;
+	int i;
+
+	for (i = 0; i < BATCH; i++)
+		p[i] = xmalloc(8 + (i * 13) % 400);
+	return NULL;
+}
+
+static void *_worker(void *arg)
+{
+	char *p[BATCH];
+	xarena_t *arena;
+	long bad = 0;
+	int i, j, size;
+
+	for (i = 0; i < rounds; i++) {
+		arena = (alloc_type == ALLOC_ARENA) ? xarena_create() : NULL;
+		for (j = 0; j < BATCH; j++) {
+			size = 8 + (j * 13) % 400;
+			if (alloc_type == ALLOC_XMALLOC)
+				p[j] = xmalloc(size);
+			else if (alloc_type == ALLOC_ARENA)
+				p[j] = xarena_alloc(arena, size);
+			else if ((p[j] = malloc(size)))
+				memset(p[j], 0, size);
+			else
+				return (void *) 1;
+			p[j][size - 1] = j;
+		}
+		for (j = 0; j < BATCH; j++) {
+			size = 8 + (j * 13) % 400;
+			if (p[j][size - 1] != j)
+				bad++;
+			if (alloc_type == ALLOC_XMALLOC)
+				xfree(p[j]);
+			else if (alloc_type == ALLOC_MALLOC)
+				free(p[j]);
+		}
+		xarena_destroy(arena);
+	}
+	return (void *) bad;
+}
+
+/* Returns allocations per second, or -1 on error */
+static double _run(int threads)
+{
+	pthread_t tid[MAX_THREADS];
+	struct timeval start;
+	void *bad;
+	long errors = 0;
+	int i;
+
+	rounds = ROUNDS / threads;
+	gettimeofday(&start, NULL);
+	for (i = 0; i < threads; i++) {
+		if (pthread_create(&tid[i], NULL, _worker, NULL))
+			return -1;
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(tid[i], &bad);
+		errors += (long) bad;
+	}
+	if (errors)
+		return -1;
+	return (rounds * threads * BATCH) / _elapsed(&start);
+}
+
+int main (int argc, char *argv[])
+{
+	char *p[BATCH], msg[128];
+	pthread_t tid;
+	double rate;
+	int i, j, bad = 0, threads;
+
+	_test_sizes();
+	_test_arena();
+
+	/* blocks allocated by one thread, freed by another */
+	for (i = 0; i < 100; i++) {
+		pthread_create(&tid, NULL, _alloc_batch, p);
+		pthread_join(tid, NULL);
+		for (j = 0; j < BATCH; j++) {
+			bad += (xsize(p[j]) != 8 + (j * 13) % 400);
+			xfree(p[j]);
+		}
+	}
+	TEST(bad, "blocks freed by another thread");
+
+	for (alloc_type = ALLOC_XMALLOC; alloc_type <= ALLOC_ARENA;
+	     alloc_type++) {
+		for (threads = 1; threads <= MAX_THREADS; threads *= 4) {
+			rate = _run(threads);
+			snprintf(msg, sizeof(msg), "%s, %d threads",
+				 alloc_names[alloc_type], threads);
+			TEST(rate < 0, msg);
+			if (rate >= 0)
+				note("%s: %.0f allocations per second",
+				     msg, rate);
+		}
+	}
+
+	totals();
+	return failed;
+}